@@ -0,0 +1,74 @@
+/*  =========================================================================
+    asset_key - Asset name hashed once, key of asset hash tables
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef ASSET_KEY_H_INCLUDED
+#define ASSET_KEY_H_INCLUDED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  Asset name with its length and hash. Usually lives on the stack and
+//  borrows the name, keys created by asset_key_new own a copy of it.
+struct _asset_key_t {
+    const char *name;
+    size_t length;
+    uint64_t hash;
+};
+
+//  @interface
+//  Set up key of the name, it is borrowed and must outlive the key
+FTY_OUTAGE_EXPORT void
+    asset_key_init (asset_key_t *self, const char *name);
+
+//  Create a new key owning a copy of the name, in one heap block
+FTY_OUTAGE_EXPORT asset_key_t *
+    asset_key_new (const char *name);
+
+//  Return owned copy of the key, the hash is not computed again
+FTY_OUTAGE_EXPORT asset_key_t *
+    asset_key_dup (const asset_key_t *self);
+
+//  Destroy key created by asset_key_new or asset_key_dup
+FTY_OUTAGE_EXPORT void
+    asset_key_destroy (asset_key_t **self_p);
+
+//  Return true if both keys have the same name
+FTY_OUTAGE_EXPORT bool
+    asset_key_eq (const asset_key_t *self, const asset_key_t *other);
+
+//  Create a new hash table keyed by asset_key_t, looking an item up uses
+//  the hash stored in the key. With owned_keys the table stores copies of
+//  inserted keys, otherwise the keys must outlive their items.
+FTY_OUTAGE_EXPORT zhashx_t *
+    asset_key_hash_new (bool owned_keys);
+
+//  Self test of this class
+FTY_OUTAGE_EXPORT void
+    asset_key_test (bool verbose);
+
+//  @end
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -84,12 +84,18 @@
 #ifdef FTY_OUTAGE_BUILD_DRAFT_API
 typedef struct _fty_outage_server_t fty_outage_server_t;
 #define FTY_OUTAGE_SERVER_T_DEFINED
+typedef struct _asset_key_t asset_key_t;
+#define ASSET_KEY_T_DEFINED
+typedef struct _fty_outage_liveness_t fty_outage_liveness_t;
+#define FTY_OUTAGE_LIVENESS_T_DEFINED
 #endif // FTY_OUTAGE_BUILD_DRAFT_API
 
 
 //  Public classes, each with its own header file
 #ifdef FTY_OUTAGE_BUILD_DRAFT_API
 #include "fty_outage_server.h"
+#include "asset_key.h"
+#include "fty_outage_liveness.h"
 #endif // FTY_OUTAGE_BUILD_DRAFT_API
 
 #ifdef FTY_OUTAGE_BUILD_DRAFT_API
@@ -0,0 +1,251 @@
+/*  =========================================================================
+    fty_outage_liveness - Liveness of keys refreshed by events, escalating after silence
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef FTY_OUTAGE_LIVENESS_H_INCLUDED
+#define FTY_OUTAGE_LIVENESS_H_INCLUDED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  Levels reached by silent record, level N after factor N * ttl of silence
+#define FTY_OUTAGE_LIVENESS_ALIVE       0   //  record is alive
+#define FTY_OUTAGE_LIVENESS_WARNING     1   //  silent for warning factor * ttl
+#define FTY_OUTAGE_LIVENESS_CRITICAL    2   //  silent for critical factor * ttl
+#define FTY_OUTAGE_LIVENESS_LEVELS      2
+
+//  Tiers of timer resolution, each with its own deadlines and tick, records
+//  are inserted to tier 0
+#define FTY_OUTAGE_LIVENESS_TIERS       4
+
+//  How ttl of a record changes when it is touched
+#define FTY_OUTAGE_LIVENESS_TTL_MIN     0   //  the shortest ttl seen is kept
+#define FTY_OUTAGE_LIVENESS_TTL_LAST    1   //  ttl of the last touch is kept
+
+//  Transitions of records
+#define FTY_OUTAGE_LIVENESS_ADDED       1   //  record was inserted
+#define FTY_OUTAGE_LIVENESS_DELETED     2   //  record was deleted
+#define FTY_OUTAGE_LIVENESS_EXPIRED     3   //  record reached escalation level
+#define FTY_OUTAGE_LIVENESS_REVIVED     4   //  silent record was touched
+#define FTY_OUTAGE_LIVENESS_FUTURE      5   //  touch seen in future was ignored
+
+//  State of a record, times are on the monotonic timeline of the caller
+typedef struct _fty_outage_liveness_state_t {
+    int64_t seen_ms;        //  [ms] when the record was seen last
+    int64_t ttl_ms;         //  [ms] time to live of the record
+    int level;              //  FTY_OUTAGE_LIVENESS_ALIVE or escalation level
+    int64_t deadline_ms;    //  [ms] the next escalation, 0 if none is scheduled
+} fty_outage_liveness_state_t;
+
+//  Item of batch touch
+typedef struct _fty_outage_liveness_touch_t {
+    asset_key_t key;
+    int64_t seen_ms;        //  [ms] when the record was seen
+    int64_t ttl_ms;         //  [ms] time to live proposed by the touch
+} fty_outage_liveness_touch_t;
+
+//  Transition caused by item of a batch
+typedef struct _fty_outage_liveness_transition_t {
+    size_t index;           //  item of the batch
+    int type;               //  FTY_OUTAGE_LIVENESS_ADDED, ...
+} fty_outage_liveness_transition_t;
+
+//  Destroys item of a record
+typedef void (fty_outage_liveness_destructor_fn) (void **item_p);
+
+//  Called on each transition of a record, except FTY_OUTAGE_LIVENESS_FUTURE,
+//  after the record got to its new state
+typedef void (fty_outage_liveness_handler_fn) (
+    void *arg, int type, const asset_key_t *key, void *item, const fty_outage_liveness_state_t *state);
+
+//  Estimated heap memory held by liveness, in bytes
+typedef struct _fty_outage_liveness_memory_t {
+    size_t records;         //  records and hash tables indexing them
+    size_t keys;            //  names of keys
+    size_t index;           //  expiry index and scratch of batch touch
+} fty_outage_liveness_memory_t;
+
+//  @interface
+//  Create a new liveness, records get ttl of 60 seconds and reach
+//  CRITICAL after 2 * ttl of silence
+FTY_OUTAGE_EXPORT fty_outage_liveness_t *
+    fty_outage_liveness_new (void);
+
+//  Destroy the liveness and items of its records
+FTY_OUTAGE_EXPORT void
+    fty_outage_liveness_destroy (fty_outage_liveness_t **self_p);
+
+//  Set destructor of record items, they are not destroyed by default
+FTY_OUTAGE_EXPORT void
+    fty_outage_liveness_set_destructor (fty_outage_liveness_t *self, fty_outage_liveness_destructor_fn destructor);
+
+//  Set handler called on transitions of records, NULL disables it
+FTY_OUTAGE_EXPORT void
+    fty_outage_liveness_set_handler (fty_outage_liveness_t *self, fty_outage_liveness_handler_fn handler, void *arg);
+
+//  Return ttl of newly inserted records
+FTY_OUTAGE_EXPORT int64_t
+    fty_outage_liveness_default_ttl (fty_outage_liveness_t *self);
+
+//  Set ttl of newly inserted records
+FTY_OUTAGE_EXPORT void
+    fty_outage_liveness_set_default_ttl (fty_outage_liveness_t *self, int64_t ttl_ms);
+
+//  Set how ttl changes when record is touched, FTY_OUTAGE_LIVENESS_TTL_MIN
+//  by default
+FTY_OUTAGE_EXPORT void
+    fty_outage_liveness_set_ttl_policy (fty_outage_liveness_t *self, int policy);
+
+//  Set after how many ttls of silence record escalates to WARNING and to
+//  CRITICAL, warning_factor 0 disables WARNING, and reschedule all records
+FTY_OUTAGE_EXPORT void
+    fty_outage_liveness_set_escalation (fty_outage_liveness_t *self, double warning_factor, double critical_factor, int64_t now_ms);
+
+//  Set tick of the tier, deadlines of its records are rounded up to a
+//  multiple of it, so the owner can check the tier once per tick. 0, the
+//  default, keeps them exact. Records of the tier are rescheduled.
+FTY_OUTAGE_EXPORT void
+    fty_outage_liveness_set_tick (fty_outage_liveness_t *self, int tier, int64_t tick_ms, int64_t now_ms);
+
+//  Return tick of the tier
+FTY_OUTAGE_EXPORT int64_t
+    fty_outage_liveness_tick (fty_outage_liveness_t *self, int tier);
+
+//  Move record of the key to the tier, its deadlines are rescheduled with
+//  the tick of the tier. Returns -1 if the key is not known.
+FTY_OUTAGE_EXPORT int
+    fty_outage_liveness_set_tier (fty_outage_liveness_t *self, const asset_key_t *key, int tier, int64_t now_ms);
+
+//  Return tier of the record of the key, -1 if it is not known
+FTY_OUTAGE_EXPORT int
+    fty_outage_liveness_tier (fty_outage_liveness_t *self, const asset_key_t *key);
+
+//  Return the earliest deadline scheduled in the tier, INT64_MAX if there
+//  is none
+FTY_OUTAGE_EXPORT int64_t
+    fty_outage_liveness_next_deadline (fty_outage_liveness_t *self, int tier);
+
+//  Insert record of the key seen now with default ttl, takes ownership of
+//  the item. Returns -1 if the key is known already, item is not taken.
+FTY_OUTAGE_EXPORT int
+    fty_outage_liveness_insert (fty_outage_liveness_t *self, const asset_key_t *key, void *item, int64_t now_ms);
+
+//  Delete record of the key, returns -1 if it is not known
+FTY_OUTAGE_EXPORT int
+    fty_outage_liveness_delete (fty_outage_liveness_t *self, const asset_key_t *key);
+
+//  Return item of the key, NULL if it is not known
+FTY_OUTAGE_EXPORT void *
+    fty_outage_liveness_lookup (fty_outage_liveness_t *self, const asset_key_t *key);
+
+//  Replace item of the key, takes ownership of the new item and destroys
+//  the old one. Returns -1 if the key is not known, item is not taken.
+FTY_OUTAGE_EXPORT int
+    fty_outage_liveness_replace (fty_outage_liveness_t *self, const asset_key_t *key, void *item);
+
+//  Return level reached by the key, FTY_OUTAGE_LIVENESS_ALIVE if unknown
+FTY_OUTAGE_EXPORT int
+    fty_outage_liveness_level (fty_outage_liveness_t *self, const asset_key_t *key);
+
+//  Fill state of the key, returns -1 if it is not known
+FTY_OUTAGE_EXPORT int
+    fty_outage_liveness_state (fty_outage_liveness_t *self, const asset_key_t *key, fty_outage_liveness_state_t *state);
+
+//  Record of the key was seen at seen_ms with ttl_ms. Seen time never moves
+//  backward, seen time after now_ms is ignored, ttl is applied anyway.
+//  Returns -1 if the key is not known, FTY_OUTAGE_LIVENESS_REVIVED or
+//  FTY_OUTAGE_LIVENESS_FUTURE if it was a transition, 0 otherwise.
+FTY_OUTAGE_EXPORT int
+    fty_outage_liveness_touch (fty_outage_liveness_t *self, const asset_key_t *key, int64_t seen_ms, int64_t ttl_ms, int64_t now_ms);
+
+//  Alive record of the key was seen at seen_ms, ttl is kept. It is not
+//  rescheduled, its deadlines move once they are due, so it costs one
+//  lookup and escalation happens as after fty_outage_liveness_touch. Seen
+//  time never moves backward, seen time after now_ms is ignored.
+//  Returns -1 if the key is not known or it is not alive, 0 otherwise.
+FTY_OUTAGE_EXPORT int
+    fty_outage_liveness_defer (fty_outage_liveness_t *self, const asset_key_t *key, int64_t seen_ms, int64_t now_ms);
+
+//  Touch records with batch of items as fty_outage_liveness_touch does.
+//  Record touched several times is rescheduled once. Fills transitions,
+//  if not NULL, room for count of them is needed, and returns their number.
+FTY_OUTAGE_EXPORT size_t
+    fty_outage_liveness_touch_batch (fty_outage_liveness_t *self, const fty_outage_liveness_touch_t *items, size_t count, int64_t now_ms, fty_outage_liveness_transition_t *transitions);
+
+//  Escalate records whose deadlines passed at now_ms, returns list of keys
+//  of all records which reached some escalation level, they are references
+//  to asset_key_t of records
+FTY_OUTAGE_EXPORT zlistx_t *
+    fty_outage_liveness_expire (fty_outage_liveness_t *self, int64_t now_ms);
+
+//  Escalate records of the tier whose deadlines passed at now_ms, append
+//  keys of records which reached a higher level now to the list, each once,
+//  and return their number. Records dead already are not listed again.
+FTY_OUTAGE_EXPORT size_t
+    fty_outage_liveness_expire_tier (fty_outage_liveness_t *self, int tier, int64_t now_ms, zlistx_t *escalated);
+
+//  Return number of records
+FTY_OUTAGE_EXPORT size_t
+    fty_outage_liveness_size (fty_outage_liveness_t *self);
+
+//  Return number of escalation deadlines scheduled
+FTY_OUTAGE_EXPORT size_t
+    fty_outage_liveness_scheduled (fty_outage_liveness_t *self);
+
+//  Return key of the first record, NULL if there are none
+FTY_OUTAGE_EXPORT const asset_key_t *
+    fty_outage_liveness_first (fty_outage_liveness_t *self);
+
+//  Return key of the next record, NULL after the last one. Records must
+//  not be inserted or deleted while iterating.
+FTY_OUTAGE_EXPORT const asset_key_t *
+    fty_outage_liveness_next (fty_outage_liveness_t *self);
+
+//  Estimate heap memory held by liveness, items are not counted
+FTY_OUTAGE_EXPORT void
+    fty_outage_liveness_memory (fty_outage_liveness_t *self, fty_outage_liveness_memory_t *memory);
+
+//  Shrink hash tables and the expiry index left over-allocated by past
+//  churn of records. Returns number of structures compacted.
+FTY_OUTAGE_EXPORT int
+    fty_outage_liveness_compact (fty_outage_liveness_t *self);
+
+//  Return snapshot of all records, seen times are stored relative to now_ms
+FTY_OUTAGE_EXPORT zconfig_t *
+    fty_outage_liveness_snapshot (fty_outage_liveness_t *self, int64_t now_ms);
+
+//  Restore records from snapshot, seen times are rebased to now_ms. Known
+//  records take the state of the snapshot, the others are inserted with
+//  NULL item. Returns number of restored records, -1 if snapshot is invalid.
+FTY_OUTAGE_EXPORT int
+    fty_outage_liveness_restore (fty_outage_liveness_t *self, zconfig_t *snapshot, int64_t now_ms);
+
+//  Self test of this class
+FTY_OUTAGE_EXPORT void
+    fty_outage_liveness_test (bool verbose);
+
+//  @end
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -122,6 +122,8 @@ find %{buildroot} -name '*.la' | xargs rm -f
 %defattr(-,root,root)
 %doc README.md
 %{_bindir}/fty-outage
+%{_bindir}/fty-outage-events
+%{_bindir}/fty-outage-sim
 %{_mandir}/man1/fty-outage*
 %config(noreplace) %{_sysconfdir}/fty-outage/fty-outage.cfg
 %{SYSTEMD_UNIT_DIR}/fty-outage.service
@@ -0,0 +1,118 @@
+/*  =========================================================================
+    alloc_count - Allocation counting and timing shared by perf tools
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    alloc_count - Allocation counting and timing shared by perf tools
+@discuss
+    Included by exactly one source of outage_perf, data_bench and
+    liveness_bench, it defines malloc, calloc and realloc of the program.
+
+    malloc, calloc and realloc are counted by interposing them, glibc
+    only, elsewhere s_allocations stays 0. Only allocations of a thread
+    which set s_counting are counted, so actors running in their own
+    threads do not add to the count. Benchmarks report ns/op,
+    allocations/op and peak RSS, with --json every benchmark is one JSON
+    object per line, to compare builds.
+@end
+*/
+
+#ifndef ALLOC_COUNT_H_INCLUDED
+#define ALLOC_COUNT_H_INCLUDED
+
+#include <sys/resource.h>
+#include <time.h>
+
+//  allocations of threads which set s_counting
+static __thread bool s_counting = false;
+static uint64_t s_allocations = 0;
+
+#if defined (__GLIBC__)
+extern void *__libc_malloc (size_t size);
+extern void *__libc_calloc (size_t nmemb, size_t size);
+extern void *__libc_realloc (void *ptr, size_t size);
+
+void *
+malloc (size_t size)
+{
+    if (s_counting)
+        s_allocations++;
+    return __libc_malloc (size);
+}
+
+void *
+calloc (size_t nmemb, size_t size)
+{
+    if (s_counting)
+        s_allocations++;
+    return __libc_calloc (nmemb, size);
+}
+
+void *
+realloc (void *ptr, size_t size)
+{
+    if (s_counting)
+        s_allocations++;
+    return __libc_realloc (ptr, size);
+}
+#endif
+
+typedef struct _bench_t {
+    const char *name;
+    int64_t start_ns;
+    uint64_t start_allocations;
+} bench_t;
+
+static inline int64_t
+s_now_ns (void)
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static inline long
+s_peak_rss_kb (void)
+{
+    struct rusage usage;
+    getrusage (RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static inline void
+s_bench_start (bench_t *bench, const char *name)
+{
+    bench->name = name;
+    bench->start_allocations = s_allocations;
+    bench->start_ns = s_now_ns ();
+}
+
+//  time and allocations per operation since s_bench_start
+static inline void
+s_bench_per_op (bench_t *bench, size_t ops, double *ns_per_op, double *allocs_per_op)
+{
+    int64_t elapsed_ns = s_now_ns () - bench->start_ns;
+    uint64_t allocations = s_allocations - bench->start_allocations;
+    *ns_per_op = ops ? (double) elapsed_ns / ops : 0;
+    *allocs_per_op = ops ? (double) allocations / ops : 0;
+}
+
+#endif
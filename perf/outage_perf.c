@@ -0,0 +1,197 @@
+/*  =========================================================================
+    outage_perf - Deterministic workload for the perfcheck gate
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    outage_perf - Deterministic workload for the perfcheck gate
+@discuss
+    Fixed number of assets, fixed sequence of metrics and a fake clock, so
+    that callgrind counts the same instructions on every run of the same
+    build. The server is compiled in, so its static entry points can be
+    driven directly, without malamute.
+
+    Prints allocations of the main thread per entry point as
+    "allocs <entry point> <count>", perfcheck.sh adds instruction counts
+    from callgrind. Exits with 1 if control or unavailable traffic
+    allocates, make check runs it for that.
+@end
+*/
+
+#include "fty_outage_server.c"
+#include "alloc_count.h"
+
+#define PERF_ASSETS     10000
+#define PERF_METRICS    100000
+#define PERF_ALERTS     1000
+#define PERF_DEAD_CHECKS 100
+#define PERF_CONTROLS   1000
+
+int main (void)
+{
+    ftylog_setInstance ("outage_perf", "");
+    s_osrv_t *self = s_osrv_new ();
+    assert (self);
+    outage_clock_t *clock = outage_clock_new_fake ((int64_t) 1500000000 * 1000, 1000);
+    data_set_clock (self->assets, clock);
+    outage_clock_destroy (&self->clock);
+    self->clock = clock;
+    data_set_default_expiry (self->assets, 60);
+
+    // inputs prepared outside of counted sections
+    char *names [PERF_ASSETS];
+    fty_proto_t *assets [PERF_ASSETS];
+    zhash_t *aux = zhash_new ();
+    zhash_insert (aux, FTY_PROTO_ASSET_TYPE, "device");
+    zhash_insert (aux, FTY_PROTO_ASSET_SUBTYPE, "ups");
+    for (size_t i = 0; i < PERF_ASSETS; i++) {
+        names [i] = zsys_sprintf ("ups-%zu", i);
+        zmsg_t *msg = fty_proto_encode_asset (aux, names [i], FTY_PROTO_ASSET_OP_CREATE, NULL);
+        assets [i] = fty_proto_decode (&msg);
+    }
+    zhash_destroy (&aux);
+
+    uint64_t allocations_put = 0;
+    uint64_t allocations_decode = 0;
+    uint64_t allocations_handle = 0;
+    uint64_t allocations_touch = 0;
+    uint64_t allocations_get_dead = 0;
+    uint64_t allocations_send_alert = 0;
+    uint64_t allocations_commands = 0;
+    uint64_t allocations_unavailable = 0;
+
+    s_counting = true;
+    uint64_t start = s_allocations;
+    for (size_t i = 0; i < PERF_ASSETS; i++)
+        data_put (self->assets, &assets [i]);
+    allocations_put = s_allocations - start;
+
+    // each 10th asset stays silent
+    for (size_t op = 0; op < PERF_METRICS; op++) {
+        size_t key = (op * 7) % PERF_ASSETS;
+        if (key % 10 == 0)
+            key++;
+        outage_clock_advance (clock, 1);
+        uint64_t now_sec = outage_clock_wall_ms (clock) / 1000;
+        s_counting = false;
+        zmsg_t *msg = fty_proto_encode_metric (NULL, now_sec, 60, "realpower.default", names [key], "100", "W");
+        s_counting = true;
+
+        start = s_allocations;
+        fty_proto_t *metric = fty_proto_decode (&msg);
+        allocations_decode += s_allocations - start;
+
+        // resolve alert, touch the asset, its name hashed once
+        start = s_allocations;
+        s_osrv_handle_proto (self, FTY_PROTO_STREAM_METRICS, "realpower.default", &metric);
+        allocations_handle += s_allocations - start;
+    }
+
+    // the per-metric touch on its own, so it is gated apart from parsing
+    for (size_t op = 0; op < PERF_METRICS; op++) {
+        size_t index = (op * 7) % PERF_ASSETS;
+        if (index % 10 == 0)
+            index++;
+        outage_clock_advance (clock, 1);
+        uint64_t now_sec = outage_clock_wall_ms (clock) / 1000;
+        asset_key_t key;
+        asset_key_init (&key, names [index]);
+
+        start = s_allocations;
+        data_touch_asset (self->assets, &key, now_sec, 60, now_sec);
+        allocations_touch += s_allocations - start;
+    }
+
+    outage_clock_advance (clock, 120 * 1000);
+    start = s_allocations;
+    for (size_t i = 0; i < PERF_DEAD_CHECKS; i++) {
+        zlistx_t *dead = data_get_dead (self->assets);
+        zlistx_destroy (&dead);
+    }
+    allocations_get_dead = s_allocations - start;
+
+    start = s_allocations;
+    for (size_t i = 0; i < PERF_ALERTS; i++) {
+        asset_key_t key;
+        asset_key_init (&key, names [i]);
+        s_osrv_send_alert (self, &key, "ACTIVE", "CRITICAL");
+    }
+    allocations_send_alert = s_allocations - start;
+
+    // enabling escalation grows the deadline heap once, that is not parsing
+    s_counting = false;
+    zmsg_t *warmup = zmsg_new ();
+    zmsg_addstr (warmup, "ESCALATION");
+    zmsg_addstr (warmup, "2.5");
+    zmsg_addstr (warmup, "5");
+    s_osrv_actor_commands (self, NULL, &warmup);
+
+    // control and unavailable traffic, messages built outside of counted section
+    for (size_t i = 0; i < PERF_CONTROLS; i++) {
+        s_counting = false;
+        zmsg_t *timeout = zmsg_new ();
+        zmsg_addstr (timeout, "TIMEOUT");
+        zmsg_addstrf (timeout, "%zu", 1000 + i);
+        zmsg_t *expiry = zmsg_new ();
+        zmsg_addstr (expiry, "ASSET-EXPIRY-SEC");
+        zmsg_addstr (expiry, "60");
+        zmsg_t *escalation = zmsg_new ();
+        zmsg_addstr (escalation, "ESCALATION");
+        zmsg_addstr (escalation, "2.5");
+        zmsg_addstr (escalation, "5");
+        // assets without alert, so that no RESOLVED alert is published
+        zmsg_t *unavailable = zmsg_new ();
+        zmsg_addstr (unavailable, "METRICUNAVAILABLE");
+        zmsg_addstrf (unavailable, "realpower.default@%s", names [PERF_ASSETS - 1 - i]);
+        s_counting = true;
+
+        start = s_allocations;
+        s_osrv_actor_commands (self, NULL, &timeout);
+        s_osrv_actor_commands (self, NULL, &expiry);
+        s_osrv_actor_commands (self, NULL, &escalation);
+        allocations_commands += s_allocations - start;
+
+        start = s_allocations;
+        s_osrv_handle_unavailable (self, unavailable);
+        zmsg_destroy (&unavailable);
+        allocations_unavailable += s_allocations - start;
+    }
+    s_counting = false;
+
+    printf ("allocs data_put %" PRIu64 "\n", allocations_put);
+    printf ("allocs fty_proto_decode %" PRIu64 "\n", allocations_decode);
+    printf ("allocs s_osrv_handle_proto %" PRIu64 "\n", allocations_handle);
+    printf ("allocs data_touch_asset %" PRIu64 "\n", allocations_touch);
+    printf ("allocs data_get_dead %" PRIu64 "\n", allocations_get_dead);
+    printf ("allocs s_osrv_send_alert %" PRIu64 "\n", allocations_send_alert);
+    printf ("allocs s_osrv_actor_commands %" PRIu64 "\n", allocations_commands);
+    printf ("allocs s_osrv_handle_unavailable %" PRIu64 "\n", allocations_unavailable);
+
+    s_osrv_destroy (&self);
+    for (size_t i = 0; i < PERF_ASSETS; i++)
+        zstr_free (&names [i]);
+
+    // not a matter of baseline, control and unavailable traffic must not allocate
+    if (allocations_commands != 0 || allocations_unavailable != 0) {
+        fprintf (stderr, "outage_perf: control or unavailable traffic allocates\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,387 @@
+/*  =========================================================================
+    outage_soak - Long horizon soak of the server on simulated time
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    outage_soak - Long horizon soak of the server on simulated time
+@discuss
+    Weeks of uptime in minutes: the server is compiled in and driven
+    directly on a fake clock, one tick per simulated minute. Each asset
+    reports once per ttl, randomly fails for up to six hours or flaps for
+    less than 2 * ttl (which must not alert), and a share of assets is
+    retired and replaced by new ones every simulated day.
+
+    Alerts the server publishes are checked against the model as they are
+    sent (alert_publisher_send is redirected to the oracle):
+      * no missed outage - asset silent for 2 * ttl got ACTIVE
+      * no false alert   - ACTIVE only after 2 * ttl of silence
+      * no duplicate ACTIVE, no RESOLVED or refresh of inactive alert
+      * bounded memory   - RSS after daily compaction stays within
+                           --rss-slack of the first day
+    Exit status is 1 if any invariant is violated.
+
+    Run with 'make soak SOAK_ARGS="..."'.
+@end
+*/
+
+#define alert_publisher_send s_soak_publish
+#include "fty_outage_server.c"
+#undef alert_publisher_send
+
+#define TICK_SEC 60
+#define DAY_SEC (24 * 3600)
+#define MAX_FAILURE_SEC (6 * 3600)
+
+typedef struct _soak_asset_t {
+    char *name;                 // ups-<slot>-<generation>
+    unsigned int generation;
+    uint64_t last_report_sec;
+    uint64_t down_until_sec;    // 0 when the asset is up
+    bool active;                // ACTIVE alert published and not resolved
+    bool alerted;               // ACTIVE seen during current failure
+} soak_asset_t;
+
+typedef struct _soak_t {
+    size_t assets_count;
+    uint64_t days;
+    uint64_t ttl;
+    double failures;            // per asset per day
+    double churn;               // percent of assets replaced per day
+    unsigned int seed;
+    double rss_slack;           // percent
+
+    soak_asset_t *assets;
+    uint64_t now_sec;
+    // counters
+    uint64_t metrics;
+    uint64_t outages;           // failures long enough to alert
+    uint64_t flaps;             // failures too short to alert
+    uint64_t retired;
+    uint64_t active_sent;
+    uint64_t resolved_sent;
+    uint64_t refresh_sent;
+    // violations
+    uint64_t missed;
+    uint64_t false_alerts;
+    uint64_t duplicates;
+    uint64_t unexpected;
+} soak_t;
+
+static soak_t s_soak;
+
+static soak_asset_t *
+s_soak_asset (const char *name)
+{
+    size_t slot;
+    unsigned int generation;
+    if (sscanf (name, "ups-%zu-%u", &slot, &generation) != 2
+    ||  slot >= s_soak.assets_count
+    ||  s_soak.assets [slot].generation != generation)
+        return NULL;
+    return &s_soak.assets [slot];
+}
+
+//  oracle, receives alerts instead of the publisher
+int
+s_soak_publish (zactor_t *publisher, const char *subject, bool refresh, zmsg_t **msg_p)
+{
+    fty_proto_t *alert = fty_proto_decode (msg_p);
+    assert (alert);
+    soak_asset_t *asset = s_soak_asset (fty_proto_name (alert));
+    const char *state = fty_proto_state (alert);
+
+    if (!asset) {
+        log_error ("soak: alert %s for unknown asset %s", state, fty_proto_name (alert));
+        s_soak.unexpected++;
+    }
+    else
+    if (refresh) {
+        s_soak.refresh_sent++;
+        if (!asset->active) {
+            log_error ("soak: refresh of inactive alert of %s", asset->name);
+            s_soak.unexpected++;
+        }
+    }
+    else
+    if (streq (state, "ACTIVE")) {
+        s_soak.active_sent++;
+        if (asset->active) {
+            log_error ("soak: duplicate ACTIVE of %s", asset->name);
+            s_soak.duplicates++;
+        }
+        if (s_soak.now_sec < asset->last_report_sec + 2 * s_soak.ttl) {
+            log_error ("soak: false ACTIVE of %s silent for %" PRIu64 " s", asset->name, s_soak.now_sec - asset->last_report_sec);
+            s_soak.false_alerts++;
+        }
+        asset->active = true;
+        asset->alerted = true;
+    }
+    else
+    if (streq (state, "RESOLVED")) {
+        s_soak.resolved_sent++;
+        if (!asset->active) {
+            log_error ("soak: RESOLVED of inactive alert of %s", asset->name);
+            s_soak.unexpected++;
+        }
+        asset->active = false;
+    }
+    fty_proto_destroy (&alert);
+    return 0;
+}
+
+static void
+s_soak_send_asset (s_osrv_t *self, const char *name, const char *operation)
+{
+    zhash_t *aux = zhash_new ();
+    zhash_insert (aux, FTY_PROTO_ASSET_TYPE, "device");
+    zhash_insert (aux, FTY_PROTO_ASSET_SUBTYPE, "ups");
+    zmsg_t *msg = fty_proto_encode_asset (aux, name, operation, NULL);
+    fty_proto_t *proto = fty_proto_decode (&msg);
+    s_osrv_handle_proto (self, FTY_PROTO_STREAM_ASSETS, name, &proto);
+    zhash_destroy (&aux);
+}
+
+static void
+s_soak_create (s_osrv_t *self, size_t slot)
+{
+    soak_asset_t *asset = &s_soak.assets [slot];
+    zstr_free (&asset->name);
+    asset->name = zsys_sprintf ("ups-%zu-%u", slot, asset->generation);
+    asset->last_report_sec = s_soak.now_sec;
+    asset->down_until_sec = 0;
+    asset->active = false;
+    asset->alerted = false;
+    s_soak_send_asset (self, asset->name, FTY_PROTO_ASSET_OP_CREATE);
+}
+
+//  failure is over or the asset is gone, was it alerted when it had to be?
+static void
+s_soak_failure_end (soak_asset_t *asset)
+{
+    // dead check runs each tick, so the alert comes at most a tick late
+    if (s_soak.now_sec >= asset->last_report_sec + 2 * s_soak.ttl + TICK_SEC) {
+        s_soak.outages++;
+        if (!asset->alerted) {
+            log_error ("soak: missed outage of %s silent for %" PRIu64 " s", asset->name, s_soak.now_sec - asset->last_report_sec);
+            s_soak.missed++;
+        }
+    }
+    else
+        s_soak.flaps++;
+    asset->down_until_sec = 0;
+    asset->alerted = false;
+}
+
+static void
+s_soak_report (s_osrv_t *self, soak_asset_t *asset)
+{
+    fty_proto_t *metric = fty_proto_new (FTY_PROTO_METRIC);
+    fty_proto_set_name (metric, "%s", asset->name);
+    fty_proto_set_time (metric, s_soak.now_sec);
+    fty_proto_set_ttl (metric, (uint32_t) s_soak.ttl);
+    s_osrv_handle_proto (self, FTY_PROTO_STREAM_METRICS, asset->name, &metric);
+    asset->last_report_sec = s_soak.now_sec;
+    s_soak.metrics++;
+}
+
+static int64_t
+s_now_ns (void)
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int
+s_soak_run (void)
+{
+    s_osrv_t *self = s_osrv_new ();
+    assert (self);
+    outage_clock_t *clock = outage_clock_new_fake ((int64_t) 1500000000 * 1000, 1000);
+    assert (clock);
+    data_set_clock (self->assets, clock);
+    outage_clock_destroy (&self->clock);
+    self->clock = clock;
+    alert_refresh_destroy (&self->refresh);
+    self->refresh = alert_refresh_new (s_osrv_refresh_period_ms (self), REFRESH_SLOTS, outage_clock_mono_ms (clock));
+    assert (self->refresh);
+    s_soak.now_sec = outage_clock_wall_ms (clock) / 1000;
+    // as ASSET-EXPIRY-SEC, new assets which never report expire after 2 * ttl as well
+    data_set_default_expiry (self->assets, s_soak.ttl);
+
+    s_soak.assets = (soak_asset_t *) zmalloc (s_soak.assets_count * sizeof (soak_asset_t));
+    assert (s_soak.assets);
+    for (size_t slot = 0; slot < s_soak.assets_count; slot++)
+        s_soak_create (self, slot);
+
+    uint64_t period = s_soak.ttl / TICK_SEC ? s_soak.ttl / TICK_SEC : 1;   // ticks between reports
+    double failure_p = s_soak.failures / ((double) DAY_SEC / TICK_SEC / period);
+    size_t churn_count = (size_t) (s_soak.assets_count * s_soak.churn / 100);
+    uint64_t ticks = s_soak.days * DAY_SEC / TICK_SEC;
+    size_t first_rss = 0;
+    size_t max_rss = 0;
+    int64_t start_ns = s_now_ns ();
+
+    for (uint64_t tick = 1; tick <= ticks; tick++) {
+        outage_clock_advance (clock, TICK_SEC * 1000);
+        s_soak.now_sec = outage_clock_wall_ms (clock) / 1000;
+
+        // each asset reports once per period, spread over its ticks
+        for (size_t slot = tick % period; slot < s_soak.assets_count; slot += period) {
+            soak_asset_t *asset = &s_soak.assets [slot];
+            if (asset->down_until_sec && s_soak.now_sec < asset->down_until_sec)
+                continue;
+            // failing again right away extends the failure
+            if ((double) rand_r (&s_soak.seed) / RAND_MAX < failure_p) {
+                // half of failures are flaps shorter than 2 * ttl
+                uint64_t max_sec = rand_r (&s_soak.seed) % 2 ? 2 * s_soak.ttl : MAX_FAILURE_SEC;
+                asset->down_until_sec = s_soak.now_sec + TICK_SEC + (uint64_t) rand_r (&s_soak.seed) % max_sec;
+                continue;
+            }
+            if (asset->down_until_sec)
+                s_soak_failure_end (asset);
+            s_soak_report (self, asset);
+        }
+
+        // the server loop duties
+        s_osrv_check_dead_devices (self);
+        uint64_t now_ms = outage_clock_mono_ms (clock);
+        if (now_ms >= alert_refresh_next_ms (self->refresh))
+            s_osrv_refresh_alerts (self, now_ms);
+
+        if (tick % (DAY_SEC / TICK_SEC) == 0) {
+            // asset lifecycle, retire some and replace them by new ones
+            for (size_t i = 0; i < churn_count; i++) {
+                size_t slot = (size_t) rand_r (&s_soak.seed) % s_soak.assets_count;
+                soak_asset_t *asset = &s_soak.assets [slot];
+                s_soak_send_asset (self, asset->name, FTY_PROTO_ASSET_OP_DELETE);
+                if (asset->active) {
+                    log_error ("soak: alert of retired %s not resolved", asset->name);
+                    s_soak.unexpected++;
+                }
+                if (asset->down_until_sec)
+                    s_soak_failure_end (asset);
+                asset->generation++;
+                s_soak.retired++;
+                s_soak_create (self, slot);
+            }
+
+            s_osrv_compact (self);
+            size_t rss = memory_usage_rss ();
+            if (first_rss == 0)
+                first_rss = rss;
+            if (rss > max_rss)
+                max_rss = rss;
+            data_memory_t memory;
+            data_memory (self->assets, &memory);
+            printf ("day %3" PRIu64 ": %zu active alerts, %" PRIu64 " outages, %" PRIu64 " flaps, %zu kB estimated, %zu kB RSS\n",
+                tick / (DAY_SEC / TICK_SEC), zhashx_size (self->active_alerts), s_soak.outages, s_soak.flaps,
+                (memory.assets + memory.strings + memory.messages + memory.heap + memory.skew + memory.locations + s_osrv_alerts_memory (self)) / 1024,
+                rss / 1024);
+        }
+    }
+    double elapsed_sec = (double) (s_now_ns () - start_ns) / 1000000000;
+
+    // failures still going on have to be alerted by now too
+    for (size_t slot = 0; slot < s_soak.assets_count; slot++) {
+        if (s_soak.assets [slot].down_until_sec)
+            s_soak_failure_end (&s_soak.assets [slot]);
+        zstr_free (&s_soak.assets [slot].name);
+    }
+    free (s_soak.assets);
+    s_osrv_destroy (&self);
+
+    bool bounded = max_rss <= first_rss * (1 + s_soak.rss_slack / 100);
+    printf ("soak: %" PRIu64 " days, %zu assets in %.1f s, %.0f metrics/s, %.2f simulated days/s\n",
+        s_soak.days, s_soak.assets_count, elapsed_sec, s_soak.metrics / elapsed_sec, s_soak.days / elapsed_sec);
+    printf ("soak: %" PRIu64 " metrics, %" PRIu64 " outages, %" PRIu64 " flaps, %" PRIu64 " retired\n",
+        s_soak.metrics, s_soak.outages, s_soak.flaps, s_soak.retired);
+    printf ("soak: %" PRIu64 " ACTIVE, %" PRIu64 " RESOLVED, %" PRIu64 " refresh sent\n",
+        s_soak.active_sent, s_soak.resolved_sent, s_soak.refresh_sent);
+    printf ("soak: RSS %zu kB after first day, %zu kB max, %s\n",
+        first_rss / 1024, max_rss / 1024, bounded ? "bounded" : "GROWING");
+    printf ("soak: %" PRIu64 " missed, %" PRIu64 " false, %" PRIu64 " duplicate, %" PRIu64 " unexpected alerts\n",
+        s_soak.missed, s_soak.false_alerts, s_soak.duplicates, s_soak.unexpected);
+
+    bool ok = bounded && s_soak.missed == 0 && s_soak.false_alerts == 0
+        && s_soak.duplicates == 0 && s_soak.unexpected == 0;
+    printf ("soak: %s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+int main (int argc, char *argv [])
+{
+    s_soak.assets_count = 50000;
+    s_soak.days = 30;
+    s_soak.ttl = 300;
+    s_soak.failures = 0.05;
+    s_soak.churn = 1;
+    s_soak.seed = 1;
+    s_soak.rss_slack = 10;
+
+    int argn;
+    for (argn = 1; argn < argc; argn++) {
+        if (streq (argv [argn], "--help")
+        ||  streq (argv [argn], "-h")) {
+            puts ("outage_soak [options] ...");
+            puts ("  --days / -d count       simulated days [30]");
+            puts ("  --assets / -a count     number of assets [50000]");
+            puts ("  --ttl / -t sec          ttl and report period of assets [300]");
+            puts ("  --failures / -f rate    failures per asset per day [0.05]");
+            puts ("  --churn / -c percent    assets replaced per day [1]");
+            puts ("  --seed / -s number      random seed [1]");
+            puts ("  --rss-slack percent     allowed RSS growth over the first day [10]");
+            puts ("  --help / -h             this information");
+            return 0;
+        }
+        else
+        if ((streq (argv [argn], "--days") || streq (argv [argn], "-d")) && argn + 1 < argc)
+            s_soak.days = (uint64_t) atoll (argv [++argn]);
+        else
+        if ((streq (argv [argn], "--assets") || streq (argv [argn], "-a")) && argn + 1 < argc)
+            s_soak.assets_count = (size_t) atol (argv [++argn]);
+        else
+        if ((streq (argv [argn], "--ttl") || streq (argv [argn], "-t")) && argn + 1 < argc)
+            s_soak.ttl = (uint64_t) atoll (argv [++argn]);
+        else
+        if ((streq (argv [argn], "--failures") || streq (argv [argn], "-f")) && argn + 1 < argc)
+            s_soak.failures = atof (argv [++argn]);
+        else
+        if ((streq (argv [argn], "--churn") || streq (argv [argn], "-c")) && argn + 1 < argc)
+            s_soak.churn = atof (argv [++argn]);
+        else
+        if ((streq (argv [argn], "--seed") || streq (argv [argn], "-s")) && argn + 1 < argc)
+            s_soak.seed = (unsigned int) atol (argv [++argn]);
+        else
+        if (streq (argv [argn], "--rss-slack") && argn + 1 < argc)
+            s_soak.rss_slack = atof (argv [++argn]);
+        else {
+            fprintf (stderr, "Unknown option: %s\n", argv [argn]);
+            return 1;
+        }
+    }
+    if (s_soak.assets_count == 0 || s_soak.days == 0 || s_soak.ttl == 0) {
+        fprintf (stderr, "Invalid number of assets, days or ttl\n");
+        return 1;
+    }
+    ftylog_setInstance ("outage_soak", "");
+    return s_soak_run ();
+}
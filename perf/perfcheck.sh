@@ -0,0 +1,88 @@
+#!/bin/sh
+#   perfcheck.sh - instruction and allocation count regression gate
+#
+#   Runs outage_perf under callgrind, takes inclusive instruction counts
+#   of the key entry points and allocation counts reported by outage_perf
+#   and compares them with the baseline. Fails if any of them grew by more
+#   than PERFCHECK_TOLERANCE percent (default 2), if the baseline is missing
+#   or if it lacks any of them. With --update writes the current counts as
+#   the new baseline instead.
+#
+#   usage: perfcheck.sh [--update] outage_perf baseline
+#   PERFCHECK_RUN is prepended to the valgrind command (libtool wrapper)
+
+set -e
+
+UPDATE=no
+if [ "$1" = "--update" ]; then
+    UPDATE=yes
+    shift
+fi
+PERF="$1"
+BASELINE="$2"
+if [ -z "$PERF" ] || [ -z "$BASELINE" ]; then
+    echo "usage: $0 [--update] outage_perf baseline" >&2
+    exit 2
+fi
+if [ "$UPDATE" != yes ] && [ ! -f "$BASELINE" ]; then
+    echo "FAIL: no baseline $BASELINE, write it by make perfcheck-baseline and commit it" >&2
+    exit 1
+fi
+TOLERANCE="${PERFCHECK_TOLERANCE:-2}"
+ENTRY_POINTS="data_put fty_proto_decode s_osrv_handle_proto data_touch_asset data_get_dead s_osrv_send_alert"
+
+WORKDIR="$(mktemp -d)"
+trap 'rm -rf "$WORKDIR"' EXIT
+
+${PERFCHECK_RUN} valgrind --tool=callgrind --callgrind-out-file="$WORKDIR/callgrind.out" \
+    "$PERF" > "$WORKDIR/allocs.txt" 2> "$WORKDIR/valgrind.log" || {
+    cat "$WORKDIR/valgrind.log" >&2
+    echo "FAIL: outage_perf did not run" >&2
+    exit 1
+}
+callgrind_annotate --inclusive=yes --threshold=100 "$WORKDIR/callgrind.out" > "$WORKDIR/annotate.txt"
+
+# current counts as "metric value" lines
+for ENTRY in $ENTRY_POINTS; do
+    IR="$(sed -n "s/^ *\([0-9,]*\) .*[: ]${ENTRY}\( .*\)\?\$/\1/p" "$WORKDIR/annotate.txt" | head -n 1 | tr -d ,)"
+    if [ -z "$IR" ]; then
+        echo "FAIL: no instruction count of $ENTRY, is outage_perf built with symbols?" >&2
+        exit 1
+    fi
+    echo "ir:$ENTRY $IR"
+done > "$WORKDIR/current.txt"
+sed -n 's/^allocs \([^ ]*\) \([0-9]*\)$/allocs:\1 \2/p' "$WORKDIR/allocs.txt" >> "$WORKDIR/current.txt"
+
+if [ "$UPDATE" = yes ]; then
+    {
+        echo "# perfcheck baseline, regenerate by make perfcheck-baseline"
+        echo "# ir: inclusive instructions (callgrind Ir), allocs: allocations of main thread"
+        cat "$WORKDIR/current.txt"
+    } > "$BASELINE"
+    echo "perfcheck: baseline written to $BASELINE"
+    cat "$WORKDIR/current.txt"
+    exit 0
+fi
+
+RESULT=0
+while read -r METRIC VALUE; do
+    BASE="$(awk -v m="$METRIC" '$1 == m { print $2 }' "$BASELINE")"
+    if [ -z "$BASE" ]; then
+        printf '%-32s %14s %14s  MISSING\n' "$METRIC" "-" "$VALUE"
+        RESULT=1
+        continue
+    fi
+    STATUS="$(awk -v b="$BASE" -v v="$VALUE" -v t="$TOLERANCE" 'BEGIN {
+        if (v > b * (1 + t / 100)) print "REGRESSED"; else if (v < b * (1 - t / 100)) print "IMPROVED"; else print "OK" }')"
+    printf '%-32s %14s %14s  %s\n' "$METRIC" "$BASE" "$VALUE" "$STATUS"
+    if [ "$STATUS" = REGRESSED ]; then
+        RESULT=1
+    fi
+done < "$WORKDIR/current.txt"
+
+if [ "$RESULT" != 0 ]; then
+    echo "FAIL: perfcheck, counts grew by more than ${TOLERANCE}% over $BASELINE or are missing in it" >&2
+else
+    echo "PASS: perfcheck"
+fi
+exit $RESULT
@@ -0,0 +1,666 @@
+/*  =========================================================================
+    alert_publisher - Asynchronous alert publisher
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    alert_publisher - Asynchronous alert publisher
+@discuss
+    Alerts are handed over to this actor through its pipe and stored in
+    a bounded ring. The actor publishes them with its own malamute client,
+    so a slow broker never stalls metric processing in fty_outage_server.
+    The pipe holds as many messages as the ring, so a burst waits in it
+    till the actor moves it to the ring, where the drop policy applies.
+    While the client is not connected, messages stay at the head of the
+    queue and sending is retried with exponential backoff. When the queue
+    is full, refresh messages are dropped first (the next refresh re-sends
+    them), then the configured policy decides whether the oldest or the
+    incoming state change is lost.
+@end
+*/
+
+#include "fty_outage_classes.h"
+
+#define DEFAULT_QUEUE_SIZE 10000    // messages
+#define RETRY_MIN_MS 100            // first retry after failed send
+#define RETRY_MAX_MS 5000           // maximal delay between retries
+#define FLUSH_BATCH 100             // max messages sent before pipe is checked again
+
+typedef struct _publisher_item_t {
+    char *subject;
+    zmsg_t *msg;
+    size_t bytes;                   // estimated heap memory of subject and message
+    bool refresh;                   // message only repeats already published state
+} publisher_item_t;
+
+typedef struct _publisher_ring_t {
+    publisher_item_t *items;
+    size_t capacity;
+    size_t head;                    // index of the oldest item
+    size_t size;
+    size_t bytes;                   // estimated heap memory of queued items
+    bool drop_newest;               // policy when full and no refresh can be dropped
+} publisher_ring_t;
+
+typedef struct _publisher_stats_t {
+    uint64_t enqueued;
+    uint64_t sent;
+    uint64_t dropped;
+    uint64_t retries;
+    size_t max_depth;
+} publisher_stats_t;
+
+typedef struct _publisher_t {
+    mlm_client_t *client;
+    publisher_ring_t ring;
+    publisher_stats_t stats;
+    alert_publisher_counters_t *counters; // shared with the owner, NULL if not
+    uint64_t retry_ms;              // current backoff, 0 if last send succeeded
+    uint64_t next_attempt_ms;       // [ms] monotonic time of the next send attempt
+} publisher_t;
+
+static void
+s_item_clear (publisher_item_t *item)
+{
+    zstr_free (&item->subject);
+    zmsg_destroy (&item->msg);
+    item->bytes = 0;
+    item->refresh = false;
+}
+
+static int
+s_ring_init (publisher_ring_t *ring, size_t capacity)
+{
+    assert (ring);
+    assert (capacity > 0);
+    ring->items = (publisher_item_t *) zmalloc (capacity * sizeof (publisher_item_t));
+    if (!ring->items)
+        return -1;
+    ring->capacity = capacity;
+    ring->head = 0;
+    ring->size = 0;
+    return 0;
+}
+
+static void
+s_ring_clear (publisher_ring_t *ring)
+{
+    assert (ring);
+    for (size_t i = 0; i != ring->size; i++)
+        s_item_clear (&ring->items [(ring->head + i) % ring->capacity]);
+    free (ring->items);
+    ring->items = NULL;
+    ring->size = 0;
+    ring->bytes = 0;
+}
+
+static publisher_item_t *
+s_ring_at (publisher_ring_t *ring, size_t i)
+{
+    return &ring->items [(ring->head + i) % ring->capacity];
+}
+
+// remove item on position i (counted from the head), keeping the order of others
+static void
+s_ring_remove (publisher_ring_t *ring, size_t i)
+{
+    assert (i < ring->size);
+    ring->bytes -= s_ring_at (ring, i)->bytes;
+    s_item_clear (s_ring_at (ring, i));
+    for (size_t j = i; j + 1 < ring->size; j++)
+        *s_ring_at (ring, j) = *s_ring_at (ring, j + 1);
+    memset (s_ring_at (ring, ring->size - 1), 0, sizeof (publisher_item_t));
+    ring->size--;
+}
+
+// put message to the tail of the ring, applying the drop policy
+// return number of dropped messages (0 or 1)
+static int
+s_ring_push (publisher_ring_t *ring, char **subject_p, bool refresh, zmsg_t **msg_p)
+{
+    assert (ring);
+    assert (subject_p && *subject_p);
+    assert (msg_p && *msg_p);
+
+    int dropped = 0;
+    if (ring->size == ring->capacity) {
+        dropped = 1;
+        size_t victim = ring->size;
+        for (size_t i = 0; i != ring->size; i++) {
+            if (s_ring_at (ring, i)->refresh) {
+                victim = i;
+                break;
+            }
+        }
+        if (victim == ring->size && (refresh || ring->drop_newest)) {
+            zstr_free (subject_p);
+            zmsg_destroy (msg_p);
+            return dropped;
+        }
+        s_ring_remove (ring, victim == ring->size ? 0 : victim);
+    }
+    publisher_item_t *item = s_ring_at (ring, ring->size);
+    item->subject = *subject_p;
+    item->msg = *msg_p;
+    item->bytes = memory_usage_string (item->subject) + zmsg_content_size (item->msg);
+    item->refresh = refresh;
+    *subject_p = NULL;
+    *msg_p = NULL;
+    ring->size++;
+    ring->bytes += item->bytes;
+    return dropped;
+}
+
+// drop the oldest item
+static void
+s_ring_pop (publisher_ring_t *ring)
+{
+    assert (ring->size > 0);
+    ring->bytes -= s_ring_at (ring, 0)->bytes;
+    s_item_clear (s_ring_at (ring, 0));
+    ring->head = (ring->head + 1) % ring->capacity;
+    ring->size--;
+}
+
+// change the capacity, oldest messages which do not fit are dropped
+static size_t
+s_ring_resize (publisher_ring_t *ring, size_t capacity)
+{
+    assert (capacity > 0);
+    size_t dropped = 0;
+    while (ring->size > capacity) {
+        s_ring_pop (ring);
+        dropped++;
+    }
+    publisher_item_t *items = (publisher_item_t *) zmalloc (capacity * sizeof (publisher_item_t));
+    assert (items);
+    for (size_t i = 0; i != ring->size; i++)
+        items [i] = *s_ring_at (ring, i);
+    free (ring->items);
+    ring->items = items;
+    ring->capacity = capacity;
+    ring->head = 0;
+    return dropped;
+}
+
+static void
+s_publisher_destroy (publisher_t **self_p)
+{
+    assert (self_p);
+    if (*self_p) {
+        publisher_t *self = *self_p;
+        s_ring_clear (&self->ring);
+        mlm_client_destroy (&self->client);
+        free (self);
+        *self_p = NULL;
+    }
+}
+
+static publisher_t *
+s_publisher_new (alert_publisher_counters_t *counters)
+{
+    publisher_t *self = (publisher_t *) zmalloc (sizeof (publisher_t));
+    if (self) {
+        self->counters = counters;
+        self->client = mlm_client_new ();
+        if (!self->client || s_ring_init (&self->ring, DEFAULT_QUEUE_SIZE) != 0)
+            s_publisher_destroy (&self);
+    }
+    return self;
+}
+
+// send messages from the head of the queue, they stay in the ring and are
+// retried with backoff while the client is not connected
+static void
+s_publisher_flush (publisher_t *self)
+{
+    assert (self);
+
+    if (self->ring.size == 0 || zclock_mono () < (int64_t) self->next_attempt_ms)
+        return;
+
+    for (int i = 0; i != FLUSH_BATCH && self->ring.size > 0; i++) {
+        publisher_item_t *item = s_ring_at (&self->ring, 0);
+        if (!mlm_client_connected (self->client)) {
+            self->retry_ms = self->retry_ms ? self->retry_ms * 2 : RETRY_MIN_MS;
+            if (self->retry_ms > RETRY_MAX_MS)
+                self->retry_ms = RETRY_MAX_MS;
+            self->next_attempt_ms = zclock_mono () + self->retry_ms;
+            self->stats.retries++;
+            log_warning ("Cannot publish '%s', %zu messages queued, retry in %" PRIu64 "ms",
+                item->subject, self->ring.size, self->retry_ms);
+            return;
+        }
+        self->retry_ms = 0;
+        // client takes ownership of the message, even if it fails
+        if (mlm_client_send (self->client, item->subject, &item->msg) == 0)
+            self->stats.sent++;
+        else {
+            log_error ("Cannot publish '%s', message dropped", item->subject);
+            self->stats.dropped++;
+        }
+        s_ring_pop (&self->ring);
+    }
+}
+
+// estimated heap memory of the queue
+static size_t
+s_publisher_memory (publisher_t *self)
+{
+    return memory_usage_block (self->ring.capacity * sizeof (publisher_item_t)) + self->ring.bytes;
+}
+
+// update counters shared with the owner, each is read on its own
+static void
+s_publisher_export (publisher_t *self)
+{
+    alert_publisher_counters_t *counters = self->counters;
+    if (!counters)
+        return;
+    __atomic_store_n (&counters->depth, (uint64_t) self->ring.size, __ATOMIC_RELAXED);
+    __atomic_store_n (&counters->max_depth, (uint64_t) self->stats.max_depth, __ATOMIC_RELAXED);
+    __atomic_store_n (&counters->capacity, (uint64_t) self->ring.capacity, __ATOMIC_RELAXED);
+    __atomic_store_n (&counters->enqueued, self->stats.enqueued, __ATOMIC_RELAXED);
+    __atomic_store_n (&counters->sent, self->stats.sent, __ATOMIC_RELAXED);
+    __atomic_store_n (&counters->dropped, self->stats.dropped, __ATOMIC_RELAXED);
+    __atomic_store_n (&counters->retries, self->stats.retries, __ATOMIC_RELAXED);
+    __atomic_store_n (&counters->memory, (uint64_t) s_publisher_memory (self), __ATOMIC_RELAXED);
+}
+
+static void
+s_publisher_stats_send (publisher_t *self, zsock_t *pipe, const char *sequence)
+{
+    zmsg_t *reply = zmsg_new ();
+    zmsg_addstr (reply, "STATS");
+    zmsg_addstr (reply, sequence ? sequence : "0");
+    zmsg_addstr (reply, "publish-queue-depth");
+    zmsg_addstrf (reply, "%zu", self->ring.size);
+    zmsg_addstr (reply, "publish-queue-max-depth");
+    zmsg_addstrf (reply, "%zu", self->stats.max_depth);
+    zmsg_addstr (reply, "publish-queue-capacity");
+    zmsg_addstrf (reply, "%zu", self->ring.capacity);
+    zmsg_addstr (reply, "publish-enqueued");
+    zmsg_addstrf (reply, "%" PRIu64, self->stats.enqueued);
+    zmsg_addstr (reply, "publish-sent");
+    zmsg_addstrf (reply, "%" PRIu64, self->stats.sent);
+    zmsg_addstr (reply, "publish-dropped");
+    zmsg_addstrf (reply, "%" PRIu64, self->stats.dropped);
+    zmsg_addstr (reply, "publish-retries");
+    zmsg_addstrf (reply, "%" PRIu64, self->stats.retries);
+    zmsg_addstr (reply, "memory-publish-queue");
+    zmsg_addstrf (reply, "%zu", s_publisher_memory (self));
+    zmsg_send (&reply, pipe);
+}
+
+/*
+ * return values :
+ * 1 - $TERM recieved
+ * 0 - message processed and deleted
+ */
+static int
+s_publisher_command (publisher_t *self, zsock_t *pipe, zmsg_t **message_p)
+{
+    zmsg_t *message = *message_p;
+    char *command = zmsg_popstr (message);
+    if (!command) {
+        zmsg_destroy (message_p);
+        return 0;
+    }
+
+    int ret = 0;
+    if (streq (command, "$TERM"))
+        ret = 1;
+    else
+    if (streq (command, "PUBLISH")) {
+        char *subject = zmsg_popstr (message);
+        char *kind = zmsg_popstr (message);
+        if (subject && kind && zmsg_size (message) > 0) {
+            self->stats.enqueued++;
+            self->stats.dropped += s_ring_push (&self->ring, &subject, streq (kind, "REFRESH"), message_p);
+            if (self->ring.size > self->stats.max_depth)
+                self->stats.max_depth = self->ring.size;
+        }
+        zstr_free (&subject);
+        zstr_free (&kind);
+    }
+    else
+    if (streq (command, "CONNECT")) {
+        char *endpoint = zmsg_popstr (message);
+        char *name = zmsg_popstr (message);
+        if (endpoint && name) {
+            log_debug ("alert_publisher: CONNECT: %s/%s", endpoint, name);
+            if (mlm_client_connect (self->client, endpoint, 1000, name) == -1)
+                log_error ("alert_publisher: mlm_client_connect failed");
+        }
+        zstr_free (&endpoint);
+        zstr_free (&name);
+    }
+    else
+    if (streq (command, "PRODUCER")) {
+        char *stream = zmsg_popstr (message);
+        if (stream) {
+            log_debug ("alert_publisher: PRODUCER: %s", stream);
+            if (mlm_client_set_producer (self->client, stream) == -1)
+                log_error ("alert_publisher: mlm_client_set_producer failed");
+        }
+        zstr_free (&stream);
+    }
+    else
+    if (streq (command, "QUEUE")) {
+        char *size = zmsg_popstr (message);
+        char *policy = zmsg_popstr (message);
+        if (size && atol (size) > 0) {
+            self->stats.dropped += s_ring_resize (&self->ring, (size_t) atol (size));
+            zsock_set_rcvhwm (pipe, (int) self->ring.capacity);
+        }
+        if (policy)
+            self->ring.drop_newest = streq (policy, "newest");
+        log_debug ("alert_publisher: QUEUE: %zu/%s", self->ring.capacity, self->ring.drop_newest ? "newest" : "oldest");
+        zstr_free (&size);
+        zstr_free (&policy);
+    }
+    else
+    if (streq (command, "STATS")) {
+        char *sequence = zmsg_popstr (message);
+        s_publisher_stats_send (self, pipe, sequence);
+        zstr_free (&sequence);
+    }
+    else
+        log_error ("alert_publisher: Unknown actor command: %s", command);
+
+    zstr_free (&command);
+    zmsg_destroy (message_p);
+    return ret;
+}
+
+// --------------------------------------------------------------------------
+// alert_publisher actor
+void
+alert_publisher (zsock_t *pipe, void *args)
+{
+    publisher_t *self = s_publisher_new ((alert_publisher_counters_t *) args);
+    assert (self);
+    s_publisher_export (self);
+
+    zpoller_t *poller = zpoller_new (pipe, NULL);
+    assert (poller);
+    // burst waits in the pipe rather than being refused by it
+    zsock_set_rcvhwm (pipe, (int) self->ring.capacity);
+
+    zsock_signal (pipe, 0);
+    log_info ("alert_publisher: Started");
+
+    while (!zsys_interrupted)
+    {
+        int timeout = -1;
+        if (self->ring.size > 0) {
+            int64_t now_ms = zclock_mono ();
+            timeout = now_ms < (int64_t) self->next_attempt_ms ? (int) (self->next_attempt_ms - now_ms) : 0;
+        }
+
+        void *which = zpoller_wait (poller, timeout);
+        if (which == pipe) {
+            zmsg_t *msg = zmsg_recv (pipe);
+            if (!msg)
+                break;
+            if (s_publisher_command (self, pipe, &msg) == 1)
+                break;
+        }
+        else
+        if (zpoller_terminated (poller))
+            break;
+
+        s_publisher_flush (self);
+        s_publisher_export (self);
+    }
+
+    if (self->ring.size > 0)
+        log_warning ("alert_publisher: %zu messages not published", self->ring.size);
+    zpoller_destroy (&poller);
+    s_publisher_destroy (&self);
+    log_info ("alert_publisher: Ended");
+}
+
+// --------------------------------------------------------------------------
+// Create alert_publisher actor, sends to its pipe never block
+zactor_t *
+alert_publisher_new (alert_publisher_counters_t *counters)
+{
+    zactor_t *self = zactor_new (alert_publisher, counters);
+    // pipe holds a full queue, once it is full anyway the publisher is
+    // hopelessly behind
+    if (self) {
+        zsock_set_sndhwm (self, DEFAULT_QUEUE_SIZE);
+        zsock_set_sndtimeo (self, 0);
+    }
+    return self;
+}
+
+// --------------------------------------------------------------------------
+// Read counters updated by the actor into the copy
+void
+alert_publisher_counters (alert_publisher_counters_t *counters, alert_publisher_counters_t *copy)
+{
+    assert (counters);
+    assert (copy);
+    copy->depth = __atomic_load_n (&counters->depth, __ATOMIC_RELAXED);
+    copy->max_depth = __atomic_load_n (&counters->max_depth, __ATOMIC_RELAXED);
+    copy->capacity = __atomic_load_n (&counters->capacity, __ATOMIC_RELAXED);
+    copy->enqueued = __atomic_load_n (&counters->enqueued, __ATOMIC_RELAXED);
+    copy->sent = __atomic_load_n (&counters->sent, __ATOMIC_RELAXED);
+    copy->dropped = __atomic_load_n (&counters->dropped, __ATOMIC_RELAXED);
+    copy->retries = __atomic_load_n (&counters->retries, __ATOMIC_RELAXED);
+    copy->memory = __atomic_load_n (&counters->memory, __ATOMIC_RELAXED);
+}
+
+// --------------------------------------------------------------------------
+// Enqueue message for publishing without blocking the caller
+int
+alert_publisher_send (zactor_t *self, const char *subject, bool refresh, zmsg_t **msg_p)
+{
+    assert (self);
+    assert (subject);
+    assert (msg_p);
+
+    zmsg_t *msg = *msg_p;
+    *msg_p = NULL;
+    if (!msg)
+        return -1;
+    zmsg_pushstr (msg, refresh ? "REFRESH" : "STATE");
+    zmsg_pushstr (msg, subject);
+    zmsg_pushstr (msg, "PUBLISH");
+    int rv = zmsg_send (&msg, self);
+    zmsg_destroy (&msg);
+    return rv;
+}
+
+// --------------------------------------------------------------------------
+// Self test of this class
+
+static uint64_t
+s_stats_get (zactor_t *self, const char *key)
+{
+    zstr_sendx (self, "STATS", NULL);
+    zmsg_t *msg = zmsg_recv (self);
+    assert (msg);
+    uint64_t ret = UINT64_MAX;
+    char *name = zmsg_popstr (msg);
+    assert (name && streq (name, "STATS"));
+    zstr_free (&name);
+    name = zmsg_popstr (msg);
+    assert (name && streq (name, "0"));
+    zstr_free (&name);
+    for (name = zmsg_popstr (msg); name; name = zmsg_popstr (msg)) {
+        char *value = zmsg_popstr (msg);
+        if (value && streq (name, key))
+            ret = (uint64_t) atoll (value);
+        zstr_free (&name);
+        zstr_free (&value);
+    }
+    zmsg_destroy (&msg);
+    return ret;
+}
+
+void
+alert_publisher_test (bool verbose)
+{
+    printf (" * alert_publisher: ");
+
+    //  @selftest
+    // ring drop policy
+    publisher_ring_t ring;
+    memset (&ring, 0, sizeof (ring));
+    assert (s_ring_init (&ring, 3) == 0);
+    const char *kinds [] = {"STATE", "REFRESH", "STATE"};
+    for (int i = 0; i != 3; i++) {
+        char *subject = zsys_sprintf ("%s-%d", kinds [i], i);
+        zmsg_t *msg = zmsg_new ();
+        zmsg_addstr (msg, "payload");
+        assert (s_ring_push (&ring, &subject, streq (kinds [i], "REFRESH"), &msg) == 0);
+        assert (!subject && !msg);
+    }
+    assert (ring.size == 3);
+
+    // full: refresh is dropped to make room for state change
+    char *subject = strdup ("STATE-3");
+    zmsg_t *msg = zmsg_new ();
+    zmsg_addstr (msg, "payload");
+    assert (s_ring_push (&ring, &subject, false, &msg) == 1);
+    assert (ring.size == 3);
+    assert (streq (s_ring_at (&ring, 0)->subject, "STATE-0"));
+    assert (streq (s_ring_at (&ring, 1)->subject, "STATE-2"));
+    assert (streq (s_ring_at (&ring, 2)->subject, "STATE-3"));
+
+    // full of state changes: incoming refresh is dropped
+    subject = strdup ("REFRESH-4");
+    msg = zmsg_new ();
+    zmsg_addstr (msg, "payload");
+    assert (s_ring_push (&ring, &subject, true, &msg) == 1);
+    assert (!subject && !msg);
+    assert (streq (s_ring_at (&ring, 2)->subject, "STATE-3"));
+
+    // policy oldest: the oldest state change is dropped
+    subject = strdup ("STATE-5");
+    msg = zmsg_new ();
+    zmsg_addstr (msg, "payload");
+    assert (s_ring_push (&ring, &subject, false, &msg) == 1);
+    assert (streq (s_ring_at (&ring, 0)->subject, "STATE-2"));
+    assert (streq (s_ring_at (&ring, 2)->subject, "STATE-5"));
+
+    // policy newest: the incoming state change is dropped
+    ring.drop_newest = true;
+    subject = strdup ("STATE-6");
+    msg = zmsg_new ();
+    zmsg_addstr (msg, "payload");
+    assert (s_ring_push (&ring, &subject, false, &msg) == 1);
+    assert (streq (s_ring_at (&ring, 2)->subject, "STATE-5"));
+
+    assert (s_ring_resize (&ring, 2) == 1);
+    assert (ring.size == 2 && ring.capacity == 2);
+    assert (streq (s_ring_at (&ring, 0)->subject, "STATE-3"));
+    s_ring_clear (&ring);
+
+    // messages are queued until the publisher is connected, then delivered
+    static const char *endpoint = "inproc://alert-publisher-test";
+    zactor_t *server = zactor_new (mlm_server, (void*) "Malamute");
+    zstr_sendx (server, "BIND", endpoint, NULL);
+
+    mlm_client_t *consumer = mlm_client_new ();
+    int rv = mlm_client_connect (consumer, endpoint, 5000, "publisher-consumer");
+    assert (rv >= 0);
+    rv = mlm_client_set_consumer (consumer, "_ALERTS_SYS", ".*");
+    assert (rv >= 0);
+
+    alert_publisher_counters_t counters;
+    memset (&counters, 0, sizeof (counters));
+    zactor_t *self = alert_publisher_new (&counters);
+    assert (self);
+    zstr_sendx (self, "QUEUE", "100", "oldest", NULL);
+
+    for (int i = 0; i != 10; i++) {
+        msg = zmsg_new ();
+        zmsg_addstrf (msg, "alert-%d", i);
+        assert (alert_publisher_send (self, "outage/CRITICAL@ups", false, &msg) == 0);
+        assert (!msg);
+    }
+    assert (s_stats_get (self, "publish-queue-depth") == 10);
+    assert (s_stats_get (self, "publish-sent") == 0);
+    assert (s_stats_get (self, "publish-retries") >= 1);
+
+    zstr_sendx (self, "CONNECT", endpoint, "alert-publisher", NULL);
+    zstr_sendx (self, "PRODUCER", "_ALERTS_SYS", NULL);
+
+    for (int i = 0; i != 10; i++) {
+        msg = mlm_client_recv (consumer);
+        assert (msg);
+        assert (streq (mlm_client_subject (consumer), "outage/CRITICAL@ups"));
+        char *payload = zmsg_popstr (msg);
+        char *expected = zsys_sprintf ("alert-%d", i);
+        assert (streq (payload, expected));
+        zstr_free (&payload);
+        zstr_free (&expected);
+        zmsg_destroy (&msg);
+    }
+    assert (s_stats_get (self, "publish-queue-depth") == 0);
+    assert (s_stats_get (self, "publish-sent") == 10);
+    assert (s_stats_get (self, "publish-enqueued") == 10);
+    assert (s_stats_get (self, "publish-dropped") == 0);
+    assert (s_stats_get (self, "publish-queue-max-depth") == 10);
+    // counters were exported by the loops which sent the messages
+    alert_publisher_counters_t copy;
+    alert_publisher_counters (&counters, &copy);
+    assert (copy.sent == 10 && copy.enqueued == 10 && copy.depth == 0);
+    assert (copy.capacity == 100);
+    assert (copy.memory >= 100 * sizeof (publisher_item_t));
+
+    // sequence of the request is echoed, so a late reply can be told apart
+    zstr_sendx (self, "STATS", "42", NULL);
+    msg = zmsg_recv (self);
+    assert (msg);
+    char *name = zmsg_popstr (msg);
+    assert (name && streq (name, "STATS"));
+    zstr_free (&name);
+    name = zmsg_popstr (msg);
+    assert (name && streq (name, "42"));
+    zstr_free (&name);
+    zmsg_destroy (&msg);
+
+    zactor_destroy (&self);
+
+    // burst of a full queue is not refused by the pipe, the ring policy
+    // decides what is dropped
+    self = alert_publisher_new (NULL);
+    assert (self);
+    zstr_sendx (self, "QUEUE", "100", "oldest", NULL);
+    for (int i = 0; i != DEFAULT_QUEUE_SIZE; i++) {
+        msg = zmsg_new ();
+        zmsg_addstrf (msg, "alert-%d", i);
+        assert (alert_publisher_send (self, "outage/CRITICAL@ups", false, &msg) == 0);
+    }
+    assert (s_stats_get (self, "publish-enqueued") == DEFAULT_QUEUE_SIZE);
+    assert (s_stats_get (self, "publish-dropped") == DEFAULT_QUEUE_SIZE - 100);
+    assert (s_stats_get (self, "publish-queue-depth") == 100);
+    zactor_destroy (&self);
+
+    mlm_client_destroy (&consumer);
+    zactor_destroy (&server);
+    //  @end
+    printf ("OK\n");
+}
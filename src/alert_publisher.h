@@ -0,0 +1,85 @@
+/*  =========================================================================
+    alert_publisher - Asynchronous alert publisher
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef ALERT_PUBLISHER_H_INCLUDED
+#define ALERT_PUBLISHER_H_INCLUDED
+
+#include "../include/fty_outage.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  Counters of the publisher, updated by its thread with relaxed atomics,
+//  so the owner reads them by alert_publisher_counters without a request
+typedef struct _alert_publisher_counters_t {
+    uint64_t depth;             //  messages queued
+    uint64_t max_depth;         //  most messages queued
+    uint64_t capacity;          //  capacity of the queue
+    uint64_t enqueued;          //  messages accepted from the pipe
+    uint64_t sent;              //  messages published
+    uint64_t dropped;           //  messages dropped by the policy or the client
+    uint64_t retries;           //  attempts while not connected
+    uint64_t memory;            //  [B] estimated heap memory of the queue
+} alert_publisher_counters_t;
+
+//  @interface
+//  alert_publisher actor, owns its own malamute client and a bounded queue
+//  of messages to be published, args are alert_publisher_counters_t to be
+//  updated or NULL
+//
+//  Commands:
+//      CONNECT/endpoint/address    - connect to malamute
+//      PRODUCER/stream             - set the stream to publish on
+//      QUEUE/size/policy           - queue capacity and drop policy ("oldest" or "newest")
+//      PUBLISH/subject/kind/msg... - enqueue message, kind is "STATE" or "REFRESH"
+//      STATS[/sequence]            - reply with STATS/sequence/name/value/...,
+//                                    queue depth, counters and memory-publish-queue
+//                                    bytes, sequence is echoed ("0" if not given)
+FTY_OUTAGE_EXPORT void
+    alert_publisher (zsock_t *pipe, void *args);
+
+//  Create alert_publisher actor, sends to its pipe never block. Counters,
+//  if not NULL, are updated by the actor and must outlive it.
+FTY_OUTAGE_EXPORT zactor_t *
+    alert_publisher_new (alert_publisher_counters_t *counters);
+
+//  Read counters updated by the actor into the copy
+FTY_OUTAGE_EXPORT void
+    alert_publisher_counters (alert_publisher_counters_t *counters, alert_publisher_counters_t *copy);
+
+//  Enqueue message for publishing without blocking the caller
+//  refresh messages are dropped first when the queue is full
+//  return -1 if the publisher can't accept the message (it is destroyed)
+FTY_OUTAGE_EXPORT int
+    alert_publisher_send (zactor_t *self, const char *subject, bool refresh, zmsg_t **msg_p);
+
+//  Self test of this class
+FTY_OUTAGE_EXPORT void
+    alert_publisher_test (bool verbose);
+
+//  @end
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,337 @@
+/*  =========================================================================
+    alert_refresh - Staggered refresh of active alerts
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    alert_refresh - Staggered refresh of active alerts
+@discuss
+    Active alerts must be re-published before their TTL lapses. Sending all
+    of them at once would flood the bus, so the refresh period is split into
+    slots (a timing wheel) and every key lives in exactly one slot. Keys are
+    placed into the least loaded slot, so each tick sends roughly
+    size / slots messages.
+@end
+*/
+
+#include "fty_outage_classes.h"
+
+typedef struct _refresh_item_t {
+    asset_key_t *key;           // owned copy, key in items
+    size_t slot;                // index of slot the key lives in
+    void *handle;               // handle in the slot list
+} refresh_item_t;
+
+static void
+refresh_item_destroy (refresh_item_t **self_p)
+{
+    assert (self_p);
+    if (*self_p) {
+        refresh_item_t *self = *self_p;
+        asset_key_destroy (&self->key);
+        free (self);
+        *self_p = NULL;
+    }
+}
+
+//  Structure of our class
+struct _alert_refresh_t {
+    uint64_t period_ms;         // [ms] each key is returned once per period
+    size_t slots_count;         // number of slots in the period
+    zlistx_t **slots;           // slot => list of refresh_item_t (references)
+    zhashx_t *items;            // asset_key => refresh_item_t (owner)
+    size_t cursor;              // slot to be returned next
+    uint64_t cursor_ms;         // [ms] time when cursor slot becomes due
+};
+
+static uint64_t
+s_slot_width (alert_refresh_t *self)
+{
+    uint64_t width = self->period_ms / self->slots_count;
+    return width > 0 ? width : 1;
+}
+
+//  --------------------------------------------------------------------------
+//  Destroy the refresh scheduler
+void
+alert_refresh_destroy (alert_refresh_t **self_p)
+{
+    assert (self_p);
+    if (*self_p) {
+        alert_refresh_t *self = *self_p;
+        if (self->slots) {
+            for (size_t i = 0; i != self->slots_count; i++)
+                zlistx_destroy (&self->slots [i]);
+            free (self->slots);
+        }
+        zhashx_destroy (&self->items);
+        free (self);
+        *self_p = NULL;
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Create a new refresh scheduler
+alert_refresh_t *
+alert_refresh_new (uint64_t period_ms, size_t slots, uint64_t now_ms)
+{
+    assert (slots > 0);
+    alert_refresh_t *self = (alert_refresh_t *) zmalloc (sizeof (alert_refresh_t));
+    if (self) {
+        self->period_ms = period_ms;
+        self->slots_count = slots;
+        self->slots = (zlistx_t **) zmalloc (slots * sizeof (zlistx_t *));
+        if (!self->slots) {
+            alert_refresh_destroy (&self);
+            return NULL;
+        }
+        for (size_t i = 0; i != slots; i++) {
+            self->slots [i] = zlistx_new ();
+            if (!self->slots [i]) {
+                alert_refresh_destroy (&self);
+                return NULL;
+            }
+        }
+        self->items = asset_key_hash_new (false);
+        if (!self->items) {
+            alert_refresh_destroy (&self);
+            return NULL;
+        }
+        zhashx_set_destructor (self->items, (zhashx_destructor_fn *) refresh_item_destroy);
+        self->cursor = 0;
+        self->cursor_ms = now_ms + s_slot_width (self);
+    }
+    return self;
+}
+
+//  --------------------------------------------------------------------------
+//  Change the refresh period
+void
+alert_refresh_set_period (alert_refresh_t *self, uint64_t period_ms)
+{
+    assert (self);
+    self->period_ms = period_ms;
+}
+
+//  --------------------------------------------------------------------------
+//  Return the refresh period
+uint64_t
+alert_refresh_period (alert_refresh_t *self)
+{
+    assert (self);
+    return self->period_ms;
+}
+
+//  --------------------------------------------------------------------------
+//  Schedule key for periodic refresh
+int
+alert_refresh_insert (alert_refresh_t *self, const asset_key_t *key)
+{
+    assert (self);
+    assert (key);
+
+    if (zhashx_lookup (self->items, key))
+        return -1;
+
+    // least loaded slot, starting from the one which is due next
+    size_t slot = self->cursor;
+    for (size_t i = 1; i != self->slots_count; i++) {
+        size_t candidate = (self->cursor + i) % self->slots_count;
+        if (zlistx_size (self->slots [candidate]) < zlistx_size (self->slots [slot]))
+            slot = candidate;
+    }
+
+    refresh_item_t *item = (refresh_item_t *) zmalloc (sizeof (refresh_item_t));
+    assert (item);
+    item->key = asset_key_dup (key);
+    assert (item->key);
+    item->slot = slot;
+    item->handle = zlistx_add_end (self->slots [slot], item);
+    assert (item->handle);
+    zhashx_insert (self->items, item->key, item);
+    return 0;
+}
+
+//  --------------------------------------------------------------------------
+//  Stop refreshing the key
+void
+alert_refresh_remove (alert_refresh_t *self, const asset_key_t *key)
+{
+    assert (self);
+    assert (key);
+
+    refresh_item_t *item = (refresh_item_t *) zhashx_lookup (self->items, key);
+    if (!item)
+        return;
+    zlistx_detach (self->slots [item->slot], item->handle);
+    zhashx_delete (self->items, key);
+}
+
+//  --------------------------------------------------------------------------
+//  Return number of scheduled keys
+size_t
+alert_refresh_size (alert_refresh_t *self)
+{
+    assert (self);
+    return zhashx_size (self->items);
+}
+
+//  --------------------------------------------------------------------------
+//  Return estimated heap memory held by the scheduler, in bytes
+size_t
+alert_refresh_memory (alert_refresh_t *self)
+{
+    assert (self);
+    size_t items = zhashx_size (self->items);
+    // each item is in the hash and in one slot list (node: next, prev, item, tag)
+    size_t bytes = memory_usage_block (sizeof (alert_refresh_t))
+        + memory_usage_block (self->slots_count * sizeof (zlistx_t *))
+        + memory_usage_hash (items)
+        + items * (memory_usage_block (sizeof (refresh_item_t)) + memory_usage_block (4 * sizeof (void *)));
+    for (refresh_item_t *item = (refresh_item_t *) zhashx_first (self->items);
+                         item != NULL;
+                         item = (refresh_item_t *) zhashx_next (self->items))
+        bytes += memory_usage_block (sizeof (asset_key_t) + item->key->length + 1);
+    return bytes;
+}
+
+//  --------------------------------------------------------------------------
+//  Append keys from all slots which became due till now_ms to 'due'
+size_t
+alert_refresh_due (alert_refresh_t *self, uint64_t now_ms, zlistx_t *due)
+{
+    assert (self);
+    assert (due);
+
+    size_t count = 0;
+    // never return a key twice in one call, even after a long pause
+    for (size_t processed = 0;
+                self->cursor_ms <= now_ms && processed != self->slots_count;
+                processed++)
+    {
+        zlistx_t *slot = self->slots [self->cursor];
+        for (refresh_item_t *item = (refresh_item_t *) zlistx_first (slot);
+                             item != NULL;
+                             item = (refresh_item_t *) zlistx_next (slot))
+        {
+            zlistx_add_end (due, item->key);
+            count++;
+        }
+        self->cursor = (self->cursor + 1) % self->slots_count;
+        self->cursor_ms += s_slot_width (self);
+    }
+    // we are more than one period behind, restart the wheel from now
+    if (self->cursor_ms <= now_ms)
+        self->cursor_ms = now_ms + s_slot_width (self);
+    return count;
+}
+
+//  --------------------------------------------------------------------------
+//  Return time [ms] when the next slot becomes due
+uint64_t
+alert_refresh_next_ms (alert_refresh_t *self)
+{
+    assert (self);
+    return self->cursor_ms;
+}
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+void
+alert_refresh_test (bool verbose)
+{
+    printf (" * alert_refresh: ");
+
+    //  @selftest
+    // 10 slots of 100ms each
+    alert_refresh_t *self = alert_refresh_new (1000, 10, 0);
+    assert (self);
+    assert (alert_refresh_period (self) == 1000);
+
+    char name [32];
+    asset_key_t key;
+    for (int i = 0; i != 1000; i++) {
+        snprintf (name, sizeof (name), "ups-%d", i);
+        asset_key_init (&key, name);
+        assert (alert_refresh_insert (self, &key) == 0);
+    }
+    asset_key_init (&key, "ups-0");
+    assert (alert_refresh_insert (self, &key) == -1);
+    assert (alert_refresh_size (self) == 1000);
+    assert (alert_refresh_memory (self) > 1000 * memory_usage_block (sizeof (refresh_item_t)));
+
+    // nothing is due before the first slot
+    zlistx_t *due = zlistx_new ();
+    assert (alert_refresh_due (self, 99, due) == 0);
+    assert (alert_refresh_next_ms (self) == 100);
+
+    // keys are spread uniformly over the period
+    for (uint64_t now_ms = 100; now_ms <= 1000; now_ms += 100) {
+        zlistx_purge (due);
+        assert (alert_refresh_due (self, now_ms, due) == 100);
+    }
+
+    // whole period returns every key exactly once
+    zlistx_purge (due);
+    assert (alert_refresh_due (self, 2000, due) == 1000);
+    zhashx_t *seen = asset_key_hash_new (false);
+    for (asset_key_t *it = (asset_key_t *) zlistx_first (due);
+                      it != NULL;
+                      it = (asset_key_t *) zlistx_next (due))
+    {
+        assert (!zhashx_lookup (seen, it));
+        zhashx_insert (seen, it, it);
+    }
+    assert (zhashx_size (seen) == 1000);
+    zhashx_destroy (&seen);
+
+    // long pause returns each key once and restarts the wheel
+    zlistx_purge (due);
+    assert (alert_refresh_due (self, 100000, due) == 1000);
+    assert (alert_refresh_next_ms (self) == 100100);
+
+    // removed keys are not refreshed, new ones fill the emptied slot
+    for (int i = 0; i != 50; i++) {
+        snprintf (name, sizeof (name), "ups-%d", i);
+        asset_key_init (&key, name);
+        alert_refresh_remove (self, &key);
+    }
+    asset_key_init (&key, "unknown");
+    alert_refresh_remove (self, &key);
+    assert (alert_refresh_size (self) == 950);
+    zlistx_purge (due);
+    assert (alert_refresh_due (self, 101000, due) == 950);
+
+    for (int i = 0; i != 50; i++) {
+        snprintf (name, sizeof (name), "epdu-%d", i);
+        asset_key_init (&key, name);
+        assert (alert_refresh_insert (self, &key) == 0);
+    }
+    for (uint64_t now_ms = 101100; now_ms <= 102000; now_ms += 100) {
+        zlistx_purge (due);
+        assert (alert_refresh_due (self, now_ms, due) == 100);
+    }
+
+    zlistx_destroy (&due);
+    alert_refresh_destroy (&self);
+    //  @end
+    printf ("OK\n");
+}
@@ -0,0 +1,91 @@
+/*  =========================================================================
+    alert_refresh - Staggered refresh of active alerts
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef ALERT_REFRESH_H_INCLUDED
+#define ALERT_REFRESH_H_INCLUDED
+
+#include "../include/fty_outage.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef ALERT_REFRESH_T_DEFINED
+typedef struct _alert_refresh_t alert_refresh_t;
+#define ALERT_REFRESH_T_DEFINED
+#endif
+
+//  @interface
+//  Create a new refresh scheduler, every key is returned once per period_ms,
+//  keys are spread over 'slots' buckets of the period
+FTY_OUTAGE_EXPORT alert_refresh_t *
+    alert_refresh_new (uint64_t period_ms, size_t slots, uint64_t now_ms);
+
+//  Destroy the refresh scheduler
+FTY_OUTAGE_EXPORT void
+    alert_refresh_destroy (alert_refresh_t **self_p);
+
+//  Change the refresh period, takes effect from the next slot
+FTY_OUTAGE_EXPORT void
+    alert_refresh_set_period (alert_refresh_t *self, uint64_t period_ms);
+
+//  Return the refresh period
+FTY_OUTAGE_EXPORT uint64_t
+    alert_refresh_period (alert_refresh_t *self);
+
+//  Schedule key for periodic refresh, key is put to the least loaded slot
+//  return -1 if key is already scheduled, 0 otherwise
+FTY_OUTAGE_EXPORT int
+    alert_refresh_insert (alert_refresh_t *self, const asset_key_t *key);
+
+//  Stop refreshing the key
+FTY_OUTAGE_EXPORT void
+    alert_refresh_remove (alert_refresh_t *self, const asset_key_t *key);
+
+//  Return number of scheduled keys
+FTY_OUTAGE_EXPORT size_t
+    alert_refresh_size (alert_refresh_t *self);
+
+//  Return estimated heap memory held by the scheduler, in bytes
+FTY_OUTAGE_EXPORT size_t
+    alert_refresh_memory (alert_refresh_t *self);
+
+//  Append keys from all slots which became due till now_ms to 'due'
+//  zlistx entries are asset_key_t references valid until the key is removed
+//  return number of keys appended
+FTY_OUTAGE_EXPORT size_t
+    alert_refresh_due (alert_refresh_t *self, uint64_t now_ms, zlistx_t *due);
+
+//  Return time [ms] when the next slot becomes due
+FTY_OUTAGE_EXPORT uint64_t
+    alert_refresh_next_ms (alert_refresh_t *self);
+
+//  Self test of this class
+FTY_OUTAGE_EXPORT void
+    alert_refresh_test (bool verbose);
+
+//  @end
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,277 @@
+/*  =========================================================================
+    asset_filter - Compiled include/exclude rules selecting monitored assets
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    asset_filter - Compiled include/exclude rules selecting monitored assets
+@discuss
+    Rules are compiled once, when they are loaded: lists of types,
+    subtypes and locations into hashed sets and the name pattern into
+    a regular expression. Matching of ASSET message then costs a few hash
+    lookups and one regexec, independently of number of rules.
+@end
+*/
+
+#include <regex.h>
+#include "fty_outage_classes.h"
+
+#define DEFAULT_TYPES    "device"
+#define DEFAULT_SUBTYPES "ups,epdu,sensor,sensorgpio,sts"
+
+static void *MEMBER = (void*) "member";   // value of set members
+
+// aux keys of asset locations, from direct parent up
+static const char *PARENT_KEYS [] = {
+    "parent_name.1", "parent_name.2", "parent_name.3", "parent_name.4", "parent_name.5",
+    "parent_name.6", "parent_name.7", "parent_name.8", "parent_name.9", "parent_name.10"
+};
+
+//  Structure of our class
+struct _asset_filter_t {
+    zhashx_t *types;            // included types
+    zhashx_t *subtypes;         // included subtypes
+    zhashx_t *locations;        // excluded locations
+    regex_t *name_regex;        // excluded inames or enames, NULL if none
+};
+
+//  --------------------------------------------------------------------------
+//  Destroy the filter
+void
+asset_filter_destroy (asset_filter_t **self_p)
+{
+    assert (self_p);
+    if (*self_p) {
+        asset_filter_t *self = *self_p;
+        zhashx_destroy (&self->types);
+        zhashx_destroy (&self->subtypes);
+        zhashx_destroy (&self->locations);
+        if (self->name_regex) {
+            regfree (self->name_regex);
+            free (self->name_regex);
+        }
+        free (self);
+        *self_p = NULL;
+    }
+}
+
+// fill set by members of comma separated list
+static zhashx_t *
+s_set_new (const char *list)
+{
+    zhashx_t *set = zhashx_new ();
+    if (!set)
+        return NULL;
+    char *copy = strdup (list);
+    char *saveptr = NULL;
+    for (char *member = strtok_r (copy, ",", &saveptr);
+               member != NULL;
+               member = strtok_r (NULL, ",", &saveptr))
+    {
+        while (*member == ' ')
+            member++;
+        char *end = member + strlen (member);
+        while (end > member && end [-1] == ' ')
+            *--end = '\0';
+        if (*member)
+            zhashx_update (set, member, MEMBER);
+    }
+    free (copy);
+    return set;
+}
+
+static asset_filter_t *
+s_asset_filter_compile (const char *types, const char *subtypes, const char *locations, const char *name)
+{
+    asset_filter_t *self = (asset_filter_t *) zmalloc (sizeof (asset_filter_t));
+    if (!self)
+        return NULL;
+    self->types = s_set_new (types);
+    self->subtypes = s_set_new (subtypes);
+    self->locations = s_set_new (locations);
+    if (!self->types || !self->subtypes || !self->locations) {
+        asset_filter_destroy (&self);
+        return NULL;
+    }
+    if (*name) {
+        // compiled pattern stays where regcomp put it, the filter holds
+        // just a pointer to it and can be swapped by value
+        regex_t *regex = (regex_t *) zmalloc (sizeof (regex_t));
+        if (!regex) {
+            asset_filter_destroy (&self);
+            return NULL;
+        }
+        int rv = regcomp (regex, name, REG_EXTENDED | REG_NOSUB);
+        if (rv != 0) {
+            char error [256];
+            regerror (rv, regex, error, sizeof (error));
+            log_error ("Invalid exclude/name pattern '%s': %s", name, error);
+            free (regex);
+            asset_filter_destroy (&self);
+            return NULL;
+        }
+        self->name_regex = regex;
+    }
+    return self;
+}
+
+//  --------------------------------------------------------------------------
+//  Create a new filter with default rules: devices of subtype ups, epdu,
+//  sensor, sensorgpio and sts
+asset_filter_t *
+asset_filter_new (void)
+{
+    return s_asset_filter_compile (DEFAULT_TYPES, DEFAULT_SUBTYPES, "", "");
+}
+
+//  --------------------------------------------------------------------------
+//  Replace rules by the 'filter' section of the configuration
+//  Return -1 if the rules are not valid, rules are not changed then
+int
+asset_filter_load (asset_filter_t *self, zconfig_t *config)
+{
+    assert (self);
+    assert (config);
+
+    asset_filter_t *compiled = s_asset_filter_compile (
+        zconfig_get (config, "include/type", DEFAULT_TYPES),
+        zconfig_get (config, "include/subtype", DEFAULT_SUBTYPES),
+        zconfig_get (config, "exclude/location", ""),
+        zconfig_get (config, "exclude/name", ""));
+    if (!compiled)
+        return -1;
+
+    // swap the rules, old ones are destroyed with 'compiled'
+    asset_filter_t swap = *self;
+    *self = *compiled;
+    *compiled = swap;
+    asset_filter_destroy (&compiled);
+    return 0;
+}
+
+//  --------------------------------------------------------------------------
+//  Return true if the asset should be monitored
+bool
+asset_filter_match (asset_filter_t *self, fty_proto_t *asset)
+{
+    assert (self);
+    assert (asset);
+
+    if (!zhashx_lookup (self->types, fty_proto_aux_string (asset, FTY_PROTO_ASSET_TYPE, "")))
+        return false;
+    if (!zhashx_lookup (self->subtypes, fty_proto_aux_string (asset, FTY_PROTO_ASSET_SUBTYPE, "")))
+        return false;
+    if (zhashx_size (self->locations) > 0) {
+        for (size_t i = 0; i < sizeof (PARENT_KEYS) / sizeof (PARENT_KEYS [0]); i++) {
+            const char *location = fty_proto_aux_string (asset, PARENT_KEYS [i], NULL);
+            if (!location)
+                break;
+            if (zhashx_lookup (self->locations, location))
+                return false;
+        }
+    }
+    if (self->name_regex) {
+        if (regexec (self->name_regex, fty_proto_name (asset), 0, NULL, 0) == 0)
+            return false;
+        if (regexec (self->name_regex, fty_proto_ext_string (asset, "name", ""), 0, NULL, 0) == 0)
+            return false;
+    }
+    return true;
+}
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+static fty_proto_t *
+s_test_asset (const char *name, const char *ename, const char *type, const char *subtype, const char *parent1, const char *parent2)
+{
+    zhash_t *aux = zhash_new ();
+    zhash_insert (aux, FTY_PROTO_ASSET_TYPE, (void *) type);
+    zhash_insert (aux, FTY_PROTO_ASSET_SUBTYPE, (void *) subtype);
+    if (parent1)
+        zhash_insert (aux, "parent_name.1", (void *) parent1);
+    if (parent2)
+        zhash_insert (aux, "parent_name.2", (void *) parent2);
+    zhash_t *ext = zhash_new ();
+    zhash_insert (ext, "name", (void *) ename);
+    zmsg_t *msg = fty_proto_encode_asset (aux, name, FTY_PROTO_ASSET_OP_CREATE, ext);
+    zhash_destroy (&aux);
+    zhash_destroy (&ext);
+    return fty_proto_decode (&msg);
+}
+
+void
+asset_filter_test (bool verbose)
+{
+    printf (" * asset_filter: ");
+
+    //  @selftest
+    asset_filter_t *self = asset_filter_new ();
+    assert (self);
+
+    fty_proto_t *ups = s_test_asset ("ups-1", "UPS in lab", "device", "ups", "rack-1", "room-lab");
+    fty_proto_t *server = s_test_asset ("server-1", "Server", "device", "server", "rack-1", NULL);
+    fty_proto_t *rack = s_test_asset ("rack-1", "Rack", "rack", "", "room-lab", NULL);
+    fty_proto_t *epdu = s_test_asset ("epdu-test-1", "ePDU", "device", "epdu", "rack-2", NULL);
+
+    // defaults
+    assert (asset_filter_match (self, ups));
+    assert (!asset_filter_match (self, server));
+    assert (!asset_filter_match (self, rack));
+    assert (asset_filter_match (self, epdu));
+
+    // custom rules
+    zconfig_t *config = zconfig_new ("filter", NULL);
+    zconfig_put (config, "include/subtype", "ups, epdu, server");
+    zconfig_put (config, "exclude/location", "room-lab");
+    zconfig_put (config, "exclude/name", "-test-");
+    assert (asset_filter_load (self, config) == 0);
+    assert (!asset_filter_match (self, ups));
+    assert (asset_filter_match (self, server));
+    assert (!asset_filter_match (self, epdu));
+
+    // invalid pattern keeps the rules
+    zconfig_put (config, "exclude/name", "(");
+    assert (asset_filter_load (self, config) == -1);
+    assert (asset_filter_match (self, server));
+    assert (!asset_filter_match (self, epdu));
+
+    // pattern matches ename too
+    zconfig_put (config, "exclude/location", "");
+    zconfig_put (config, "exclude/name", "^UPS ");
+    assert (asset_filter_load (self, config) == 0);
+    assert (!asset_filter_match (self, ups));
+    assert (asset_filter_match (self, epdu));
+
+    // rules without pattern drop the one loaded before
+    zconfig_put (config, "exclude/name", "");
+    assert (asset_filter_load (self, config) == 0);
+    assert (asset_filter_match (self, ups));
+    assert (asset_filter_match (self, epdu));
+    zconfig_destroy (&config);
+
+    fty_proto_destroy (&ups);
+    fty_proto_destroy (&server);
+    fty_proto_destroy (&rack);
+    fty_proto_destroy (&epdu);
+    asset_filter_destroy (&self);
+    //  @end
+    printf ("OK\n");
+}
@@ -0,0 +1,70 @@
+/*  =========================================================================
+    asset_filter - Compiled include/exclude rules selecting monitored assets
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef ASSET_FILTER_H_INCLUDED
+#define ASSET_FILTER_H_INCLUDED
+
+#include "../include/fty_outage.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef ASSET_FILTER_T_DEFINED
+typedef struct _asset_filter_t asset_filter_t;
+#define ASSET_FILTER_T_DEFINED
+#endif
+
+//  @interface
+//  Create a new filter with default rules: devices of subtype ups, epdu,
+//  sensor, sensorgpio and sts
+FTY_OUTAGE_EXPORT asset_filter_t *
+    asset_filter_new (void);
+
+//  Destroy the filter
+FTY_OUTAGE_EXPORT void
+    asset_filter_destroy (asset_filter_t **self_p);
+
+//  Replace rules by the 'filter' section of the configuration:
+//      include/type      comma separated asset types
+//      include/subtype   comma separated asset subtypes
+//      exclude/location  comma separated inames of locations (any parent)
+//      exclude/name      extended regular expression on iname or ename
+//  Missing values keep the defaults.
+//  Return -1 if the rules are not valid, rules are not changed then
+FTY_OUTAGE_EXPORT int
+    asset_filter_load (asset_filter_t *self, zconfig_t *config);
+
+//  Return true if the asset should be monitored
+FTY_OUTAGE_EXPORT bool
+    asset_filter_match (asset_filter_t *self, fty_proto_t *asset);
+
+//  Self test of this class
+FTY_OUTAGE_EXPORT void
+    asset_filter_test (bool verbose);
+
+//  @end
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,218 @@
+/*  =========================================================================
+    asset_key - Asset name hashed once, key of asset hash tables
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    asset_key - Asset name hashed once, key of asset hash tables
+@discuss
+    One metric names its asset once, but the name used to be hashed by
+    every table it was looked up in: active alerts, known assets, dead
+    assets, enames and refresh schedule. The key is made once, when the
+    message is parsed, and tables created by asset_key_hash_new take the
+    hash from the key instead of hashing the name again.
+
+    The hash is 64 bit FNV-1a, length is counted in the same pass.
+@end
+*/
+
+#include "fty_outage_classes.h"
+
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+//  --------------------------------------------------------------------------
+//  Set up key of the name, it is borrowed and must outlive the key
+
+void
+asset_key_init (asset_key_t *self, const char *name)
+{
+    assert (self);
+    assert (name);
+    uint64_t hash = FNV_OFFSET_BASIS;
+    const char *p = name;
+    for (; *p; p++) {
+        hash ^= (unsigned char) *p;
+        hash *= FNV_PRIME;
+    }
+    self->name = name;
+    self->length = (size_t) (p - name);
+    self->hash = hash;
+}
+
+//  --------------------------------------------------------------------------
+//  Create a new key owning a copy of the name, in one heap block
+
+asset_key_t *
+asset_key_new (const char *name)
+{
+    asset_key_t key;
+    asset_key_init (&key, name);
+    return asset_key_dup (&key);
+}
+
+//  --------------------------------------------------------------------------
+//  Return owned copy of the key, the hash is not computed again
+
+asset_key_t *
+asset_key_dup (const asset_key_t *self)
+{
+    assert (self);
+    asset_key_t *copy = (asset_key_t *) malloc (sizeof (asset_key_t) + self->length + 1);
+    if (copy) {
+        char *name = (char *) (copy + 1);
+        memcpy (name, self->name, self->length + 1);
+        copy->name = name;
+        copy->length = self->length;
+        copy->hash = self->hash;
+    }
+    return copy;
+}
+
+//  --------------------------------------------------------------------------
+//  Destroy key created by asset_key_new or asset_key_dup
+
+void
+asset_key_destroy (asset_key_t **self_p)
+{
+    assert (self_p);
+    if (*self_p) {
+        free (*self_p);
+        *self_p = NULL;
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Return true if both keys have the same name
+
+bool
+asset_key_eq (const asset_key_t *self, const asset_key_t *other)
+{
+    assert (self);
+    assert (other);
+    return self->hash == other->hash
+        && self->length == other->length
+        && memcmp (self->name, other->name, self->length) == 0;
+}
+
+static size_t
+s_key_hasher (const void *key)
+{
+    return (size_t) ((const asset_key_t *) key)->hash;
+}
+
+static int
+s_key_comparator (const void *key1, const void *key2)
+{
+    return asset_key_eq ((const asset_key_t *) key1, (const asset_key_t *) key2) ? 0 : 1;
+}
+
+static void *
+s_key_duplicator (const void *key)
+{
+    return asset_key_dup ((const asset_key_t *) key);
+}
+
+//  --------------------------------------------------------------------------
+//  Create a new hash table keyed by asset_key_t
+
+zhashx_t *
+asset_key_hash_new (bool owned_keys)
+{
+    zhashx_t *hash = zhashx_new ();
+    if (hash) {
+        zhashx_set_key_hasher (hash, s_key_hasher);
+        zhashx_set_key_comparator (hash, s_key_comparator);
+        zhashx_set_key_duplicator (hash, owned_keys ? s_key_duplicator : NULL);
+        zhashx_set_key_destructor (hash, owned_keys ? (zhashx_destructor_fn *) asset_key_destroy : NULL);
+    }
+    return hash;
+}
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+void
+asset_key_test (bool verbose)
+{
+    printf (" * asset_key: ");
+
+    //  @selftest
+    asset_key_t key;
+    asset_key_init (&key, "");
+    assert (key.length == 0);
+    assert (key.hash == FNV_OFFSET_BASIS);
+    asset_key_init (&key, "a");
+    assert (key.length == 1);
+    assert (key.hash == 0xaf63dc4c8601ec8cULL);
+
+    asset_key_t ups;
+    asset_key_init (&ups, "ups-1");
+    assert (ups.length == 5);
+    assert (!asset_key_eq (&key, &ups));
+    asset_key_t *copy = asset_key_new ("ups-1");
+    assert (copy);
+    assert (copy->name != ups.name);
+    assert (streq (copy->name, "ups-1"));
+    assert (asset_key_eq (copy, &ups));
+    asset_key_destroy (&copy);
+    assert (copy == NULL);
+
+    //  owned keys survive the names they were made of
+    zhashx_t *hash = asset_key_hash_new (true);
+    assert (hash);
+    for (int i = 0; i < 1000; i++) {
+        char name [32];
+        snprintf (name, sizeof (name), "ups-%d", i);
+        asset_key_init (&key, name);
+        int rv = zhashx_insert (hash, &key, (void *) "CRITICAL");
+        assert (rv == 0);
+        rv = zhashx_insert (hash, &key, (void *) "WARNING");
+        assert (rv == -1);
+    }
+    assert (zhashx_size (hash) == 1000);
+    assert (streq ((char *) zhashx_lookup (hash, &ups), "CRITICAL"));
+    size_t names = 0;
+    for (void *it = zhashx_first (hash); it; it = zhashx_next (hash)) {
+        const asset_key_t *cursor = (const asset_key_t *) zhashx_cursor (hash);
+        assert (strncmp (cursor->name, "ups-", 4) == 0);
+        names++;
+    }
+    assert (names == 1000);
+    zhashx_delete (hash, &ups);
+    assert (!zhashx_lookup (hash, &ups));
+    asset_key_init (&key, "ups-10000");
+    assert (!zhashx_lookup (hash, &key));
+    zhashx_destroy (&hash);
+
+    //  borrowed keys
+    hash = asset_key_hash_new (false);
+    assert (hash);
+    zhashx_insert (hash, &ups, (void *) "CRITICAL");
+    asset_key_t other;
+    asset_key_init (&other, "ups-1");
+    assert (zhashx_lookup (hash, &other));
+    zhashx_first (hash);
+    assert (zhashx_cursor (hash) == &ups);
+    zhashx_destroy (&hash);
+    //  @end
+
+    printf ("OK\n");
+}
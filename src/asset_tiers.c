@@ -0,0 +1,303 @@
+/*  =========================================================================
+    asset_tiers - Criticality tiers of assets with their timer resolution
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    asset_tiers - Criticality tiers of assets with their timer resolution
+@discuss
+    A few critical assets (main UPSes) need detection within a second,
+    thousands of sensors are fine with a minute. Each configured tier has
+    its own resolution of deadlines, kept by its own index in liveness,
+    and the agent wakes up once per tick only for tiers which have a
+    deadline due. Assets no tier selects stay in the default tier, served
+    by the periodic check of dead assets as before.
+
+    Lists are compiled into hashed sets when loaded, so selecting tier of
+    an asset costs a few hash lookups per configured tier.
+@end
+*/
+
+#include "fty_outage_classes.h"
+
+#define DEFAULT_TICK_MS "1000"
+
+static void *MEMBER = (void*) "member";   // value of set members
+
+//  Configured tier and its rules
+typedef struct _tier_t {
+    char *name;
+    int64_t tick_ms;            // resolution of deadlines
+    zhashx_t *priorities;       // selected priorities without P, empty selects any
+    zhashx_t *subtypes;         // selected subtypes, empty selects any
+    zhashx_t *names;            // selected inames, empty selects any
+} tier_t;
+
+//  Structure of our class
+struct _asset_tiers_t {
+    tier_t tiers [ASSET_TIERS_MAX];     // tier N is at N - 1
+    size_t size;
+};
+
+//  --------------------------------------------------------------------------
+//  Create a new tiers, all assets are in the default tier
+asset_tiers_t *
+asset_tiers_new (void)
+{
+    return (asset_tiers_t *) zmalloc (sizeof (asset_tiers_t));
+}
+
+//  --------------------------------------------------------------------------
+//  Destroy the tiers
+void
+asset_tiers_destroy (asset_tiers_t **self_p)
+{
+    assert (self_p);
+    if (*self_p) {
+        asset_tiers_t *self = *self_p;
+        for (size_t i = 0; i < self->size; i++) {
+            zstr_free (&self->tiers [i].name);
+            zhashx_destroy (&self->tiers [i].priorities);
+            zhashx_destroy (&self->tiers [i].subtypes);
+            zhashx_destroy (&self->tiers [i].names);
+        }
+        free (self);
+        *self_p = NULL;
+    }
+}
+
+// priority 1 is written as P1 too
+static const char *
+s_priority (const char *priority)
+{
+    return (*priority == 'P' || *priority == 'p') ? priority + 1 : priority;
+}
+
+// fill set by members of comma separated list
+static zhashx_t *
+s_set_new (const char *list, bool priorities)
+{
+    zhashx_t *set = zhashx_new ();
+    if (!set)
+        return NULL;
+    char *copy = strdup (list);
+    char *saveptr = NULL;
+    for (char *member = strtok_r (copy, ",", &saveptr);
+               member != NULL;
+               member = strtok_r (NULL, ",", &saveptr))
+    {
+        while (*member == ' ')
+            member++;
+        char *end = member + strlen (member);
+        while (end > member && end [-1] == ' ')
+            *--end = '\0';
+        if (*member)
+            zhashx_update (set, priorities ? s_priority (member) : member, MEMBER);
+    }
+    free (copy);
+    return set;
+}
+
+// compile tier of the configuration into the next slot
+static int
+s_asset_tiers_add (asset_tiers_t *self, zconfig_t *config)
+{
+    const char *name = zconfig_name (config);
+    const char *tick = zconfig_get (config, "tick", DEFAULT_TICK_MS);
+    char *end;
+    long long tick_ms = strtoll (tick, &end, 10);
+    if (self->size == ASSET_TIERS_MAX || !name || *end || tick_ms <= 0) {
+        log_error ("Invalid tier '%s', at most %d tiers with tick above 0 are supported", name ? name : "", ASSET_TIERS_MAX);
+        return -1;
+    }
+    tier_t *tier = &self->tiers [self->size++];
+    tier->name = strdup (name);
+    tier->tick_ms = (int64_t) tick_ms;
+    tier->priorities = s_set_new (zconfig_get (config, "priority", ""), true);
+    tier->subtypes = s_set_new (zconfig_get (config, "subtype", ""), false);
+    tier->names = s_set_new (zconfig_get (config, "name", ""), false);
+    if (!tier->name || !tier->priorities || !tier->subtypes || !tier->names)
+        return -1;
+    return 0;
+}
+
+//  --------------------------------------------------------------------------
+//  Replace tiers by children of the 'tiers' section of the configuration
+//  Return -1 if the tiers are not valid, tiers are not changed then
+int
+asset_tiers_load (asset_tiers_t *self, zconfig_t *config)
+{
+    assert (self);
+    assert (config);
+
+    asset_tiers_t *compiled = asset_tiers_new ();
+    if (!compiled)
+        return -1;
+    for (zconfig_t *child = zconfig_child (config);
+                    child != NULL;
+                    child = zconfig_next (child))
+    {
+        if (s_asset_tiers_add (compiled, child) != 0) {
+            asset_tiers_destroy (&compiled);
+            return -1;
+        }
+    }
+
+    // swap the tiers, old ones are destroyed with 'compiled'
+    asset_tiers_t swap = *self;
+    *self = *compiled;
+    *compiled = swap;
+    asset_tiers_destroy (&compiled);
+    return 0;
+}
+
+//  --------------------------------------------------------------------------
+//  Return tier of the asset, ASSET_TIERS_DEFAULT if no tier selects it
+int
+asset_tiers_match (asset_tiers_t *self, fty_proto_t *asset)
+{
+    assert (self);
+    assert (asset);
+
+    for (size_t i = 0; i < self->size; i++) {
+        tier_t *tier = &self->tiers [i];
+        if (zhashx_size (tier->priorities) > 0
+        &&  !zhashx_lookup (tier->priorities, s_priority (fty_proto_aux_string (asset, FTY_PROTO_ASSET_PRIORITY, ""))))
+            continue;
+        if (zhashx_size (tier->subtypes) > 0
+        &&  !zhashx_lookup (tier->subtypes, fty_proto_aux_string (asset, FTY_PROTO_ASSET_SUBTYPE, "")))
+            continue;
+        if (zhashx_size (tier->names) > 0
+        &&  !zhashx_lookup (tier->names, fty_proto_name (asset)))
+            continue;
+        return (int) i + 1;
+    }
+    return ASSET_TIERS_DEFAULT;
+}
+
+//  --------------------------------------------------------------------------
+//  Return number of configured tiers
+size_t
+asset_tiers_size (asset_tiers_t *self)
+{
+    assert (self);
+    return self->size;
+}
+
+//  --------------------------------------------------------------------------
+//  Return name of the tier, "default" for ASSET_TIERS_DEFAULT
+const char *
+asset_tiers_name (asset_tiers_t *self, int tier)
+{
+    assert (self);
+    assert (tier >= 0 && (size_t) tier <= self->size);
+    return tier == ASSET_TIERS_DEFAULT ? "default" : self->tiers [tier - 1].name;
+}
+
+//  --------------------------------------------------------------------------
+//  Return resolution of deadlines of the tier [ms], 0 (exact) for
+//  ASSET_TIERS_DEFAULT
+int64_t
+asset_tiers_tick (asset_tiers_t *self, int tier)
+{
+    assert (self);
+    assert (tier >= 0 && (size_t) tier <= self->size);
+    return tier == ASSET_TIERS_DEFAULT ? 0 : self->tiers [tier - 1].tick_ms;
+}
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+static fty_proto_t *
+s_test_asset (const char *name, const char *subtype, const char *priority)
+{
+    zhash_t *aux = zhash_new ();
+    zhash_insert (aux, FTY_PROTO_ASSET_TYPE, (void *) "device");
+    zhash_insert (aux, FTY_PROTO_ASSET_SUBTYPE, (void *) subtype);
+    if (priority)
+        zhash_insert (aux, FTY_PROTO_ASSET_PRIORITY, (void *) priority);
+    zmsg_t *msg = fty_proto_encode_asset (aux, name, FTY_PROTO_ASSET_OP_CREATE, NULL);
+    zhash_destroy (&aux);
+    return fty_proto_decode (&msg);
+}
+
+void
+asset_tiers_test (bool verbose)
+{
+    printf (" * asset_tiers: ");
+
+    //  @selftest
+    asset_tiers_t *self = asset_tiers_new ();
+    assert (self);
+
+    fty_proto_t *main_ups = s_test_asset ("ups-1", "ups", "1");
+    fty_proto_t *ups = s_test_asset ("ups-2", "ups", "3");
+    fty_proto_t *sensor = s_test_asset ("sensor-1", "sensor", NULL);
+    fty_proto_t *epdu = s_test_asset ("epdu-1", "epdu", "P1");
+
+    // no tiers
+    assert (asset_tiers_size (self) == 0);
+    assert (asset_tiers_match (self, main_ups) == ASSET_TIERS_DEFAULT);
+    assert (streq (asset_tiers_name (self, ASSET_TIERS_DEFAULT), "default"));
+    assert (asset_tiers_tick (self, ASSET_TIERS_DEFAULT) == 0);
+
+    // main UPSes in a second, sensors and anything else of P1 in a minute
+    zconfig_t *config = zconfig_new ("tiers", NULL);
+    zconfig_put (config, "fine/tick", "1000");
+    zconfig_put (config, "fine/priority", "P1, P2");
+    zconfig_put (config, "fine/subtype", "ups");
+    zconfig_put (config, "coarse/tick", "60000");
+    zconfig_put (config, "coarse/subtype", "sensor, sensorgpio");
+    zconfig_put (config, "named/name", "epdu-1");
+    assert (asset_tiers_load (self, config) == 0);
+    assert (asset_tiers_size (self) == 3);
+    assert (asset_tiers_match (self, main_ups) == 1);
+    assert (asset_tiers_match (self, ups) == ASSET_TIERS_DEFAULT);
+    assert (asset_tiers_match (self, sensor) == 2);
+    assert (asset_tiers_match (self, epdu) == 3);
+    assert (streq (asset_tiers_name (self, 2), "coarse"));
+    assert (asset_tiers_tick (self, 2) == 60000);
+    assert (asset_tiers_tick (self, 3) == 1000);
+
+    // invalid tick or too many tiers keep the tiers
+    zconfig_put (config, "named/tick", "0");
+    assert (asset_tiers_load (self, config) == -1);
+    zconfig_put (config, "named/tick", "500");
+    zconfig_put (config, "extra/tick", "500");
+    assert (asset_tiers_load (self, config) == -1);
+    assert (asset_tiers_size (self) == 3);
+    assert (asset_tiers_tick (self, 3) == 1000);
+    zconfig_destroy (&config);
+
+    // empty section drops all tiers
+    config = zconfig_new ("tiers", NULL);
+    assert (asset_tiers_load (self, config) == 0);
+    assert (asset_tiers_size (self) == 0);
+    assert (asset_tiers_match (self, sensor) == ASSET_TIERS_DEFAULT);
+    zconfig_destroy (&config);
+
+    fty_proto_destroy (&main_ups);
+    fty_proto_destroy (&ups);
+    fty_proto_destroy (&sensor);
+    fty_proto_destroy (&epdu);
+    asset_tiers_destroy (&self);
+    //  @end
+    printf ("OK\n");
+}
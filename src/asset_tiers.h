@@ -0,0 +1,89 @@
+/*  =========================================================================
+    asset_tiers - Criticality tiers of assets with their timer resolution
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef ASSET_TIERS_H_INCLUDED
+#define ASSET_TIERS_H_INCLUDED
+
+#include "../include/fty_outage.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef ASSET_TIERS_T_DEFINED
+typedef struct _asset_tiers_t asset_tiers_t;
+#define ASSET_TIERS_T_DEFINED
+#endif
+
+//  Tier of assets no configured tier selects, deadlines are exact and
+//  checked by the periodic check of dead assets
+#define ASSET_TIERS_DEFAULT     0
+//  Configured tiers at most, they are numbered from 1
+#define ASSET_TIERS_MAX         (FTY_OUTAGE_LIVENESS_TIERS - 1)
+
+//  @interface
+//  Create a new tiers, all assets are in the default tier
+FTY_OUTAGE_EXPORT asset_tiers_t *
+    asset_tiers_new (void);
+
+//  Destroy the tiers
+FTY_OUTAGE_EXPORT void
+    asset_tiers_destroy (asset_tiers_t **self_p);
+
+//  Replace tiers by children of the 'tiers' section of the configuration,
+//  in order, the first one selecting an asset wins:
+//      <name>/tick       resolution of deadlines [ms], 1000 by default
+//      <name>/priority   comma separated priorities, 1 or P1 for the highest
+//      <name>/subtype    comma separated asset subtypes
+//      <name>/name       comma separated inames of assets
+//  Tier selects assets matching all its non-empty lists.
+//  Return -1 if the tiers are not valid, tiers are not changed then
+FTY_OUTAGE_EXPORT int
+    asset_tiers_load (asset_tiers_t *self, zconfig_t *config);
+
+//  Return tier of the asset, ASSET_TIERS_DEFAULT if no tier selects it
+FTY_OUTAGE_EXPORT int
+    asset_tiers_match (asset_tiers_t *self, fty_proto_t *asset);
+
+//  Return number of configured tiers
+FTY_OUTAGE_EXPORT size_t
+    asset_tiers_size (asset_tiers_t *self);
+
+//  Return name of the tier, "default" for ASSET_TIERS_DEFAULT
+FTY_OUTAGE_EXPORT const char *
+    asset_tiers_name (asset_tiers_t *self, int tier);
+
+//  Return resolution of deadlines of the tier [ms], 0 (exact) for
+//  ASSET_TIERS_DEFAULT
+FTY_OUTAGE_EXPORT int64_t
+    asset_tiers_tick (asset_tiers_t *self, int tier);
+
+//  Self test of this class
+FTY_OUTAGE_EXPORT void
+    asset_tiers_test (bool verbose);
+
+//  @end
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,405 @@
+/*  =========================================================================
+    clock_skew - Skew of metric timestamps ahead of local clock, per source
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    clock_skew - Skew of metric timestamps ahead of local clock, per source
+@discuss
+    Devices with a slightly fast clock stamp their metrics in the future.
+    Such metrics are taken as seen now, so a skewed device is neither
+    lost nor able to push its deadline away. Skew within the tolerance is
+    only counted, skew beyond it is reported, at most once per interval
+    of a source and at most a few reports of all sources per interval,
+    the rest is counted as suppressed and summed up in the next report.
+
+    Statistics are kept only for sources with a metric ahead, in one
+    small block per source, created when its first metric ahead comes.
+    Once CLOCK_SKEW_MAX_SOURCES are tracked, metrics of new sources are
+    only counted as untracked. Recording a metric allocates only for the
+    first metric ahead of a new source (its block and hash entry), so at
+    most CLOCK_SKEW_MAX_SOURCES times; further metrics never allocate.
+@end
+*/
+
+#include "fty_outage_classes.h"
+
+#define DEFAULT_TOLERANCE_SEC 60
+#define DEFAULT_REPORT_INTERVAL_MS (10 * 60 * 1000)
+#define DEFAULT_REPORTS 16
+#define CLOCK_SKEW_MAX_SOURCES 4096
+
+//  Structure of our class
+struct _clock_skew_t {
+    zhashx_t *sources;          // asset_key_t => clock_skew_source_t
+    int64_t tolerance_sec;      // [s] tolerated skew
+    int64_t grace_sec;          // [s] tolerated skew after the wall clock stepped back
+    int64_t grace_until_ms;     // [ms] monotonic, grace_sec applies till then
+    int64_t report_interval_ms; // [ms] shortest interval between reports of a source
+    size_t reports;             // most reports of all sources per interval
+    int64_t window_start_ms;    // [ms] monotonic, start of the current interval
+    size_t window_reports;      // reports in the current interval
+    uint64_t untracked;         // metrics ahead of sources over the limit
+    uint64_t suppressed;        // clamped metrics not reported, all sources
+};
+
+static void
+s_source_destroy (void **item_p)
+{
+    free (*item_p);
+    *item_p = NULL;
+}
+
+//  --------------------------------------------------------------------------
+//  Create a new clock skew statistics
+clock_skew_t *
+clock_skew_new (void)
+{
+    clock_skew_t *self = (clock_skew_t *) zmalloc (sizeof (clock_skew_t));
+    if (self) {
+        self->sources = asset_key_hash_new (true);
+        if (!self->sources) {
+            free (self);
+            return NULL;
+        }
+        zhashx_set_destructor (self->sources, s_source_destroy);
+        self->tolerance_sec = DEFAULT_TOLERANCE_SEC;
+        self->report_interval_ms = DEFAULT_REPORT_INTERVAL_MS;
+        self->reports = DEFAULT_REPORTS;
+        self->window_start_ms = INT64_MIN;
+    }
+    return self;
+}
+
+//  --------------------------------------------------------------------------
+//  Destroy the clock skew statistics
+void
+clock_skew_destroy (clock_skew_t **self_p)
+{
+    assert (self_p);
+    if (*self_p) {
+        clock_skew_t *self = *self_p;
+        zhashx_destroy (&self->sources);
+        free (self);
+        *self_p = NULL;
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Return how far ahead of local clock metrics are tolerated
+int64_t
+clock_skew_tolerance (clock_skew_t *self)
+{
+    assert (self);
+    return self->tolerance_sec;
+}
+
+//  --------------------------------------------------------------------------
+//  Set how far ahead of local clock metrics are tolerated
+void
+clock_skew_set_tolerance (clock_skew_t *self, int64_t tolerance_sec)
+{
+    assert (self);
+    self->tolerance_sec = tolerance_sec > 0 ? tolerance_sec : 0;
+}
+
+//  --------------------------------------------------------------------------
+//  Set the interval between reports of a source and reports per interval
+void
+clock_skew_set_report_limit (clock_skew_t *self, int64_t interval_ms, size_t reports)
+{
+    assert (self);
+    self->report_interval_ms = interval_ms > 0 ? interval_ms : 0;
+    self->reports = reports;
+    self->window_start_ms = INT64_MIN;
+}
+
+//  --------------------------------------------------------------------------
+//  Tolerate larger skew for a while after the wall clock stepped backward
+void
+clock_skew_set_grace (clock_skew_t *self, int64_t tolerance_sec, int64_t until_ms)
+{
+    assert (self);
+    self->grace_sec = tolerance_sec;
+    self->grace_until_ms = until_ms;
+}
+
+static uint32_t
+s_inc32 (uint32_t value)
+{
+    return value < UINT32_MAX ? value + 1 : value;
+}
+
+static int32_t
+s_sec32 (int64_t sec)
+{
+    return sec < INT32_MAX ? (int32_t) sec : INT32_MAX;
+}
+
+//  --------------------------------------------------------------------------
+//  report skew of the source if neither it nor all sources did too much
+//  of it lately
+static void
+s_report (clock_skew_t *self, const asset_key_t *key, clock_skew_source_t *source, int64_t now_ms)
+{
+    if (source->reported_ms != INT64_MIN
+    &&  now_ms - source->reported_ms < self->report_interval_ms) {
+        source->suppressed = s_inc32 (source->suppressed);
+        self->suppressed++;
+        return;
+    }
+    if (self->window_start_ms == INT64_MIN
+    ||  now_ms - self->window_start_ms >= self->report_interval_ms) {
+        self->window_start_ms = now_ms;
+        self->window_reports = 0;
+    }
+    if (self->window_reports >= self->reports) {
+        source->suppressed = s_inc32 (source->suppressed);
+        self->suppressed++;
+        return;
+    }
+    self->window_reports++;
+    log_warning ("asset %s: metric is %" PRIi32 "s ahead of local clock (max %" PRIi32 "s, tolerance %" PRIi64 "s), taken as seen now, %" PRIu32 " more since the last report",
+        key->name, source->last_sec, source->max_sec, self->tolerance_sec, source->suppressed);
+    source->reported_ms = now_ms;
+    source->suppressed = 0;
+}
+
+//  --------------------------------------------------------------------------
+//  Record metric of the source stamped skew_sec ahead of local clock
+int
+clock_skew_record (clock_skew_t *self, const asset_key_t *key, int64_t skew_sec, int64_t now_ms)
+{
+    assert (self);
+    assert (key);
+    if (skew_sec <= 0)
+        return CLOCK_SKEW_NONE;
+
+    int64_t tolerance_sec = self->tolerance_sec;
+    if (now_ms < self->grace_until_ms && self->grace_sec > tolerance_sec)
+        tolerance_sec = self->grace_sec;
+    int verdict = skew_sec <= tolerance_sec ? CLOCK_SKEW_TOLERATED : CLOCK_SKEW_CLAMPED;
+
+    clock_skew_source_t *source = (clock_skew_source_t *) zhashx_lookup (self->sources, key);
+    if (!source) {
+        if (zhashx_size (self->sources) >= CLOCK_SKEW_MAX_SOURCES
+        ||  !(source = (clock_skew_source_t *) zmalloc (sizeof (clock_skew_source_t)))) {
+            self->untracked++;
+            return verdict;
+        }
+        source->reported_ms = INT64_MIN;
+        zhashx_insert (self->sources, key, source);
+    }
+    source->ahead = s_inc32 (source->ahead);
+    source->last_sec = s_sec32 (skew_sec);
+    if (source->last_sec > source->max_sec)
+        source->max_sec = source->last_sec;
+    source->last_ms = now_ms;
+    if (verdict == CLOCK_SKEW_CLAMPED) {
+        source->clamped = s_inc32 (source->clamped);
+        s_report (self, key, source, now_ms);
+    }
+    return verdict;
+}
+
+//  --------------------------------------------------------------------------
+//  Return statistics of the source, NULL if none of its metrics was ahead
+const clock_skew_source_t *
+clock_skew_lookup (clock_skew_t *self, const asset_key_t *key)
+{
+    assert (self);
+    assert (key);
+    return (const clock_skew_source_t *) zhashx_lookup (self->sources, key);
+}
+
+//  --------------------------------------------------------------------------
+//  Forget statistics of the source
+void
+clock_skew_forget (clock_skew_t *self, const asset_key_t *key)
+{
+    assert (self);
+    assert (key);
+    zhashx_delete (self->sources, key);
+}
+
+//  --------------------------------------------------------------------------
+//  Fill statistics of all sources
+void
+clock_skew_totals (clock_skew_t *self, clock_skew_totals_t *totals)
+{
+    assert (self);
+    assert (totals);
+    memset (totals, 0, sizeof (clock_skew_totals_t));
+    const clock_skew_source_t *source = (const clock_skew_source_t *) zhashx_first (self->sources);
+    while (source) {
+        totals->ahead += source->ahead;
+        totals->clamped += source->clamped;
+        if (source->max_sec > totals->max_sec)
+            totals->max_sec = source->max_sec;
+        source = (const clock_skew_source_t *) zhashx_next (self->sources);
+    }
+    totals->ahead += self->untracked;
+    totals->suppressed = self->suppressed;
+    totals->sources = zhashx_size (self->sources);
+    totals->untracked = self->untracked;
+}
+
+//  --------------------------------------------------------------------------
+//  Return statistics of the first source
+const clock_skew_source_t *
+clock_skew_first (clock_skew_t *self)
+{
+    assert (self);
+    return (const clock_skew_source_t *) zhashx_first (self->sources);
+}
+
+//  --------------------------------------------------------------------------
+//  Return statistics of the next source
+const clock_skew_source_t *
+clock_skew_next (clock_skew_t *self)
+{
+    assert (self);
+    return (const clock_skew_source_t *) zhashx_next (self->sources);
+}
+
+//  --------------------------------------------------------------------------
+//  Return key of the source returned by first/next
+const asset_key_t *
+clock_skew_cursor (clock_skew_t *self)
+{
+    assert (self);
+    return (const asset_key_t *) zhashx_cursor (self->sources);
+}
+
+//  --------------------------------------------------------------------------
+//  Return bytes of heap memory held by the statistics
+size_t
+clock_skew_memory (clock_skew_t *self)
+{
+    assert (self);
+    size_t bytes = memory_usage_block (sizeof (clock_skew_t))
+        + memory_usage_hash (zhashx_size (self->sources))
+        + zhashx_size (self->sources) * memory_usage_block (sizeof (clock_skew_source_t));
+    const clock_skew_source_t *source = (const clock_skew_source_t *) zhashx_first (self->sources);
+    while (source) {
+        const asset_key_t *key = (const asset_key_t *) zhashx_cursor (self->sources);
+        bytes += memory_usage_block (sizeof (asset_key_t) + key->length + 1);
+        source = (const clock_skew_source_t *) zhashx_next (self->sources);
+    }
+    return bytes;
+}
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+void
+clock_skew_test (bool verbose)
+{
+    printf (" * clock_skew: ");
+
+    //  @selftest
+    clock_skew_t *self = clock_skew_new ();
+    assert (self);
+    assert (clock_skew_tolerance (self) == DEFAULT_TOLERANCE_SEC);
+    clock_skew_set_tolerance (self, 30);
+    clock_skew_set_report_limit (self, 60000, 2);
+
+    asset_key_t ups, epdu, sensor;
+    asset_key_init (&ups, "ups-1");
+    asset_key_init (&epdu, "epdu-1");
+    asset_key_init (&sensor, "sensor-1");
+
+    // in time or late is not skew and is not tracked
+    assert (clock_skew_record (self, &ups, 0, 1000) == CLOCK_SKEW_NONE);
+    assert (clock_skew_record (self, &ups, -3600, 1000) == CLOCK_SKEW_NONE);
+    assert (clock_skew_lookup (self, &ups) == NULL);
+
+    // within tolerance it is only counted
+    assert (clock_skew_record (self, &ups, 5, 1000) == CLOCK_SKEW_TOLERATED);
+    assert (clock_skew_record (self, &ups, 30, 2000) == CLOCK_SKEW_TOLERATED);
+    const clock_skew_source_t *source = clock_skew_lookup (self, &ups);
+    assert (source);
+    assert (source->ahead == 2 && source->clamped == 0);
+    assert (source->max_sec == 30 && source->last_sec == 30 && source->last_ms == 2000);
+    assert (source->reported_ms == INT64_MIN);
+
+    // beyond tolerance it is reported, then suppressed till the interval passes
+    assert (clock_skew_record (self, &ups, 3600, 3000) == CLOCK_SKEW_CLAMPED);
+    assert (source->clamped == 1 && source->reported_ms == 3000 && source->suppressed == 0);
+    assert (clock_skew_record (self, &ups, 3601, 4000) == CLOCK_SKEW_CLAMPED);
+    assert (clock_skew_record (self, &ups, 3602, 5000) == CLOCK_SKEW_CLAMPED);
+    assert (source->clamped == 3 && source->reported_ms == 3000 && source->suppressed == 2);
+    assert (clock_skew_record (self, &ups, 10, 63000) == CLOCK_SKEW_TOLERATED);
+    assert (clock_skew_record (self, &ups, 3603, 63000) == CLOCK_SKEW_CLAMPED);
+    assert (source->reported_ms == 63000 && source->suppressed == 0);
+    assert (source->max_sec == 3603 && source->ahead == 7);
+
+    // two reports of all sources per interval, the third source waits
+    assert (clock_skew_record (self, &epdu, 100, 64000) == CLOCK_SKEW_CLAMPED);
+    assert (clock_skew_lookup (self, &epdu)->reported_ms == 64000);
+    assert (clock_skew_record (self, &sensor, 100, 65000) == CLOCK_SKEW_CLAMPED);
+    assert (clock_skew_lookup (self, &sensor)->reported_ms == INT64_MIN);
+    assert (clock_skew_lookup (self, &sensor)->suppressed == 1);
+    assert (clock_skew_record (self, &sensor, 100, 123000) == CLOCK_SKEW_CLAMPED);
+    assert (clock_skew_lookup (self, &sensor)->reported_ms == 123000);
+
+    clock_skew_totals_t totals;
+    clock_skew_totals (self, &totals);
+    assert (totals.sources == 3);
+    assert (totals.ahead == 10 && totals.clamped == 7 && totals.suppressed == 3);
+    assert (totals.max_sec == 3603 && totals.untracked == 0);
+
+    size_t count = 0;
+    for (source = clock_skew_first (self); source; source = clock_skew_next (self)) {
+        const asset_key_t *key = clock_skew_cursor (self);
+        assert (clock_skew_lookup (self, key) == source);
+        count++;
+    }
+    assert (count == 3);
+    assert (clock_skew_memory (self) > 3 * sizeof (clock_skew_source_t));
+
+    // after the wall clock stepped back by an hour, an hour is tolerated
+    clock_skew_set_grace (self, 3600, 200000);
+    assert (clock_skew_record (self, &epdu, 3500, 199000) == CLOCK_SKEW_TOLERATED);
+    assert (clock_skew_record (self, &epdu, 3500, 200000) == CLOCK_SKEW_CLAMPED);
+
+    clock_skew_forget (self, &ups);
+    assert (clock_skew_lookup (self, &ups) == NULL);
+    clock_skew_totals (self, &totals);
+    assert (totals.sources == 2);
+
+    // sources over the limit are counted, not tracked
+    char name [32];
+    for (size_t i = 0; i < CLOCK_SKEW_MAX_SOURCES; i++) {
+        snprintf (name, sizeof (name), "device-%zu", i);
+        asset_key_t key;
+        asset_key_init (&key, name);
+        assert (clock_skew_record (self, &key, 1, 300000) == CLOCK_SKEW_TOLERATED);
+    }
+    clock_skew_totals (self, &totals);
+    assert (totals.sources == CLOCK_SKEW_MAX_SOURCES);
+    assert (totals.untracked == 2);
+
+    clock_skew_destroy (&self);
+    assert (self == NULL);
+    clock_skew_destroy (&self);
+    //  @end
+    printf ("OK\n");
+}
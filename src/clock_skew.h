@@ -0,0 +1,134 @@
+/*  =========================================================================
+    clock_skew - Skew of metric timestamps ahead of local clock, per source
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef CLOCK_SKEW_H_INCLUDED
+#define CLOCK_SKEW_H_INCLUDED
+
+#include "../include/fty_outage.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef CLOCK_SKEW_T_DEFINED
+typedef struct _clock_skew_t clock_skew_t;
+#define CLOCK_SKEW_T_DEFINED
+#endif
+
+//  How a metric stamped ahead of local clock was taken, it is always
+//  taken as seen now
+#define CLOCK_SKEW_NONE         0   //  not ahead
+#define CLOCK_SKEW_TOLERATED    1   //  ahead within tolerance
+#define CLOCK_SKEW_CLAMPED      2   //  ahead beyond tolerance, reported
+
+//  Skew of one source, 40 bytes
+typedef struct _clock_skew_source_t {
+    uint32_t ahead;         //  metrics stamped ahead of local clock
+    uint32_t clamped;       //  of them beyond tolerance
+    uint32_t suppressed;    //  clamped metrics not reported since the last report
+    int32_t max_sec;        //  [s] largest skew
+    int32_t last_sec;       //  [s] skew of the last metric ahead
+    int64_t last_ms;        //  [ms] monotonic, when the last metric ahead came
+    int64_t reported_ms;    //  [ms] monotonic, last report, INT64_MIN if never
+} clock_skew_source_t;
+
+//  Skew of all sources
+typedef struct _clock_skew_totals_t {
+    uint64_t ahead;         //  metrics stamped ahead of local clock
+    uint64_t clamped;       //  of them beyond tolerance
+    uint64_t suppressed;    //  clamped metrics not reported
+    int64_t max_sec;        //  [s] largest skew
+    size_t sources;         //  sources tracked
+    uint64_t untracked;     //  metrics ahead of sources over the limit of tracked ones
+} clock_skew_totals_t;
+
+//  @interface
+//  Create a new clock skew statistics
+FTY_OUTAGE_EXPORT clock_skew_t *
+    clock_skew_new (void);
+
+//  Destroy the clock skew statistics
+FTY_OUTAGE_EXPORT void
+    clock_skew_destroy (clock_skew_t **self_p);
+
+//  Return how far ahead of local clock metrics are tolerated [s]
+FTY_OUTAGE_EXPORT int64_t
+    clock_skew_tolerance (clock_skew_t *self);
+
+//  Set how far ahead of local clock metrics are tolerated [s]
+FTY_OUTAGE_EXPORT void
+    clock_skew_set_tolerance (clock_skew_t *self, int64_t tolerance_sec);
+
+//  Set the shortest interval between two reports of one source [ms], and
+//  the most reports of all sources in such an interval
+FTY_OUTAGE_EXPORT void
+    clock_skew_set_report_limit (clock_skew_t *self, int64_t interval_ms, size_t reports);
+
+//  Tolerate metrics up to tolerance_sec ahead till until_ms, after the
+//  wall clock stepped backward
+FTY_OUTAGE_EXPORT void
+    clock_skew_set_grace (clock_skew_t *self, int64_t tolerance_sec, int64_t until_ms);
+
+//  Record metric of the source stamped skew_sec ahead of local clock,
+//  clamped ones are reported at most once per interval of the source
+//  return CLOCK_SKEW_NONE, CLOCK_SKEW_TOLERATED or CLOCK_SKEW_CLAMPED
+FTY_OUTAGE_EXPORT int
+    clock_skew_record (clock_skew_t *self, const asset_key_t *key, int64_t skew_sec, int64_t now_ms);
+
+//  Return statistics of the source, NULL if none of its metrics was ahead
+FTY_OUTAGE_EXPORT const clock_skew_source_t *
+    clock_skew_lookup (clock_skew_t *self, const asset_key_t *key);
+
+//  Forget statistics of the source
+FTY_OUTAGE_EXPORT void
+    clock_skew_forget (clock_skew_t *self, const asset_key_t *key);
+
+//  Fill statistics of all sources
+FTY_OUTAGE_EXPORT void
+    clock_skew_totals (clock_skew_t *self, clock_skew_totals_t *totals);
+
+//  Return statistics of the first source, NULL if there is none
+FTY_OUTAGE_EXPORT const clock_skew_source_t *
+    clock_skew_first (clock_skew_t *self);
+
+//  Return statistics of the next source, NULL after the last one
+FTY_OUTAGE_EXPORT const clock_skew_source_t *
+    clock_skew_next (clock_skew_t *self);
+
+//  Return key of the source returned by first/next
+FTY_OUTAGE_EXPORT const asset_key_t *
+    clock_skew_cursor (clock_skew_t *self);
+
+//  Return bytes of heap memory held by the statistics
+FTY_OUTAGE_EXPORT size_t
+    clock_skew_memory (clock_skew_t *self);
+
+//  Self test of this class
+FTY_OUTAGE_EXPORT void
+    clock_skew_test (bool verbose);
+
+//  @end
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
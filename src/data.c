@@ -32,77 +32,26 @@
 // so if we here would have 15 minutes-> the first alert will come in 30 minutes
 #define DEFAULT_ASSET_EXPIRATION_TIME_SEC 15*60/2
 
-//  Structure of our class
-typedef struct _expiration_t {
-    uint64_t ttl_sec;                      // [s] minimal ttl seen for some asset
-    uint64_t last_time_seen_sec;           // [s] time when  some metrics were seen for this asset
-    fty_proto_t *msg;                      // asset represetation
-} expiration_t;
-
-static expiration_t*
-expiration_new (uint64_t default_expiry_sec, fty_proto_t **msg_p)
-{
-    assert (msg_p);
-    expiration_t *self = (expiration_t *) zmalloc (sizeof (expiration_t));
-    if (self) {
-        self->ttl_sec = default_expiry_sec;
-        self->msg = *msg_p;
-        *msg_p = NULL;
-    }
-    return self;
-}
-
-static void
-expiration_destroy (expiration_t **self_p)
-{
-    assert (self_p);
-    if (*self_p) {
-        expiration_t *self = *self_p;
-        fty_proto_destroy (&self->msg);
-        free (self);
-        *self_p = NULL;
-    }
-}
-
-// set up new expected expiration time, given last seen time
-// this function can only prolong exiration_time
-static void
-expiration_update (expiration_t *self, uint64_t new_time_seen_sec)
-{
-    assert (self);
-    // this will ensure, that we will not have 'experiation' time moving backwards!
-    // Situation: at 03:33 metric with 24h average comes with 'time' = 00:00
-    // ttl is 5 minutes -> new expiration date would be 00:05 BUT now already 3:33 !!
-    // So we will create false alert!
-    // This 'if' is a guard for this situation!
-    if ( new_time_seen_sec > self->last_time_seen_sec )
-        self->last_time_seen_sec = new_time_seen_sec;
-}
-
-static void
-expiration_update_ttl (expiration_t *self, uint64_t proposed_ttl)
-{
-    assert (self);
-    // ATTENTION: if minimum ttl for some asset is greater than DEFAULT_ASSET_EXPIRATION_TIME_SEC
-    // it will be sending alerts every DEFAULT_ASSET_EXPIRATION_TIME_SEC
+// asset is considered dead after it is silent for 2 * ttl
+#define DEFAULT_CRITICAL_FACTOR 2.0
 
-    // logic: we are looking for the minimum ttl
-    if ( self->ttl_sec > proposed_ttl ) {
-        self->ttl_sec = proposed_ttl;
-    }
-}
-
-static uint64_t
-expiration_get (expiration_t *self)
-{
-    assert (self);
-    return self->last_time_seen_sec + self->ttl_sec * 2;
-}
+// after wall clock steps backward, metrics stamped before the step look like
+// they are from future, tolerate them for this long
+#define CLOCK_STEP_GRACE_MS 5*60*1000
 
+//  Structure of our class
 struct _data_t {
-    zhashx_t *assets;           // asset_name => expiration time [s]
-    zhashx_t *asset_enames;      // asset iname => asset ename (unicode name)
-    uint64_t default_expiry_sec; // [s] default time for the asset, in what asset would be considered as not responding
+    fty_outage_liveness_t *liveness; // asset_key => asset message, liveness on monotonic time of clock
+    asset_filter_t *filter;      // selects monitored assets
+    asset_tiers_t *tiers;        // selects timer resolution of assets
+    event_log_t *event_log;      // records transitions of assets, NULL if disabled
+    outage_clock_t *clock;       // time source
+    outage_clock_t *own_clock;   // clock created by data_new, NULL if another was set
+    clock_skew_t *skew;          // statistics of metrics from future, they are taken as seen now
+    outage_locations_t *locations; // monitored and dead assets per location, kept by transitions
+    size_t subtypes [OUTAGE_METRICS_SUBTYPES]; // monitored assets per outage_metrics_subtype, kept by transitions
+    fty_outage_liveness_touch_t *touches; // scratch of data_touch_batch, kept between batches
+    size_t touches_capacity;
 };
 
 //  --------------------------------------------------------------------------
@@ -113,13 +62,21 @@ data_destroy (data_t **self_p)
     assert (self_p);
     if (*self_p) {
         data_t *self = *self_p;
-        zhashx_destroy(&self -> assets);
-        zhashx_destroy(&self -> asset_enames);
+        fty_outage_liveness_destroy (&self->liveness);
+        free (self->touches);
+        clock_skew_destroy (&self->skew);
+        outage_locations_destroy (&self->locations);
+        asset_filter_destroy (&self->filter);
+        asset_tiers_destroy (&self->tiers);
+        outage_clock_destroy (&self->own_clock);
         free (self);
         *self_p = NULL;
     }
 }
 
+static void
+s_data_handler (void *arg, int type, const asset_key_t *key, void *item, const fty_outage_liveness_state_t *state);
+
 //  -----------------------------------------------------------------------
 //  Create a new data
 data_t *
@@ -127,15 +84,23 @@ data_new (void)
 {
     data_t *self = (data_t *) zmalloc (sizeof (data_t));
     if (self) {
-        self -> asset_enames = zhashx_new();
-        if ( !self->asset_enames ) {
+        self -> filter = asset_filter_new ();
+        self -> tiers = asset_tiers_new ();
+        if ( !self->filter || !self->tiers ) {
             data_destroy (&self);
             return NULL;
         }
-        self -> assets = zhashx_new();
-        if ( self->assets ) {
-            self->default_expiry_sec = DEFAULT_ASSET_EXPIRATION_TIME_SEC;
-            zhashx_set_destructor (self -> assets,  (zhashx_destructor_fn *) expiration_destroy);
+        self -> own_clock = outage_clock_new ();
+        self -> clock = self->own_clock;
+        self -> skew = clock_skew_new ();
+        self -> locations = outage_locations_new ();
+        if ( self->clock && self->skew && self->locations )
+            self -> liveness = fty_outage_liveness_new ();
+        if ( self->liveness ) {
+            fty_outage_liveness_set_destructor (self->liveness, (fty_outage_liveness_destructor_fn *) fty_proto_destroy);
+            fty_outage_liveness_set_handler (self->liveness, s_data_handler, self);
+            fty_outage_liveness_set_default_ttl (self->liveness, (int64_t) DEFAULT_ASSET_EXPIRATION_TIME_SEC * 1000);
+            fty_outage_liveness_set_escalation (self->liveness, 0, DEFAULT_CRITICAL_FACTOR, outage_clock_mono_ms (self->clock));
         }
         else
             data_destroy (&self);
@@ -145,10 +110,42 @@ data_new (void)
 }
 
 const char*
-data_get_asset_ename (data_t *self, const char *asset_name)
+data_get_asset_ename (data_t *self, const asset_key_t *key)
+{
+    assert (self);
+    assert (key);
+    fty_proto_t *msg = (fty_proto_t *) fty_outage_liveness_lookup (self->liveness, key);
+    return msg ? fty_proto_ext_string (msg, "name", "") : NULL;
+}
+
+//  ------------------------------------------------------------------------
+//  Return asset message of known asset, NULL if it is not known
+fty_proto_t *
+data_get_asset (data_t *self, const asset_key_t *key)
+{
+    assert (self);
+    assert (key);
+    return (fty_proto_t *) fty_outage_liveness_lookup (self->liveness, key);
+}
+
+//  ------------------------------------------------------------------------
+//  Return asset message of the first known asset, NULL if there are none
+fty_proto_t *
+data_first (data_t *self)
 {
-    return (const char*) zhashx_lookup (self->asset_enames, asset_name);
+    assert (self);
+    const asset_key_t *key = fty_outage_liveness_first (self->liveness);
+    return key ? (fty_proto_t *) fty_outage_liveness_lookup (self->liveness, key) : NULL;
+}
 
+//  ------------------------------------------------------------------------
+//  Return asset message of the next known asset, NULL after the last one
+fty_proto_t *
+data_next (data_t *self)
+{
+    assert (self);
+    const asset_key_t *key = fty_outage_liveness_next (self->liveness);
+    return key ? (fty_proto_t *) fty_outage_liveness_lookup (self->liveness, key) : NULL;
 }
 
 //  ------------------------------------------------------------------------
@@ -157,7 +154,7 @@ uint64_t
 data_default_expiry (data_t* self)
 {
     assert (self);
-    return self->default_expiry_sec;
+    return (uint64_t) fty_outage_liveness_default_ttl (self->liveness) / 1000;
 }
 
 //  ------------------------------------------------------------------------
@@ -166,113 +163,543 @@ void
 data_set_default_expiry (data_t* self, uint64_t expiry_sec)
 {
     assert (self);
-    self->default_expiry_sec = expiry_sec;
+    fty_outage_liveness_set_default_ttl (self->liveness, (int64_t) expiry_sec * 1000);
 }
 
 //  ------------------------------------------------------------------------
-//  update information about expiration time
-//  return -1, if data are from future and are ignored as damaging
-//  return 0 otherwise
+//  Use another clock, it is not owned and must outlive the data
+void
+data_set_clock (data_t *self, outage_clock_t *clock)
+{
+    assert (self);
+    assert (clock);
+    outage_clock_destroy (&self->own_clock);
+    self->clock = clock;
+}
+
+//  ------------------------------------------------------------------------
+//  Return the clock used by data
+outage_clock_t *
+data_clock (data_t *self)
+{
+    assert (self);
+    return self->clock;
+}
+
+//  ------------------------------------------------------------------------
+//  Return statistics of metrics from future
+clock_skew_t *
+data_skew (data_t *self)
+{
+    assert (self);
+    return self->skew;
+}
+
+//  ------------------------------------------------------------------------
+//  Return monitored and dead assets per location
+outage_locations_t *
+data_locations (data_t *self)
+{
+    assert (self);
+    return self->locations;
+}
+
+//  ------------------------------------------------------------------------
+//  Return monitored assets per outage_metrics_subtype
+const size_t *
+data_subtypes (data_t *self)
+{
+    assert (self);
+    return self->subtypes;
+}
+
+//  ------------------------------------------------------------------------
+//  Set after how many ttls of silence asset escalates to WARNING and to
+//  CRITICAL, warning_factor 0 disables WARNING
+void
+data_set_escalation (data_t *self, double warning_factor, double critical_factor)
+{
+    assert (self);
+    fty_outage_liveness_set_escalation (self->liveness, warning_factor, critical_factor, outage_clock_mono_ms (self->clock));
+}
+
+//  ------------------------------------------------------------------------
+//  Return escalation level reached by the asset, DATA_LEVEL_NONE if unknown
 int
-data_touch_asset (data_t *self, const char *asset_name, uint64_t timestamp, uint64_t ttl, uint64_t now_sec)
+data_asset_level (data_t *self, const asset_key_t *key)
 {
     assert (self);
-    assert (asset_name);
+    assert (key);
+    return fty_outage_liveness_level (self->liveness, key);
+}
 
-    expiration_t *e = (expiration_t *) zhashx_lookup (self->assets, asset_name);
-    if ( e == NULL ) {
-        // asset is not known -> we are not interested in this asset -> do nothing
-        return 0;
+//  ------------------------------------------------------------------------
+//  record transition of the asset into the event log, times of liveness
+//  are monotonic, the log has wall times
+static void
+s_data_event (data_t *self, int type, const asset_key_t *key, const fty_outage_liveness_state_t *state)
+{
+    int64_t deadline_ms = 0;
+    if (state->deadline_ms)
+        deadline_ms = outage_clock_mono_to_wall (self->clock, state->deadline_ms);
+    uint64_t last_seen_sec = (uint64_t) (outage_clock_mono_to_wall (self->clock, state->seen_ms) / 1000);
+    event_log_record (self->event_log, type, state->level, key->name, (uint64_t) (state->ttl_ms / 1000), last_seen_sec, deadline_ms);
+}
+
+// index of the subtype of asset message in counts of monitored assets
+static int
+s_data_subtype (fty_proto_t *proto)
+{
+    return outage_metrics_subtype (fty_proto_aux_string (proto, FTY_PROTO_ASSET_SUBTYPE, ""));
+}
+
+// transitions of liveness update counters of locations and subtypes and
+// go to the event log, if there is one
+static void
+s_data_handler (void *arg, int type, const asset_key_t *key, void *item, const fty_outage_liveness_state_t *state)
+{
+    data_t *self = (data_t *) arg;
+    if (type == FTY_OUTAGE_LIVENESS_ADDED) {
+        outage_locations_insert (self->locations, key, (fty_proto_t *) item);
+        self->subtypes [s_data_subtype ((fty_proto_t *) item)]++;
+    }
+    else
+    if (type == FTY_OUTAGE_LIVENESS_DELETED) {
+        outage_locations_delete (self->locations, key);
+        self->subtypes [s_data_subtype ((fty_proto_t *) item)]--;
     }
+    else
+    if (type == FTY_OUTAGE_LIVENESS_EXPIRED || type == FTY_OUTAGE_LIVENESS_REVIVED)
+        outage_locations_set_dead (self->locations, key, type == FTY_OUTAGE_LIVENESS_EXPIRED);
+    if (self->event_log)
+        s_data_event (self, type, key, state);
+}
+
+//  ------------------------------------------------------------------------
+//  Record transitions into the event log, it is not owned, NULL disables it
+void
+data_set_event_log (data_t *self, event_log_t *event_log)
+{
+    assert (self);
+    self->event_log = event_log;
+}
+
+//  ------------------------------------------------------------------------
+//  Record transition of known asset, done elsewhere, into the event log
+void
+data_log_event (data_t *self, int type, const asset_key_t *key)
+{
+    assert (self);
+    assert (key);
+    if (!self->event_log)
+        return;
+    fty_outage_liveness_state_t state;
+    if (fty_outage_liveness_state (self->liveness, key, &state) == 0)
+        s_data_event (self, type, key, &state);
+    else
+        event_log_record (self->event_log, type, DATA_LEVEL_NONE, key->name, 0, 0, 0);
+}
 
-    // we know information about this asset
-    // try to update ttl
-    expiration_update_ttl (e, ttl);
-    // need to compute new expiration time
+//  ------------------------------------------------------------------------
+//  detect wall clock step, deadlines are on monotonic timeline, so they
+//  stay where they are, only metrics stamped before backward step need
+//  some grace
+static void
+s_data_check_clock (data_t *self)
+{
+    int64_t step_ms = outage_clock_sync (self->clock);
+    if (step_ms == 0)
+        return;
+
+    int64_t step_sec = step_ms / 1000;
+    if (step_sec < 0)
+        clock_skew_set_grace (self->skew, -step_sec, outage_clock_mono_ms (self->clock) + CLOCK_STEP_GRACE_MS);
+    log_warning ("wall clock stepped by %" PRIi64 "ms, %zu assets keep their deadlines", step_ms, fty_outage_liveness_size (self->liveness));
+}
+
+//  ------------------------------------------------------------------------
+//  monotonic time the metric was seen at, metrics from future are clamped
+//  to now: device is alive, but its clock must not push its deadline away
+static int64_t
+s_data_seen_ms (data_t *self, uint64_t timestamp, uint64_t now_sec, int64_t now_ms)
+{
     if ( timestamp > now_sec )
-        return -1;
-    else {
-        expiration_update (e, timestamp);
-        log_debug ("asset: INFO UPDATED name='%s', last_seen=%" PRIu64 "[s], ttl= %" PRIu64 "[s], expires_at=%" PRIu64 "[s]", asset_name, e->last_time_seen_sec, e->ttl_sec, expiration_get (e));
+        return now_ms;
+    int64_t seen_ms = outage_clock_wall_to_mono (self->clock, (int64_t) timestamp * 1000);
+    // now of the caller can be a bit ahead of the clock
+    return seen_ms < now_ms ? seen_ms : now_ms;
+}
+
+//  ------------------------------------------------------------------------
+//  skew of metric of known asset from future goes to the statistics
+static int
+s_data_skew (data_t *self, const asset_key_t *key, uint64_t timestamp, uint64_t now_sec, int64_t now_ms)
+{
+    if ( timestamp <= now_sec )
+        return CLOCK_SKEW_NONE;
+    return clock_skew_record (self->skew, key, (int64_t) (timestamp - now_sec), now_ms);
+}
+
+//  ------------------------------------------------------------------------
+//  update information about expiration time
+//  return CLOCK_SKEW_TOLERATED or CLOCK_SKEW_CLAMPED if metric of known
+//  asset is from future, it is taken as seen now
+//  return 0 otherwise
+int
+data_touch_asset (data_t *self, const asset_key_t *key, uint64_t timestamp, uint64_t ttl, uint64_t now_sec)
+{
+    assert (self);
+    assert (key);
+
+    s_data_check_clock (self);
+    int64_t now_ms = outage_clock_mono_ms (self->clock);
+    int64_t seen_ms = s_data_seen_ms (self, timestamp, now_sec, now_ms);
+    int type = fty_outage_liveness_touch (self->liveness, key, seen_ms, (int64_t) ttl * 1000, now_ms);
+    // asset is not known -> we are not interested in this asset -> do nothing
+    if (type == -1)
+        return 0;
+    log_debug ("asset: INFO UPDATED name='%s', seen=%" PRIu64 "[s], ttl= %" PRIu64 "[s]", key->name, timestamp, ttl);
+    return s_data_skew (self, key, timestamp, now_sec, now_ms);
+}
+
+//  ------------------------------------------------------------------------
+//  metric of alive asset arrived now and was not decoded
+int
+data_elide_touch (data_t *self, const asset_key_t *key)
+{
+    assert (self);
+    assert (key);
+    int64_t now_ms = outage_clock_mono_ms (self->clock);
+    return fty_outage_liveness_defer (self->liveness, key, now_ms, now_ms);
+}
+
+//  ------------------------------------------------------------------------
+//  touch assets of a batch of metrics, they are converted to monotonic time
+//  and touched as a batch of liveness
+size_t
+data_touch_batch (data_t *self, const data_touch_t *items, size_t count, uint64_t now_sec, data_transition_t *transitions)
+{
+    assert (self);
+    assert (items || count == 0);
+
+    s_data_check_clock (self);
+    int64_t now_ms = outage_clock_mono_ms (self->clock);
+    if (count > self->touches_capacity) {
+        fty_outage_liveness_touch_t *touches = (fty_outage_liveness_touch_t *)
+            realloc (self->touches, count * sizeof (fty_outage_liveness_touch_t));
+        if (!touches) {
+            log_error ("Can't allocate batch of %zu metrics (memory error), touch them one by one", count);
+            size_t transitions_count = 0;
+            for (size_t i = 0; i < count; i++) {
+                int64_t seen_ms = s_data_seen_ms (self, items [i].timestamp, now_sec, now_ms);
+                int type = fty_outage_liveness_touch (self->liveness, &items [i].key, seen_ms, (int64_t) items [i].ttl * 1000, now_ms);
+                if (type != -1)
+                    s_data_skew (self, &items [i].key, items [i].timestamp, now_sec, now_ms);
+                if (type > 0) {
+                    if (transitions) {
+                        transitions [transitions_count].index = i;
+                        transitions [transitions_count].type = type;
+                    }
+                    transitions_count++;
+                }
+            }
+            return transitions_count;
+        }
+        self->touches = touches;
+        self->touches_capacity = count;
     }
-    return 0;
+    for (size_t i = 0; i < count; i++) {
+        self->touches [i].key = items [i].key;
+        self->touches [i].seen_ms = s_data_seen_ms (self, items [i].timestamp, now_sec, now_ms);
+        self->touches [i].ttl_ms = (int64_t) items [i].ttl * 1000;
+        // metrics from future are rare, known asset is looked up only for them
+        if (items [i].timestamp > now_sec && fty_outage_liveness_lookup (self->liveness, &items [i].key))
+            s_data_skew (self, &items [i].key, items [i].timestamp, now_sec, now_ms);
+    }
+    return fty_outage_liveness_touch_batch (self->liveness, self->touches, count, now_ms, transitions);
+}
+
+// asset message removes the asset from monitoring by operation or status
+static bool
+s_data_removes (fty_proto_t *proto)
+{
+    return streq (fty_proto_operation (proto), FTY_PROTO_ASSET_OP_DELETE)
+        || streq (fty_proto_aux_string (proto, FTY_PROTO_ASSET_STATUS, ""), "retired")
+        || streq (fty_proto_aux_string (proto, FTY_PROTO_ASSET_STATUS, ""), "nonactive");
 }
 
 //  ------------------------------------------------------------------------
-//  put data
-void
-data_put (data_t *self, fty_proto_t **proto_p)
+//  Return true if the asset message makes or keeps its asset monitored
+bool
+data_selects (data_t *self, fty_proto_t *proto)
 {
     assert (self);
-    assert (proto_p);
+    assert (proto);
+    return fty_proto_id (proto) == FTY_PROTO_ASSET
+        && !s_data_removes (proto)
+        && asset_filter_match (self->filter, proto);
+}
 
+// move known asset to the tier selected for its message
+static void
+s_data_set_tier (data_t *self, const asset_key_t *key, fty_proto_t *proto)
+{
+    int tier = asset_tiers_match (self->tiers, proto);
+    if (fty_outage_liveness_tier (self->liveness, key) != tier)
+        fty_outage_liveness_set_tier (self->liveness, key, tier, outage_clock_mono_ms (self->clock));
+}
+
+//  ------------------------------------------------------------------------
+//  put data, return DATA_ADDED or DATA_DELETED if it was a transition, 0
+//  otherwise
+static int
+s_data_put (data_t *self, fty_proto_t **proto_p)
+{
+    int transition = 0;
     fty_proto_t *proto = *proto_p;
     if ( proto == NULL )
-        return;
+        return transition;
 
     if (fty_proto_id (proto) != FTY_PROTO_ASSET) {
         fty_proto_destroy (proto_p);
-        return;
+        return transition;
     }
 
     const char *operation = fty_proto_operation (proto);
     const char *asset_name = fty_proto_name (proto);
+    asset_key_t key;
+    asset_key_init (&key, asset_name);
 
     log_debug ("Received asset: name=%s, operation=%s", asset_name, operation);
 
     // remove asset from cache
-    const char* sub_type = fty_proto_aux_string (proto, FTY_PROTO_ASSET_SUBTYPE, "");
-    if (    streq (operation, FTY_PROTO_ASSET_OP_DELETE)
-         || streq (fty_proto_aux_string (proto, FTY_PROTO_ASSET_STATUS, ""), "retired")
-         || streq (fty_proto_aux_string (proto, FTY_PROTO_ASSET_STATUS, ""), "nonactive")
-    )
+    if ( s_data_removes (proto) )
     {
-        data_delete (self, asset_name);
+        if (fty_outage_liveness_delete (self->liveness, &key) == 0)
+            transition = DATA_DELETED;
+        clock_skew_forget (self->skew, &key);
         log_debug ("asset: DELETED name=%s, operation=%s", asset_name, operation);
         fty_proto_destroy (proto_p);
     }
     else
-    // other asset operations - add ups, epdu or sensors to the cache if not present
-    if (    streq (fty_proto_aux_string (proto, FTY_PROTO_ASSET_TYPE, ""), "device" )
-         && (   streq (sub_type, "ups")
-             || streq (sub_type, "epdu")
-             || streq (sub_type, "sensor")
-             || streq (sub_type, "sensorgpio")
-             || streq (sub_type, "sts")
-            )
-       )
+    // other asset operations - add assets selected by the filter to the cache if not present
+    if ( asset_filter_match (self->filter, proto) )
     {
-        zhashx_insert (self->asset_enames, asset_name, (void*) fty_proto_ext_string (proto, "name", ""));
-
-        // this asset is not known yet -> add it to the cache
-        expiration_t *e = (expiration_t *) zhashx_lookup (self->assets, asset_name );
-        if ( e == NULL ) {
-            e = expiration_new (self->default_expiry_sec, proto_p);
-            uint64_t now_sec = zclock_time() / 1000;
-            expiration_update (e, now_sec);
-            log_debug ("asset: ADDED name='%s', last_seen=%" PRIu64 "[s], ttl= %" PRIu64 "[s], expires_at=%" PRIu64 "[s]", asset_name, e->last_time_seen_sec, e->ttl_sec, expiration_get (e));
-            zhashx_insert (self->assets, asset_name, e);
+        // this asset is not known yet -> add it to the cache, seen now
+        // So, if we already knew this asset -> nothing to do
+        if (fty_outage_liveness_insert (self->liveness, &key, proto, outage_clock_mono_ms (self->clock)) == 0) {
+            *proto_p = NULL;
+            s_data_set_tier (self, &key, proto);
+            log_debug ("asset: ADDED name='%s', ttl= %" PRIu64 "[s]", key.name, data_default_expiry (self));
+            transition = DATA_ADDED;
         }
         else {
-            fty_proto_destroy (proto_p);
-            // intentionally left empty
-            // So, if we already knew this asset -> nothing to do
+            // known asset may have moved or changed its priority or subtype,
+            // the new message is kept, so tiers loaded later match what the
+            // asset is now
+            fty_proto_t *known = (fty_proto_t *) fty_outage_liveness_lookup (self->liveness, &key);
+            int subtype = known ? s_data_subtype (known) : 0;
+            if (known && fty_outage_liveness_replace (self->liveness, &key, proto) == 0) {
+                *proto_p = NULL;
+                self->subtypes [subtype]--;
+                self->subtypes [s_data_subtype (proto)]++;
+                outage_locations_insert (self->locations, &key, proto);
+                s_data_set_tier (self, &key, proto);
+            }
+            else
+                fty_proto_destroy (proto_p);
         }
     }
     else {
+        // known asset which is not selected any more, e.g. moved out of
+        // included location, is dropped
+        if (fty_outage_liveness_delete (self->liveness, &key) == 0) {
+            transition = DATA_DELETED;
+            clock_skew_forget (self->skew, &key);
+            log_debug ("asset: FILTERED OUT name=%s", asset_name);
+        }
         fty_proto_destroy (proto_p);
     }
+    return transition;
+}
+
+void
+data_put (data_t *self, fty_proto_t **proto_p)
+{
+    assert (self);
+    assert (proto_p);
+    s_data_put (self, proto_p);
+}
+
+//  ------------------------------------------------------------------------
+//  put asset messages of a batch
+size_t
+data_put_batch (data_t *self, fty_proto_t **protos, size_t count, data_transition_t *transitions)
+{
+    assert (self);
+    assert (protos || count == 0);
+
+    size_t transitions_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        int transition = s_data_put (self, &protos [i]);
+        if (transition) {
+            if (transitions) {
+                transitions [transitions_count].index = i;
+                transitions [transitions_count].type = transition;
+            }
+            transitions_count++;
+        }
+    }
+    return transitions_count;
 }
 
 // --------------------------------------------------------------------------
 // delete from cache
 void
-data_delete (data_t *self, const char* source)
+data_delete (data_t *self, const asset_key_t *key)
+{
+    assert (self);
+    assert (key);
+    fty_outage_liveness_delete (self->liveness, key);
+    clock_skew_forget (self->skew, key);
+}
+
+// --------------------------------------------------------------------------
+// estimate heap memory held by data
+void
+data_memory (data_t *self, data_memory_t *memory)
+{
+    assert (self);
+    assert (memory);
+
+    fty_outage_liveness_memory_t liveness;
+    fty_outage_liveness_memory (self->liveness, &liveness);
+    memset (memory, 0, sizeof (data_memory_t));
+    memory->assets = memory_usage_block (sizeof (data_t)) + liveness.records;
+    memory->strings = liveness.keys;
+    for (const asset_key_t *key = fty_outage_liveness_first (self->liveness);
+                            key != NULL;
+                            key = fty_outage_liveness_next (self->liveness))
+        memory->messages += memory_usage_proto ((fty_proto_t *) fty_outage_liveness_lookup (self->liveness, key));
+    memory->heap = liveness.index;
+    memory->locations = outage_locations_memory (self->locations);
+    if (self->touches_capacity)
+        memory->heap += memory_usage_block (self->touches_capacity * sizeof (fty_outage_liveness_touch_t));
+    memory->skew = clock_skew_memory (self->skew);
+}
+
+// --------------------------------------------------------------------------
+// give memory left over from past asset churn back to the allocator
+int
+data_compact (data_t *self)
+{
+    assert (self);
+
+    int compacted = fty_outage_liveness_compact (self->liveness);
+    // batch scratch is allocated again by the next batch
+    if (self->touches) {
+        free (self->touches);
+        self->touches = NULL;
+        self->touches_capacity = 0;
+        compacted++;
+    }
+    return compacted;
+}
+
+// --------------------------------------------------------------------------
+// replace the asset filter and drop assets it does not select any more,
+// in one pass over the cache, return list of their names
+zlistx_t *
+data_set_filter (data_t *self, asset_filter_t **filter_p)
+{
+    assert (self);
+    assert (filter_p && *filter_p);
+
+    asset_filter_destroy (&self->filter);
+    self->filter = *filter_p;
+    *filter_p = NULL;
+
+    zlistx_t *removed = zlistx_new ();
+    zlistx_set_duplicator (removed, (zlistx_duplicator_fn *) strdup);
+    zlistx_set_destructor (removed, (zlistx_destructor_fn *) zstr_free);
+    for (const asset_key_t *key = fty_outage_liveness_first (self->liveness);
+                            key != NULL;
+                            key = fty_outage_liveness_next (self->liveness))
+    {
+        fty_proto_t *msg = (fty_proto_t *) fty_outage_liveness_lookup (self->liveness, key);
+        if (!asset_filter_match (self->filter, msg))
+            zlistx_add_end (removed, (void *) key->name);
+    }
+    for (const char *name = (const char *) zlistx_first (removed);
+                     name != NULL;
+                     name = (const char *) zlistx_next (removed))
+    {
+        log_debug ("asset: FILTERED OUT name=%s", name);
+        asset_key_t key;
+        asset_key_init (&key, name);
+        data_delete (self, &key);
+    }
+    return removed;
+}
+
+// --------------------------------------------------------------------------
+// replace the asset tiers, set resolution of their deadlines and move known
+// assets to the tiers selecting them
+void
+data_set_tiers (data_t *self, asset_tiers_t **tiers_p)
 {
     assert (self);
-    assert (source);
+    assert (tiers_p && *tiers_p);
+
+    asset_tiers_destroy (&self->tiers);
+    self->tiers = *tiers_p;
+    *tiers_p = NULL;
+
+    int64_t now_ms = outage_clock_mono_ms (self->clock);
+    for (int tier = ASSET_TIERS_DEFAULT + 1; tier <= ASSET_TIERS_MAX; tier++) {
+        int64_t tick_ms = (size_t) tier <= asset_tiers_size (self->tiers) ? asset_tiers_tick (self->tiers, tier) : 0;
+        fty_outage_liveness_set_tick (self->liveness, tier, tick_ms, now_ms);
+    }
+    for (const asset_key_t *key = fty_outage_liveness_first (self->liveness);
+                            key != NULL;
+                            key = fty_outage_liveness_next (self->liveness))
+        s_data_set_tier (self, key, (fty_proto_t *) fty_outage_liveness_lookup (self->liveness, key));
+}
+
+// --------------------------------------------------------------------------
+// time till the earliest deadline of configured tiers is due
+int64_t
+data_tiers_wait_ms (data_t *self)
+{
+    assert (self);
+
+    int64_t next_ms = INT64_MAX;
+    for (int tier = ASSET_TIERS_DEFAULT + 1; tier <= ASSET_TIERS_MAX; tier++) {
+        int64_t deadline_ms = fty_outage_liveness_next_deadline (self->liveness, tier);
+        if (deadline_ms < next_ms)
+            next_ms = deadline_ms;
+    }
+    if (next_ms == INT64_MAX)
+        return -1;
+    int64_t now_ms = outage_clock_mono_ms (self->clock);
+    return next_ms > now_ms ? next_ms - now_ms : 0;
+}
 
-    zhashx_delete (self->assets, source);
+//  ------------------------------------------------------------------------
+//  Escalate assets of configured tiers whose deadlines are due, returns
+//  list of assets which reached a higher level now
+zlistx_t *
+data_expire_tiers (data_t *self)
+{
+    assert (self);
+    s_data_check_clock (self);
+    zlistx_t *escalated = zlistx_new ();
+    if (!escalated)
+        return NULL;
+    int64_t now_ms = outage_clock_mono_ms (self->clock);
+    for (int tier = ASSET_TIERS_DEFAULT + 1; tier <= ASSET_TIERS_MAX; tier++)
+        fty_outage_liveness_expire_tier (self->liveness, tier, now_ms, escalated);
+    return escalated;
 }
 
 // --------------------------------------------------------------------------
@@ -301,34 +728,27 @@ zlistx_t *
 data_get_dead (data_t *self)
 {
     assert (self);
-    // list of devices
-    zlistx_t *dead = zlistx_new();
-
-    uint64_t now_sec = zclock_time() / 1000;
-    log_debug ("now=%" PRIu64 "s", now_sec);
-    for (expiration_t *e =  (expiration_t *) zhashx_first (self->assets);
-        e != NULL;
-	    e = (expiration_t *) zhashx_next (self->assets))
-    {
-        void *asset_name = (void*) zhashx_cursor(self->assets);
-        log_debug ("asset: name=%s, ttl=%" PRIu64 ", expires_at=%" PRIu64, asset_name, e->ttl_sec, expiration_get (e));
-        if ( expiration_get (e) <= now_sec)
-        {
-            assert(zlistx_add_start (dead, asset_name));
-        }
-    }
-
+    s_data_check_clock (self);
+    int64_t now_ms = outage_clock_mono_ms (self->clock);
+    log_debug ("now=%" PRIi64 "ms", now_ms);
+    zlistx_t *dead = fty_outage_liveness_expire (self->liveness, now_ms);
+    assert (dead);
     return dead;
 }
 
 // support fn for test
-// - reads expiration time for device (source) from zhashx
+// - reads expiration time for device (source) from liveness
 uint64_t
 zhashx_get_expiration_test (data_t *self, char *source)
 {
     assert(self);
-    expiration_t *e = (expiration_t *) zhashx_lookup (self->assets, source);
-    return expiration_get (e);
+    asset_key_t key;
+    asset_key_init (&key, source);
+    fty_outage_liveness_state_t state;
+    int rv = fty_outage_liveness_state (self->liveness, &key, &state);
+    assert (rv == 0);
+    int64_t seen_ms = outage_clock_mono_to_wall (self->clock, state.seen_ms);
+    return (uint64_t) ((seen_ms + state.ttl_ms * 2) / 1000);
 }
 
 // print content of zlistx
@@ -339,10 +759,19 @@ zlistx_print_dead (zlistx_t *self) {
          it != NULL;
          it = zlistx_next(self))
     {
-        log_debug ("\t%s",(char *) it);
+        log_debug ("\t%s", ((asset_key_t *) it)->name);
     }
 }
 
+// key of the name for tests, valid till the next call
+static const asset_key_t *
+s_key (const char *name)
+{
+    static asset_key_t key;
+    asset_key_init (&key, name);
+    return &key;
+}
+
 void test0 (bool verbose)
 {
     if ( verbose )
@@ -353,45 +782,689 @@ void test0 (bool verbose)
         log_info ("%s: OK", __func__);
 }
 
-void test2 (bool verbose)
+void test4 (bool verbose)
 {
     if ( verbose )
-        log_info ("%s: expiration new/destroy test", __func__);
+        log_info ("%s: wall clock steps test", __func__);
+
+    outage_clock_t *clock = outage_clock_new_fake ((int64_t) 1500000000 * 1000, 1000);
+    data_t *data = data_new ();
+    data_set_clock (data, clock);
+    data_set_default_expiry (data, 10);
+
+    zhash_t *aux = zhash_new ();
+    zhash_insert (aux, "type", "device");
+    zhash_insert (aux, "subtype", "ups");
+    zmsg_t *asset = fty_proto_encode_asset (aux, "UPS1", "create", NULL);
+    fty_proto_t *proto = fty_proto_decode (&asset);
+    data_put (data, &proto);
+    zhash_destroy (&aux);
+
+    uint64_t now_sec = outage_clock_wall_ms (clock) / 1000;
+    assert (data_touch_asset (data, s_key ("UPS1"), now_sec, 10, now_sec) == 0);
+
+    // step forward: no false expiry
+    outage_clock_step (clock, 3600 * 1000);
+    outage_clock_advance (clock, 5000);
+    zlistx_t *dead = data_get_dead (data);
+    assert (zlistx_size (dead) == 0);
+    zlistx_destroy (&dead);
+
+    // metrics in new wall time keep asset alive, silence still detected in 2*ttl
+    now_sec = outage_clock_wall_ms (clock) / 1000;
+    assert (data_touch_asset (data, s_key ("UPS1"), now_sec, 10, now_sec) == 0);
+    outage_clock_advance (clock, 15000);
+    dead = data_get_dead (data);
+    assert (zlistx_size (dead) == 0);
+    zlistx_destroy (&dead);
+    outage_clock_advance (clock, 5000);
+    dead = data_get_dead (data);
+    assert (zlistx_size (dead) == 1);
+    zlistx_destroy (&dead);
+
+    // step backward: new metrics are not ignored as older than the last seen
+    now_sec = outage_clock_wall_ms (clock) / 1000;
+    uint64_t before_step_sec = now_sec;
+    outage_clock_step (clock, -7200 * 1000);
+    now_sec = outage_clock_wall_ms (clock) / 1000;
+    assert (data_touch_asset (data, s_key ("UPS1"), now_sec, 10, now_sec) == 0);
+    dead = data_get_dead (data);
+    assert (zlistx_size (dead) == 0);
+    zlistx_destroy (&dead);
+
+    // metric stamped before the step is tolerated as seen now
+    outage_clock_advance (clock, 15000);
+    now_sec = outage_clock_wall_ms (clock) / 1000;
+    assert (data_touch_asset (data, s_key ("UPS1"), before_step_sec, 10, now_sec) == CLOCK_SKEW_TOLERATED);
+    outage_clock_advance (clock, 15000);
+    dead = data_get_dead (data);
+    assert (zlistx_size (dead) == 0);
+    zlistx_destroy (&dead);
+
+    // ... after the grace period it is clamped to now and reported
+    outage_clock_advance (clock, CLOCK_STEP_GRACE_MS);
+    now_sec = outage_clock_wall_ms (clock) / 1000;
+    assert (data_touch_asset (data, s_key ("UPS1"), now_sec + 7200, 10, now_sec) == CLOCK_SKEW_CLAMPED);
+    fty_outage_liveness_state_t state;
+    assert (fty_outage_liveness_state (data->liveness, s_key ("UPS1"), &state) == 0);
+    assert (state.seen_ms == outage_clock_mono_ms (clock));
+    const clock_skew_source_t *skew = clock_skew_lookup (data_skew (data), s_key ("UPS1"));
+    assert (skew && skew->ahead == 2 && skew->clamped == 1);
+    assert (skew->max_sec == 7200);
+
+    // skew within tolerance is only counted, unknown asset is not tracked
+    assert (data_touch_asset (data, s_key ("UPS1"), now_sec + 1, 10, now_sec) == CLOCK_SKEW_TOLERATED);
+    assert (data_touch_asset (data, s_key ("UPS9"), now_sec + 7200, 10, now_sec) == 0);
+    assert (clock_skew_lookup (data_skew (data), s_key ("UPS9")) == NULL);
+    data_delete (data, s_key ("UPS1"));
+    assert (clock_skew_lookup (data_skew (data), s_key ("UPS1")) == NULL);
 
-    fty_proto_t *msg = fty_proto_new (FTY_PROTO_ASSET);
-    expiration_t *e = expiration_new(10, &msg);
+    data_destroy (&data);
+    outage_clock_destroy (&clock);
 
-    expiration_destroy (&e);
     if ( verbose )
         log_info ("%s: OK", __func__);
 }
 
-void test3 (bool verbose)
+void test5 (bool verbose)
 {
     if ( verbose )
-        log_info ("%s: expiration update/update_ttl test", __func__);
+        log_info ("%s: escalation deadlines test", __func__);
 
-    fty_proto_t *msg = fty_proto_new (FTY_PROTO_ASSET);
-    expiration_t *e = expiration_new (10, &msg);
-    zclock_sleep (1000);
+    outage_clock_t *clock = outage_clock_new_fake ((int64_t) 1500000000 * 1000, 1000);
+    data_t *data = data_new ();
+    data_set_clock (data, clock);
+    data_set_default_expiry (data, 10);
+    data_set_escalation (data, 1, 3);
 
-    uint64_t old_last_seen_date = e->last_time_seen_sec;
-    expiration_update (e, zclock_time() / 1000);
-    assert ( e->last_time_seen_sec != old_last_seen_date );
+    zhash_t *aux = zhash_new ();
+    zhash_insert (aux, "type", "device");
+    zhash_insert (aux, "subtype", "ups");
+    zmsg_t *asset = fty_proto_encode_asset (aux, "UPS1", "create", NULL);
+    fty_proto_t *proto = fty_proto_decode (&asset);
+    data_put (data, &proto);
+
+    // WARNING after 1 * ttl, CRITICAL after 3 * ttl
+    outage_clock_advance (clock, 9000);
+    zlistx_t *dead = data_get_dead (data);
+    assert (zlistx_size (dead) == 0);
+    zlistx_destroy (&dead);
+    assert (data_asset_level (data, s_key ("UPS1")) == DATA_LEVEL_NONE);
+    outage_clock_advance (clock, 1000);
+    dead = data_get_dead (data);
+    assert (zlistx_size (dead) == 1);
+    zlistx_destroy (&dead);
+    assert (data_asset_level (data, s_key ("UPS1")) == DATA_LEVEL_WARNING);
+    outage_clock_advance (clock, 20000);
+    dead = data_get_dead (data);
+    assert (zlistx_size (dead) == 1);
+    zlistx_destroy (&dead);
+    assert (data_asset_level (data, s_key ("UPS1")) == DATA_LEVEL_CRITICAL);
+
+    // metric brings it back, both deadlines are rescheduled
+    uint64_t now_sec = outage_clock_wall_ms (clock) / 1000;
+    assert (data_touch_asset (data, s_key ("UPS1"), now_sec, 10, now_sec) == 0);
+    assert (data_asset_level (data, s_key ("UPS1")) == DATA_LEVEL_NONE);
+    dead = data_get_dead (data);
+    assert (zlistx_size (dead) == 0);
+    zlistx_destroy (&dead);
+    outage_clock_advance (clock, 30000);
+    dead = data_get_dead (data);
+    assert (zlistx_size (dead) == 1);
+    zlistx_destroy (&dead);
+    assert (data_asset_level (data, s_key ("UPS1")) == DATA_LEVEL_CRITICAL);
+
+    // deleted asset leaves no deadlines behind
+    data_delete (data, s_key ("UPS1"));
+    assert (fty_outage_liveness_scheduled (data->liveness) == 0);
+    dead = data_get_dead (data);
+    assert (zlistx_size (dead) == 0);
+    zlistx_destroy (&dead);
+
+    // many assets with 2 deadlines each, timing is measured by data_bench
+    #define ESCALATION_ASSETS 100
+    for (int i = 0; i < ESCALATION_ASSETS; i++) {
+        char name [32];
+        snprintf (name, sizeof (name), "ups-%d", i);
+        asset = fty_proto_encode_asset (aux, name, "create", NULL);
+        proto = fty_proto_decode (&asset);
+        data_put (data, &proto);
+    }
+    assert (fty_outage_liveness_scheduled (data->liveness) == 2 * ESCALATION_ASSETS);
+
+    for (int round = 0; round < 10; round++) {
+        outage_clock_advance (clock, 1000);
+        now_sec = outage_clock_wall_ms (clock) / 1000;
+        for (int i = 0; i < ESCALATION_ASSETS; i++) {
+            char name [32];
+            snprintf (name, sizeof (name), "ups-%d", i);
+            data_touch_asset (data, s_key (name), now_sec - (i % 10), 10, now_sec);
+        }
+        dead = data_get_dead (data);
+        assert (zlistx_size (dead) == 0);
+        zlistx_destroy (&dead);
+    }
 
-    // from past!!
-    old_last_seen_date = e->last_time_seen_sec;
-    expiration_update (e, zclock_time() / 1000 - 10000);
-    assert ( e->last_time_seen_sec == old_last_seen_date );
+    // everybody goes silent, warnings first
+    outage_clock_advance (clock, 10000);
+    dead = data_get_dead (data);
+    assert (zlistx_size (dead) == ESCALATION_ASSETS);
+    zlistx_destroy (&dead);
+    assert (data_asset_level (data, s_key ("ups-0")) == DATA_LEVEL_WARNING);
+    assert (fty_outage_liveness_scheduled (data->liveness) == ESCALATION_ASSETS);
+    outage_clock_advance (clock, 20000);
+    dead = data_get_dead (data);
+    assert (zlistx_size (dead) == ESCALATION_ASSETS);
+    zlistx_destroy (&dead);
+    assert (fty_outage_liveness_scheduled (data->liveness) == 0);
+    assert (data_asset_level (data, s_key ("ups-0")) == DATA_LEVEL_CRITICAL);
+
+    zhash_destroy (&aux);
+    data_destroy (&data);
+    outage_clock_destroy (&clock);
+
+    if ( verbose )
+        log_info ("%s: OK", __func__);
+}
 
-    expiration_update_ttl (e, 1);
-    assert ( e->ttl_sec == 1 );
+void test6 (bool verbose)
+{
+    if ( verbose )
+        log_info ("%s: asset filter reload test", __func__);
 
-    expiration_update_ttl (e, 10);
-    assert ( e->ttl_sec == 1 ); // because 10 > 1
+    data_t *data = data_new ();
+    zhash_t *aux = zhash_new ();
+    zhash_insert (aux, "type", "device");
+    zhash_insert (aux, "subtype", "ups");
+    zmsg_t *asset = fty_proto_encode_asset (aux, "UPS1", "create", NULL);
+    fty_proto_t *proto = fty_proto_decode (&asset);
+    data_put (data, &proto);
+    zhash_update (aux, "subtype", "server");
+    asset = fty_proto_encode_asset (aux, "SRV1", "create", NULL);
+    proto = fty_proto_decode (&asset);
+    data_put (data, &proto);
+    assert (data_get_asset (data, s_key ("UPS1")));
+    assert (!data_get_asset (data, s_key ("SRV1")));
+
+    // servers are monitored, ups excluded by name
+    asset_filter_t *filter = asset_filter_new ();
+    zconfig_t *config = zconfig_new ("filter", NULL);
+    zconfig_put (config, "include/subtype", "ups,server");
+    zconfig_put (config, "exclude/name", "^UPS");
+    assert (asset_filter_load (filter, config) == 0);
+    zconfig_destroy (&config);
+    zlistx_t *removed = data_set_filter (data, &filter);
+    assert (!filter);
+    assert (zlistx_size (removed) == 1);
+    assert (streq ((char *) zlistx_first (removed), "UPS1"));
+    zlistx_destroy (&removed);
+    assert (!data_get_asset (data, s_key ("UPS1")));
+
+    asset = fty_proto_encode_asset (aux, "SRV1", "create", NULL);
+    proto = fty_proto_decode (&asset);
+    data_put (data, &proto);
+    assert (data_get_asset (data, s_key ("SRV1")));
+
+    // known asset updated out of the filter is dropped
+    zhash_update (aux, "subtype", "pdu");
+    asset = fty_proto_encode_asset (aux, "SRV1", "update", NULL);
+    proto = fty_proto_decode (&asset);
+    assert (!data_selects (data, proto));
+    data_transition_t transition;
+    assert (data_put_batch (data, &proto, 1, &transition) == 1);
+    assert (transition.type == DATA_DELETED);
+    assert (!proto);
+    assert (!data_get_asset (data, s_key ("SRV1")));
 
-    assert ( expiration_get (e) == old_last_seen_date + 1 * 2 );
-    expiration_destroy (&e);
+    zhash_destroy (&aux);
+    data_destroy (&data);
+
+    if ( verbose )
+        log_info ("%s: OK", __func__);
+}
+
+void test7 (bool verbose)
+{
+    if ( verbose )
+        log_info ("%s: memory accounting and compaction test", __func__);
+
+    // enough of them for hash tables to be rebuilt
+    #define CHURN_ASSETS 4096
+    data_t *data = data_new ();
+    zhash_t *aux = zhash_new ();
+    zhash_insert (aux, "type", "device");
+    zhash_insert (aux, "subtype", "ups");
+    zhash_t *ext = zhash_new ();
+    zhash_insert (ext, "name", "UPS");
+    char name [32];
+    for (int i = 0; i < CHURN_ASSETS; i++) {
+        snprintf (name, sizeof (name), "ups-%d", i);
+        zmsg_t *asset = fty_proto_encode_asset (aux, name, "create", ext);
+        fty_proto_t *proto = fty_proto_decode (&asset);
+        data_put (data, &proto);
+    }
+    data_memory_t full;
+    data_memory (data, &full);
+    assert (full.assets > CHURN_ASSETS * sizeof (asset_key_t));
+    assert (full.strings > 0 && full.messages > full.strings);
+    assert (full.heap >= CHURN_ASSETS * sizeof (void *));
+    // nothing to give back yet
+    assert (data_compact (data) == 0);
+
+    for (int i = 1; i < CHURN_ASSETS; i++) {
+        snprintf (name, sizeof (name), "ups-%d", i);
+        data_delete (data, s_key (name));
+    }
+    // enames go away with their assets
+    assert (!data_get_asset_ename (data, s_key ("ups-1")));
+    assert (streq (data_get_asset_ename (data, s_key ("ups-0")), "UPS"));
+    assert (data_compact (data) == 3);
+    assert (data_compact (data) == 0);
+    data_memory_t compacted;
+    data_memory (data, &compacted);
+    assert (compacted.assets < full.assets / 100);
+    assert (compacted.heap < full.heap);
+
+    // assets survive compaction
+    assert (data_get_asset (data, s_key ("ups-0")));
+    assert (streq (data_get_asset_ename (data, s_key ("ups-0")), "UPS"));
+    assert (data_touch_asset (data, s_key ("ups-0"), 100, 60, 100) == 0);
+    data_delete (data, s_key ("ups-0"));
+    assert (!data_get_asset (data, s_key ("ups-0")));
+
+    zhash_destroy (&aux);
+    zhash_destroy (&ext);
+    data_destroy (&data);
+
+    if ( verbose )
+        log_info ("%s: OK", __func__);
+}
+
+void test8 (bool verbose)
+{
+    if ( verbose )
+        log_info ("%s: batch updates test", __func__);
+
+    outage_clock_t *clock = outage_clock_new_fake ((int64_t) 1500000000 * 1000, 1000);
+    data_t *batch = data_new ();
+    data_t *single = data_new ();
+    data_set_clock (batch, clock);
+    data_set_clock (single, clock);
+    data_set_default_expiry (batch, 10);
+    data_set_default_expiry (single, 10);
+
+    zhash_t *aux = zhash_new ();
+    zhash_insert (aux, "type", "device");
+    zhash_insert (aux, "subtype", "ups");
+    const char *names [] = {"ups-0", "ups-1", "ups-2", "ups-3"};
+    fty_proto_t *protos [5];
+    for (int i = 0; i < 4; i++) {
+        zmsg_t *asset = fty_proto_encode_asset (aux, names [i], "create", NULL);
+        protos [i] = fty_proto_decode (&asset);
+        asset = fty_proto_encode_asset (aux, names [i], "create", NULL);
+        fty_proto_t *proto = fty_proto_decode (&asset);
+        data_put (single, &proto);
+    }
+    // deleting unknown asset is not a transition
+    zmsg_t *asset = fty_proto_encode_asset (aux, "ups-9", "delete", NULL);
+    protos [4] = fty_proto_decode (&asset);
+    data_transition_t transitions [8];
+    assert (data_put_batch (batch, protos, 5, transitions) == 4);
+    for (int i = 0; i < 4; i++) {
+        assert (!protos [i]);
+        assert (transitions [i].index == (size_t) i);
+        assert (transitions [i].type == DATA_ADDED);
+    }
+    assert (!protos [4]);
+
+    // ups-0 and ups-1 go silent
+    outage_clock_advance (clock, 9000);
+    uint64_t now_sec = outage_clock_wall_ms (clock) / 1000;
+    for (int i = 2; i < 4; i++) {
+        assert (data_touch_asset (batch, s_key (names [i]), now_sec, 10, now_sec) == 0);
+        assert (data_touch_asset (single, s_key (names [i]), now_sec, 10, now_sec) == 0);
+    }
+    outage_clock_advance (clock, 11000);
+    zlistx_t *dead = data_get_dead (batch);
+    assert (zlistx_size (dead) == 2);
+    zlistx_destroy (&dead);
+    dead = data_get_dead (single);
+    assert (zlistx_size (dead) == 2);
+    zlistx_destroy (&dead);
+
+    // duplicates, unknown asset and metric from future in one batch
+    now_sec = outage_clock_wall_ms (clock) / 1000;
+    struct { const char *name; uint64_t timestamp; uint64_t ttl; } metrics [] = {
+        {"ups-2", now_sec - 5, 30},
+        {"ups-0", now_sec - 1, 10},
+        {"ups-9", now_sec, 10},
+        {"ups-2", now_sec - 2, 20},
+        {"ups-3", now_sec + 7200, 10},
+        {"ups-0", now_sec - 3, 5},
+    };
+    size_t count = sizeof (metrics) / sizeof (metrics [0]);
+    data_touch_t items [6];
+    for (size_t i = 0; i < count; i++) {
+        asset_key_init (&items [i].key, metrics [i].name);
+        items [i].timestamp = metrics [i].timestamp;
+        items [i].ttl = metrics [i].ttl;
+        data_touch_asset (single, &items [i].key, metrics [i].timestamp, metrics [i].ttl, now_sec);
+    }
+    assert (data_touch_batch (batch, items, count, now_sec, transitions) == 1);
+    assert (transitions [0].index == 1 && transitions [0].type == DATA_REVIVED);
+    assert (data_touch_batch (batch, items, count, now_sec, NULL) == 0);
+    // metric from future is clamped to now, skew of unknown asset is not tracked
+    assert (clock_skew_lookup (data_skew (batch), s_key ("ups-3"))->clamped == 2);
+    assert (clock_skew_lookup (data_skew (single), s_key ("ups-3"))->clamped == 1);
+    assert (clock_skew_lookup (data_skew (batch), s_key ("ups-9")) == NULL);
+
+    // same state as touching item by item
+    for (int i = 0; i < 4; i++) {
+        fty_outage_liveness_state_t b, e;
+        assert (fty_outage_liveness_state (batch->liveness, s_key (names [i]), &b) == 0);
+        assert (fty_outage_liveness_state (single->liveness, s_key (names [i]), &e) == 0);
+        assert (b.ttl_ms == e.ttl_ms);
+        assert (b.seen_ms == e.seen_ms);
+        assert (b.level == e.level);
+        assert (b.deadline_ms == e.deadline_ms);
+    }
+    assert (data_asset_level (batch, s_key ("ups-0")) == DATA_LEVEL_NONE);
+    assert (data_asset_level (batch, s_key ("ups-1")) == DATA_LEVEL_CRITICAL);
+    data_memory_t memory;
+    data_memory (batch, &memory);
+    assert (memory.heap >= count * sizeof (fty_outage_liveness_touch_t));
+
+    asset = fty_proto_encode_asset (aux, "ups-1", "delete", NULL);
+    protos [0] = fty_proto_decode (&asset);
+    assert (data_put_batch (batch, protos, 1, transitions) == 1);
+    assert (transitions [0].index == 0 && transitions [0].type == DATA_DELETED);
+    assert (!data_get_asset (batch, s_key ("ups-1")));
+    assert (data_touch_batch (batch, NULL, 0, now_sec, NULL) == 0);
+
+    zhash_destroy (&aux);
+    data_destroy (&batch);
+    data_destroy (&single);
+    outage_clock_destroy (&clock);
+
+    if ( verbose )
+        log_info ("%s: OK", __func__);
+}
+
+// true if the location of data has the counters
+static bool
+s_location_counts (data_t *data, const char *location, size_t monitored, size_t dead)
+{
+    const outage_locations_stats_t *stats = outage_locations_lookup (data_locations (data), location);
+    if (!stats)
+        return monitored == 0 && dead == 0;
+    return stats->monitored == monitored && stats->dead == dead;
+}
+
+void test9 (bool verbose)
+{
+    if ( verbose )
+        log_info ("%s: per location aggregates test", __func__);
+
+    outage_clock_t *clock = outage_clock_new_fake ((int64_t) 1500000000 * 1000, 1000);
+    data_t *data = data_new ();
+    data_set_clock (data, clock);
+    data_set_default_expiry (data, 10);
+    // WARNING and CRITICAL of one asset count it dead once
+    data_set_escalation (data, 1, 2);
+
+    zhash_t *aux = zhash_new ();
+    zhash_insert (aux, "type", "device");
+    zhash_insert (aux, "subtype", "ups");
+    zhash_insert (aux, "parent_name.2", "room-1");
+    const char *names [] = {"ups-0", "ups-1", "ups-2"};
+    const char *racks [] = {"rack-1", "rack-1", "rack-2"};
+    for (int i = 0; i < 3; i++) {
+        zhash_update (aux, "parent_name.1", (void *) racks [i]);
+        zmsg_t *asset = fty_proto_encode_asset (aux, names [i], "create", NULL);
+        fty_proto_t *proto = fty_proto_decode (&asset);
+        data_put (data, &proto);
+    }
+    assert (s_location_counts (data, "room-1", 3, 0));
+    assert (s_location_counts (data, "rack-1", 2, 0));
+
+    // ups-0 goes silent, first WARNING then CRITICAL
+    outage_clock_advance (clock, 9000);
+    uint64_t now_sec = outage_clock_wall_ms (clock) / 1000;
+    assert (data_touch_asset (data, s_key ("ups-1"), now_sec, 10, now_sec) == 0);
+    assert (data_touch_asset (data, s_key ("ups-2"), now_sec, 10, now_sec) == 0);
+    outage_clock_advance (clock, 2000);
+    zlistx_t *dead = data_get_dead (data);
+    zlistx_destroy (&dead);
+    assert (data_asset_level (data, s_key ("ups-0")) == DATA_LEVEL_WARNING);
+    assert (s_location_counts (data, "room-1", 3, 1));
+    assert (s_location_counts (data, "rack-1", 2, 1));
+    outage_clock_advance (clock, 8000);
+    now_sec = outage_clock_wall_ms (clock) / 1000;
+    assert (data_touch_asset (data, s_key ("ups-1"), now_sec, 10, now_sec) == 0);
+    assert (data_touch_asset (data, s_key ("ups-2"), now_sec, 10, now_sec) == 0);
+    outage_clock_advance (clock, 1000);
+    dead = data_get_dead (data);
+    zlistx_destroy (&dead);
+    assert (data_asset_level (data, s_key ("ups-0")) == DATA_LEVEL_CRITICAL);
+    assert (s_location_counts (data, "room-1", 3, 1));
+
+    // dead asset moves to rack-2, then comes back alive
+    zhash_update (aux, "parent_name.1", "rack-2");
+    zmsg_t *asset = fty_proto_encode_asset (aux, "ups-0", "update", NULL);
+    fty_proto_t *proto = fty_proto_decode (&asset);
+    data_put (data, &proto);
+    assert (s_location_counts (data, "rack-1", 1, 0));
+    assert (s_location_counts (data, "rack-2", 2, 1));
+    now_sec = outage_clock_wall_ms (clock) / 1000;
+    assert (data_touch_asset (data, s_key ("ups-0"), now_sec, 10, now_sec) == 0);
+    assert (s_location_counts (data, "room-1", 3, 0));
+    assert (s_location_counts (data, "rack-2", 2, 0));
+
+    // deleted assets are not counted, empty location is gone
+    asset = fty_proto_encode_asset (aux, "ups-1", "delete", NULL);
+    proto = fty_proto_decode (&asset);
+    data_put (data, &proto);
+    assert (s_location_counts (data, "rack-1", 0, 0));
+    assert (outage_locations_size (data_locations (data)) == 2);
+    data_memory_t memory;
+    data_memory (data, &memory);
+    assert (memory.locations > 0);
+
+    // counts per subtype follow adds, subtype changes and deletes
+    int ups = outage_metrics_subtype ("ups");
+    int epdu = outage_metrics_subtype ("epdu");
+    assert (data_subtypes (data) [ups] == 2);
+    zhash_update (aux, "subtype", "epdu");
+    asset = fty_proto_encode_asset (aux, "ups-2", "update", NULL);
+    proto = fty_proto_decode (&asset);
+    data_put (data, &proto);
+    assert (data_subtypes (data) [ups] == 1);
+    assert (data_subtypes (data) [epdu] == 1);
+    asset = fty_proto_encode_asset (aux, "ups-2", "delete", NULL);
+    proto = fty_proto_decode (&asset);
+    data_put (data, &proto);
+    assert (data_subtypes (data) [epdu] == 0);
+    data_delete (data, s_key ("ups-0"));
+    assert (data_subtypes (data) [ups] == 0);
+
+    zhash_destroy (&aux);
+    data_destroy (&data);
+    outage_clock_destroy (&clock);
+
+    if ( verbose )
+        log_info ("%s: OK", __func__);
+}
+
+void test10 (bool verbose)
+{
+    if ( verbose )
+        log_info ("%s: touch elision test", __func__);
+
+    // the same metrics, all decoded by plain and elided when hinted by lazy
+    outage_clock_t *clock = outage_clock_new_fake ((int64_t) 1500000000 * 1000, 1000);
+    data_t *plain = data_new ();
+    data_t *lazy = data_new ();
+    data_set_clock (plain, clock);
+    data_set_clock (lazy, clock);
+    data_set_escalation (plain, 1, 2);
+    data_set_escalation (lazy, 1, 2);
+    touch_elision_t *elision = touch_elision_new (8, 16);
+
+    zhash_t *aux = zhash_new ();
+    zhash_insert (aux, "type", "device");
+    zhash_insert (aux, "subtype", "ups");
+    for (int i = 0; i < 2; i++) {
+        zmsg_t *asset = fty_proto_encode_asset (aux, "ups-1", "create", NULL);
+        fty_proto_t *proto = fty_proto_decode (&asset);
+        data_put (i == 0 ? plain : lazy, &proto);
+    }
+    zhash_destroy (&aux);
+
+    // 3 quantities each 250ms with ttl 16s, the device dies after 60s, one
+    // message per quantity is decoded each 16s/8
+    const char *subjects [] = {"realpower.default@ups-1", "load.default@ups-1", "voltage.input.L1@ups-1"};
+    const asset_key_t *key = s_key ("ups-1");
+    int metrics = 0;
+    int elided = 0;
+    for (int tick = 0; tick < 240; tick++) {
+        outage_clock_advance (clock, 250);
+        int64_t now_ms = outage_clock_mono_ms (clock);
+        uint64_t now_sec = outage_clock_wall_ms (clock) / 1000;
+        for (int i = 0; i < 3; i++) {
+            metrics++;
+            assert (data_touch_asset (plain, key, now_sec, 16, now_sec) == 0);
+            const asset_key_t *hinted = touch_elision_check (elision, subjects [i], now_ms);
+            if (hinted && data_elide_touch (lazy, hinted) == 0) {
+                elided++;
+                continue;
+            }
+            assert (data_touch_asset (lazy, key, now_sec, 16, now_sec) == 0);
+            int64_t age_ms = outage_clock_wall_ms (clock) - (int64_t) now_sec * 1000;
+            touch_elision_update (elision, subjects [i], key, 16000, age_ms, now_ms);
+        }
+    }
+    if ( verbose )
+        log_info ("%s: %d of %d metrics elided", __func__, elided, metrics);
+    assert (elided * 5 >= metrics * 4);
+
+    // detection latency is unchanged: both reach each level at the same tick
+    int warning_tick = -1, critical_tick = -1;
+    for (int tick = 1; tick <= 40 * 10; tick++) {
+        outage_clock_advance (clock, 100);
+        zlistx_t *dead = data_get_dead (plain);
+        zlistx_destroy (&dead);
+        dead = data_get_dead (lazy);
+        zlistx_destroy (&dead);
+        assert (data_asset_level (plain, key) == data_asset_level (lazy, key));
+        if (warning_tick == -1 && data_asset_level (lazy, key) == DATA_LEVEL_WARNING)
+            warning_tick = tick;
+        if (critical_tick == -1 && data_asset_level (lazy, key) == DATA_LEVEL_CRITICAL)
+            critical_tick = tick;
+    }
+    assert (warning_tick == 160);
+    assert (critical_tick == 320);
+
+    // silent asset is not touched by elision, metric must be decoded to revive it
+    assert (data_elide_touch (lazy, key) == -1);
+    assert (data_elide_touch (lazy, s_key ("ups-9")) == -1);
+
+    touch_elision_destroy (&elision);
+    data_destroy (&plain);
+    data_destroy (&lazy);
+    outage_clock_destroy (&clock);
+
+    if ( verbose )
+        log_info ("%s: OK", __func__);
+}
+
+void test11 (bool verbose)
+{
+    if ( verbose )
+        log_info ("%s: asset tiers test", __func__);
+
+    outage_clock_t *clock = outage_clock_new_fake ((int64_t) 1500000000 * 1000, 1000);
+    data_t *data = data_new ();
+    data_set_clock (data, clock);
+
+    zhash_t *aux = zhash_new ();
+    zhash_insert (aux, "type", "device");
+    zhash_insert (aux, "subtype", "ups");
+    zhash_insert (aux, FTY_PROTO_ASSET_PRIORITY, "1");
+    zmsg_t *asset = fty_proto_encode_asset (aux, "ups-1", "create", NULL);
+    fty_proto_t *proto = fty_proto_decode (&asset);
+    data_put (data, &proto);
+    zhash_update (aux, FTY_PROTO_ASSET_PRIORITY, "3");
+    asset = fty_proto_encode_asset (aux, "ups-2", "create", NULL);
+    proto = fty_proto_decode (&asset);
+    data_put (data, &proto);
+
+    // without tiers everything is left to the periodic check
+    assert (data_tiers_wait_ms (data) == -1);
+
+    // main UPSes are checked each second
+    asset_tiers_t *tiers = asset_tiers_new ();
+    zconfig_t *config = zconfig_new ("tiers", NULL);
+    zconfig_put (config, "critical/tick", "1000");
+    zconfig_put (config, "critical/priority", "P1");
+    assert (asset_tiers_load (tiers, config) == 0);
+    zconfig_destroy (&config);
+    data_set_tiers (data, &tiers);
+    assert (!tiers);
+    assert (fty_outage_liveness_tier (data->liveness, s_key ("ups-1")) == 1);
+    assert (fty_outage_liveness_tier (data->liveness, s_key ("ups-2")) == ASSET_TIERS_DEFAULT);
+    assert (fty_outage_liveness_tick (data->liveness, 1) == 1000);
+
+    // ups-1 is dead 10s after its last metric, the agent wakes up for it
+    uint64_t now_sec = outage_clock_wall_ms (clock) / 1000;
+    data_touch_asset (data, s_key ("ups-1"), now_sec, 5, now_sec);
+    data_touch_asset (data, s_key ("ups-2"), now_sec, 5, now_sec);
+    int64_t wait_ms = data_tiers_wait_ms (data);
+    assert (wait_ms > 9000 && wait_ms <= 10000);
+    outage_clock_advance (clock, wait_ms);
+    assert (data_tiers_wait_ms (data) == 0);
+    // the wakeup escalates just the tier which is due
+    zlistx_t *dead = data_expire_tiers (data);
+    assert (zlistx_size (dead) == 1);
+    assert (streq (((asset_key_t *) zlistx_first (dead))->name, "ups-1"));
+    zlistx_destroy (&dead);
+    assert (data_tiers_wait_ms (data) == -1);
+    assert (data_asset_level (data, s_key ("ups-2")) == DATA_LEVEL_NONE);
+    dead = data_expire_tiers (data);
+    assert (zlistx_size (dead) == 0);
+    zlistx_destroy (&dead);
+    dead = data_get_dead (data);
+    assert (zlistx_size (dead) == 2);
+    zlistx_destroy (&dead);
+
+    // asset changing its priority changes its tier
+    data_touch_asset (data, s_key ("ups-1"), now_sec + 10, 5, now_sec + 10);
+    assert (data_tiers_wait_ms (data) > 0);
+    asset = fty_proto_encode_asset (aux, "ups-1", "update", NULL);
+    proto = fty_proto_decode (&asset);
+    data_put (data, &proto);
+    assert (fty_outage_liveness_tier (data->liveness, s_key ("ups-1")) == ASSET_TIERS_DEFAULT);
+    assert (data_tiers_wait_ms (data) == -1);
+    assert (streq (fty_proto_aux_string (data_get_asset (data, s_key ("ups-1")), FTY_PROTO_ASSET_PRIORITY, ""), "3"));
+
+    // reloaded tiers match the updated message, not the first one
+    tiers = asset_tiers_new ();
+    config = zconfig_new ("tiers", NULL);
+    zconfig_put (config, "critical/tick", "1000");
+    zconfig_put (config, "critical/priority", "P1");
+    assert (asset_tiers_load (tiers, config) == 0);
+    zconfig_destroy (&config);
+    data_set_tiers (data, &tiers);
+    assert (fty_outage_liveness_tier (data->liveness, s_key ("ups-1")) == ASSET_TIERS_DEFAULT);
+    assert (data_tiers_wait_ms (data) == -1);
+
+    // dropped tiers reset their tick
+    tiers = asset_tiers_new ();
+    data_set_tiers (data, &tiers);
+    assert (fty_outage_liveness_tick (data->liveness, 1) == 0);
+
+    zhash_destroy (&aux);
+    data_destroy (&data);
+    outage_clock_destroy (&clock);
 
     if ( verbose )
         log_info ("%s: OK", __func__);
@@ -412,9 +1485,21 @@ data_test (bool verbose)
 
     test0 (verbose);
 
-    test2 (verbose);
+    test4 (verbose);
+
+    test5 (verbose);
+
+    test6 (verbose);
+
+    test7 (verbose);
 
-    test3 (verbose);
+    test8 (verbose);
+
+    test9 (verbose);
+
+    test10 (verbose);
+
+    test11 (verbose);
 
     //  aux data for metric - var_name | msg issued
     zhash_t *aux = zhash_new();
@@ -450,13 +1535,21 @@ data_test (bool verbose)
     data_put(data, &proto_n);
     zhash_destroy (&asset_aux);
 
+    // both assets are iterated
+    int iterated = 0;
+    for (fty_proto_t *msg = data_first (data); msg; msg = data_next (data)) {
+        assert (streq (fty_proto_name (msg), "UPS3") || streq (fty_proto_name (msg), "UPS4"));
+        iterated++;
+    }
+    assert (iterated == 2);
+
     // create new metric UPS4 - exp NOK
     uint64_t now_sec = zclock_time() / 1000;
-    int rv = data_touch_asset(data, "UPS4", now_sec, 3, now_sec);
+    int rv = data_touch_asset(data, s_key ("UPS4"), now_sec, 3, now_sec);
 
     // create new metric UPS3 - exp NOT OK
     now_sec = zclock_time() / 1000;
-    rv = data_touch_asset(data, "UPS3", now_sec, 1, now_sec);
+    rv = data_touch_asset(data, s_key ("UPS3"), now_sec, 1, now_sec);
 
     zclock_sleep (5000);
     // give me dead devices
@@ -469,7 +1562,7 @@ data_test (bool verbose)
 
     // update metric - exp OK
     now_sec = zclock_time() / 1000;
-    rv = data_touch_asset(data, "UPS4", now_sec, 2, now_sec);
+    rv = data_touch_asset(data, s_key ("UPS4"), now_sec, 2, now_sec);
     assert ( rv == 0 );
 
     // give me dead devices
@@ -490,7 +1583,7 @@ data_test (bool verbose)
     fty_proto_t* bmsg = fty_proto_decode (&msg);
     data_put (data, &bmsg);
 
-    assert (zhashx_lookup (data->assets, "PDU1"));
+    assert (data_get_asset (data, s_key ("PDU1")));
     now_sec = zclock_time() / 1000;
     uint64_t diff = zhashx_get_expiration_test (data, "PDU1") - now_sec;
     if (verbose)
@@ -498,7 +1591,7 @@ data_test (bool verbose)
     assert ( diff <= (data_default_expiry (data) * 2));
     // TODO: test it more
 
-    assert (streq (data_get_asset_ename (data, "PDU1"),"ename_of_pdu1"));
+    assert (streq (data_get_asset_ename (data, s_key ("PDU1")),"ename_of_pdu1"));
 
     zlistx_destroy(&list);
     fty_proto_destroy(&proto_n);
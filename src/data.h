@@ -33,6 +33,37 @@ typedef struct _data_t data_t;
 #define DATA_T_DEFINED
 #endif
 
+//  Escalation levels of silent asset
+#define DATA_LEVEL_NONE     FTY_OUTAGE_LIVENESS_ALIVE
+#define DATA_LEVEL_WARNING  FTY_OUTAGE_LIVENESS_WARNING
+#define DATA_LEVEL_CRITICAL FTY_OUTAGE_LIVENESS_CRITICAL
+#define DATA_LEVELS         FTY_OUTAGE_LIVENESS_LEVELS
+
+//  Estimated heap memory held by data, in bytes
+typedef struct _data_memory_t {
+    size_t assets;      //  asset records and hash tables indexing them
+    size_t strings;     //  asset names
+    size_t messages;    //  asset messages
+    size_t heap;        //  expiry index and scratch of batch touch
+    size_t skew;        //  statistics of metrics from future
+    size_t locations;   //  counters of locations and location chains of assets
+} data_memory_t;
+
+//  Transitions reported by batch updates
+#define DATA_ADDED      FTY_OUTAGE_LIVENESS_ADDED     //  asset started to be monitored
+#define DATA_DELETED    FTY_OUTAGE_LIVENESS_DELETED   //  asset is not monitored any more
+#define DATA_REVIVED    FTY_OUTAGE_LIVENESS_REVIVED   //  silent asset is alive again
+
+//  Metric touching an asset, item of batch touch
+typedef struct _data_touch_t {
+    asset_key_t key;
+    uint64_t timestamp;     //  [s] when the metric was measured
+    uint64_t ttl;           //  [s] time to live of the metric
+} data_touch_t;
+
+//  Transition caused by item of a batch
+typedef fty_outage_liveness_transition_t data_transition_t;
+
 //  @interface
 //  Create a new data
 FTY_OUTAGE_EXPORT data_t *
@@ -42,9 +73,22 @@ FTY_OUTAGE_EXPORT data_t *
 FTY_OUTAGE_EXPORT void
     data_destroy (data_t **self_p);
 
-// get asset unicode name
+// get asset unicode name, NULL if asset is not known
 FTY_OUTAGE_EXPORT const char*
-data_get_asset_ename (data_t *self, const char *asset_name);
+data_get_asset_ename (data_t *self, const asset_key_t *key);
+
+//  Return asset message of known asset, NULL if it is not known
+FTY_OUTAGE_EXPORT fty_proto_t *
+    data_get_asset (data_t *self, const asset_key_t *key);
+
+//  Return asset message of the first known asset, NULL if there are none
+FTY_OUTAGE_EXPORT fty_proto_t *
+    data_first (data_t *self);
+
+//  Return asset message of the next known asset, NULL after the last one.
+//  Assets must not be added or deleted while iterating.
+FTY_OUTAGE_EXPORT fty_proto_t *
+    data_next (data_t *self);
 
 //  Return default number of seconds in that newly added asset would expire
 FTY_OUTAGE_EXPORT uint64_t
@@ -54,24 +98,125 @@ FTY_OUTAGE_EXPORT uint64_t
 FTY_OUTAGE_EXPORT void
     data_set_default_expiry (data_t* self, uint64_t expiry_sec);
 
+//  Use another clock, it is not owned and must outlive the data
+FTY_OUTAGE_EXPORT void
+    data_set_clock (data_t *self, outage_clock_t *clock);
+
+//  Return the clock used by data
+FTY_OUTAGE_EXPORT outage_clock_t *
+    data_clock (data_t *self);
+
+//  Return statistics of metrics from future, their tolerance and reporting
+FTY_OUTAGE_EXPORT clock_skew_t *
+    data_skew (data_t *self);
+
+//  Return monitored and dead assets per location, kept up to date by
+//  transitions of assets
+FTY_OUTAGE_EXPORT outage_locations_t *
+    data_locations (data_t *self);
+
+//  Return monitored assets per outage_metrics_subtype, OUTAGE_METRICS_SUBTYPES
+//  counts kept up to date by adds, subtype changes and deletes of assets
+FTY_OUTAGE_EXPORT const size_t *
+    data_subtypes (data_t *self);
+
+//  Set after how many ttls of silence asset escalates to WARNING and to
+//  CRITICAL, warning_factor 0 disables WARNING. Defaults are 0 and 2.
+FTY_OUTAGE_EXPORT void
+    data_set_escalation (data_t *self, double warning_factor, double critical_factor);
+
+//  Return escalation level reached by the asset, DATA_LEVEL_NONE if unknown
+FTY_OUTAGE_EXPORT int
+    data_asset_level (data_t *self, const asset_key_t *key);
+
+//  Record transitions into the event log, it is not owned, NULL disables it
+FTY_OUTAGE_EXPORT void
+    data_set_event_log (data_t *self, event_log_t *event_log);
+
+//  Record transition of known asset, done elsewhere, into the event log
+FTY_OUTAGE_EXPORT void
+    data_log_event (data_t *self, int type, const asset_key_t *key);
+
+//  Return true if the asset message makes or keeps its asset monitored:
+//  it is not deleted, retired or nonactive and the filter selects it
+FTY_OUTAGE_EXPORT bool
+    data_selects (data_t *self, fty_proto_t *proto);
+
 //  calculates metric expiration time for each asset
 //  takes owneship of the message
 FTY_OUTAGE_EXPORT void
     data_put (data_t *self, fty_proto_t  **proto);
 
+//  Put batch of messages as data_put does, takes ownership of them. Fills
+//  transitions, if not NULL, room for count of them is needed, and returns
+//  their number.
+FTY_OUTAGE_EXPORT size_t
+    data_put_batch (data_t *self, fty_proto_t **protos, size_t count, data_transition_t *transitions);
+
+//  Replace the asset filter, takes ownership of it, and drop assets which
+//  are not selected by it any more. Returns list of dropped asset names.
+//  Messages of assets which were not selected are not kept, assets the new
+//  filter selects are added when their messages are put again.
+FTY_OUTAGE_EXPORT zlistx_t *
+    data_set_filter (data_t *self, asset_filter_t **filter_p);
+
+//  Replace the asset tiers, takes ownership of them, set resolution of
+//  deadlines of the tiers and move known assets to the tiers selecting them.
+FTY_OUTAGE_EXPORT void
+    data_set_tiers (data_t *self, asset_tiers_t **tiers_p);
+
+//  Return time [ms] till the earliest deadline of configured tiers is due,
+//  0 if it is due already, -1 if there is none. Deadlines of the default
+//  tier are left to the periodic data_get_dead.
+FTY_OUTAGE_EXPORT int64_t
+    data_tiers_wait_ms (data_t *self);
+
+//  Escalate assets of configured tiers whose deadlines are due, returns
+//  list of assets which reached a higher level now, zlistx entries are
+//  references to their asset_key_t. Assets dead already and the default
+//  tier are left to data_get_dead.
+FTY_OUTAGE_EXPORT zlistx_t *
+    data_expire_tiers (data_t *self);
+
 //  delete from cache
 FTY_OUTAGE_EXPORT void
-    data_delete (data_t *self, const char* source);
+    data_delete (data_t *self, const asset_key_t *key);
+
+//  Estimate heap memory held by data
+FTY_OUTAGE_EXPORT void
+    data_memory (data_t *self, data_memory_t *memory);
 
-//  Returns list of nonresponding devices, zlistx entries are refereces
+//  Shrink hash tables and the deadline heap left over-allocated by past
+//  asset churn. Returns number of structures compacted.
+FTY_OUTAGE_EXPORT int
+    data_compact (data_t *self);
+
+//  Returns list of nonresponding devices (which reached any escalation level),
+//  zlistx entries are refereces to their asset_key_t
 FTY_OUTAGE_EXPORT zlistx_t *
     data_get_dead (data_t *self);
 
-//  update information about expiration time
-//  return -1, if data are from future and are ignored as damaging
-//  return 0 otherwise
+//  update information about expiration time, metric from future is taken
+//  as seen now
+//  return CLOCK_SKEW_TOLERATED or CLOCK_SKEW_CLAMPED if metric of known
+//  asset is from future, 0 otherwise
+FTY_OUTAGE_EXPORT int
+    data_touch_asset (data_t *self, const asset_key_t *key, uint64_t timestamp, uint64_t ttl, uint64_t now_sec);
+
+//  Metric of alive asset arrived now and was not decoded, it is taken as
+//  seen now, its deadline moves once it is due, so escalation happens as
+//  after data_touch_asset, for the cost of one lookup
+//  return -1 if asset is not known or it is not alive, 0 otherwise
 FTY_OUTAGE_EXPORT int
-    data_touch_asset (data_t *self, const char *asset_name, uint64_t timestamp, uint64_t ttl, uint64_t now_sec);
+    data_elide_touch (data_t *self, const asset_key_t *key);
+
+//  Touch assets with batch of metrics as data_touch_asset does. Asset
+//  touched several times is rescheduled once, reaching the same state as
+//  by touching it item by item. Fills transitions, if not NULL, room for
+//  count of them is needed, in order of items touching an asset for the
+//  first time, and returns their number.
+FTY_OUTAGE_EXPORT size_t
+    data_touch_batch (data_t *self, const data_touch_t *items, size_t count, uint64_t now_sec, data_transition_t *transitions);
 
 //  Self test of this class
 FTY_OUTAGE_EXPORT void
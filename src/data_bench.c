@@ -0,0 +1,439 @@
+/*  =========================================================================
+    data_bench - Microbenchmark of the data API
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    data_bench - Microbenchmark of the data API
+@discuss
+    Drives data_put, data_touch_asset, data_get_dead and data_delete in
+    isolation on a fake clock, so results do not depend on wall time.
+    Input messages and asset names are prepared before the measurement.
+    Touch includes making the asset key, which is the only time a metric
+    has its asset name hashed, asset_key_init shows what that costs.
+    The same touches are then done by data_touch_batch in batches of 16
+    to 4096 metrics, filling the batch is measured as well.
+
+    With --escalation assets get a WARNING deadline after 1 ttl besides
+    the CRITICAL one after 3 ttls, data_get_dead/escalate then measures
+    the second expiry of all of them.
+
+    Reports ns/op, allocations/op and peak RSS of every benchmark, as
+    text or with --json as one JSON object per line.
+
+    With --churn every cycle adds all assets under new names, touches
+    them, lets them expire, deletes them and compacts the data. RSS after
+    each cycle must stay within --rss-slack of the first one, otherwise
+    the exit status is 1, so it works as a soak test of memory reuse.
+
+    Run with 'make bench-data BENCH_ARGS="..."'.
+@end
+*/
+
+#include <math.h>
+#include "fty_outage_classes.h"
+#include "../perf/alloc_count.h"
+
+#define DIST_UNIFORM    0
+#define DIST_SEQUENTIAL 1
+#define DIST_ZIPF       2
+
+//  results of measured loops which are not used otherwise
+static volatile uint64_t s_sink;
+
+typedef struct _options_t {
+    size_t assets;
+    size_t ops;
+    int dist;
+    const char *dist_name;
+    const char *ttls;
+    uint64_t *ttl_values;
+    size_t ttl_count;
+    unsigned int seed;
+    bool json;
+    size_t churn;
+    double rss_slack;
+    bool escalation;
+} options_t;
+
+static void
+s_bench_stop (bench_t *bench, options_t *options, size_t ops)
+{
+    double ns_per_op, allocs_per_op;
+    s_bench_per_op (bench, ops, &ns_per_op, &allocs_per_op);
+    if (options->json)
+        printf ("{\"bench\":\"%s\",\"assets\":%zu,\"ops\":%zu,\"dist\":\"%s\",\"ttl\":\"%s\","
+                "\"ns_per_op\":%.1f,\"allocs_per_op\":%.3f,\"peak_rss_kb\":%ld}\n",
+            bench->name, options->assets, ops, options->dist_name, options->ttls,
+            ns_per_op, allocs_per_op, s_peak_rss_kb ());
+    else
+        printf ("%-24s %10zu ops %12.1f ns/op %8.3f allocs/op %10ld kB peak RSS\n",
+            bench->name, ops, ns_per_op, allocs_per_op, s_peak_rss_kb ());
+}
+
+//  keys of operations in given distribution, zipf with s = 1
+static size_t *
+s_keys_new (options_t *options)
+{
+    size_t *keys = (size_t *) malloc (options->ops * sizeof (size_t));
+    double *cdf = NULL;
+    assert (keys);
+    if (options->dist == DIST_ZIPF) {
+        cdf = (double *) malloc (options->assets * sizeof (double));
+        assert (cdf);
+        double sum = 0;
+        for (size_t i = 0; i < options->assets; i++) {
+            sum += 1.0 / (i + 1);
+            cdf [i] = sum;
+        }
+        for (size_t i = 0; i < options->assets; i++)
+            cdf [i] /= sum;
+    }
+    for (size_t op = 0; op < options->ops; op++) {
+        if (options->dist == DIST_SEQUENTIAL)
+            keys [op] = op % options->assets;
+        else
+        if (options->dist == DIST_UNIFORM)
+            keys [op] = (size_t) rand_r (&options->seed) % options->assets;
+        else {
+            double u = (double) rand_r (&options->seed) / RAND_MAX;
+            size_t low = 0, high = options->assets - 1;
+            while (low < high) {
+                size_t middle = low + (high - low) / 2;
+                if (cdf [middle] < u)
+                    low = middle + 1;
+                else
+                    high = middle;
+            }
+            keys [op] = low;
+        }
+    }
+    free (cdf);
+    return keys;
+}
+
+static int
+s_parse_ttls (options_t *options)
+{
+    options->ttl_count = 1;
+    for (const char *c = options->ttls; *c; c++)
+        if (*c == ',')
+            options->ttl_count++;
+    options->ttl_values = (uint64_t *) malloc (options->ttl_count * sizeof (uint64_t));
+    assert (options->ttl_values);
+    const char *c = options->ttls;
+    for (size_t i = 0; i < options->ttl_count; i++) {
+        options->ttl_values [i] = (uint64_t) strtoull (c, (char **) &c, 10);
+        if (options->ttl_values [i] == 0)
+            return -1;
+        if (*c == ',')
+            c++;
+    }
+    return 0;
+}
+
+//  repeated add/expire/delete cycles, RSS has to stay bounded
+static int
+s_churn (options_t *options)
+{
+    outage_clock_t *clock = outage_clock_new_fake ((int64_t) 1500000000 * 1000, 1000);
+    data_t *data = data_new ();
+    assert (clock && data);
+    data_set_clock (data, clock);
+    zhash_t *aux = zhash_new ();
+    zhash_insert (aux, FTY_PROTO_ASSET_TYPE, "device");
+    zhash_insert (aux, FTY_PROTO_ASSET_SUBTYPE, "ups");
+    char **names = (char **) malloc (options->assets * sizeof (char *));
+    assert (names);
+
+    size_t first_rss = 0;
+    size_t max_rss = 0;
+    for (size_t cycle = 0; cycle < options->churn; cycle++) {
+        int64_t start_ns = s_now_ns ();
+        for (size_t i = 0; i < options->assets; i++) {
+            names [i] = zsys_sprintf ("ups-%zu-%zu", cycle, i);
+            zmsg_t *msg = fty_proto_encode_asset (aux, names [i], FTY_PROTO_ASSET_OP_CREATE, NULL);
+            fty_proto_t *proto = fty_proto_decode (&msg);
+            data_put (data, &proto);
+        }
+        uint64_t now_sec = outage_clock_wall_ms (clock) / 1000;
+        asset_key_t key;
+        for (size_t i = 0; i < options->assets; i++) {
+            asset_key_init (&key, names [i]);
+            data_touch_asset (data, &key, now_sec, options->ttl_values [i % options->ttl_count], now_sec);
+        }
+        outage_clock_advance (clock, 24 * 3600 * 1000);
+        zlistx_t *dead = data_get_dead (data);
+        size_t dead_count = zlistx_size (dead);
+        zlistx_destroy (&dead);
+        data_memory_t memory;
+        data_memory (data, &memory);
+        size_t estimate = memory.assets + memory.strings + memory.messages + memory.heap;
+        for (size_t i = 0; i < options->assets; i++) {
+            asset_key_init (&key, names [i]);
+            data_delete (data, &key);
+            zstr_free (&names [i]);
+        }
+        int compacted = data_compact (data);
+        memory_usage_trim ();
+        size_t rss = memory_usage_rss ();
+        if (cycle == 0)
+            first_rss = rss;
+        if (rss > max_rss)
+            max_rss = rss;
+        double elapsed_ms = (double) (s_now_ns () - start_ns) / 1000000;
+        if (options->json)
+            printf ("{\"bench\":\"churn\",\"cycle\":%zu,\"assets\":%zu,\"dead\":%zu,\"estimate_kb\":%zu,"
+                    "\"compacted\":%d,\"rss_kb\":%zu,\"ms\":%.1f}\n",
+                cycle, options->assets, dead_count, estimate / 1024, compacted, rss / 1024, elapsed_ms);
+        else
+            printf ("churn %4zu: %zu dead, %10zu kB estimated at peak, %d compacted, %10zu kB RSS, %.1f ms\n",
+                cycle, dead_count, estimate / 1024, compacted, rss / 1024, elapsed_ms);
+    }
+
+    free (names);
+    zhash_destroy (&aux);
+    data_destroy (&data);
+    outage_clock_destroy (&clock);
+
+    bool bounded = max_rss <= first_rss * (1 + options->rss_slack / 100);
+    printf ("churn: RSS %zu kB after first cycle, %zu kB max, %s\n",
+        first_rss / 1024, max_rss / 1024, bounded ? "bounded" : "GROWING");
+    return bounded ? 0 : 1;
+}
+
+int main (int argc, char *argv [])
+{
+    //  benchmarks are single threaded, count everything
+    s_counting = true;
+    options_t options = {
+        .assets = 10000,
+        .ops = 1000000,
+        .dist = DIST_UNIFORM,
+        .dist_name = "uniform",
+        .ttls = "60",
+        .seed = 1,
+        .rss_slack = 10
+    };
+
+    int argn;
+    for (argn = 1; argn < argc; argn++) {
+        if (streq (argv [argn], "--help")
+        ||  streq (argv [argn], "-h")) {
+            puts ("data_bench [options] ...");
+            puts ("  --assets / -a count    number of assets [10000]");
+            puts ("  --ops / -o count       number of touches [1000000]");
+            puts ("  --dist / -d name       key distribution of touches: uniform, sequential, zipf [uniform]");
+            puts ("  --ttl / -t list        comma separated ttls [s] assigned to assets round robin [60]");
+            puts ("  --seed / -s number     random seed [1]");
+            puts ("  --json / -j            JSON line per benchmark");
+            puts ("  --escalation / -e      WARNING after 1 ttl and CRITICAL after 3 ttls of silence");
+            puts ("  --churn / -c cycles    soak: add, expire and delete all assets each cycle [0]");
+            puts ("  --rss-slack percent    allowed RSS growth over the first churn cycle [10]");
+            puts ("  --help / -h            this information");
+            return 0;
+        }
+        else
+        if ((streq (argv [argn], "--assets") || streq (argv [argn], "-a")) && argn + 1 < argc)
+            options.assets = (size_t) atol (argv [++argn]);
+        else
+        if ((streq (argv [argn], "--ops") || streq (argv [argn], "-o")) && argn + 1 < argc)
+            options.ops = (size_t) atol (argv [++argn]);
+        else
+        if ((streq (argv [argn], "--dist") || streq (argv [argn], "-d")) && argn + 1 < argc) {
+            options.dist_name = argv [++argn];
+            if (streq (options.dist_name, "uniform"))
+                options.dist = DIST_UNIFORM;
+            else
+            if (streq (options.dist_name, "sequential"))
+                options.dist = DIST_SEQUENTIAL;
+            else
+            if (streq (options.dist_name, "zipf"))
+                options.dist = DIST_ZIPF;
+            else {
+                fprintf (stderr, "Unknown distribution: %s\n", options.dist_name);
+                return 1;
+            }
+        }
+        else
+        if ((streq (argv [argn], "--ttl") || streq (argv [argn], "-t")) && argn + 1 < argc)
+            options.ttls = argv [++argn];
+        else
+        if ((streq (argv [argn], "--seed") || streq (argv [argn], "-s")) && argn + 1 < argc)
+            options.seed = (unsigned int) atol (argv [++argn]);
+        else
+        if (streq (argv [argn], "--json") || streq (argv [argn], "-j"))
+            options.json = true;
+        else
+        if (streq (argv [argn], "--escalation") || streq (argv [argn], "-e"))
+            options.escalation = true;
+        else
+        if ((streq (argv [argn], "--churn") || streq (argv [argn], "-c")) && argn + 1 < argc)
+            options.churn = (size_t) atol (argv [++argn]);
+        else
+        if (streq (argv [argn], "--rss-slack") && argn + 1 < argc)
+            options.rss_slack = atof (argv [++argn]);
+        else {
+            fprintf (stderr, "Unknown option: %s\n", argv [argn]);
+            return 1;
+        }
+    }
+    if (options.assets == 0 || s_parse_ttls (&options) != 0) {
+        fprintf (stderr, "Invalid number of assets or ttl\n");
+        return 1;
+    }
+#if !defined (__GLIBC__)
+    fprintf (stderr, "allocations are not counted on this platform\n");
+#endif
+    ftylog_setInstance ("data_bench", "");
+    if (options.churn > 0) {
+        int rv = s_churn (&options);
+        free (options.ttl_values);
+        return rv;
+    }
+
+    // inputs prepared outside of measurements
+    outage_clock_t *clock = outage_clock_new_fake ((int64_t) 1500000000 * 1000, 1000);
+    char **names = (char **) malloc (options.assets * sizeof (char *));
+    fty_proto_t **protos = (fty_proto_t **) malloc (options.assets * sizeof (fty_proto_t *));
+    assert (clock && names && protos);
+    zhash_t *aux = zhash_new ();
+    zhash_insert (aux, FTY_PROTO_ASSET_TYPE, "device");
+    zhash_insert (aux, FTY_PROTO_ASSET_SUBTYPE, "ups");
+    for (size_t i = 0; i < options.assets; i++) {
+        names [i] = zsys_sprintf ("ups-%zu", i);
+        zmsg_t *msg = fty_proto_encode_asset (aux, names [i], FTY_PROTO_ASSET_OP_CREATE, NULL);
+        protos [i] = fty_proto_decode (&msg);
+    }
+    zhash_destroy (&aux);
+    size_t *keys = s_keys_new (&options);
+
+    data_t *data = data_new ();
+    assert (data);
+    data_set_clock (data, clock);
+    if (options.escalation)
+        data_set_escalation (data, 1, 3);
+    bench_t bench;
+
+    s_bench_start (&bench, "data_put");
+    for (size_t i = 0; i < options.assets; i++)
+        data_put (data, &protos [i]);
+    s_bench_stop (&bench, &options, options.assets);
+
+    // hashing alone, once per metric
+    asset_key_t asset_key;
+    uint64_t hashes = 0;
+    s_bench_start (&bench, "asset_key_init");
+    for (size_t op = 0; op < options.ops; op++) {
+        asset_key_init (&asset_key, names [keys [op]]);
+        hashes += asset_key.hash;
+    }
+    s_bench_stop (&bench, &options, options.ops);
+    s_sink = hashes;
+
+    // one touch per ms of fake time
+    s_bench_start (&bench, "data_touch_asset");
+    for (size_t op = 0; op < options.ops; op++) {
+        size_t key = keys [op];
+        outage_clock_advance (clock, 1);
+        uint64_t now_sec = outage_clock_wall_ms (clock) / 1000;
+        asset_key_init (&asset_key, names [key]);
+        data_touch_asset (data, &asset_key, now_sec, options.ttl_values [key % options.ttl_count], now_sec);
+    }
+    s_bench_stop (&bench, &options, options.ops);
+
+    // same touches in batches, one batch per batch size ms of fake time
+    size_t batch_sizes [] = {16, 64, 256, 1024, 4096};
+    data_touch_t *items = (data_touch_t *) malloc (4096 * sizeof (data_touch_t));
+    data_transition_t *transitions = (data_transition_t *) malloc (4096 * sizeof (data_transition_t));
+    assert (items && transitions);
+    for (size_t i = 0; i < sizeof (batch_sizes) / sizeof (batch_sizes [0]); i++) {
+        size_t batch_size = batch_sizes [i];
+        char name [32];
+        snprintf (name, sizeof (name), "data_touch_batch/%zu", batch_size);
+        s_bench_start (&bench, name);
+        for (size_t op = 0; op < options.ops; op += batch_size) {
+            size_t count = options.ops - op < batch_size ? options.ops - op : batch_size;
+            outage_clock_advance (clock, (int64_t) count);
+            uint64_t now_sec = outage_clock_wall_ms (clock) / 1000;
+            for (size_t item = 0; item < count; item++) {
+                size_t key = keys [op + item];
+                asset_key_init (&items [item].key, names [key]);
+                items [item].timestamp = now_sec;
+                items [item].ttl = options.ttl_values [key % options.ttl_count];
+            }
+            data_touch_batch (data, items, count, now_sec, transitions);
+        }
+        s_bench_stop (&bench, &options, options.ops);
+    }
+    free (items);
+    free (transitions);
+
+    // periodic check right after the touches, only cold keys may be dead
+    size_t rounds = 1000;
+    s_bench_start (&bench, "data_get_dead/steady");
+    for (size_t round = 0; round < rounds; round++) {
+        zlistx_t *dead = data_get_dead (data);
+        zlistx_destroy (&dead);
+    }
+    s_bench_stop (&bench, &options, rounds);
+
+    // all of them expire at once, then stay dead
+    uint64_t max_ttl = 0;
+    for (size_t i = 0; i < options.ttl_count; i++)
+        if (options.ttl_values [i] > max_ttl)
+            max_ttl = options.ttl_values [i];
+    outage_clock_advance (clock, (int64_t) (max_ttl * 2 + 1) * 1000 + (int64_t) options.ops);
+    s_bench_start (&bench, "data_get_dead/expire");
+    zlistx_t *dead = data_get_dead (data);
+    zlistx_destroy (&dead);
+    s_bench_stop (&bench, &options, 1);
+    if (options.escalation) {
+        // WARNING deadlines passed above, CRITICAL ones are left
+        outage_clock_advance (clock, (int64_t) max_ttl * 1000);
+        s_bench_start (&bench, "data_get_dead/escalate");
+        dead = data_get_dead (data);
+        zlistx_destroy (&dead);
+        s_bench_stop (&bench, &options, 1);
+    }
+    s_bench_start (&bench, "data_get_dead/dead");
+    for (size_t round = 0; round < 10; round++) {
+        dead = data_get_dead (data);
+        zlistx_destroy (&dead);
+    }
+    s_bench_stop (&bench, &options, 10);
+
+    s_bench_start (&bench, "data_delete");
+    for (size_t i = 0; i < options.assets; i++) {
+        asset_key_init (&asset_key, names [i]);
+        data_delete (data, &asset_key);
+    }
+    s_bench_stop (&bench, &options, options.assets);
+
+    data_destroy (&data);
+    for (size_t i = 0; i < options.assets; i++)
+        zstr_free (&names [i]);
+    free (names);
+    free (protos);
+    free (keys);
+    free (options.ttl_values);
+    outage_clock_destroy (&clock);
+    return 0;
+}
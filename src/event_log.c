@@ -0,0 +1,337 @@
+/*  =========================================================================
+    event_log - Memory mapped ring of outage state transitions
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    event_log - Memory mapped ring of outage state transitions
+@discuss
+    Every transition of monitored asset (added, deleted, expired, revived,
+    alert sent, resolved or suppressed) is stored as fixed size binary
+    record into a ring in memory mapped file. Recording is a copy into
+    the mapping, there are no syscalls, so the log can stay on in
+    production. The kernel writes the pages back, so records survive crash
+    of the agent. Ring is continued after restart if its size matches.
+
+    File starts with 64 bytes header (magic, version, record size,
+    capacity and sequence of the last record) followed by the records.
+    Use fty-outage-events to dump and filter it.
+@end
+*/
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include "fty_outage_classes.h"
+
+#define EVENT_LOG_MAGIC     "FTYOEVT1"
+#define EVENT_LOG_VERSION   1
+
+typedef struct _event_log_header_t {
+    char magic [8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t capacity;          // number of records in the ring
+    uint64_t sequence;          // sequence of the last written record
+    char reserved [32];
+} event_log_header_t;
+
+//  Structure of our class
+struct _event_log_t {
+    int fd;
+    void *map;
+    size_t map_size;
+    event_log_header_t *header;
+    event_log_record_t *records;
+    outage_clock_t *clock;      // NULL if opened for reading
+};
+
+static const char *TYPE_NAMES [] = {
+    "UNKNOWN", "ADDED", "DELETED", "EXPIRED", "REVIVED", "ACTIVE", "RESOLVED", "SUPPRESSED"
+};
+
+//  --------------------------------------------------------------------------
+//  Destroy the event log
+void
+event_log_destroy (event_log_t **self_p)
+{
+    assert (self_p);
+    if (*self_p) {
+        event_log_t *self = *self_p;
+        if (self->map)
+            munmap (self->map, self->map_size);
+        if (self->fd != -1)
+            close (self->fd);
+        free (self);
+        *self_p = NULL;
+    }
+}
+
+// map the file of 'map_size' bytes, return -1 on error
+static int
+s_event_log_map (event_log_t *self, size_t map_size, int prot)
+{
+    void *map = mmap (NULL, map_size, prot, MAP_SHARED, self->fd, 0);
+    if (map == MAP_FAILED)
+        return -1;
+    self->map = map;
+    self->map_size = map_size;
+    self->header = (event_log_header_t *) map;
+    self->records = (event_log_record_t *) ((char *) map + sizeof (event_log_header_t));
+    return 0;
+}
+
+static bool
+s_event_log_header_valid (event_log_header_t *header, size_t file_size)
+{
+    return memcmp (header->magic, EVENT_LOG_MAGIC, sizeof (header->magic)) == 0
+        && header->version == EVENT_LOG_VERSION
+        && header->record_size == sizeof (event_log_record_t)
+        && header->capacity > 0
+        && sizeof (event_log_header_t) + header->capacity * sizeof (event_log_record_t) == file_size;
+}
+
+//  --------------------------------------------------------------------------
+//  Create or continue the ring of 'records' records in file 'path'
+event_log_t *
+event_log_new (const char *path, size_t records, outage_clock_t *clock)
+{
+    assert (path);
+    assert (records > 0);
+    assert (clock);
+
+    event_log_t *self = (event_log_t *) zmalloc (sizeof (event_log_t));
+    if (!self)
+        return NULL;
+    self->clock = clock;
+    self->fd = open (path, O_RDWR | O_CREAT | O_CLOEXEC, 0640);
+    if (self->fd == -1) {
+        log_error ("Can't open event log %s: %m", path);
+        event_log_destroy (&self);
+        return NULL;
+    }
+
+    size_t map_size = sizeof (event_log_header_t) + records * sizeof (event_log_record_t);
+    struct stat st;
+    bool reuse = fstat (self->fd, &st) == 0 && (size_t) st.st_size == map_size;
+    if (!reuse && (ftruncate (self->fd, 0) != 0 || ftruncate (self->fd, (off_t) map_size) != 0)) {
+        log_error ("Can't resize event log %s: %m", path);
+        event_log_destroy (&self);
+        return NULL;
+    }
+    if (s_event_log_map (self, map_size, PROT_READ | PROT_WRITE) != 0) {
+        log_error ("Can't map event log %s: %m", path);
+        event_log_destroy (&self);
+        return NULL;
+    }
+    if (!reuse || !s_event_log_header_valid (self->header, map_size)) {
+        memset (self->map, 0, map_size);
+        memcpy (self->header->magic, EVENT_LOG_MAGIC, sizeof (self->header->magic));
+        self->header->version = EVENT_LOG_VERSION;
+        self->header->record_size = sizeof (event_log_record_t);
+        self->header->capacity = records;
+    }
+    log_info ("event log %s: %zu records, continues at %" PRIu64, path, records, self->header->sequence);
+    return self;
+}
+
+//  --------------------------------------------------------------------------
+//  Open the ring in file 'path' for reading
+event_log_t *
+event_log_open (const char *path)
+{
+    assert (path);
+
+    event_log_t *self = (event_log_t *) zmalloc (sizeof (event_log_t));
+    if (!self)
+        return NULL;
+    self->fd = open (path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (self->fd == -1
+        || fstat (self->fd, &st) != 0
+        || (size_t) st.st_size < sizeof (event_log_header_t)
+        || s_event_log_map (self, (size_t) st.st_size, PROT_READ) != 0
+        || !s_event_log_header_valid (self->header, (size_t) st.st_size))
+    {
+        event_log_destroy (&self);
+        return NULL;
+    }
+    return self;
+}
+
+//  --------------------------------------------------------------------------
+//  Record one transition of 'asset'
+void
+event_log_record (event_log_t *self, int type, int level, const char *asset,
+    uint64_t ttl_sec, uint64_t last_seen_sec, int64_t deadline_ms)
+{
+    assert (self);
+    assert (self->clock);
+    assert (asset);
+
+    uint64_t sequence = self->header->sequence + 1;
+    event_log_record_t *record = &self->records [(sequence - 1) % self->header->capacity];
+    record->time_ms = outage_clock_wall_ms (self->clock);
+    record->ttl_sec = ttl_sec;
+    record->last_seen_sec = last_seen_sec;
+    record->deadline_ms = deadline_ms;
+    record->type = (uint8_t) type;
+    record->level = (uint8_t) level;
+    strncpy (record->asset, asset, EVENT_LOG_ASSET_SIZE - 1);
+    record->asset [EVENT_LOG_ASSET_SIZE - 1] = '\0';
+    // readers of the live file see the record once sequences are stored
+    __atomic_store_n (&record->sequence, sequence, __ATOMIC_RELEASE);
+    __atomic_store_n (&self->header->sequence, sequence, __ATOMIC_RELEASE);
+}
+
+//  --------------------------------------------------------------------------
+//  Return number of records available in the ring
+size_t
+event_log_size (event_log_t *self)
+{
+    assert (self);
+    uint64_t sequence = __atomic_load_n (&self->header->sequence, __ATOMIC_ACQUIRE);
+    return (size_t) (sequence < self->header->capacity ? sequence : self->header->capacity);
+}
+
+//  --------------------------------------------------------------------------
+//  Return index-th available record, the oldest first, NULL if there is none
+const event_log_record_t *
+event_log_get (event_log_t *self, size_t index)
+{
+    assert (self);
+    uint64_t sequence = __atomic_load_n (&self->header->sequence, __ATOMIC_ACQUIRE);
+    size_t size = (size_t) (sequence < self->header->capacity ? sequence : self->header->capacity);
+    if (index >= size)
+        return NULL;
+    uint64_t wanted = sequence - size + 1 + index;
+    event_log_record_t *record = &self->records [(wanted - 1) % self->header->capacity];
+    // overwritten by the writer meanwhile
+    if (__atomic_load_n (&record->sequence, __ATOMIC_ACQUIRE) != wanted)
+        return NULL;
+    return record;
+}
+
+//  --------------------------------------------------------------------------
+//  Return name of record type
+const char *
+event_log_type_name (int type)
+{
+    if (type < 0 || (size_t) type >= sizeof (TYPE_NAMES) / sizeof (TYPE_NAMES [0]))
+        type = 0;
+    return TYPE_NAMES [type];
+}
+
+// format wall time in ms as local time
+static void
+s_format_time (int64_t time_ms, char *buffer, size_t size)
+{
+    time_t time_sec = (time_t) (time_ms / 1000);
+    struct tm tm;
+    localtime_r (&time_sec, &tm);
+    size_t length = strftime (buffer, size, "%Y-%m-%d %H:%M:%S", &tm);
+    snprintf (buffer + length, size - length, ".%03d", (int) (time_ms % 1000));
+}
+
+//  --------------------------------------------------------------------------
+//  Print the record as one line
+void
+event_log_print (const event_log_record_t *record, FILE *file)
+{
+    assert (record);
+    assert (file);
+
+    char time [32];
+    char deadline [32] = "-";
+    s_format_time (record->time_ms, time, sizeof (time));
+    if (record->deadline_ms)
+        s_format_time (record->deadline_ms, deadline, sizeof (deadline));
+    fprintf (file, "%s #%" PRIu64 " %-10s level=%d asset=%s ttl=%" PRIu64 "s last_seen=%" PRIu64 " deadline=%s\n",
+        time, record->sequence, event_log_type_name (record->type), record->level,
+        record->asset, record->ttl_sec, record->last_seen_sec, deadline);
+}
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+void
+event_log_test (bool verbose)
+{
+    printf (" * event_log: ");
+
+    //  @selftest
+    const char *path = "src/selftest-rw/event_log.ring";
+    assert (sizeof (event_log_header_t) == 64);
+    assert (sizeof (event_log_record_t) == 96);
+
+    outage_clock_t *clock = outage_clock_new_fake ((int64_t) 1500000000 * 1000, 1000);
+    event_log_t *self = event_log_new (path, 4, clock);
+    assert (self);
+    assert (event_log_size (self) == 0);
+    assert (event_log_get (self, 0) == NULL);
+
+    event_log_record (self, EVENT_LOG_ADDED, 0, "ups-1", 300, 1500000000, 1500000600000);
+    outage_clock_advance (clock, 1000);
+    event_log_record (self, EVENT_LOG_ACTIVE, 2,
+        "asset-with-very-long-name-which-does-not-fit-into-the-record", 300, 1500000000, 0);
+    assert (event_log_size (self) == 2);
+    const event_log_record_t *record = event_log_get (self, 0);
+    assert (record->sequence == 1);
+    assert (record->type == EVENT_LOG_ADDED);
+    assert (streq (record->asset, "ups-1"));
+    assert (record->time_ms == (int64_t) 1500000000 * 1000);
+    record = event_log_get (self, 1);
+    assert (record->level == 2);
+    assert (strlen (record->asset) == EVENT_LOG_ASSET_SIZE - 1);
+    if (verbose)
+        event_log_print (record, stdout);
+    event_log_destroy (&self);
+
+    // ring continues after restart and wraps around
+    self = event_log_new (path, 4, clock);
+    assert (event_log_size (self) == 2);
+    for (int i = 0; i < 5; i++)
+        event_log_record (self, EVENT_LOG_RESOLVED, 2, "ups-2", 300, 1500000000, 0);
+    assert (event_log_size (self) == 4);
+    assert (event_log_get (self, 0)->sequence == 4);
+    assert (event_log_get (self, 3)->sequence == 7);
+    assert (event_log_get (self, 4) == NULL);
+
+    // reader sees the writer's records
+    event_log_t *reader = event_log_open (path);
+    assert (reader);
+    assert (event_log_size (reader) == 4);
+    event_log_record (self, EVENT_LOG_DELETED, 0, "ups-2", 300, 1500000000, 0);
+    assert (event_log_get (reader, 3)->type == EVENT_LOG_DELETED);
+    assert (streq (event_log_type_name (event_log_get (reader, 3)->type), "DELETED"));
+    event_log_destroy (&reader);
+    event_log_destroy (&self);
+
+    // other capacity starts new ring
+    self = event_log_new (path, 8, clock);
+    assert (event_log_size (self) == 0);
+    event_log_destroy (&self);
+
+    assert (event_log_open ("src/selftest-rw/no-such-file") == NULL);
+    unlink (path);
+    outage_clock_destroy (&clock);
+    //  @end
+    printf ("OK\n");
+}
@@ -0,0 +1,105 @@
+/*  =========================================================================
+    event_log - Memory mapped ring of outage state transitions
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef EVENT_LOG_H_INCLUDED
+#define EVENT_LOG_H_INCLUDED
+
+#include "../include/fty_outage.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef EVENT_LOG_T_DEFINED
+typedef struct _event_log_t event_log_t;
+#define EVENT_LOG_T_DEFINED
+#endif
+
+//  Types of recorded transitions
+//  Transitions of liveness are recorded as they are
+#define EVENT_LOG_ADDED         FTY_OUTAGE_LIVENESS_ADDED     //  asset started to be monitored
+#define EVENT_LOG_DELETED       FTY_OUTAGE_LIVENESS_DELETED   //  asset is not monitored any more
+#define EVENT_LOG_EXPIRED       FTY_OUTAGE_LIVENESS_EXPIRED   //  asset reached escalation level
+#define EVENT_LOG_REVIVED       FTY_OUTAGE_LIVENESS_REVIVED   //  asset was touched after it expired
+#define EVENT_LOG_ACTIVE        5   //  ACTIVE alert was sent
+#define EVENT_LOG_RESOLVED      6   //  RESOLVED alert was sent
+#define EVENT_LOG_SUPPRESSED    7   //  alert was not sent because of maintenance
+
+#define EVENT_LOG_ASSET_SIZE    54  //  asset names are truncated to 53 characters
+
+//  One record of the ring, stored as is in the file
+typedef struct _event_log_record_t {
+    uint64_t sequence;              //  1 for the first record ever written
+    int64_t time_ms;                //  [ms] wall time of the transition
+    uint64_t ttl_sec;               //  [s] ttl of the asset
+    uint64_t last_seen_sec;         //  [s] wall time metrics were seen last
+    int64_t deadline_ms;            //  [ms] wall time of the next escalation, 0 if none
+    uint8_t type;                   //  EVENT_LOG_*
+    uint8_t level;                  //  DATA_LEVEL_*
+    char asset [EVENT_LOG_ASSET_SIZE];
+} event_log_record_t;
+
+//  @interface
+//  Create or continue the ring of 'records' records in file 'path', time
+//  is read from 'clock', which is not owned and must outlive the log
+FTY_OUTAGE_EXPORT event_log_t *
+    event_log_new (const char *path, size_t records, outage_clock_t *clock);
+
+//  Open the ring in file 'path' for reading
+FTY_OUTAGE_EXPORT event_log_t *
+    event_log_open (const char *path);
+
+//  Destroy the event log
+FTY_OUTAGE_EXPORT void
+    event_log_destroy (event_log_t **self_p);
+
+//  Record one transition of 'asset'
+FTY_OUTAGE_EXPORT void
+    event_log_record (event_log_t *self, int type, int level, const char *asset,
+        uint64_t ttl_sec, uint64_t last_seen_sec, int64_t deadline_ms);
+
+//  Return number of records available in the ring
+FTY_OUTAGE_EXPORT size_t
+    event_log_size (event_log_t *self);
+
+//  Return index-th available record, the oldest first, NULL if there is none
+FTY_OUTAGE_EXPORT const event_log_record_t *
+    event_log_get (event_log_t *self, size_t index);
+
+//  Return name of record type
+FTY_OUTAGE_EXPORT const char *
+    event_log_type_name (int type);
+
+//  Print the record as one line
+FTY_OUTAGE_EXPORT void
+    event_log_print (const event_log_record_t *record, FILE *file);
+
+//  Self test of this class
+FTY_OUTAGE_EXPORT void
+    event_log_test (bool verbose);
+
+//  @end
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -29,6 +29,32 @@
 #include "fty_outage_classes.h"
 
 static const char *CONFIG = "/etc/fty-outage/fty-outage.cfg";
+static const char *DEFAULT_EVENT_LOG = "/var/lib/fty/fty-outage/events.ring";
+static const char *DEFAULT_HISTORY = "/var/lib/fty/fty-outage/history.dat";
+
+// central aggregator of outage summaries published by edge agents
+static int
+s_run_aggregator (zconfig_t *cfg)
+{
+    zactor_t *aggregator = zactor_new (outage_aggregator, NULL);
+    zstr_sendx (aggregator, "CONNECT", "ipc://@/malamute", "fty-outage-aggregator", NULL);
+    zstr_sendx (aggregator, "STALE-MS", zconfig_get (cfg, "aggregator/stale", "180000"), NULL);
+    zstr_sendx (aggregator, "CONSUMER", zconfig_get (cfg, "aggregator/stream", ""), OUTAGE_SUMMARY_SUBJECT ".*", NULL);
+
+    while (true) {
+        char *str = zstr_recv (aggregator);
+        if (str) {
+            puts (str);
+            zstr_free (&str);
+        }
+        else {
+            log_info ("Interrupted ...");
+            break;
+        }
+    }
+    zactor_destroy (&aggregator);
+    return 0;
+}
 
 int main (int argc, char *argv [])
 {
@@ -70,11 +96,25 @@ int main (int argc, char *argv [])
         ftylog_setVeboseMode(ftylog_getInstance());
     }
     
+    // the same binary runs either as edge agent or as central aggregator
+    if (cfg && !streq (zconfig_get (cfg, "aggregator/stream", ""), ""))
+        return s_run_aggregator (cfg);
+
     zactor_t *server = zactor_new (fty_outage_server, "outage");
     //  Insert main code here
     
     zstr_sendx (server, "STATE-FILE", "/var/lib/fty/fty-outage/state.zpl", NULL);
     zstr_sendx (server, "TIMEOUT", "30000", NULL);
+    // always on ring of asset transitions for post-mortem, see fty-outage-events
+    zstr_sendx (server, "EVENT-LOG",
+        cfg ? zconfig_get (cfg, "event_log/path", DEFAULT_EVENT_LOG) : DEFAULT_EVENT_LOG,
+        cfg ? zconfig_get (cfg, "event_log/records", "65536") : "65536",
+        NULL);
+    // outages per asset for MTBF/MTTR, older half rolled up over records
+    zstr_sendx (server, "HISTORY",
+        cfg ? zconfig_get (cfg, "history/path", DEFAULT_HISTORY) : DEFAULT_HISTORY,
+        cfg ? zconfig_get (cfg, "history/records", "65536") : "65536",
+        NULL);
     zstr_sendx (server, "CONNECT", "ipc://@/malamute", "fty-outage", NULL);
     zstr_sendx (server, "PRODUCER", FTY_PROTO_STREAM_ALERTS_SYS, NULL);
     zstr_sendx (server, "CONSUMER", FTY_PROTO_STREAM_METRICS, ".*", NULL);
@@ -82,6 +122,65 @@ int main (int argc, char *argv [])
     zstr_sendx (server, "CONSUMER", FTY_PROTO_STREAM_METRICS_SENSOR, ".*", NULL);
     zstr_sendx (server, "CONSUMER", FTY_PROTO_STREAM_ASSETS, ".*", NULL);
 
+    // WARNING and CRITICAL outage after number of ttls of silence
+    if (cfg) {
+        zstr_sendx (server, "ESCALATION",
+            zconfig_get (cfg, "escalation/warning", "0"),
+            zconfig_get (cfg, "escalation/critical", "2"),
+            NULL);
+    }
+
+    // metrics stamped further ahead of local clock are reported, all are
+    // taken as seen now
+    if (cfg) {
+        zstr_sendx (server, "SKEW-TOLERANCE-SEC",
+            zconfig_get (cfg, "skew/tolerance", "60"),
+            NULL);
+    }
+
+    // metrics of a subject which touched alive asset within the last
+    // ttl/divisor are taken as seen without decode
+    if (cfg) {
+        zstr_sendx (server, "TOUCH-ELISION",
+            zconfig_get (cfg, "elision/divisor", "8"),
+            NULL);
+    }
+
+    // which assets are monitored, reloaded on RELOAD request to FILTER mailbox
+    if (cfg && zconfig_locate (cfg, "filter")) {
+        zstr_sendx (server, "FILTER-FILE", CONFIG, NULL);
+    }
+
+    // assets checked with finer timer resolution than the timeout
+    if (cfg && zconfig_locate (cfg, "tiers")) {
+        zstr_sendx (server, "TIERS-FILE", CONFIG, NULL);
+    }
+
+    // maintenance windows suppressing outage alerts
+    if (cfg && !streq (zconfig_get (cfg, "maintenance/file", ""), "")) {
+        zstr_sendx (server, "MAINTENANCE-FILE", zconfig_get (cfg, "maintenance/file", ""), NULL);
+    }
+
+    // optional compact summary of dead assets
+    if (cfg && !streq (zconfig_get (cfg, "summary/stream", ""), "")) {
+        zstr_sendx (server, "SUMMARY",
+            zconfig_get (cfg, "summary/stream", ""),
+            zconfig_get (cfg, "summary/interval", "60000"),
+            zconfig_get (cfg, "summary/full_every", "10"),
+            zconfig_get (cfg, "summary/site", ""),
+            NULL);
+    }
+
+    // optional OpenMetrics exporter, scraped over unix socket or read from file
+    if (cfg && (!streq (zconfig_get (cfg, "exporter/socket", ""), "")
+                || !streq (zconfig_get (cfg, "exporter/file", ""), ""))) {
+        zstr_sendx (server, "EXPORTER",
+            zconfig_get (cfg, "exporter/socket", ""),
+            zconfig_get (cfg, "exporter/file", ""),
+            zconfig_get (cfg, "exporter/interval", "15000"),
+            NULL);
+    }
+
     // src/malamute.c, under MPL license
     while (true) {
         char *str = zstr_recv (server);
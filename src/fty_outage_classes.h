@@ -39,10 +39,90 @@
 typedef struct _data_t data_t;
 #define DATA_T_DEFINED
 #endif
+#ifndef ALERT_REFRESH_T_DEFINED
+typedef struct _alert_refresh_t alert_refresh_t;
+#define ALERT_REFRESH_T_DEFINED
+#endif
+#ifndef ALERT_PUBLISHER_T_DEFINED
+typedef struct _alert_publisher_t alert_publisher_t;
+#define ALERT_PUBLISHER_T_DEFINED
+#endif
+#ifndef OUTAGE_SUMMARY_T_DEFINED
+typedef struct _outage_summary_t outage_summary_t;
+#define OUTAGE_SUMMARY_T_DEFINED
+#endif
+#ifndef OUTAGE_CLOCK_T_DEFINED
+typedef struct _outage_clock_t outage_clock_t;
+#define OUTAGE_CLOCK_T_DEFINED
+#endif
+#ifndef MAINTENANCE_T_DEFINED
+typedef struct _maintenance_t maintenance_t;
+#define MAINTENANCE_T_DEFINED
+#endif
+#ifndef ASSET_FILTER_T_DEFINED
+typedef struct _asset_filter_t asset_filter_t;
+#define ASSET_FILTER_T_DEFINED
+#endif
+#ifndef EVENT_LOG_T_DEFINED
+typedef struct _event_log_t event_log_t;
+#define EVENT_LOG_T_DEFINED
+#endif
+#ifndef OUTAGE_AGGREGATOR_T_DEFINED
+typedef struct _outage_aggregator_t outage_aggregator_t;
+#define OUTAGE_AGGREGATOR_T_DEFINED
+#endif
+#ifndef MEMORY_USAGE_T_DEFINED
+typedef struct _memory_usage_t memory_usage_t;
+#define MEMORY_USAGE_T_DEFINED
+#endif
+#ifndef CLOCK_SKEW_T_DEFINED
+typedef struct _clock_skew_t clock_skew_t;
+#define CLOCK_SKEW_T_DEFINED
+#endif
+#ifndef OUTAGE_HISTORY_T_DEFINED
+typedef struct _outage_history_t outage_history_t;
+#define OUTAGE_HISTORY_T_DEFINED
+#endif
+#ifndef OUTAGE_METRICS_T_DEFINED
+typedef struct _outage_metrics_t outage_metrics_t;
+#define OUTAGE_METRICS_T_DEFINED
+#endif
+#ifndef OUTAGE_LOCATIONS_T_DEFINED
+typedef struct _outage_locations_t outage_locations_t;
+#define OUTAGE_LOCATIONS_T_DEFINED
+#endif
+#ifndef TOUCH_ELISION_T_DEFINED
+typedef struct _touch_elision_t touch_elision_t;
+#define TOUCH_ELISION_T_DEFINED
+#endif
+#ifndef OUTAGE_SIM_T_DEFINED
+typedef struct _outage_sim_t outage_sim_t;
+#define OUTAGE_SIM_T_DEFINED
+#endif
+#ifndef ASSET_TIERS_T_DEFINED
+typedef struct _asset_tiers_t asset_tiers_t;
+#define ASSET_TIERS_T_DEFINED
+#endif
 
 //  Internal API
 
 #include "data.h"
+#include "alert_refresh.h"
+#include "alert_publisher.h"
+#include "outage_summary.h"
+#include "outage_clock.h"
+#include "maintenance.h"
+#include "asset_filter.h"
+#include "event_log.h"
+#include "outage_aggregator.h"
+#include "memory_usage.h"
+#include "clock_skew.h"
+#include "outage_history.h"
+#include "outage_metrics.h"
+#include "outage_locations.h"
+#include "touch_elision.h"
+#include "outage_sim.h"
+#include "asset_tiers.h"
 
 //  *** To avoid double-definitions, only define if building without draft ***
 #ifndef FTY_OUTAGE_BUILD_DRAFT_API
@@ -52,6 +132,86 @@ typedef struct _data_t data_t;
 FTY_OUTAGE_PRIVATE void
     data_test (bool verbose);
 
+//  *** Draft method, defined for internal use only ***
+//  Self test of this class.
+FTY_OUTAGE_PRIVATE void
+    alert_refresh_test (bool verbose);
+
+//  *** Draft method, defined for internal use only ***
+//  Self test of this class.
+FTY_OUTAGE_PRIVATE void
+    alert_publisher_test (bool verbose);
+
+//  *** Draft method, defined for internal use only ***
+//  Self test of this class.
+FTY_OUTAGE_PRIVATE void
+    outage_summary_test (bool verbose);
+
+//  *** Draft method, defined for internal use only ***
+//  Self test of this class.
+FTY_OUTAGE_PRIVATE void
+    outage_clock_test (bool verbose);
+
+//  *** Draft method, defined for internal use only ***
+//  Self test of this class.
+FTY_OUTAGE_PRIVATE void
+    maintenance_test (bool verbose);
+
+//  *** Draft method, defined for internal use only ***
+//  Self test of this class.
+FTY_OUTAGE_PRIVATE void
+    asset_filter_test (bool verbose);
+
+//  *** Draft method, defined for internal use only ***
+//  Self test of this class.
+FTY_OUTAGE_PRIVATE void
+    event_log_test (bool verbose);
+
+//  *** Draft method, defined for internal use only ***
+//  Self test of this class.
+FTY_OUTAGE_PRIVATE void
+    outage_aggregator_test (bool verbose);
+
+//  *** Draft method, defined for internal use only ***
+//  Self test of this class.
+FTY_OUTAGE_PRIVATE void
+    memory_usage_test (bool verbose);
+
+//  *** Draft method, defined for internal use only ***
+//  Self test of this class.
+FTY_OUTAGE_PRIVATE void
+    clock_skew_test (bool verbose);
+
+//  *** Draft method, defined for internal use only ***
+//  Self test of this class.
+FTY_OUTAGE_PRIVATE void
+    outage_history_test (bool verbose);
+
+//  *** Draft method, defined for internal use only ***
+//  Self test of this class.
+FTY_OUTAGE_PRIVATE void
+    outage_metrics_test (bool verbose);
+
+//  *** Draft method, defined for internal use only ***
+//  Self test of this class.
+FTY_OUTAGE_PRIVATE void
+    outage_locations_test (bool verbose);
+
+//  *** Draft method, defined for internal use only ***
+//  Self test of this class.
+FTY_OUTAGE_PRIVATE void
+    touch_elision_test (bool verbose);
+
+//  *** Draft method, defined for internal use only ***
+//  Self test of this class.
+FTY_OUTAGE_PRIVATE void
+    outage_sim_test (bool verbose);
+
+//  *** Draft method, defined for internal use only ***
+//  Self test of this class.
+FTY_OUTAGE_PRIVATE void
+    asset_tiers_test (bool verbose);
+
 //  Self test for private classes
 FTY_OUTAGE_PRIVATE void
     fty_outage_private_selftest (bool verbose, const char *subtest);
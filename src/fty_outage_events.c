@@ -0,0 +1,130 @@
+/*  =========================================================================
+    fty_outage_events - Dump and filter outage event log
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    fty_outage_events - Dump and filter outage event log
+@discuss
+    Reads the ring written by fty-outage (see event_log) and prints the
+    records, the oldest first. The file can be read while the agent runs.
+@end
+*/
+
+#include <regex.h>
+#include "fty_outage_classes.h"
+
+static const char *DEFAULT_EVENT_LOG = "/var/lib/fty/fty-outage/events.ring";
+
+static int
+s_type (const char *name)
+{
+    for (int type = EVENT_LOG_ADDED; type <= EVENT_LOG_SUPPRESSED; type++) {
+        if (strcasecmp (name, event_log_type_name (type)) == 0)
+            return type;
+    }
+    return -1;
+}
+
+int main (int argc, char *argv [])
+{
+    const char *path = DEFAULT_EVENT_LOG;
+    const char *asset = NULL;
+    int type = 0;
+    int64_t since_ms = 0;
+    size_t last = 0;
+
+    int argn;
+    for (argn = 1; argn < argc; argn++) {
+        if (streq (argv [argn], "--help")
+        ||  streq (argv [argn], "-h")) {
+            puts ("fty-outage-events [options] [file]");
+            puts ("  --asset / -a regex     only records of assets matching regex");
+            puts ("  --type / -t type       only records of type (ADDED, DELETED, EXPIRED,");
+            puts ("                         REVIVED, ACTIVE, RESOLVED, SUPPRESSED)");
+            puts ("  --since / -s seconds   only records since unix time");
+            puts ("  --last / -n count      only last count records (after other filters)");
+            puts ("  --help / -h            this information");
+            printf ("  file defaults to %s\n", DEFAULT_EVENT_LOG);
+            return 0;
+        }
+        else
+        if ((streq (argv [argn], "--asset") || streq (argv [argn], "-a")) && argn + 1 < argc)
+            asset = argv [++argn];
+        else
+        if ((streq (argv [argn], "--type") || streq (argv [argn], "-t")) && argn + 1 < argc) {
+            type = s_type (argv [++argn]);
+            if (type == -1) {
+                fprintf (stderr, "Unknown type: %s\n", argv [argn]);
+                return 1;
+            }
+        }
+        else
+        if ((streq (argv [argn], "--since") || streq (argv [argn], "-s")) && argn + 1 < argc)
+            since_ms = atoll (argv [++argn]) * 1000;
+        else
+        if ((streq (argv [argn], "--last") || streq (argv [argn], "-n")) && argn + 1 < argc)
+            last = (size_t) atol (argv [++argn]);
+        else
+        if (argv [argn][0] != '-')
+            path = argv [argn];
+        else {
+            fprintf (stderr, "Unknown option: %s\n", argv [argn]);
+            return 1;
+        }
+    }
+
+    regex_t asset_regex;
+    if (asset && regcomp (&asset_regex, asset, REG_EXTENDED | REG_NOSUB) != 0) {
+        fprintf (stderr, "Invalid regular expression: %s\n", asset);
+        return 1;
+    }
+
+    event_log_t *event_log = event_log_open (path);
+    if (!event_log) {
+        fprintf (stderr, "Can't open event log %s\n", path);
+        if (asset)
+            regfree (&asset_regex);
+        return 1;
+    }
+
+    // copy matching records first, the writer may overwrite the ring meanwhile
+    size_t size = event_log_size (event_log);
+    event_log_record_t *records = (event_log_record_t *) malloc ((size ? size : 1) * sizeof (event_log_record_t));
+    assert (records);
+    size_t matching = 0;
+    for (size_t index = 0; index < size; index++) {
+        const event_log_record_t *record = event_log_get (event_log, index);
+        if (!record
+            || (type && record->type != type)
+            || record->time_ms < since_ms
+            || (asset && regexec (&asset_regex, record->asset, 0, NULL, 0) != 0))
+            continue;
+        records [matching++] = *record;
+    }
+    for (size_t index = (last && last < matching) ? matching - last : 0; index < matching; index++)
+        event_log_print (&records [index], stdout);
+
+    free (records);
+    event_log_destroy (&event_log);
+    if (asset)
+        regfree (&asset_regex);
+    return 0;
+}
@@ -0,0 +1,1330 @@
+/*  =========================================================================
+    fty_outage_liveness - Liveness of keys refreshed by events, escalating after silence
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    fty_outage_liveness - Liveness of keys refreshed by events, escalating
+    after silence
+@discuss
+    Deadline per key, refreshed by events: every record has time it was
+    seen last and ttl, once it is silent for factor * ttl it escalates to
+    WARNING and then to CRITICAL. Records carry an opaque item of their
+    owner, nothing else is known about them, so the engine serves outage
+    of assets as well as heartbeats of agents.
+
+    All times are milliseconds on the monotonic timeline of the caller, it
+    passes the current time in, so wall clock steps and time sources are
+    its business and tests can run on simulated time.
+
+    Deadlines are kept in an indexed binary min-heap, only deadlines which
+    are due are visited by fty_outage_liveness_expire. Each tier of records
+    has its own heap and tick, its deadlines are rounded up to a multiple
+    of the tick, so the owner can wake up once per tick for a tier which
+    needs fine resolution and check the rest of records rarely;
+    fty_outage_liveness_expire_tier visits just the due deadlines of the
+    tier and lists only records which escalated. Deferred touch just
+    notes seen time of alive record, its deadlines move once they are due,
+    so escalation happens at the same time as after a plain touch.
+    Snapshot stores seen times relative to now, so it can be restored
+    after restart, when the monotonic timeline starts again.
+@end
+*/
+
+#include "fty_outage_classes.h"
+
+#define DEFAULT_TTL_MS 60*1000
+#define DEFAULT_CRITICAL_FACTOR 2.0
+
+// deadline is not in the heap
+#define DEADLINE_IDLE SIZE_MAX
+#define HEAP_MIN_CAPACITY 64
+
+// hash tables are rebuilt once they hold less than 1/COMPACT_RATIO of their peak
+#define COMPACT_RATIO 4
+#define COMPACT_MIN_PEAK 1024
+
+// records of a batch are prefetched this many ahead of the one being rescheduled
+#define BATCH_PREFETCH 8
+
+#if defined (__GNUC__)
+#define PREFETCH(address) __builtin_prefetch (address)
+#else
+#define PREFETCH(address)
+#endif
+
+typedef struct _record_t record_t;
+
+// one escalation deadline of a record, embedded in it, so scheduling does
+// not allocate
+typedef struct _deadline_t {
+    int64_t at_ms;                         // [ms] time of escalation
+    size_t index;                          // position in the heap or DEADLINE_IDLE
+    int level;                             // FTY_OUTAGE_LIVENESS_WARNING or _CRITICAL
+    record_t *owner;
+} deadline_t;
+
+// record of a key, its name follows in the same heap block
+struct _record_t {
+    asset_key_t key;                       // key in records and dead
+    int64_t seen_ms;                       // [ms] when it was seen last, as deadlines know
+    int64_t deferred_ms;                   // [ms] seen later, deadlines move once due, INT64_MIN if not
+    int64_t ttl_ms;                        // [ms] time to live
+    void *item;                            // owned by the record
+    int level;                             // escalation level reached
+    int tier;                              // index of deadlines of the record
+    uint64_t batch;                        // last batch which touched or expiry which listed it
+    deadline_t deadlines [FTY_OUTAGE_LIVENESS_LEVELS];
+};
+
+// record touched by a batch, once however many items of the batch touch it
+typedef struct _batch_entry_t {
+    record_t *record;
+    size_t index;                          // the first item touching it
+    int level;                             // level before the batch
+} batch_entry_t;
+
+// deadlines of records of one tier of timer resolution
+typedef struct _tier_t {
+    deadline_t **heap;          // binary min-heap of scheduled deadlines
+    size_t heap_size;
+    size_t heap_capacity;
+    int64_t tick_ms;            // deadlines are rounded up to its multiple, 0 keeps them exact
+} tier_t;
+
+//  Structure of our class
+
+struct _fty_outage_liveness_t {
+    zhashx_t *records;          // asset_key => record_t, keys are owned by records
+    zhashx_t *dead;             // asset_key => record_t, records which reached some level
+    tier_t tiers [FTY_OUTAGE_LIVENESS_TIERS];
+    size_t records_peak;        // most records since the last compaction, hashes never shrink
+    double factors [FTY_OUTAGE_LIVENESS_LEVELS]; // escalation after factor * ttl of silence, 0 disables the level
+    int64_t default_ttl_ms;     // [ms] ttl of inserted records
+    int ttl_policy;             // FTY_OUTAGE_LIVENESS_TTL_MIN or _LAST
+    fty_outage_liveness_destructor_fn *destructor; // of items, NULL if not owned
+    fty_outage_liveness_handler_fn *handler;       // of transitions, NULL if disabled
+    void *handler_arg;
+    batch_entry_t *batch;       // scratch of batch touch, kept between batches
+    size_t batch_capacity;
+    uint64_t batch_seq;         // number of the last batch
+};
+
+//  --------------------------------------------------------------------------
+//  Record of the key with its name in one heap block
+
+static record_t *
+s_record_new (const asset_key_t *key, int64_t seen_ms, int64_t ttl_ms, void *item)
+{
+    record_t *self = (record_t *) zmalloc (sizeof (record_t) + key->length + 1);
+    if (self) {
+        char *name = (char *) (self + 1);
+        memcpy (name, key->name, key->length + 1);
+        self->key = *key;
+        self->key.name = name;
+        self->seen_ms = seen_ms;
+        self->deferred_ms = INT64_MIN;
+        self->ttl_ms = ttl_ms;
+        self->item = item;
+        self->level = FTY_OUTAGE_LIVENESS_ALIVE;
+        for (int i = 0; i < FTY_OUTAGE_LIVENESS_LEVELS; i++) {
+            self->deadlines [i].index = DEADLINE_IDLE;
+            self->deadlines [i].level = i + 1;
+            self->deadlines [i].owner = self;
+        }
+    }
+    return self;
+}
+
+// item is destroyed by the liveness, it knows the destructor
+static void
+s_record_destroy (record_t **self_p)
+{
+    assert (self_p);
+    if (*self_p) {
+        free (*self_p);
+        *self_p = NULL;
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Destroy the fty_outage_liveness
+
+void
+fty_outage_liveness_destroy (fty_outage_liveness_t **self_p)
+{
+    assert (self_p);
+    if (*self_p) {
+        fty_outage_liveness_t *self = *self_p;
+        zhashx_destroy (&self->dead);
+        if (self->records && self->destructor)
+            for (record_t *record = (record_t *) zhashx_first (self->records);
+                           record != NULL;
+                           record = (record_t *) zhashx_next (self->records))
+                self->destructor (&record->item);
+        zhashx_destroy (&self->records);
+        for (int tier = 0; tier < FTY_OUTAGE_LIVENESS_TIERS; tier++)
+            free (self->tiers [tier].heap);
+        free (self->batch);
+        free (self);
+        *self_p = NULL;
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Create a new fty_outage_liveness
+
+fty_outage_liveness_t *
+fty_outage_liveness_new (void)
+{
+    fty_outage_liveness_t *self = (fty_outage_liveness_t *) zmalloc (sizeof (fty_outage_liveness_t));
+    if (self) {
+        self->records = asset_key_hash_new (false);
+        if (self->records)
+            self->dead = asset_key_hash_new (false);
+        if (self->dead) {
+            zhashx_set_destructor (self->records, (zhashx_destructor_fn *) s_record_destroy);
+            self->default_ttl_ms = DEFAULT_TTL_MS;
+            self->factors [FTY_OUTAGE_LIVENESS_WARNING - 1] = 0;
+            self->factors [FTY_OUTAGE_LIVENESS_CRITICAL - 1] = DEFAULT_CRITICAL_FACTOR;
+            self->ttl_policy = FTY_OUTAGE_LIVENESS_TTL_MIN;
+        }
+        else
+            fty_outage_liveness_destroy (&self);
+    }
+    return self;
+}
+
+//  --------------------------------------------------------------------------
+//  Set destructor of record items, they are not destroyed by default
+
+void
+fty_outage_liveness_set_destructor (fty_outage_liveness_t *self, fty_outage_liveness_destructor_fn destructor)
+{
+    assert (self);
+    self->destructor = destructor;
+}
+
+//  --------------------------------------------------------------------------
+//  Set handler called on transitions of records, NULL disables it
+
+void
+fty_outage_liveness_set_handler (fty_outage_liveness_t *self, fty_outage_liveness_handler_fn handler, void *arg)
+{
+    assert (self);
+    self->handler = handler;
+    self->handler_arg = arg;
+}
+
+//  --------------------------------------------------------------------------
+//  Return ttl of newly inserted records
+
+int64_t
+fty_outage_liveness_default_ttl (fty_outage_liveness_t *self)
+{
+    assert (self);
+    return self->default_ttl_ms;
+}
+
+//  --------------------------------------------------------------------------
+//  Set ttl of newly inserted records
+
+void
+fty_outage_liveness_set_default_ttl (fty_outage_liveness_t *self, int64_t ttl_ms)
+{
+    assert (self);
+    self->default_ttl_ms = ttl_ms;
+}
+
+//  --------------------------------------------------------------------------
+//  Set how ttl changes when record is touched
+
+void
+fty_outage_liveness_set_ttl_policy (fty_outage_liveness_t *self, int policy)
+{
+    assert (self);
+    assert (policy == FTY_OUTAGE_LIVENESS_TTL_MIN || policy == FTY_OUTAGE_LIVENESS_TTL_LAST);
+    self->ttl_policy = policy;
+}
+
+//  --------------------------------------------------------------------------
+//  indexed binary min-heap of deadlines, each deadline knows its position,
+//  so it can be rescheduled or removed in O(log N)
+
+static void
+s_heap_set (tier_t *self, size_t index, deadline_t *deadline)
+{
+    self->heap [index] = deadline;
+    deadline->index = index;
+}
+
+static void
+s_heap_sift_up (tier_t *self, size_t index)
+{
+    deadline_t *deadline = self->heap [index];
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (self->heap [parent]->at_ms <= deadline->at_ms)
+            break;
+        s_heap_set (self, index, self->heap [parent]);
+        index = parent;
+    }
+    s_heap_set (self, index, deadline);
+}
+
+static void
+s_heap_sift_down (tier_t *self, size_t index)
+{
+    deadline_t *deadline = self->heap [index];
+    while (true) {
+        size_t child = 2 * index + 1;
+        if (child >= self->heap_size)
+            break;
+        if (child + 1 < self->heap_size && self->heap [child + 1]->at_ms < self->heap [child]->at_ms)
+            child++;
+        if (deadline->at_ms <= self->heap [child]->at_ms)
+            break;
+        s_heap_set (self, index, self->heap [child]);
+        index = child;
+    }
+    s_heap_set (self, index, deadline);
+}
+
+static void
+s_heap_remove (tier_t *self, deadline_t *deadline)
+{
+    size_t index = deadline->index;
+    if (index == DEADLINE_IDLE)
+        return;
+    deadline->index = DEADLINE_IDLE;
+    deadline_t *last = self->heap [--self->heap_size];
+    if (last == deadline)
+        return;
+    s_heap_set (self, index, last);
+    s_heap_sift_up (self, index);
+    s_heap_sift_down (self, last->index);
+}
+
+//  schedule deadline at 'at_ms' or move it there if already scheduled
+static void
+s_heap_schedule (tier_t *self, deadline_t *deadline, int64_t at_ms)
+{
+    if (deadline->index != DEADLINE_IDLE) {
+        int64_t old_at_ms = deadline->at_ms;
+        deadline->at_ms = at_ms;
+        if (at_ms < old_at_ms)
+            s_heap_sift_up (self, deadline->index);
+        else
+            s_heap_sift_down (self, deadline->index);
+        return;
+    }
+    if (self->heap_size == self->heap_capacity) {
+        size_t capacity = self->heap_capacity ? self->heap_capacity * 2 : HEAP_MIN_CAPACITY;
+        deadline_t **heap = (deadline_t **) realloc (self->heap, capacity * sizeof (deadline_t *));
+        if (!heap) {
+            log_error ("Can't schedule deadline of %s (memory error)", deadline->owner->key.name);
+            return;
+        }
+        self->heap = heap;
+        self->heap_capacity = capacity;
+    }
+    deadline->at_ms = at_ms;
+    s_heap_set (self, self->heap_size++, deadline);
+    s_heap_sift_up (self, deadline->index);
+}
+
+//  --------------------------------------------------------------------------
+//  (re)compute escalation deadlines of the record after its seen time or
+//  ttl changed, levels which are still due keep their state
+
+static void
+s_schedule (fty_outage_liveness_t *self, record_t *record, int64_t now_ms)
+{
+    if (record->deferred_ms > record->seen_ms)
+        record->seen_ms = record->deferred_ms;
+    record->deferred_ms = INT64_MIN;
+    tier_t *tier = &self->tiers [record->tier];
+    int level = FTY_OUTAGE_LIVENESS_ALIVE;
+    for (int i = 0; i < FTY_OUTAGE_LIVENESS_LEVELS; i++) {
+        deadline_t *deadline = &record->deadlines [i];
+        if (self->factors [i] <= 0) {
+            s_heap_remove (tier, deadline);
+            continue;
+        }
+        int64_t at_ms = record->seen_ms + (int64_t) (record->ttl_ms * self->factors [i]);
+        // round up to the tick of the tier, times may be negative
+        if (tier->tick_ms > 0) {
+            int64_t remainder = at_ms % tier->tick_ms;
+            if (remainder < 0)
+                remainder += tier->tick_ms;
+            if (remainder)
+                at_ms += tier->tick_ms - remainder;
+        }
+        if (at_ms <= now_ms && record->level >= deadline->level)
+            level = deadline->level;
+        else
+            s_heap_schedule (tier, deadline, at_ms);
+    }
+    record->level = level;
+    if (level == FTY_OUTAGE_LIVENESS_ALIVE)
+        zhashx_delete (self->dead, &record->key);
+}
+
+//  --------------------------------------------------------------------------
+//  Fill state of the record
+
+static void
+s_state (record_t *record, fty_outage_liveness_state_t *state)
+{
+    state->seen_ms = record->deferred_ms > record->seen_ms ? record->deferred_ms : record->seen_ms;
+    state->ttl_ms = record->ttl_ms;
+    state->level = record->level;
+    // the earliest deadline still scheduled
+    state->deadline_ms = 0;
+    for (int i = 0; i < FTY_OUTAGE_LIVENESS_LEVELS; i++) {
+        deadline_t *deadline = &record->deadlines [i];
+        if (deadline->index != DEADLINE_IDLE && (state->deadline_ms == 0 || deadline->at_ms < state->deadline_ms))
+            state->deadline_ms = deadline->at_ms;
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Report transition of the record to the handler, if there is one
+
+static void
+s_transition (fty_outage_liveness_t *self, int type, record_t *record)
+{
+    if (!self->handler)
+        return;
+    fty_outage_liveness_state_t state;
+    s_state (record, &state);
+    self->handler (self->handler_arg, type, &record->key, record->item, &state);
+}
+
+//  --------------------------------------------------------------------------
+//  Set after how many ttls of silence record escalates to WARNING and to
+//  CRITICAL, warning_factor 0 disables WARNING, and reschedule all records
+
+void
+fty_outage_liveness_set_escalation (fty_outage_liveness_t *self, double warning_factor, double critical_factor, int64_t now_ms)
+{
+    assert (self);
+    assert (critical_factor > 0);
+    if (warning_factor >= critical_factor) {
+        log_warning ("WARNING escalation (%f) must come before CRITICAL (%f), disable it", warning_factor, critical_factor);
+        warning_factor = 0;
+    }
+    self->factors [FTY_OUTAGE_LIVENESS_WARNING - 1] = warning_factor;
+    self->factors [FTY_OUTAGE_LIVENESS_CRITICAL - 1] = critical_factor;
+    for (record_t *record = (record_t *) zhashx_first (self->records);
+                   record != NULL;
+                   record = (record_t *) zhashx_next (self->records))
+        s_schedule (self, record, now_ms);
+}
+
+//  --------------------------------------------------------------------------
+//  Set tick of the tier, deadlines of its records are rounded up to a
+//  multiple of it, 0 keeps them exact, and reschedule records of the tier
+
+void
+fty_outage_liveness_set_tick (fty_outage_liveness_t *self, int tier, int64_t tick_ms, int64_t now_ms)
+{
+    assert (self);
+    assert (tier >= 0 && tier < FTY_OUTAGE_LIVENESS_TIERS);
+    assert (tick_ms >= 0);
+    if (self->tiers [tier].tick_ms == tick_ms)
+        return;
+    self->tiers [tier].tick_ms = tick_ms;
+    for (record_t *record = (record_t *) zhashx_first (self->records);
+                   record != NULL;
+                   record = (record_t *) zhashx_next (self->records))
+        if (record->tier == tier)
+            s_schedule (self, record, now_ms);
+}
+
+//  --------------------------------------------------------------------------
+//  Return tick of the tier
+
+int64_t
+fty_outage_liveness_tick (fty_outage_liveness_t *self, int tier)
+{
+    assert (self);
+    assert (tier >= 0 && tier < FTY_OUTAGE_LIVENESS_TIERS);
+    return self->tiers [tier].tick_ms;
+}
+
+//  --------------------------------------------------------------------------
+//  Move record of the key to the tier, its deadlines are rescheduled with
+//  the tick of the tier. Returns -1 if the key is not known.
+
+int
+fty_outage_liveness_set_tier (fty_outage_liveness_t *self, const asset_key_t *key, int tier, int64_t now_ms)
+{
+    assert (self);
+    assert (key);
+    assert (tier >= 0 && tier < FTY_OUTAGE_LIVENESS_TIERS);
+    record_t *record = (record_t *) zhashx_lookup (self->records, key);
+    if (!record)
+        return -1;
+    if (record->tier == tier)
+        return 0;
+    for (int i = 0; i < FTY_OUTAGE_LIVENESS_LEVELS; i++)
+        s_heap_remove (&self->tiers [record->tier], &record->deadlines [i]);
+    record->tier = tier;
+    s_schedule (self, record, now_ms);
+    return 0;
+}
+
+//  --------------------------------------------------------------------------
+//  Return tier of the record of the key, -1 if it is not known
+
+int
+fty_outage_liveness_tier (fty_outage_liveness_t *self, const asset_key_t *key)
+{
+    assert (self);
+    assert (key);
+    record_t *record = (record_t *) zhashx_lookup (self->records, key);
+    return record ? record->tier : -1;
+}
+
+//  --------------------------------------------------------------------------
+//  Return the earliest deadline scheduled in the tier, INT64_MAX if there
+//  is none
+
+int64_t
+fty_outage_liveness_next_deadline (fty_outage_liveness_t *self, int tier)
+{
+    assert (self);
+    assert (tier >= 0 && tier < FTY_OUTAGE_LIVENESS_TIERS);
+    return self->tiers [tier].heap_size ? self->tiers [tier].heap [0]->at_ms : INT64_MAX;
+}
+
+//  --------------------------------------------------------------------------
+//  Insert record of the key seen now with default ttl, takes ownership of
+//  the item. Returns -1 if the key is known already, item is not taken.
+
+int
+fty_outage_liveness_insert (fty_outage_liveness_t *self, const asset_key_t *key, void *item, int64_t now_ms)
+{
+    assert (self);
+    assert (key);
+    if (zhashx_lookup (self->records, key))
+        return -1;
+    record_t *record = s_record_new (key, now_ms, self->default_ttl_ms, item);
+    if (!record) {
+        log_error ("Can't insert record of %s (memory error)", key->name);
+        return -1;
+    }
+    zhashx_insert (self->records, &record->key, record);
+    if (zhashx_size (self->records) > self->records_peak)
+        self->records_peak = zhashx_size (self->records);
+    s_schedule (self, record, now_ms);
+    s_transition (self, FTY_OUTAGE_LIVENESS_ADDED, record);
+    return 0;
+}
+
+//  --------------------------------------------------------------------------
+//  Delete record of the key, returns -1 if it is not known
+
+int
+fty_outage_liveness_delete (fty_outage_liveness_t *self, const asset_key_t *key)
+{
+    assert (self);
+    assert (key);
+    record_t *record = (record_t *) zhashx_lookup (self->records, key);
+    if (!record)
+        return -1;
+    for (int i = 0; i < FTY_OUTAGE_LIVENESS_LEVELS; i++)
+        s_heap_remove (&self->tiers [record->tier], &record->deadlines [i]);
+    s_transition (self, FTY_OUTAGE_LIVENESS_DELETED, record);
+    if (self->destructor)
+        self->destructor (&record->item);
+    zhashx_delete (self->dead, &record->key);
+    zhashx_delete (self->records, &record->key);
+    return 0;
+}
+
+//  --------------------------------------------------------------------------
+//  Return item of the key, NULL if it is not known
+
+void *
+fty_outage_liveness_lookup (fty_outage_liveness_t *self, const asset_key_t *key)
+{
+    assert (self);
+    assert (key);
+    record_t *record = (record_t *) zhashx_lookup (self->records, key);
+    return record ? record->item : NULL;
+}
+
+//  --------------------------------------------------------------------------
+//  Replace item of the key, takes ownership of the new item and destroys
+//  the old one. Returns -1 if the key is not known, item is not taken.
+
+int
+fty_outage_liveness_replace (fty_outage_liveness_t *self, const asset_key_t *key, void *item)
+{
+    assert (self);
+    assert (key);
+    record_t *record = (record_t *) zhashx_lookup (self->records, key);
+    if (!record)
+        return -1;
+    if (record->item != item) {
+        if (self->destructor)
+            self->destructor (&record->item);
+        record->item = item;
+    }
+    return 0;
+}
+
+//  --------------------------------------------------------------------------
+//  Return level reached by the key, FTY_OUTAGE_LIVENESS_ALIVE if unknown
+
+int
+fty_outage_liveness_level (fty_outage_liveness_t *self, const asset_key_t *key)
+{
+    assert (self);
+    assert (key);
+    record_t *record = (record_t *) zhashx_lookup (self->records, key);
+    return record ? record->level : FTY_OUTAGE_LIVENESS_ALIVE;
+}
+
+//  --------------------------------------------------------------------------
+//  Fill state of the key, returns -1 if it is not known
+
+int
+fty_outage_liveness_state (fty_outage_liveness_t *self, const asset_key_t *key, fty_outage_liveness_state_t *state)
+{
+    assert (self);
+    assert (key);
+    assert (state);
+    record_t *record = (record_t *) zhashx_lookup (self->records, key);
+    if (!record)
+        return -1;
+    s_state (record, state);
+    return 0;
+}
+
+//  --------------------------------------------------------------------------
+//  update ttl and seen time of the record, without rescheduling it
+//  return -1 if it was seen in future, 0 otherwise
+
+static int
+s_touch (fty_outage_liveness_t *self, record_t *record, int64_t seen_ms, int64_t ttl_ms, int64_t now_ms)
+{
+    if (self->ttl_policy == FTY_OUTAGE_LIVENESS_TTL_LAST || ttl_ms < record->ttl_ms)
+        record->ttl_ms = ttl_ms;
+    if (seen_ms > now_ms)
+        return -1;
+    // seen time never moves backward: metric averaged over the last day,
+    // stamped at its start, would make a silent record of alive one
+    if (seen_ms > record->seen_ms)
+        record->seen_ms = seen_ms;
+    return 0;
+}
+
+//  --------------------------------------------------------------------------
+//  Record of the key was seen at seen_ms with ttl_ms
+
+int
+fty_outage_liveness_touch (fty_outage_liveness_t *self, const asset_key_t *key, int64_t seen_ms, int64_t ttl_ms, int64_t now_ms)
+{
+    assert (self);
+    assert (key);
+    record_t *record = (record_t *) zhashx_lookup (self->records, key);
+    if (!record)
+        return -1;
+    int level = record->level;
+    // ttl is taken even from future, so it is rescheduled anyway
+    int type = s_touch (self, record, seen_ms, ttl_ms, now_ms) == 0 ? 0 : FTY_OUTAGE_LIVENESS_FUTURE;
+    s_schedule (self, record, now_ms);
+    if (level != FTY_OUTAGE_LIVENESS_ALIVE && record->level == FTY_OUTAGE_LIVENESS_ALIVE) {
+        s_transition (self, FTY_OUTAGE_LIVENESS_REVIVED, record);
+        if (type == 0)
+            type = FTY_OUTAGE_LIVENESS_REVIVED;
+    }
+    return type;
+}
+
+//  --------------------------------------------------------------------------
+//  Alive record of the key was seen at seen_ms, its deadlines move once due
+
+int
+fty_outage_liveness_defer (fty_outage_liveness_t *self, const asset_key_t *key, int64_t seen_ms, int64_t now_ms)
+{
+    assert (self);
+    assert (key);
+    record_t *record = (record_t *) zhashx_lookup (self->records, key);
+    if (!record || record->level != FTY_OUTAGE_LIVENESS_ALIVE)
+        return -1;
+    if (seen_ms <= now_ms && seen_ms > record->deferred_ms)
+        record->deferred_ms = seen_ms;
+    return 0;
+}
+
+//  --------------------------------------------------------------------------
+//  add transition to the list if caller wants it
+
+static size_t
+s_transition_add (fty_outage_liveness_transition_t *transitions, size_t count, size_t index, int type)
+{
+    if (transitions) {
+        transitions [count].index = index;
+        transitions [count].type = type;
+    }
+    return count + 1;
+}
+
+//  --------------------------------------------------------------------------
+//  Touch records with batch of items: each item is looked up and applied
+//  while its record is hot, records are rescheduled afterwards, once per
+//  record, prefetched ahead of the one being rescheduled
+
+size_t
+fty_outage_liveness_touch_batch (fty_outage_liveness_t *self, const fty_outage_liveness_touch_t *items, size_t count, int64_t now_ms, fty_outage_liveness_transition_t *transitions)
+{
+    assert (self);
+    assert (items || count == 0);
+
+    size_t transitions_count = 0;
+    if (count > self->batch_capacity) {
+        batch_entry_t *batch = (batch_entry_t *) realloc (self->batch, count * sizeof (batch_entry_t));
+        if (!batch) {
+            log_error ("Can't allocate batch of %zu items (memory error), touch them one by one", count);
+            for (size_t i = 0; i < count; i++) {
+                int type = fty_outage_liveness_touch (self, &items [i].key, items [i].seen_ms, items [i].ttl_ms, now_ms);
+                if (type > 0)
+                    transitions_count = s_transition_add (transitions, transitions_count, i, type);
+            }
+            return transitions_count;
+        }
+        self->batch = batch;
+        self->batch_capacity = count;
+    }
+
+    uint64_t seq = ++self->batch_seq;
+    size_t unique = 0;
+    for (size_t i = 0; i < count; i++) {
+        record_t *record = (record_t *) zhashx_lookup (self->records, &items [i].key);
+        if (!record)
+            continue;
+        if (record->batch != seq) {
+            record->batch = seq;
+            self->batch [unique].record = record;
+            self->batch [unique].index = i;
+            self->batch [unique].level = record->level;
+            unique++;
+        }
+        if (s_touch (self, record, items [i].seen_ms, items [i].ttl_ms, now_ms) != 0)
+            transitions_count = s_transition_add (transitions, transitions_count, i, FTY_OUTAGE_LIVENESS_FUTURE);
+    }
+
+    for (size_t i = 0; i < unique; i++) {
+        if (i + BATCH_PREFETCH < unique)
+            PREFETCH (self->batch [i + BATCH_PREFETCH].record);
+        batch_entry_t *entry = &self->batch [i];
+        s_schedule (self, entry->record, now_ms);
+        if (entry->level != FTY_OUTAGE_LIVENESS_ALIVE && entry->record->level == FTY_OUTAGE_LIVENESS_ALIVE) {
+            s_transition (self, FTY_OUTAGE_LIVENESS_REVIVED, entry->record);
+            transitions_count = s_transition_add (transitions, transitions_count, entry->index, FTY_OUTAGE_LIVENESS_REVIVED);
+        }
+    }
+    log_debug ("batch of %zu items touched %zu records, %zu transitions", count, unique, transitions_count);
+    return transitions_count;
+}
+
+//  --------------------------------------------------------------------------
+//  escalate records of the tier whose deadlines passed at now_ms, keys of
+//  records reaching a higher level are appended to 'escalated', if not NULL,
+//  once per call; returns their number
+
+static size_t
+s_expire_tier (fty_outage_liveness_t *self, tier_t *tier, int64_t now_ms, zlistx_t *escalated)
+{
+    // record escalated twice by one call is listed once, marked as a batch
+    uint64_t seq = ++self->batch_seq;
+    size_t count = 0;
+    // only deadlines which are due are touched, the rest of records is not visited
+    while (tier->heap_size > 0 && tier->heap [0]->at_ms <= now_ms) {
+        deadline_t *deadline = tier->heap [0];
+        s_heap_remove (tier, deadline);
+        record_t *record = deadline->owner;
+        // seen later than the deadline knows, move it
+        if (record->deferred_ms > record->seen_ms) {
+            s_schedule (self, record, now_ms);
+            continue;
+        }
+        log_debug ("record: name=%s, ttl=%" PRIi64 "ms, level=%d", record->key.name, record->ttl_ms, deadline->level);
+        if (record->level < deadline->level) {
+            record->level = deadline->level;
+            s_transition (self, FTY_OUTAGE_LIVENESS_EXPIRED, record);
+            if (escalated && record->batch != seq) {
+                record->batch = seq;
+                zlistx_add_end (escalated, &record->key);
+                count++;
+            }
+        }
+        zhashx_insert (self->dead, &record->key, record);
+    }
+    return count;
+}
+
+//  --------------------------------------------------------------------------
+//  Escalate records whose deadlines passed at now_ms, returns list of keys
+//  of all records which reached some escalation level
+
+zlistx_t *
+fty_outage_liveness_expire (fty_outage_liveness_t *self, int64_t now_ms)
+{
+    assert (self);
+    zlistx_t *dead = zlistx_new ();
+    if (!dead)
+        return NULL;
+
+    for (tier_t *tier = self->tiers; tier < self->tiers + FTY_OUTAGE_LIVENESS_TIERS; tier++)
+        s_expire_tier (self, tier, now_ms, NULL);
+    for (record_t *record = (record_t *) zhashx_first (self->dead);
+                   record != NULL;
+                   record = (record_t *) zhashx_next (self->dead))
+        zlistx_add_start (dead, &record->key);
+    return dead;
+}
+
+//  --------------------------------------------------------------------------
+//  Escalate records of the tier whose deadlines passed at now_ms, append
+//  keys of records which reached a higher level now to the list, returns
+//  their number
+
+size_t
+fty_outage_liveness_expire_tier (fty_outage_liveness_t *self, int tier, int64_t now_ms, zlistx_t *escalated)
+{
+    assert (self);
+    assert (tier >= 0 && tier < FTY_OUTAGE_LIVENESS_TIERS);
+    assert (escalated);
+    return s_expire_tier (self, &self->tiers [tier], now_ms, escalated);
+}
+
+//  --------------------------------------------------------------------------
+//  Return number of records
+
+size_t
+fty_outage_liveness_size (fty_outage_liveness_t *self)
+{
+    assert (self);
+    return zhashx_size (self->records);
+}
+
+//  --------------------------------------------------------------------------
+//  Return number of escalation deadlines scheduled
+
+size_t
+fty_outage_liveness_scheduled (fty_outage_liveness_t *self)
+{
+    assert (self);
+    size_t scheduled = 0;
+    for (int tier = 0; tier < FTY_OUTAGE_LIVENESS_TIERS; tier++)
+        scheduled += self->tiers [tier].heap_size;
+    return scheduled;
+}
+
+//  --------------------------------------------------------------------------
+//  Return key of the first record, NULL if there are none
+
+const asset_key_t *
+fty_outage_liveness_first (fty_outage_liveness_t *self)
+{
+    assert (self);
+    record_t *record = (record_t *) zhashx_first (self->records);
+    return record ? &record->key : NULL;
+}
+
+//  --------------------------------------------------------------------------
+//  Return key of the next record, NULL after the last one
+
+const asset_key_t *
+fty_outage_liveness_next (fty_outage_liveness_t *self)
+{
+    assert (self);
+    record_t *record = (record_t *) zhashx_next (self->records);
+    return record ? &record->key : NULL;
+}
+
+//  --------------------------------------------------------------------------
+//  Estimate heap memory held by liveness, items are not counted
+
+void
+fty_outage_liveness_memory (fty_outage_liveness_t *self, fty_outage_liveness_memory_t *memory)
+{
+    assert (self);
+    assert (memory);
+
+    memset (memory, 0, sizeof (fty_outage_liveness_memory_t));
+    memory->records = memory_usage_block (sizeof (fty_outage_liveness_t))
+        + memory_usage_hash (zhashx_size (self->records))
+        + memory_usage_hash (zhashx_size (self->dead));
+    for (record_t *record = (record_t *) zhashx_first (self->records);
+                   record != NULL;
+                   record = (record_t *) zhashx_next (self->records))
+    {
+        // name shares the block of the record
+        size_t block = memory_usage_block (sizeof (record_t) + record->key.length + 1);
+        memory->records += memory_usage_block (sizeof (record_t));
+        memory->keys += block - memory_usage_block (sizeof (record_t));
+    }
+    for (int tier = 0; tier < FTY_OUTAGE_LIVENESS_TIERS; tier++) {
+        if (self->tiers [tier].heap_capacity)
+            memory->index += memory_usage_block (self->tiers [tier].heap_capacity * sizeof (deadline_t *));
+    }
+    if (self->batch_capacity)
+        memory->index += memory_usage_block (self->batch_capacity * sizeof (batch_entry_t));
+}
+
+//  --------------------------------------------------------------------------
+//  move items of hash table into a new one with buckets sized to them
+
+static zhashx_t *
+s_hash_rebuild (zhashx_t **old_p, zhashx_destructor_fn *destructor)
+{
+    zhashx_t *old = *old_p;
+    zhashx_t *hash = asset_key_hash_new (false);
+    if (!hash)
+        return old;
+    for (void *item = zhashx_first (old); item; item = zhashx_next (old))
+        zhashx_insert (hash, zhashx_cursor (old), item);
+    zhashx_set_destructor (hash, destructor);
+    zhashx_set_destructor (old, NULL);
+    zhashx_destroy (old_p);
+    return hash;
+}
+
+//  --------------------------------------------------------------------------
+//  Shrink hash tables and the expiry index left over-allocated by past
+//  churn of records. Returns number of structures compacted.
+
+int
+fty_outage_liveness_compact (fty_outage_liveness_t *self)
+{
+    assert (self);
+
+    int compacted = 0;
+    size_t size = zhashx_size (self->records);
+    if (self->records_peak >= COMPACT_MIN_PEAK && size * COMPACT_RATIO < self->records_peak) {
+        self->records = s_hash_rebuild (&self->records, (zhashx_destructor_fn *) s_record_destroy);
+        self->dead = s_hash_rebuild (&self->dead, NULL);
+        self->records_peak = size;
+        compacted += 2;
+    }
+
+    // batch scratch is allocated again by the next batch
+    if (self->batch) {
+        free (self->batch);
+        self->batch = NULL;
+        self->batch_capacity = 0;
+        compacted++;
+    }
+
+    for (tier_t *tier = self->tiers; tier < self->tiers + FTY_OUTAGE_LIVENESS_TIERS; tier++) {
+        size_t capacity = tier->heap_capacity;
+        while (capacity > HEAP_MIN_CAPACITY && tier->heap_size * COMPACT_RATIO < capacity)
+            capacity /= 2;
+        if (capacity < tier->heap_capacity) {
+            deadline_t **heap = (deadline_t **) realloc (tier->heap, capacity * sizeof (deadline_t *));
+            if (heap) {
+                tier->heap = heap;
+                tier->heap_capacity = capacity;
+                compacted++;
+            }
+        }
+    }
+    return compacted;
+}
+
+//  --------------------------------------------------------------------------
+//  Return snapshot of all records, seen times are stored relative to now_ms
+
+zconfig_t *
+fty_outage_liveness_snapshot (fty_outage_liveness_t *self, int64_t now_ms)
+{
+    assert (self);
+    zconfig_t *root = zconfig_new ("liveness", NULL);
+    if (!root)
+        return NULL;
+    for (record_t *record = (record_t *) zhashx_first (self->records);
+                   record != NULL;
+                   record = (record_t *) zhashx_next (self->records))
+    {
+        // keys are values, names of zconfig items can't hold any string
+        zconfig_t *item = zconfig_new ("record", root);
+        zconfig_put (item, "key", record->key.name);
+        int64_t seen_ms = record->deferred_ms > record->seen_ms ? record->deferred_ms : record->seen_ms;
+        zconfig_putf (item, "age", "%" PRIi64, now_ms - seen_ms);
+        zconfig_putf (item, "ttl", "%" PRIi64, record->ttl_ms);
+        zconfig_putf (item, "level", "%d", record->level);
+        zconfig_putf (item, "tier", "%d", record->tier);
+    }
+    return root;
+}
+
+//  --------------------------------------------------------------------------
+//  Restore records from snapshot, seen times are rebased to now_ms
+
+int
+fty_outage_liveness_restore (fty_outage_liveness_t *self, zconfig_t *snapshot, int64_t now_ms)
+{
+    assert (self);
+    if (!snapshot || !streq (zconfig_name (snapshot), "liveness"))
+        return -1;
+
+    int restored = 0;
+    for (zconfig_t *item = zconfig_child (snapshot);
+                    item != NULL;
+                    item = zconfig_next (item))
+    {
+        const char *name = zconfig_get (item, "key", NULL);
+        char *end;
+        int64_t age_ms = (int64_t) strtoll (zconfig_get (item, "age", ""), &end, 10);
+        bool valid = name && *end == '\0';
+        int64_t ttl_ms = (int64_t) strtoll (zconfig_get (item, "ttl", ""), &end, 10);
+        valid = valid && *end == '\0' && ttl_ms >= 0;
+        long level = strtol (zconfig_get (item, "level", ""), &end, 10);
+        valid = valid && *end == '\0' && level >= FTY_OUTAGE_LIVENESS_ALIVE && level <= FTY_OUTAGE_LIVENESS_LEVELS;
+        // snapshots of older versions have no tiers
+        long tier = strtol (zconfig_get (item, "tier", "0"), &end, 10);
+        valid = valid && *end == '\0' && tier >= 0 && tier < FTY_OUTAGE_LIVENESS_TIERS;
+        if (!valid) {
+            log_warning ("Invalid record '%s' in liveness snapshot, skip it", name ? name : "");
+            continue;
+        }
+
+        asset_key_t key;
+        asset_key_init (&key, name);
+        record_t *record = (record_t *) zhashx_lookup (self->records, &key);
+        if (!record) {
+            record = s_record_new (&key, now_ms, ttl_ms, NULL);
+            if (!record) {
+                log_error ("Can't restore record of %s (memory error)", name);
+                continue;
+            }
+            zhashx_insert (self->records, &record->key, record);
+            if (zhashx_size (self->records) > self->records_peak)
+                self->records_peak = zhashx_size (self->records);
+        }
+        for (int i = 0; i < FTY_OUTAGE_LIVENESS_LEVELS; i++)
+            s_heap_remove (&self->tiers [record->tier], &record->deadlines [i]);
+        record->seen_ms = now_ms - age_ms;
+        record->ttl_ms = ttl_ms;
+        record->level = (int) level;
+        record->tier = (int) tier;
+        s_schedule (self, record, now_ms);
+        if (record->level != FTY_OUTAGE_LIVENESS_ALIVE)
+            zhashx_insert (self->dead, &record->key, record);
+        restored++;
+    }
+    return restored;
+}
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+// transitions reported to the handler, as "type:key"
+static void
+s_test_handler (void *arg, int type, const asset_key_t *key, void *item, const fty_outage_liveness_state_t *state)
+{
+    zlistx_t *log = (zlistx_t *) arg;
+    assert (state);
+    char *line = zsys_sprintf ("%d:%s", type, key->name);
+    zlistx_add_end (log, line);
+    zstr_free (&line);
+}
+
+// key of the name for tests, valid till the next call
+static const asset_key_t *
+s_key (const char *name)
+{
+    static asset_key_t key;
+    asset_key_init (&key, name);
+    return &key;
+}
+
+static size_t
+s_expired (fty_outage_liveness_t *self, int64_t now_ms)
+{
+    zlistx_t *dead = fty_outage_liveness_expire (self, now_ms);
+    size_t size = zlistx_size (dead);
+    zlistx_destroy (&dead);
+    return size;
+}
+
+void
+fty_outage_liveness_test (bool verbose)
+{
+    printf (" * fty_outage_liveness: ");
+
+    //  @selftest
+    //  Simple create/destroy test
+    fty_outage_liveness_t *self = fty_outage_liveness_new ();
+    assert (self);
+    fty_outage_liveness_destroy (&self);
+    fty_outage_liveness_destroy (&self);
+
+    // items are owned with destructor, transitions reported
+    self = fty_outage_liveness_new ();
+    zlistx_t *log = zlistx_new ();
+    zlistx_set_duplicator (log, (zlistx_duplicator_fn *) strdup);
+    zlistx_set_destructor (log, (zlistx_destructor_fn *) zstr_free);
+    fty_outage_liveness_set_destructor (self, (fty_outage_liveness_destructor_fn *) zstr_free);
+    fty_outage_liveness_set_handler (self, s_test_handler, log);
+    fty_outage_liveness_set_default_ttl (self, 10000);
+    fty_outage_liveness_set_escalation (self, 1, 3, 0);
+    int64_t now_ms = 1000000;
+    assert (fty_outage_liveness_insert (self, s_key ("agent-1"), strdup ("one"), now_ms) == 0);
+    assert (fty_outage_liveness_insert (self, s_key ("agent-2"), strdup ("two"), now_ms) == 0);
+    char *item = strdup ("again");
+    assert (fty_outage_liveness_insert (self, s_key ("agent-1"), item, now_ms) == -1);
+    zstr_free (&item);
+    assert (fty_outage_liveness_size (self) == 2);
+    assert (fty_outage_liveness_scheduled (self) == 4);
+    assert (streq ((char *) fty_outage_liveness_lookup (self, s_key ("agent-2")), "two"));
+    assert (!fty_outage_liveness_lookup (self, s_key ("agent-3")));
+    assert (streq ((char *) zlistx_first (log), "1:agent-1"));
+    assert (zlistx_size (log) == 2);
+
+    // replaced item is destroyed, state of the record and handler stay
+    assert (fty_outage_liveness_replace (self, s_key ("agent-2"), strdup ("two-b")) == 0);
+    assert (streq ((char *) fty_outage_liveness_lookup (self, s_key ("agent-2")), "two-b"));
+    assert (fty_outage_liveness_replace (self, s_key ("agent-2"), strdup ("two")) == 0);
+    item = strdup ("three");
+    assert (fty_outage_liveness_replace (self, s_key ("agent-3"), item) == -1);
+    zstr_free (&item);
+    assert (fty_outage_liveness_scheduled (self) == 4);
+    assert (zlistx_size (log) == 2);
+
+    // ttl only shrinks, seen time only moves forward
+    assert (fty_outage_liveness_touch (self, s_key ("agent-1"), now_ms + 1000, 5000, now_ms + 2000) == 0);
+    assert (fty_outage_liveness_touch (self, s_key ("agent-1"), now_ms, 20000, now_ms + 2000) == 0);
+    fty_outage_liveness_state_t state;
+    assert (fty_outage_liveness_state (self, s_key ("agent-1"), &state) == 0);
+    assert (state.seen_ms == now_ms + 1000);
+    assert (state.ttl_ms == 5000);
+    assert (state.level == FTY_OUTAGE_LIVENESS_ALIVE);
+    assert (state.deadline_ms == now_ms + 6000);
+    assert (fty_outage_liveness_state (self, s_key ("agent-3"), &state) == -1);
+    assert (fty_outage_liveness_touch (self, s_key ("agent-3"), now_ms, 5000, now_ms) == -1);
+    // seen in future is ignored, ttl is taken
+    assert (fty_outage_liveness_touch (self, s_key ("agent-1"), now_ms + 9000, 4000, now_ms + 2000) == FTY_OUTAGE_LIVENESS_FUTURE);
+    assert (fty_outage_liveness_state (self, s_key ("agent-1"), &state) == 0);
+    assert (state.seen_ms == now_ms + 1000 && state.ttl_ms == 4000);
+
+    // WARNING after 1 * ttl, CRITICAL after 3 * ttl
+    assert (s_expired (self, now_ms + 4999) == 0);
+    assert (s_expired (self, now_ms + 5000) == 1);
+    assert (fty_outage_liveness_level (self, s_key ("agent-1")) == FTY_OUTAGE_LIVENESS_WARNING);
+    assert (s_expired (self, now_ms + 13000) == 2);
+    assert (fty_outage_liveness_level (self, s_key ("agent-1")) == FTY_OUTAGE_LIVENESS_CRITICAL);
+    assert (streq ((char *) zlistx_last (log), "3:agent-1"));
+    assert (s_expired (self, now_ms + 30000) == 2);
+    assert (fty_outage_liveness_scheduled (self) == 0);
+
+    // touch brings it back
+    now_ms += 30000;
+    assert (fty_outage_liveness_touch (self, s_key ("agent-1"), now_ms, 4000, now_ms) == FTY_OUTAGE_LIVENESS_REVIVED);
+    assert (streq ((char *) zlistx_last (log), "4:agent-1"));
+    assert (s_expired (self, now_ms) == 1);
+
+    // ttl of the last touch
+    fty_outage_liveness_set_ttl_policy (self, FTY_OUTAGE_LIVENESS_TTL_LAST);
+    assert (fty_outage_liveness_touch (self, s_key ("agent-1"), now_ms, 8000, now_ms) == 0);
+    assert (fty_outage_liveness_state (self, s_key ("agent-1"), &state) == 0);
+    assert (state.ttl_ms == 8000);
+    fty_outage_liveness_set_ttl_policy (self, FTY_OUTAGE_LIVENESS_TTL_MIN);
+
+    // batch: duplicates, unknown key and touch from future
+    fty_outage_liveness_touch_t items [4];
+    asset_key_init (&items [0].key, "agent-2");
+    items [0].seen_ms = now_ms - 2000;
+    items [0].ttl_ms = 10000;
+    asset_key_init (&items [1].key, "agent-9");
+    items [1].seen_ms = now_ms;
+    items [1].ttl_ms = 10000;
+    asset_key_init (&items [2].key, "agent-1");
+    items [2].seen_ms = now_ms + 1000;
+    items [2].ttl_ms = 10000;
+    asset_key_init (&items [3].key, "agent-2");
+    items [3].seen_ms = now_ms - 1000;
+    items [3].ttl_ms = 10000;
+    fty_outage_liveness_transition_t transitions [4];
+    assert (fty_outage_liveness_touch_batch (self, items, 4, now_ms, transitions) == 2);
+    assert (transitions [0].index == 2 && transitions [0].type == FTY_OUTAGE_LIVENESS_FUTURE);
+    assert (transitions [1].index == 0 && transitions [1].type == FTY_OUTAGE_LIVENESS_REVIVED);
+    assert (fty_outage_liveness_state (self, s_key ("agent-2"), &state) == 0);
+    assert (state.seen_ms == now_ms - 1000 && state.level == FTY_OUTAGE_LIVENESS_ALIVE);
+    assert (s_expired (self, now_ms) == 0);
+
+    // deferred touch escalates at the same time as plain touch
+    fty_outage_liveness_t *lazy = fty_outage_liveness_new ();
+    fty_outage_liveness_set_default_ttl (lazy, 10000);
+    fty_outage_liveness_set_escalation (lazy, 1, 3, 0);
+    assert (fty_outage_liveness_insert (lazy, s_key ("plain"), NULL, 0) == 0);
+    assert (fty_outage_liveness_insert (lazy, s_key ("lazy"), NULL, 0) == 0);
+    for (int64_t seen_ms = 1000; seen_ms <= 25000; seen_ms += 3000) {
+        assert (fty_outage_liveness_touch (lazy, s_key ("plain"), seen_ms, 10000, seen_ms) == 0);
+        assert (fty_outage_liveness_defer (lazy, s_key ("lazy"), seen_ms, seen_ms) == 0);
+        assert (s_expired (lazy, seen_ms) == 0);
+    }
+    assert (fty_outage_liveness_defer (lazy, s_key ("lazy"), 20000, 25000) == 0);
+    assert (fty_outage_liveness_defer (lazy, s_key ("lazy"), 26000, 25000) == 0);
+    assert (fty_outage_liveness_defer (lazy, s_key ("unknown"), 25000, 25000) == -1);
+    assert (fty_outage_liveness_state (lazy, s_key ("lazy"), &state) == 0);
+    assert (state.seen_ms == 25000 && state.ttl_ms == 10000);
+    // both were seen last at 25000: WARNING at 35000, CRITICAL at 55000
+    assert (s_expired (lazy, 34999) == 0);
+    assert (s_expired (lazy, 35000) == 2);
+    assert (fty_outage_liveness_level (lazy, s_key ("lazy")) == FTY_OUTAGE_LIVENESS_WARNING);
+    // silent record is brought back by plain touch only
+    assert (fty_outage_liveness_defer (lazy, s_key ("lazy"), 40000, 40000) == -1);
+    assert (s_expired (lazy, 54999) == 2);
+    assert (fty_outage_liveness_level (lazy, s_key ("lazy")) == FTY_OUTAGE_LIVENESS_WARNING);
+    assert (s_expired (lazy, 55000) == 2);
+    assert (fty_outage_liveness_level (lazy, s_key ("plain")) == FTY_OUTAGE_LIVENESS_CRITICAL);
+    assert (fty_outage_liveness_level (lazy, s_key ("lazy")) == FTY_OUTAGE_LIVENESS_CRITICAL);
+    fty_outage_liveness_destroy (&lazy);
+
+    // deadlines of a tier are rounded up to its tick, each tier keeps its
+    // own resolution
+    fty_outage_liveness_t *tiered = fty_outage_liveness_new ();
+    fty_outage_liveness_set_default_ttl (tiered, 10000);
+    assert (fty_outage_liveness_insert (tiered, s_key ("ups"), NULL, 0) == 0);
+    assert (fty_outage_liveness_insert (tiered, s_key ("sensor"), NULL, 0) == 0);
+    assert (fty_outage_liveness_tier (tiered, s_key ("ups")) == 0);
+    assert (fty_outage_liveness_tier (tiered, s_key ("unknown")) == -1);
+    assert (fty_outage_liveness_set_tier (tiered, s_key ("unknown"), 1, 0) == -1);
+    assert (fty_outage_liveness_set_tier (tiered, s_key ("ups"), 1, 0) == 0);
+    assert (fty_outage_liveness_set_tier (tiered, s_key ("sensor"), 2, 0) == 0);
+    fty_outage_liveness_set_tick (tiered, 1, 1000, 0);
+    fty_outage_liveness_set_tick (tiered, 2, 60000, 0);
+    assert (fty_outage_liveness_tick (tiered, 0) == 0);
+    assert (fty_outage_liveness_tick (tiered, 2) == 60000);
+    assert (fty_outage_liveness_next_deadline (tiered, 0) == INT64_MAX);
+    // both seen at 1500, CRITICAL at 21500 is rounded up to 22000 and 60000
+    assert (fty_outage_liveness_touch (tiered, s_key ("ups"), 1500, 10000, 1500) == 0);
+    assert (fty_outage_liveness_touch (tiered, s_key ("sensor"), 1500, 10000, 1500) == 0);
+    assert (fty_outage_liveness_next_deadline (tiered, 1) == 22000);
+    assert (fty_outage_liveness_next_deadline (tiered, 2) == 60000);
+    assert (fty_outage_liveness_state (tiered, s_key ("sensor"), &state) == 0);
+    assert (state.deadline_ms == 60000);
+    assert (s_expired (tiered, 21999) == 0);
+    // expiry of a tier lists just the records it escalated
+    zlistx_t *escalated = zlistx_new ();
+    assert (fty_outage_liveness_expire_tier (tiered, 2, 22000, escalated) == 0);
+    assert (fty_outage_liveness_expire_tier (tiered, 1, 22000, escalated) == 1);
+    assert (streq (((asset_key_t *) zlistx_first (escalated))->name, "ups"));
+    assert (fty_outage_liveness_expire_tier (tiered, 1, 30000, escalated) == 0);
+    assert (zlistx_size (escalated) == 1);
+    zlistx_destroy (&escalated);
+    assert (fty_outage_liveness_level (tiered, s_key ("ups")) == FTY_OUTAGE_LIVENESS_CRITICAL);
+    assert (s_expired (tiered, 59999) == 1);
+    assert (s_expired (tiered, 60000) == 2);
+    assert (fty_outage_liveness_scheduled (tiered) == 0);
+    // tier is kept by snapshot
+    zconfig_t *tiered_snapshot = fty_outage_liveness_snapshot (tiered, 60000);
+    fty_outage_liveness_t *tiered_restored = fty_outage_liveness_new ();
+    assert (fty_outage_liveness_restore (tiered_restored, tiered_snapshot, 0) == 2);
+    assert (fty_outage_liveness_tier (tiered_restored, s_key ("sensor")) == 2);
+    zconfig_destroy (&tiered_snapshot);
+    fty_outage_liveness_destroy (&tiered_restored);
+    // revived record moved to exact tier
+    assert (fty_outage_liveness_touch (tiered, s_key ("sensor"), 61000, 10000, 61000) == FTY_OUTAGE_LIVENESS_REVIVED);
+    assert (fty_outage_liveness_set_tier (tiered, s_key ("sensor"), 0, 61000) == 0);
+    assert (fty_outage_liveness_next_deadline (tiered, 2) == INT64_MAX);
+    assert (fty_outage_liveness_next_deadline (tiered, 0) == 81000);
+    assert (fty_outage_liveness_scheduled (tiered) == 1);
+    fty_outage_liveness_destroy (&tiered);
+
+    // iteration
+    size_t keys = 0;
+    for (const asset_key_t *key = fty_outage_liveness_first (self);
+                            key != NULL;
+                            key = fty_outage_liveness_next (self))
+    {
+        assert (streq (key->name, "agent-1") || streq (key->name, "agent-2"));
+        keys++;
+    }
+    assert (keys == 2);
+
+    // snapshot survives restart, silence goes on from where it was
+    assert (s_expired (self, now_ms + 9000) == 2);
+    zconfig_t *snapshot = fty_outage_liveness_snapshot (self, now_ms + 9000);
+    assert (snapshot);
+    fty_outage_liveness_t *restored = fty_outage_liveness_new ();
+    fty_outage_liveness_set_escalation (restored, 1, 3, 0);
+    assert (fty_outage_liveness_insert (restored, s_key ("agent-1"), NULL, 0) == 0);
+    assert (fty_outage_liveness_restore (restored, snapshot, 500) == 2);
+    assert (fty_outage_liveness_size (restored) == 2);
+    assert (fty_outage_liveness_state (restored, s_key ("agent-2"), &state) == 0);
+    assert (state.seen_ms == 500 - 10000 && state.ttl_ms == 10000);
+    assert (state.level == FTY_OUTAGE_LIVENESS_WARNING);
+    assert (state.deadline_ms == 500 - 10000 + 30000);
+    assert (s_expired (restored, 500) == 2);
+    assert (s_expired (restored, 500 + 20000) == 2);
+    assert (fty_outage_liveness_level (restored, s_key ("agent-2")) == FTY_OUTAGE_LIVENESS_CRITICAL);
+    zconfig_destroy (&snapshot);
+    snapshot = zconfig_new ("alerts", NULL);
+    assert (fty_outage_liveness_restore (restored, snapshot, 500) == -1);
+    zconfig_destroy (&snapshot);
+    fty_outage_liveness_destroy (&restored);
+
+    // deleted record leaves nothing behind
+    size_t transitions_logged = zlistx_size (log);
+    assert (fty_outage_liveness_delete (self, s_key ("agent-1")) == 0);
+    assert (fty_outage_liveness_delete (self, s_key ("agent-1")) == -1);
+    assert (zlistx_size (log) == transitions_logged + 1);
+    assert (streq ((char *) zlistx_last (log), "2:agent-1"));
+    assert (s_expired (self, now_ms + 9000) == 1);
+    assert (fty_outage_liveness_scheduled (self) == 1);
+
+    // memory of churned records is given back
+    fty_outage_liveness_set_handler (self, NULL, NULL);
+    char name [32];
+    for (int i = 0; i < 4 * COMPACT_MIN_PEAK; i++) {
+        snprintf (name, sizeof (name), "agent-%d", i + 10);
+        assert (fty_outage_liveness_insert (self, s_key (name), strdup (name), now_ms) == 0);
+    }
+    fty_outage_liveness_memory_t full;
+    fty_outage_liveness_memory (self, &full);
+    assert (full.records > 4 * COMPACT_MIN_PEAK * sizeof (record_t));
+    assert (full.keys > 0);
+    assert (full.index >= 4 * COMPACT_MIN_PEAK * sizeof (deadline_t *));
+    assert (fty_outage_liveness_compact (self) == 1);
+    for (int i = 0; i < 4 * COMPACT_MIN_PEAK; i++) {
+        snprintf (name, sizeof (name), "agent-%d", i + 10);
+        assert (fty_outage_liveness_delete (self, s_key (name)) == 0);
+    }
+    assert (fty_outage_liveness_compact (self) == 3);
+    assert (fty_outage_liveness_compact (self) == 0);
+    fty_outage_liveness_memory_t compacted;
+    fty_outage_liveness_memory (self, &compacted);
+    assert (compacted.records < full.records / 100);
+    assert (compacted.index < full.index);
+    assert (streq ((char *) fty_outage_liveness_lookup (self, s_key ("agent-2")), "two"));
+
+    zlistx_destroy (&log);
+    fty_outage_liveness_destroy (&self);
+    //  @end
+    printf ("OK\n");
+}
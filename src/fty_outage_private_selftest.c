@@ -40,6 +40,38 @@ fty_outage_private_selftest (bool verbose, const char *subtest)
 // Tests for stable private classes:
     if (streq (subtest, "$ALL") || streq (subtest, "data_test"))
         data_test (verbose);
+    if (streq (subtest, "$ALL") || streq (subtest, "alert_refresh_test"))
+        alert_refresh_test (verbose);
+    if (streq (subtest, "$ALL") || streq (subtest, "alert_publisher_test"))
+        alert_publisher_test (verbose);
+    if (streq (subtest, "$ALL") || streq (subtest, "outage_summary_test"))
+        outage_summary_test (verbose);
+    if (streq (subtest, "$ALL") || streq (subtest, "outage_clock_test"))
+        outage_clock_test (verbose);
+    if (streq (subtest, "$ALL") || streq (subtest, "maintenance_test"))
+        maintenance_test (verbose);
+    if (streq (subtest, "$ALL") || streq (subtest, "asset_filter_test"))
+        asset_filter_test (verbose);
+    if (streq (subtest, "$ALL") || streq (subtest, "event_log_test"))
+        event_log_test (verbose);
+    if (streq (subtest, "$ALL") || streq (subtest, "outage_aggregator_test"))
+        outage_aggregator_test (verbose);
+    if (streq (subtest, "$ALL") || streq (subtest, "memory_usage_test"))
+        memory_usage_test (verbose);
+    if (streq (subtest, "$ALL") || streq (subtest, "clock_skew_test"))
+        clock_skew_test (verbose);
+    if (streq (subtest, "$ALL") || streq (subtest, "outage_history_test"))
+        outage_history_test (verbose);
+    if (streq (subtest, "$ALL") || streq (subtest, "outage_metrics_test"))
+        outage_metrics_test (verbose);
+    if (streq (subtest, "$ALL") || streq (subtest, "outage_locations_test"))
+        outage_locations_test (verbose);
+    if (streq (subtest, "$ALL") || streq (subtest, "touch_elision_test"))
+        touch_elision_test (verbose);
+    if (streq (subtest, "$ALL") || streq (subtest, "outage_sim_test"))
+        outage_sim_test (verbose);
+    if (streq (subtest, "$ALL") || streq (subtest, "asset_tiers_test"))
+        asset_tiers_test (verbose);
 }
 /*
 ################################################################################
@@ -42,11 +42,22 @@ all_tests [] = {
 #ifdef FTY_OUTAGE_BUILD_DRAFT_API
 // Tests for draft public classes:
     { "fty_outage_server", fty_outage_server_test, false, true, NULL },
+    { "asset_key", asset_key_test, false, true, NULL },
+    { "fty_outage_liveness", fty_outage_liveness_test, false, true, NULL },
 #endif // FTY_OUTAGE_BUILD_DRAFT_API
 #ifdef FTY_OUTAGE_BUILD_DRAFT_API
 // Tests for stable/draft private classes:
 // Now built only with --enable-drafts, so even stable builds are hidden behind the flag
     { "data", NULL, true, false, "data_test" },
+    { "alert_refresh", NULL, true, false, "alert_refresh_test" },
+    { "alert_publisher", NULL, true, false, "alert_publisher_test" },
+    { "outage_summary", NULL, true, false, "outage_summary_test" },
+    { "outage_clock", NULL, true, false, "outage_clock_test" },
+    { "maintenance", NULL, true, false, "maintenance_test" },
+    { "asset_filter", NULL, true, false, "asset_filter_test" },
+    { "event_log", NULL, true, false, "event_log_test" },
+    { "outage_aggregator", NULL, true, false, "outage_aggregator_test" },
+    { "memory_usage", NULL, true, false, "memory_usage_test" },
     { "private_classes", NULL, false, false, "$ALL" }, // compat option for older projects
 #endif // FTY_OUTAGE_BUILD_DRAFT_API
     {NULL, NULL, 0, 0, NULL}          //  Sentinel
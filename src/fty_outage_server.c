@@ -27,29 +27,109 @@
 */
 #define TIMEOUT_MS 30000   //wait at least 30 seconds
 #define SAVE_INTERVAL_MS 45*60*1000 // store state each 45 minutes
+#define STATS_INTERVAL_MS 5*60*1000 // report statistics each 5 minutes
+#define REFRESH_SLOTS 60            // active alerts are refreshed in 60 batches per period
+#define COMPACT_INTERVAL_MS 10*60*1000 // give memory back at most each 10 minutes, when idle
+#define METRICS_INTERVAL_MS 10*1000 // update gauges of exported metrics each 10 seconds
+#define TOUCH_ELISION_DIVISOR 8     // metric touching alive asset within the last ttl/8 is not decoded
+#define TOUCH_ELISION_SUBJECTS 65536 // subjects with elision hint at most
+#define ASSET_AGENT "asset-agent"   // mailbox of fty-asset, republishes assets on request
 
 #include "fty_outage_classes.h"
 #include "fty_common_macros.h"
 
-static void *TRUE = (void*) "true";   // hack to allow us to pretend zhash is set
+
+typedef struct _s_osrv_stats_t {
+    uint64_t alerts_sent;           // ACTIVE and RESOLVED alerts sent
+    uint64_t refresh_sent;          // ACTIVE alerts re-sent by the refresh
+    uint64_t alerts_dropped;        // alerts the publisher could not accept
+    uint64_t alerts_suppressed;     // alerts of dead assets not sent because of maintenance
+    uint64_t metrics_received;
+    uint64_t assets_received;
+    uint64_t metrics_elided;        // metrics taken as seen without decode
+    uint64_t compactions;           // idle or requested memory compactions
+    uint64_t tier_wakeups;          // checks of dead assets woken by deadlines of tiers
+    uint64_t window_start_ms;       // [ms] start of current statistics window
+    uint64_t window_refresh_sent;   // refresh_sent at the start of the window
+    double refresh_per_sec;         // refresh rate of the last finished window
+} s_osrv_stats_t;
 
 typedef struct _s_osrv_t {
     uint64_t timeout_ms;
-    mlm_client_t *client;
+    mlm_client_t *mailbox_client;   // receives control mail under the actor name, polled first
+    mlm_client_t *client;           // consumes metrics
+    mlm_client_t *priority_client;  // consumes asset updates and unavailable metrics, polled first
+    zactor_t *publisher;            // alert_publisher, sends alerts asynchronously
+    alert_publisher_counters_t publisher_counters; // updated by the publisher thread
+    outage_clock_t *clock;          // wall and monotonic time, shared with assets
     data_t *assets;
-    zhash_t *active_alerts;
+    zhashx_t *active_alerts;        // asset_key => severity of ACTIVE alert
+    zhashx_t *alert_cache;          // asset_key => ACTIVE alert (fty_proto_t), to be refreshed
+    zhashx_t *suppressed;           // asset_key => severity of alert suppressed by maintenance
+    alert_refresh_t *refresh;       // schedules refresh of active alerts before they expire
+    s_osrv_stats_t stats;
     char *state_file;
+    char *endpoint;                 // malamute endpoint from CONNECT
+    char *name;                     // malamute address from CONNECT
+    zactor_t *summary_publisher;    // alert_publisher for the summary stream, NULL if disabled
+    outage_summary_t *summary;
+    uint64_t summary_interval_ms;
+    char *summary_subject;          // outage-summary[@site], site keys the summary at the aggregator
+    maintenance_t *maintenance;     // windows suppressing outage alerts
+    char *maintenance_file;
+    char *filter_file;              // configuration with 'filter' section
+    char *tiers_file;               // configuration with 'tiers' section
+    event_log_t *event_log;         // ring of asset transitions, NULL if disabled
+    outage_history_t *history;      // outages of assets, NULL if disabled
+    outage_metrics_t *metrics;      // counters read by the exporter thread
+    zactor_t *exporter;             // outage_metrics_exporter, NULL if disabled
+    touch_elision_t *elision;       // hints to skip metrics without decode, NULL if disabled
 } s_osrv_t;
 
+// alerts are published with ttl = 3 * timeout
+static uint64_t
+s_osrv_alert_ttl (s_osrv_t *self)
+{
+    return self->timeout_ms * 3;
+}
+
+// refresh active alert twice per its ttl [s], so it never expires downstream
+static uint64_t
+s_osrv_refresh_period_ms (s_osrv_t *self)
+{
+    return s_osrv_alert_ttl (self) * 1000 / 2;
+}
+
 static void
 s_osrv_destroy (s_osrv_t **self_p)
 {
     assert (self_p);
     if (*self_p) {
         s_osrv_t *self = *self_p;
-        zhash_destroy (&self->active_alerts);
+        zactor_destroy (&self->exporter);
+        outage_metrics_destroy (&self->metrics);
+        touch_elision_destroy (&self->elision);
+        alert_refresh_destroy (&self->refresh);
+        zhashx_destroy (&self->alert_cache);
+        zhashx_destroy (&self->suppressed);
+        zhashx_destroy (&self->active_alerts);
         data_destroy (&self->assets);
+        event_log_destroy (&self->event_log);
+        outage_history_destroy (&self->history);
+        outage_clock_destroy (&self->clock);
+        zactor_destroy (&self->summary_publisher);
+        outage_summary_destroy (&self->summary);
+        zstr_free (&self->summary_subject);
+        maintenance_destroy (&self->maintenance);
+        zstr_free (&self->maintenance_file);
+        zstr_free (&self->filter_file);
+        zstr_free (&self->tiers_file);
+        zstr_free (&self->endpoint);
+        zstr_free (&self->name);
+        zactor_destroy (&self->publisher);
+        mlm_client_destroy (&self->priority_client);
         mlm_client_destroy (&self->client);
+        mlm_client_destroy (&self->mailbox_client);
         zstr_free (&self->state_file);
         free (self);
         *self_p = NULL;
@@ -61,13 +141,38 @@ s_osrv_new ()
 {
     s_osrv_t *self = (s_osrv_t*) zmalloc (sizeof (s_osrv_t));
     if (self) {
-        self->client = mlm_client_new ();
+        self->mailbox_client = mlm_client_new ();
+        if (self->mailbox_client)
+            self->client = mlm_client_new ();
         if (self->client)
+            self->priority_client = mlm_client_new ();
+        if (self->priority_client)
+            self->publisher = alert_publisher_new (&self->publisher_counters);
+        if (self->publisher)
+            self->clock = outage_clock_new ();
+        if (self->clock)
             self->assets = data_new ();
-        if (self->assets)
-            self->active_alerts = zhash_new ();
-        if (self->active_alerts) {
+        if (self->assets) {
+            data_set_clock (self->assets, self->clock);
+            self->active_alerts = asset_key_hash_new (true);
+        }
+        if (self->active_alerts)
+            self->alert_cache = asset_key_hash_new (true);
+        if (self->alert_cache)
+            self->suppressed = asset_key_hash_new (true);
+        if (self->suppressed) {
+            zhashx_set_destructor (self->alert_cache, (zhashx_destructor_fn *) fty_proto_destroy);
             self->timeout_ms = TIMEOUT_MS;
+            self->refresh = alert_refresh_new (s_osrv_refresh_period_ms (self), REFRESH_SLOTS, outage_clock_mono_ms (self->clock));
+        }
+        if (self->refresh)
+            self->maintenance = maintenance_new ();
+        if (self->maintenance)
+            self->metrics = outage_metrics_new ();
+        if (self->metrics)
+            self->elision = touch_elision_new (TOUCH_ELISION_DIVISOR, TOUCH_ELISION_SUBJECTS);
+        if (self->elision) {
+            self->stats.window_start_ms = outage_clock_mono_ms (self->clock);
             self->state_file = NULL;
         } else {
             s_osrv_destroy (&self);
@@ -76,75 +181,414 @@ s_osrv_new ()
     return self;
 }
 
-// publish 'outage' alert for asset 'source-asset' in state 'alert-state'
-static void
-s_osrv_send_alert (s_osrv_t* self, const char* source_asset, const char* alert_state)
+// severity of 'outage' alert for escalation level of silent asset
+static const char *
+s_osrv_severity (int level)
+{
+    return level == DATA_LEVEL_WARNING ? "WARNING" : "CRITICAL";
+}
+
+// encode 'outage' alert for asset 'source-asset' in state 'alert-state'
+static zmsg_t *
+s_osrv_encode_alert (s_osrv_t* self, const asset_key_t *key, const char* alert_state, const char *severity)
 {
     assert (self);
-    assert (source_asset);
+    assert (key);
     assert (alert_state);
+    assert (severity);
 
+    const char *source_asset = key->name;
     zlist_t *actions = zlist_new ();
     zlist_append(actions, "EMAIL");
     zlist_append(actions, "SMS");
     char *rule_name = zsys_sprintf ("%s@%s","outage",source_asset);
-    char *description = TRANSLATE_ME("Device %s does not provide expected data. It may be offline or not correctly configured.", data_get_asset_ename (self->assets, source_asset));
+    // asset may be gone already, when resolving alerts of removed assets
+    const char *ename = data_get_asset_ename (self->assets, key);
+    char *description = TRANSLATE_ME("Device %s does not provide expected data. It may be offline or not correctly configured.", ename ? ename : source_asset);
     zmsg_t *msg = fty_proto_encode_alert (
             NULL, // aux
-            zclock_time() / 1000,
-            self->timeout_ms * 3,
+            outage_clock_wall_ms (self->clock) / 1000,
+            s_osrv_alert_ttl (self),
             rule_name, // rule_name
             source_asset,
             alert_state,
-            "CRITICAL",
+            severity,
             description,
             actions);
+    zlist_destroy(&actions);
+    zstr_free (&rule_name);
+    zstr_free (&description);
+    return msg;
+}
+
+// hand over already encoded alert for asset 'source-asset' to the publisher
+static void
+s_osrv_publish_alert (s_osrv_t* self, const char* source_asset, const char *severity, bool refresh, zmsg_t **msg_p)
+{
+    assert (self);
+    assert (source_asset);
+    assert (severity);
+    assert (msg_p);
+
     char *subject = zsys_sprintf ("%s/%s@%s",
         "outage",
-        "CRITICAL",
+        severity,
         source_asset);
-    log_debug ("Alert '%s' is '%s'", subject, alert_state);
-    int rv = mlm_client_send (self->client, subject, &msg);
-    if ( rv != 0 )
-        log_error ("Cannot send alert on '%s' (mlm_client_send)", source_asset);
-    zlist_destroy(&actions);
+    int rv = alert_publisher_send (self->publisher, subject, refresh, msg_p);
+    if ( rv != 0 ) {
+        log_error ("Cannot send alert on '%s' (publisher queue is full)", source_asset);
+        self->stats.alerts_dropped++;
+    }
     zstr_free (&subject);
-    zstr_free (&rule_name);
-    zstr_free (&description);
+}
+
+// publish 'outage' alert for asset 'source-asset' in state 'alert-state' with 'severity'
+// ACTIVE alerts are kept decoded in alert_cache, so refresh only stamps and encodes them
+static void
+s_osrv_send_alert (s_osrv_t* self, const asset_key_t *key, const char* alert_state, const char *severity)
+{
+    assert (self);
+    assert (key);
+    assert (alert_state);
+    assert (severity);
+
+    zmsg_t *msg = s_osrv_encode_alert (self, key, alert_state, severity);
+    if (streq (alert_state, "ACTIVE")) {
+        zmsg_t *copy = zmsg_dup (msg);
+        fty_proto_t *alert = copy ? fty_proto_decode (&copy) : NULL;
+        if (alert)
+            zhashx_update (self->alert_cache, key, alert);
+    }
+    log_debug ("Alert 'outage/%s@%s' is '%s'", severity, key->name, alert_state);
+    s_osrv_publish_alert (self, key->name, severity, false, &msg);
+    self->stats.alerts_sent++;
+    outage_metrics_add (self->metrics, OUTAGE_METRICS_ALERTS_SENT, 1);
+}
+
+// re-send ACTIVE alerts from slots which are due, so they never expire while device is dead
+// refresh is stamped with the current time, so time + ttl moves forward downstream
+static void
+s_osrv_refresh_alerts (s_osrv_t* self, uint64_t now_ms)
+{
+    assert (self);
+
+    zlistx_t *due = zlistx_new ();
+    if (!due) {
+        log_error ("Can't get a list of alerts to refresh (memory error)");
+        return;
+    }
+    alert_refresh_due (self->refresh, now_ms, due);
+    log_debug ("alerts to refresh: %zu", zlistx_size (due));
+    uint64_t now_sec = outage_clock_wall_ms (self->clock) / 1000;
+
+    for (const asset_key_t *key = (const asset_key_t *) zlistx_first (due);
+                            key != NULL;
+                            key = (const asset_key_t *) zlistx_next (due))
+    {
+        const char *severity = (const char *) zhashx_lookup (self->active_alerts, key);
+        if (!severity)
+            severity = "CRITICAL";
+        fty_proto_t *alert = (fty_proto_t *) zhashx_lookup (self->alert_cache, key);
+        if (!alert) {
+            // alerts loaded from the state file were never encoded by us
+            zmsg_t *encoded = s_osrv_encode_alert (self, key, "ACTIVE", severity);
+            alert = encoded ? fty_proto_decode (&encoded) : NULL;
+            if (!alert)
+                continue;
+            zhashx_insert (self->alert_cache, key, alert);
+        }
+        fty_proto_set_time (alert, now_sec);
+        fty_proto_t *copy = fty_proto_dup (alert);
+        zmsg_t *msg = copy ? fty_proto_encode (&copy) : NULL;
+        if (!msg)
+            continue;
+        s_osrv_publish_alert (self, key->name, severity, true, &msg);
+        self->stats.refresh_sent++;
+    }
+    zlistx_destroy (&due);
+}
+
+// publish compact summary of dead assets
+static void
+s_osrv_publish_summary (s_osrv_t* self)
+{
+    assert (self);
+    assert (self->summary);
+
+    zmsg_t *msg = outage_summary_encode (self->summary, self->active_alerts);
+    log_debug ("outage summary %" PRIu64 ": %zu dead assets",
+        outage_summary_sequence (self->summary), zhashx_size (self->active_alerts));
+    if (alert_publisher_send (self->summary_publisher, self->summary_subject, false, &msg) != 0)
+        log_error ("Cannot send outage summary (publisher queue is full)");
+}
+
+// close the statistics window and compute rates
+static void
+s_osrv_stats_update (s_osrv_t* self, uint64_t now_ms)
+{
+    assert (self);
+
+    uint64_t elapsed_ms = now_ms - self->stats.window_start_ms;
+    if (elapsed_ms == 0)
+        return;
+    self->stats.refresh_per_sec =
+        (double) (self->stats.refresh_sent - self->stats.window_refresh_sent) * 1000 / elapsed_ms;
+    self->stats.window_start_ms = now_ms;
+    self->stats.window_refresh_sent = self->stats.refresh_sent;
+}
+
+// update gauges of exported metrics from counts kept by data, here so the
+// exporter thread never touches the assets
+static void
+s_osrv_metrics_update (s_osrv_t* self)
+{
+    assert (self);
+
+    outage_metrics_set_assets (self->metrics, data_subtypes (self->assets));
+    outage_metrics_set (self->metrics, OUTAGE_METRICS_ACTIVE_OUTAGES, (int64_t) zhashx_size (self->active_alerts));
+}
+
+// estimated heap memory held by active alerts, their cache and refresh schedule
+static size_t
+s_osrv_alerts_memory (s_osrv_t *self)
+{
+    size_t bytes = memory_usage_hash (zhashx_size (self->active_alerts))
+        + memory_usage_hash (zhashx_size (self->alert_cache))
+        + memory_usage_hash (zhashx_size (self->suppressed))
+        + alert_refresh_memory (self->refresh);
+    for (void *it = zhashx_first (self->suppressed); it; it = zhashx_next (self->suppressed)) {
+        const asset_key_t *key = (const asset_key_t *) zhashx_cursor (self->suppressed);
+        bytes += memory_usage_block (sizeof (asset_key_t) + key->length + 1);
+    }
+    for (void *it = zhashx_first (self->active_alerts); it; it = zhashx_next (self->active_alerts)) {
+        const asset_key_t *key = (const asset_key_t *) zhashx_cursor (self->active_alerts);
+        bytes += memory_usage_block (sizeof (asset_key_t) + key->length + 1);
+    }
+    for (fty_proto_t *alert = (fty_proto_t *) zhashx_first (self->alert_cache);
+                      alert != NULL;
+                      alert = (fty_proto_t *) zhashx_next (self->alert_cache))
+    {
+        const asset_key_t *key = (const asset_key_t *) zhashx_cursor (self->alert_cache);
+        bytes += memory_usage_block (sizeof (asset_key_t) + key->length + 1) + memory_usage_proto (alert);
+    }
+    return bytes;
+}
+
+// give memory left over from asset churn back to the operating system
+static void
+s_osrv_compact (s_osrv_t *self)
+{
+    size_t rss = memory_usage_rss ();
+    int compacted = data_compact (self->assets);
+    bool trimmed = memory_usage_trim ();
+    self->stats.compactions++;
+    log_info ("outage_actor: compacted %d structures, RSS %zu kB -> %zu kB%s",
+        compacted, rss / 1024, memory_usage_rss () / 1024, trimmed ? "" : " (nothing trimmed)");
+}
+
+// send statistics to the actor pipe as a list of name/value pairs
+static void
+s_osrv_stats_send (s_osrv_t* self, zsock_t *pipe)
+{
+    assert (self);
+    assert (pipe);
+
+    zmsg_t *reply = zmsg_new ();
+    zmsg_addstr (reply, "STATS");
+    zmsg_addstr (reply, "active-alerts");
+    zmsg_addstrf (reply, "%zu", zhashx_size (self->active_alerts));
+    zmsg_addstr (reply, "alerts-sent");
+    zmsg_addstrf (reply, "%" PRIu64, self->stats.alerts_sent);
+    zmsg_addstr (reply, "refresh-sent");
+    zmsg_addstrf (reply, "%" PRIu64, self->stats.refresh_sent);
+    zmsg_addstr (reply, "refresh-per-sec");
+    zmsg_addstrf (reply, "%.3f", self->stats.refresh_per_sec);
+    zmsg_addstr (reply, "alerts-dropped");
+    zmsg_addstrf (reply, "%" PRIu64, self->stats.alerts_dropped);
+    zmsg_addstr (reply, "alerts-suppressed");
+    zmsg_addstrf (reply, "%" PRIu64, self->stats.alerts_suppressed);
+    zmsg_addstr (reply, "maintenance-windows");
+    zmsg_addstrf (reply, "%zu", maintenance_size (self->maintenance));
+    zmsg_addstr (reply, "metrics-received");
+    zmsg_addstrf (reply, "%" PRIu64, self->stats.metrics_received);
+    zmsg_addstr (reply, "assets-received");
+    zmsg_addstrf (reply, "%" PRIu64, self->stats.assets_received);
+    zmsg_addstr (reply, "metrics-elided");
+    zmsg_addstrf (reply, "%" PRIu64, self->stats.metrics_elided);
+    zmsg_addstr (reply, "tier-wakeups");
+    zmsg_addstrf (reply, "%" PRIu64, self->stats.tier_wakeups);
+    zmsg_addstr (reply, "elision-ratio");
+    zmsg_addstrf (reply, "%.3f", self->stats.metrics_received
+        ? (double) self->stats.metrics_elided / self->stats.metrics_received : 0.0);
+
+    // metrics stamped ahead of local clock, taken as seen now
+    clock_skew_totals_t skew;
+    clock_skew_totals (data_skew (self->assets), &skew);
+    zmsg_addstr (reply, "skew-ahead");
+    zmsg_addstrf (reply, "%" PRIu64, skew.ahead);
+    zmsg_addstr (reply, "skew-clamped");
+    zmsg_addstrf (reply, "%" PRIu64, skew.clamped);
+    zmsg_addstr (reply, "skew-suppressed");
+    zmsg_addstrf (reply, "%" PRIu64, skew.suppressed);
+    zmsg_addstr (reply, "skew-max-sec");
+    zmsg_addstrf (reply, "%" PRIi64, skew.max_sec);
+    zmsg_addstr (reply, "skew-sources");
+    zmsg_addstrf (reply, "%zu", skew.sources);
+
+    // estimated heap memory per structure, bytes
+    data_memory_t memory;
+    data_memory (self->assets, &memory);
+    zmsg_addstr (reply, "memory-assets");
+    zmsg_addstrf (reply, "%zu", memory.assets);
+    zmsg_addstr (reply, "memory-strings");
+    zmsg_addstrf (reply, "%zu", memory.strings);
+    zmsg_addstr (reply, "memory-messages");
+    zmsg_addstrf (reply, "%zu", memory.messages);
+    zmsg_addstr (reply, "memory-deadlines");
+    zmsg_addstrf (reply, "%zu", memory.heap);
+    zmsg_addstr (reply, "memory-skew");
+    zmsg_addstrf (reply, "%zu", memory.skew);
+    zmsg_addstr (reply, "memory-locations");
+    zmsg_addstrf (reply, "%zu", memory.locations);
+    zmsg_addstr (reply, "memory-elision");
+    zmsg_addstrf (reply, "%zu", self->elision ? touch_elision_memory (self->elision) : 0);
+    zmsg_addstr (reply, "memory-history");
+    zmsg_addstrf (reply, "%zu", self->history ? outage_history_memory (self->history) : 0);
+    zmsg_addstr (reply, "memory-alerts");
+    zmsg_addstrf (reply, "%zu", s_osrv_alerts_memory (self));
+    zmsg_addstr (reply, "memory-rss");
+    zmsg_addstrf (reply, "%zu", memory_usage_rss ());
+    zmsg_addstr (reply, "compactions");
+    zmsg_addstrf (reply, "%" PRIu64, self->stats.compactions);
+
+    // queue metrics are counted by the publisher thread, read without waiting for it
+    alert_publisher_counters_t publisher;
+    alert_publisher_counters (&self->publisher_counters, &publisher);
+    zmsg_addstr (reply, "publish-queue-depth");
+    zmsg_addstrf (reply, "%" PRIu64, publisher.depth);
+    zmsg_addstr (reply, "publish-queue-max-depth");
+    zmsg_addstrf (reply, "%" PRIu64, publisher.max_depth);
+    zmsg_addstr (reply, "publish-queue-capacity");
+    zmsg_addstrf (reply, "%" PRIu64, publisher.capacity);
+    zmsg_addstr (reply, "publish-enqueued");
+    zmsg_addstrf (reply, "%" PRIu64, publisher.enqueued);
+    zmsg_addstr (reply, "publish-sent");
+    zmsg_addstrf (reply, "%" PRIu64, publisher.sent);
+    zmsg_addstr (reply, "publish-dropped");
+    zmsg_addstrf (reply, "%" PRIu64, publisher.dropped);
+    zmsg_addstr (reply, "publish-retries");
+    zmsg_addstrf (reply, "%" PRIu64, publisher.retries);
+    zmsg_addstr (reply, "memory-publish-queue");
+    zmsg_addstrf (reply, "%" PRIu64, publisher.memory);
+    zmsg_send (&reply, pipe);
+}
+
+// reply with 'count' worst assets of the outage history, name followed by
+// "outages downtime-ms mtbf-ms mttr-ms down" each
+#define HISTORY_TOP_MAX 1000
+
+static void
+s_osrv_history_send (s_osrv_t* self, zsock_t *pipe, size_t count, int by)
+{
+    assert (self);
+    assert (pipe);
+
+    if (count > HISTORY_TOP_MAX)
+        count = HISTORY_TOP_MAX;
+    outage_history_stats_t *top = NULL;
+    if (self->history && count > 0)
+        top = (outage_history_stats_t *) malloc (count * sizeof (outage_history_stats_t));
+    size_t size = top ? outage_history_top (self->history, count, by, top) : 0;
+
+    zmsg_t *reply = zmsg_new ();
+    zmsg_addstr (reply, "HISTORY-TOP");
+    for (size_t i = 0; i < size; i++) {
+        zmsg_addstr (reply, top [i].asset);
+        zmsg_addstrf (reply, "%" PRIu32 " %" PRIi64 " %" PRIi64 " %" PRIi64 " %d",
+            top [i].outages, top [i].downtime_ms, top [i].mtbf_ms, top [i].mttr_ms, top [i].down ? 1 : 0);
+    }
+    free (top);
+    zmsg_send (&reply, pipe);
+}
+
+// reply with skew of each source with metrics ahead of local clock, name
+// followed by "ahead clamped max-sec last-sec"
+static void
+s_osrv_skew_send (s_osrv_t* self, zsock_t *pipe)
+{
+    assert (self);
+    assert (pipe);
+
+    clock_skew_t *skew = data_skew (self->assets);
+    zmsg_t *reply = zmsg_new ();
+    zmsg_addstr (reply, "SKEW");
+    for (const clock_skew_source_t *source = clock_skew_first (skew);
+                                    source != NULL;
+                                    source = clock_skew_next (skew))
+    {
+        zmsg_addstr (reply, clock_skew_cursor (skew)->name);
+        zmsg_addstrf (reply, "%" PRIu32 " %" PRIu32 " %" PRIi32 " %" PRIi32,
+            source->ahead, source->clamped, source->max_sec, source->last_sec);
+    }
+    zmsg_send (&reply, pipe);
 }
 
 // if for asset 'source-asset' the 'outage' alert is tracked
 // * publish alert in RESOLVE state for asset 'source-asset'
 // * removes alert from the list of the active alerts
+// key must not be one owned by active alerts or their refresh schedule
 static void
-s_osrv_resolve_alert (s_osrv_t* self, const char* source_asset)
+s_osrv_resolve_alert (s_osrv_t* self, const asset_key_t *key)
 {
     assert (self);
-    assert (source_asset);
-
-    if (zhash_lookup (self->active_alerts, source_asset)) {
-        log_info ("\t\tsend RESOLVED alert for source=%s", source_asset);
-        s_osrv_send_alert (self, source_asset, "RESOLVED");
-        zhash_delete (self->active_alerts, source_asset);
+    assert (key);
+
+    // revived asset is not suppressed any more, the hash is empty out of maintenance
+    if (zhashx_size (self->suppressed) > 0)
+        zhashx_delete (self->suppressed, key);
+    const char *severity = (const char *) zhashx_lookup (self->active_alerts, key);
+    if (severity) {
+        log_info ("\t\tsend RESOLVED alert for source=%s", key->name);
+        s_osrv_send_alert (self, key, "RESOLVED", severity);
+        data_log_event (self->assets, EVENT_LOG_RESOLVED, key);
+        if (self->history)
+            outage_history_end (self->history, key);
+        zhashx_delete (self->active_alerts, key);
+        zhashx_delete (self->alert_cache, key);
+        alert_refresh_remove (self->refresh, key);
     }
 }
 
-// if for asset 'source-asset' the 'outage' alert is NOT tracked
-// * publish alert in ACTIVE state for asset 'source-asset'
+// if for asset 'source-asset' the 'outage' alert is NOT tracked with 'severity'
+// * publish alert in ACTIVE state for asset 'source-asset', escalating the
+//   tracked one if any
 // * adds alert to the list of the active alerts
 static void
-s_osrv_activate_alert (s_osrv_t* self, const char* source_asset)
+s_osrv_activate_alert (s_osrv_t* self, const asset_key_t *key, const char *severity)
 {
     assert (self);
-    assert (source_asset);
-
-    if ( !zhash_lookup (self->active_alerts, source_asset)) {
-        log_info ("\t\tsend ACTIVE alert for source=%s", source_asset);
-        s_osrv_send_alert (self, source_asset, "ACTIVE");
-        zhash_insert (self->active_alerts, source_asset, TRUE);
+    assert (key);
+    assert (severity);
+
+    const char *active = (const char *) zhashx_lookup (self->active_alerts, key);
+    if ( !active ) {
+        log_info ("\t\tsend ACTIVE alert for source=%s, severity=%s", key->name, severity);
+        s_osrv_send_alert (self, key, "ACTIVE", severity);
+        data_log_event (self->assets, EVENT_LOG_ACTIVE, key);
+        if (self->history)
+            outage_history_start (self->history, key);
+        zhashx_insert (self->active_alerts, key, (void *) severity);
+        alert_refresh_insert (self->refresh, key);
     }
     else
-        log_debug ("\t\talert already active for source=%s", source_asset);
+    if ( !streq (active, severity) ) {
+        log_info ("\t\tescalate ACTIVE alert for source=%s, severity=%s", key->name, severity);
+        s_osrv_send_alert (self, key, "ACTIVE", severity);
+        data_log_event (self->assets, EVENT_LOG_ACTIVE, key);
+        zhashx_update (self->active_alerts, key, (void *) severity);
+    }
+    else
+        log_debug ("\t\talert already active for source=%s", key->name);
 }
 
 static int
@@ -164,11 +608,11 @@ s_osrv_save (s_osrv_t *self)
     assert (active_alerts);
 
     size_t i = 0;
-    for (void*  it = zhash_first (self->active_alerts);
+    for (void*  it = zhashx_first (self->active_alerts);
                 it != NULL;
-                it = zhash_next (self->active_alerts))
+                it = zhashx_next (self->active_alerts))
     {
-        const char *value = (const char*) zhash_cursor (self->active_alerts);
+        const char *value = ((const asset_key_t *) zhashx_cursor (self->active_alerts))->name;
         char *key = zsys_sprintf ("%zu", i++);
         zconfig_put (active_alerts, key, value);
         zstr_free (&key);
@@ -207,19 +651,286 @@ s_osrv_load (s_osrv_t *self)
                     child != NULL;
                     child = zconfig_next (child))
     {
-        zhash_insert (self->active_alerts, zconfig_value (child), TRUE);
+        asset_key_t key;
+        asset_key_init (&key, zconfig_value (child));
+        zhashx_insert (self->active_alerts, &key, (void *) s_osrv_severity (DATA_LEVEL_CRITICAL));
+        alert_refresh_insert (self->refresh, &key);
+    }
+
+    zconfig_destroy (&root);
+    return 0;
+}
+
+// true if asset 'source' is in the maintenance window now
+static bool
+s_osrv_in_maintenance (s_osrv_t *self, const asset_key_t *key, uint64_t now_sec)
+{
+    fty_proto_t *asset = data_get_asset (self->assets, key);
+    return maintenance_active (self->maintenance, key->name,
+        asset ? fty_proto_aux_string (asset, FTY_PROTO_ASSET_AUX_PARENT_NAME_1, NULL) : NULL,
+        asset ? fty_proto_aux_string (asset, FTY_PROTO_ASSET_SUBTYPE, NULL) : NULL,
+        now_sec);
+}
+
+// (re)load maintenance windows from the file
+static int
+s_osrv_load_maintenance (s_osrv_t *self)
+{
+    assert (self);
+    assert (self->maintenance_file);
+
+    zconfig_t *root = zconfig_load (self->maintenance_file);
+    if (!root) {
+        log_error ("Can't load maintenance windows from %s: %m", self->maintenance_file);
+        return -1;
+    }
+    zconfig_t *windows = zconfig_locate (root, "maintenance");
+    int invalid = maintenance_load (self->maintenance, windows ? windows : root);
+    log_info ("loaded %zu maintenance windows from %s, %d invalid",
+        maintenance_size (self->maintenance), self->maintenance_file, invalid);
+    zconfig_destroy (&root);
+    return 0;
+}
+
+// ask the asset agent to publish all assets again: assets which the new filter
+// selects were dropped when they were published, they are added from the
+// republished messages
+static void
+s_osrv_request_republish (s_osrv_t *self)
+{
+    assert (self);
+
+    if (!mlm_client_connected (self->priority_client)) {
+        log_debug ("not connected yet, assets are added as they are published");
+        return;
+    }
+    zmsg_t *request = zmsg_new ();
+    zmsg_addstr (request, "$all");
+    if (mlm_client_sendto (self->priority_client, ASSET_AGENT, "REPUBLISH", NULL, 1000, &request) != 0)
+        log_error ("Can't request republish of assets from %s, newly selected assets are added once they change", ASSET_AGENT);
+}
+
+// (re)load asset filter from the 'filter' section of the file, resolve alerts
+// of assets which are not monitored any more and request assets again for
+// the ones it selects now
+static int
+s_osrv_load_filter (s_osrv_t *self)
+{
+    assert (self);
+    assert (self->filter_file);
+
+    zconfig_t *root = zconfig_load (self->filter_file);
+    if (!root) {
+        log_error ("Can't load asset filter from %s: %m", self->filter_file);
+        return -1;
+    }
+    asset_filter_t *filter = asset_filter_new ();
+    zconfig_t *config = zconfig_locate (root, "filter");
+    int rv = (filter && config) ? asset_filter_load (filter, config) : 0;
+    zconfig_destroy (&root);
+    if (!filter || rv != 0) {
+        log_error ("Invalid asset filter in %s, keep the previous one", self->filter_file);
+        asset_filter_destroy (&filter);
+        return -1;
+    }
+
+    zlistx_t *removed = data_set_filter (self->assets, &filter);
+    log_info ("loaded asset filter from %s, %zu assets are not monitored any more", self->filter_file, zlistx_size (removed));
+    for (const char *source = (const char *) zlistx_first (removed);
+                     source != NULL;
+                     source = (const char *) zlistx_next (removed))
+    {
+        asset_key_t key;
+        asset_key_init (&key, source);
+        s_osrv_resolve_alert (self, &key);
+    }
+    zlistx_destroy (&removed);
+    // assets were dropped by the previous filter only if some came already
+    if (self->stats.assets_received > 0)
+        s_osrv_request_republish (self);
+    return 0;
+}
+
+// handle request on MAINTENANCE mailbox and reply OK or ERROR/reason
+// ADD/scope/name/start/end - add window, times are wall time in seconds
+// CLEAR                    - remove all windows
+// RELOAD                   - reload the maintenance file
+static void
+s_osrv_maintenance_mailbox (s_osrv_t *self, mlm_client_t *client, zmsg_t *message)
+{
+    assert (self);
+    assert (client);
+    assert (message);
+
+    const char *error = NULL;
+    char *command = zmsg_popstr (message);
+    if (command && streq (command, "ADD")) {
+        char *scope = zmsg_popstr (message);
+        char *name = zmsg_popstr (message);
+        char *start = zmsg_popstr (message);
+        char *end = zmsg_popstr (message);
+        if (!scope || !name || !start || !end
+            || maintenance_add (self->maintenance, scope, name, (uint64_t) atoll (start), (uint64_t) atoll (end)) != 0)
+            error = "INVALID_WINDOW";
+        zstr_free (&scope);
+        zstr_free (&name);
+        zstr_free (&start);
+        zstr_free (&end);
+    }
+    else
+    if (command && streq (command, "CLEAR"))
+        maintenance_clear (self->maintenance);
+    else
+    if (command && streq (command, "RELOAD")) {
+        if (!self->maintenance_file || s_osrv_load_maintenance (self) != 0)
+            error = "CANNOT_LOAD";
     }
+    else
+        error = "UNKNOWN_COMMAND";
+    zstr_free (&command);
 
+    zmsg_t *reply = zmsg_new ();
+    zmsg_addstr (reply, error ? "ERROR" : "OK");
+    if (error)
+        zmsg_addstr (reply, error);
+    if (mlm_client_sendto (client, mlm_client_sender (client), "MAINTENANCE", NULL, 1000, &reply) != 0)
+        log_error ("Can't reply to %s", mlm_client_sender (client));
+}
+
+// (re)load asset tiers from the 'tiers' section of the file, missing section
+// leaves all assets in the default tier
+static int
+s_osrv_load_tiers (s_osrv_t *self)
+{
+    assert (self);
+    assert (self->tiers_file);
+
+    zconfig_t *root = zconfig_load (self->tiers_file);
+    if (!root) {
+        log_error ("Can't load asset tiers from %s: %m", self->tiers_file);
+        return -1;
+    }
+    asset_tiers_t *tiers = asset_tiers_new ();
+    zconfig_t *config = zconfig_locate (root, "tiers");
+    int rv = (tiers && config) ? asset_tiers_load (tiers, config) : 0;
     zconfig_destroy (&root);
+    if (!tiers || rv != 0) {
+        log_error ("Invalid asset tiers in %s, keep the previous ones", self->tiers_file);
+        asset_tiers_destroy (&tiers);
+        return -1;
+    }
+
+    log_info ("loaded %zu asset tiers from %s", asset_tiers_size (tiers), self->tiers_file);
+    data_set_tiers (self->assets, &tiers);
     return 0;
 }
 
+// handle request on FILTER mailbox and reply OK or ERROR/reason
+// RELOAD - reload asset filter from the configuration file
+static void
+s_osrv_filter_mailbox (s_osrv_t *self, mlm_client_t *client, zmsg_t *message)
+{
+    assert (self);
+    assert (client);
+    assert (message);
+
+    const char *error = NULL;
+    char *command = zmsg_popstr (message);
+    if (command && streq (command, "RELOAD")) {
+        if (!self->filter_file || s_osrv_load_filter (self) != 0)
+            error = "CANNOT_LOAD";
+    }
+    else
+        error = "UNKNOWN_COMMAND";
+    zstr_free (&command);
+
+    zmsg_t *reply = zmsg_new ();
+    zmsg_addstr (reply, error ? "ERROR" : "OK");
+    if (error)
+        zmsg_addstr (reply, error);
+    if (mlm_client_sendto (client, mlm_client_sender (client), "FILTER", NULL, 1000, &reply) != 0)
+        log_error ("Can't reply to %s", mlm_client_sender (client));
+}
+
+// handle request on LOCATIONS mailbox, reply OK followed by name, number
+// of monitored and of dead assets of each location, counted at any depth
+// [<location> ...] - these locations, location without monitored asset
+//                    has 0 0, all locations if none is given
+static void
+s_osrv_locations_mailbox (s_osrv_t *self, mlm_client_t *client, zmsg_t *message)
+{
+    assert (self);
+    assert (client);
+    assert (message);
+
+    outage_locations_t *locations = data_locations (self->assets);
+    zmsg_t *reply = zmsg_new ();
+    zmsg_addstr (reply, "OK");
+    if (zmsg_size (message) == 0) {
+        for (const outage_locations_stats_t *stats = outage_locations_first (locations);
+                                             stats != NULL;
+                                             stats = outage_locations_next (locations)) {
+            zmsg_addstr (reply, stats->location);
+            zmsg_addstrf (reply, "%zu", stats->monitored);
+            zmsg_addstrf (reply, "%zu", stats->dead);
+        }
+    }
+    for (char *location = zmsg_popstr (message); location; location = zmsg_popstr (message)) {
+        const outage_locations_stats_t *stats = outage_locations_lookup (locations, location);
+        zmsg_addstr (reply, location);
+        zmsg_addstrf (reply, "%zu", stats ? stats->monitored : 0);
+        zmsg_addstrf (reply, "%zu", stats ? stats->dead : 0);
+        zstr_free (&location);
+    }
+    if (mlm_client_sendto (client, mlm_client_sender (client), "LOCATIONS", NULL, 1000, &reply) != 0)
+        log_error ("Can't reply to %s", mlm_client_sender (client));
+}
+
+// alert of dead asset is not sent because of maintenance, the first time
+// and each escalation is counted and recorded, as ACTIVE alerts are
+static void
+s_osrv_suppress_alert (s_osrv_t *self, const asset_key_t *key, const char *severity)
+{
+    assert (self);
+    assert (key);
+    assert (severity);
+
+    const char *suppressed = (const char *) zhashx_lookup (self->suppressed, key);
+    if (suppressed && streq (suppressed, severity))
+        return;
+    log_debug ("\tsource=%s is in maintenance, alert suppressed", key->name);
+    self->stats.alerts_suppressed++;
+    data_log_event (self->assets, EVENT_LOG_SUPPRESSED, key);
+    zhashx_update (self->suppressed, key, (void *) severity);
+}
+
+// send or suppress alert of the dead device
+static void
+s_osrv_check_dead_device (s_osrv_t *self, const asset_key_t *key, uint64_t now_sec)
+{
+    log_debug ("\tsource=%s", key->name);
+    const char *severity = s_osrv_severity (data_asset_level (self->assets, key));
+    if (s_osrv_in_maintenance (self, key, now_sec)) {
+        // alert sent before the window started is resolved, so it is not
+        // refreshed through the window, ACTIVE is sent again after it ends
+        if (zhashx_lookup (self->active_alerts, key))
+            s_osrv_resolve_alert (self, key);
+        s_osrv_suppress_alert (self, key, severity);
+        return;
+    }
+    if (zhashx_size (self->suppressed) > 0)
+        zhashx_delete (self->suppressed, key);
+    s_osrv_activate_alert (self, key, severity);
+}
+
 static void
 s_osrv_check_dead_devices (s_osrv_t *self)
 {
     assert (self);
 
     log_debug ("time to check dead devices");
+    uint64_t now_sec = outage_clock_wall_ms (self->clock) / 1000;
+    maintenance_expire (self->maintenance, now_sec);
     zlistx_t *dead_devices = data_get_dead (self->assets);
     if ( !dead_devices ) {
         log_error ("Can't get a list of dead devices (memory error)");
@@ -229,14 +940,75 @@ s_osrv_check_dead_devices (s_osrv_t *self)
     for (void *it = zlistx_first (dead_devices);
             it != NULL;
             it = zlistx_next (dead_devices))
-    {
-        const char* source = (const char*) it;
-        log_debug ("\tsource=%s", source);
-        s_osrv_activate_alert (self, source);
-    }
+        s_osrv_check_dead_device (self, (const asset_key_t *) it, now_sec);
     zlistx_destroy (&dead_devices);
 }
 
+// wakeup for tiers with finer timer resolution: expire just their due
+// deadlines and alert devices they escalated, devices dead already and the
+// default tier are left to the periodic check
+static void
+s_osrv_check_tiers (s_osrv_t *self)
+{
+    assert (self);
+
+    uint64_t now_sec = outage_clock_wall_ms (self->clock) / 1000;
+    zlistx_t *escalated = data_expire_tiers (self->assets);
+    if ( !escalated ) {
+        log_error ("Can't get a list of escalated devices (memory error)");
+        return;
+    }
+    log_debug ("escalated.size=%zu", zlistx_size (escalated));
+    for (void *it = zlistx_first (escalated);
+            it != NULL;
+            it = zlistx_next (escalated))
+        s_osrv_check_dead_device (self, (const asset_key_t *) it, now_sec);
+    zlistx_destroy (&escalated);
+}
+
+// streams consumed by the priority client
+static bool
+s_osrv_is_priority_stream (const char *stream)
+{
+    return streq (stream, FTY_PROTO_STREAM_ASSETS)
+        || streq (stream, FTY_PROTO_STREAM_METRICS_UNAVAILABLE);
+}
+
+// parse frame as unsigned decimal number, without copying it to a string
+// return -1 if the frame is missing, empty, has other than digits or overflows
+static int
+s_frame_uint64 (zframe_t *frame, uint64_t *value_p)
+{
+    assert (value_p);
+    if (!frame || zframe_size (frame) == 0)
+        return -1;
+    const byte *data = zframe_data (frame);
+    uint64_t value = 0;
+    for (size_t i = 0; i != zframe_size (frame); i++) {
+        if (data [i] < '0' || data [i] > '9')
+            return -1;
+        uint64_t digit = (uint64_t) (data [i] - '0');
+        if (value > (UINT64_MAX - digit) / 10)
+            return -1;
+        value = value * 10 + digit;
+    }
+    *value_p = value;
+    return 0;
+}
+
+// copy frame to caller's buffer as a string
+// return NULL if the frame is missing or does not fit
+static char *
+s_frame_copy (zframe_t *frame, char *buffer, size_t size)
+{
+    assert (buffer);
+    if (!frame || zframe_size (frame) >= size)
+        return NULL;
+    memcpy (buffer, zframe_data (frame), zframe_size (frame));
+    buffer [zframe_size (frame)] = '\0';
+    return buffer;
+}
+
 /*
  * return values :
  * 1 - $TERM recieved
@@ -244,37 +1016,59 @@ s_osrv_check_dead_devices (s_osrv_t *self)
  */
 
 static int
-s_osrv_actor_commands (s_osrv_t* self, zmsg_t **message_p)
+s_osrv_actor_commands (s_osrv_t* self, zsock_t *pipe, zmsg_t **message_p)
 {
     assert (self);
     assert(message_p && *message_p);
 
     zmsg_t *message =  *message_p;
 
-    char *command = zmsg_popstr(message);
+    // command and numeric arguments are read in place, frequent control
+    // messages like TIMEOUT must not allocate
+    zframe_t *command = zmsg_pop (message);
     if (!command) {
         zmsg_destroy (message_p);
         log_warning ("Empty command.");
         return 0;
     }
-    log_debug("Command : %s",command);
-    if (streq(command, "$TERM")) {
+    log_debug ("Command : %.*s", (int) zframe_size (command), (char *) zframe_data (command));
+    if (zframe_streq (command, "$TERM")) {
         log_debug ("Got $TERM");
         zmsg_destroy (message_p);
-        zstr_free (&command);
+        zframe_destroy (&command);
         return 1;
     }
     else
-    if (streq(command, "CONNECT"))
+    if (zframe_streq (command, "CONNECT"))
     {
 	    char *endpoint = zmsg_popstr (message);
 		char *name = zmsg_popstr (message);
 
 		if (endpoint && name) {
                     log_debug ("outage_actor: CONNECT: %s/%s", endpoint, name);
-		    int rv = mlm_client_connect (self->client, endpoint, 1000, name);
+            zstr_free (&self->endpoint);
+            zstr_free (&self->name);
+            self->endpoint = strdup (endpoint);
+            self->name = strdup (name);
+            // control mail is addressed to the actor name, streams are
+            // consumed by clients of their own
+		    int rv = mlm_client_connect (self->mailbox_client, endpoint, 1000, name);
             if (rv == -1)
 			    log_error("mlm_client_connect failed\n");
+            char *metrics_name = zsys_sprintf ("%s-metrics", name);
+            rv = mlm_client_connect (self->client, endpoint, 1000, metrics_name);
+            if (rv == -1)
+                log_error("mlm_client_connect failed for %s", metrics_name);
+            zstr_free (&metrics_name);
+            char *priority_name = zsys_sprintf ("%s-priority", name);
+            rv = mlm_client_connect (self->priority_client, endpoint, 1000, priority_name);
+            if (rv == -1)
+                log_error("mlm_client_connect failed for %s", priority_name);
+            zstr_free (&priority_name);
+            // alerts are published by a dedicated client
+            char *publisher_name = zsys_sprintf ("%s-publisher", name);
+            zstr_sendx (self->publisher, "CONNECT", endpoint, publisher_name, NULL);
+            zstr_free (&publisher_name);
 	    }
 
 		zstr_free (&endpoint);
@@ -282,14 +1076,16 @@ s_osrv_actor_commands (s_osrv_t* self, zmsg_t **message_p)
 
     }
     else
-    if (streq (command, "CONSUMER"))
+    if (zframe_streq (command, "CONSUMER"))
     {
         char *stream = zmsg_popstr(message);
         char *regex = zmsg_popstr(message);
 
         if (stream && regex) {
             log_debug ("CONSUMER: %s/%s", stream, regex);
-            int rv = mlm_client_set_consumer (self->client, stream, regex);
+            // asset lifecycle must not wait behind a flood of metrics
+            mlm_client_t *client = s_osrv_is_priority_stream (stream) ? self->priority_client : self->client;
+            int rv = mlm_client_set_consumer (client, stream, regex);
             if (rv == -1 )
                 log_error("mlm_set_consumer failed");
         }
@@ -298,42 +1094,197 @@ s_osrv_actor_commands (s_osrv_t* self, zmsg_t **message_p)
         zstr_free (&regex);
     }
     else
-    if (streq (command, "PRODUCER"))
+    if (zframe_streq (command, "PRODUCER"))
     {
         char *stream = zmsg_popstr(message);
 
         if (stream){
             log_debug ("PRODUCER: %s", stream);
-            int rv = mlm_client_set_producer (self->client, stream);
-            if (rv == -1 )
-                log_error ("mlm_client_set_producer");
+            zstr_sendx (self->publisher, "PRODUCER", stream, NULL);
         }
         zstr_free(&stream);
     }
     else
-    if (streq (command, "TIMEOUT"))
+    if (zframe_streq (command, "ALERT-QUEUE"))
     {
-        char *timeout = zmsg_popstr(message);
+        char *size = zmsg_popstr(message);
+        char *policy = zmsg_popstr(message);
 
-        if (timeout) {
-            self->timeout_ms = (uint64_t) atoll (timeout);
-            log_debug ("TIMEOUT: \"%s\"/%"PRIu64, timeout, self->timeout_ms);
+        if (size && policy) {
+            log_debug ("ALERT-QUEUE: %s/%s", size, policy);
+            zstr_sendx (self->publisher, "QUEUE", size, policy, NULL);
         }
-        zstr_free(&timeout);
+        zstr_free(&size);
+        zstr_free(&policy);
     }
     else
-    if (streq (command, "ASSET-EXPIRY-SEC"))
+    if (zframe_streq (command, "TIMEOUT"))
     {
-        char *timeout = zmsg_popstr(message);
-
-        if (timeout){
-            data_set_default_expiry (self->assets, atol (timeout));
-            log_debug ("ASSET-EXPIRY-SEC: \"%s\"/%"PRIu64, timeout, atol (timeout));
+        uint64_t timeout;
+        if (s_frame_uint64 (zmsg_first (message), &timeout) == 0) {
+            self->timeout_ms = timeout;
+            alert_refresh_set_period (self->refresh, s_osrv_refresh_period_ms (self));
+            // refreshes announce the new ttl
+            for (fty_proto_t *alert = (fty_proto_t *) zhashx_first (self->alert_cache);
+                              alert != NULL;
+                              alert = (fty_proto_t *) zhashx_next (self->alert_cache))
+                fty_proto_set_ttl (alert, (uint32_t) s_osrv_alert_ttl (self));
+            log_debug ("TIMEOUT: %"PRIu64, self->timeout_ms);
+        }
+        else
+            log_error ("TIMEOUT: invalid value");
+    }
+    else
+    if (zframe_streq (command, "ASSET-EXPIRY-SEC"))
+    {
+        uint64_t timeout;
+        if (s_frame_uint64 (zmsg_first (message), &timeout) == 0) {
+            data_set_default_expiry (self->assets, timeout);
+            log_debug ("ASSET-EXPIRY-SEC: %"PRIu64, timeout);
+        }
+        else
+            log_error ("ASSET-EXPIRY-SEC: invalid value");
+    }
+    else
+    if (zframe_streq (command, "SKEW-TOLERANCE-SEC"))
+    {
+        uint64_t tolerance;
+        if (s_frame_uint64 (zmsg_first (message), &tolerance) == 0) {
+            clock_skew_set_tolerance (data_skew (self->assets), (int64_t) tolerance);
+            log_debug ("SKEW-TOLERANCE-SEC: %"PRIu64, tolerance);
+        }
+        else
+            log_error ("SKEW-TOLERANCE-SEC: invalid value");
+    }
+    else
+    if (zframe_streq (command, "ESCALATION"))
+    {
+        char warning [32];
+        char critical [32];
+        if (s_frame_copy (zmsg_first (message), warning, sizeof (warning))
+        &&  s_frame_copy (zmsg_next (message), critical, sizeof (critical))) {
+            log_debug ("ESCALATION: %s/%s", warning, critical);
+            data_set_escalation (self->assets, atof (warning), atof (critical));
+        }
+        else
+            log_error ("ESCALATION: invalid values");
+    }
+    else
+    if (zframe_streq (command, "MAINTENANCE-FILE"))
+    {
+        char *maintenance_file = zmsg_popstr(message);
+        if (maintenance_file) {
+            zstr_free (&self->maintenance_file);
+            self->maintenance_file = strdup (maintenance_file);
+            log_debug ("MAINTENANCE-FILE: %s", maintenance_file);
+            s_osrv_load_maintenance (self);
+        }
+        zstr_free(&maintenance_file);
+    }
+    else
+    if (zframe_streq (command, "FILTER-FILE"))
+    {
+        char *filter_file = zmsg_popstr(message);
+        if (filter_file) {
+            zstr_free (&self->filter_file);
+            self->filter_file = strdup (filter_file);
+            log_debug ("FILTER-FILE: %s", filter_file);
+            s_osrv_load_filter (self);
         }
-        zstr_free(&timeout);
+        zstr_free(&filter_file);
     }
     else
-    if (streq (command, "STATE-FILE"))
+    if (zframe_streq (command, "TIERS-FILE"))
+    {
+        char *tiers_file = zmsg_popstr(message);
+        if (tiers_file) {
+            zstr_free (&self->tiers_file);
+            self->tiers_file = strdup (tiers_file);
+            log_debug ("TIERS-FILE: %s", tiers_file);
+            s_osrv_load_tiers (self);
+        }
+        zstr_free(&tiers_file);
+    }
+    else
+    if (zframe_streq (command, "EVENT-LOG"))
+    {
+        char *path = zmsg_popstr(message);
+        char *records = zmsg_popstr(message);
+        if (path && records) {
+            log_debug ("EVENT-LOG: %s/%s", path, records);
+            data_set_event_log (self->assets, NULL);
+            event_log_destroy (&self->event_log);
+            if (!streq (path, "") && atol (records) > 0)
+                self->event_log = event_log_new (path, (size_t) atol (records), self->clock);
+            data_set_event_log (self->assets, self->event_log);
+        }
+        zstr_free(&path);
+        zstr_free(&records);
+    }
+    else
+    if (zframe_streq (command, "HISTORY"))
+    {
+        char *path = zmsg_popstr(message);
+        char *records = zmsg_popstr(message);
+        if (path && records) {
+            log_debug ("HISTORY: %s/%s", path, records);
+            outage_history_destroy (&self->history);
+            if (!streq (path, "") && atol (records) > 1)
+                self->history = outage_history_new (path, (size_t) atol (records), self->clock);
+        }
+        zstr_free(&path);
+        zstr_free(&records);
+    }
+    else
+    if (zframe_streq (command, "TOUCH-ELISION"))
+    {
+        uint64_t divisor;
+        if (s_frame_uint64 (zmsg_first (message), &divisor) == 0 && divisor <= 1000) {
+            log_debug ("TOUCH-ELISION: %" PRIu64, divisor);
+            touch_elision_destroy (&self->elision);
+            if (divisor > 0)
+                self->elision = touch_elision_new ((unsigned) divisor, TOUCH_ELISION_SUBJECTS);
+        }
+        else
+            log_error ("TOUCH-ELISION: invalid value");
+    }
+    else
+    if (zframe_streq (command, "EXPORTER"))
+    {
+        char *socket_path = zmsg_popstr(message);
+        char *file_path = zmsg_popstr(message);
+        char *interval = zmsg_popstr(message);
+        if (socket_path && file_path && interval) {
+            log_debug ("EXPORTER: %s/%s/%s", socket_path, file_path, interval);
+            zactor_destroy (&self->exporter);
+            if (!streq (socket_path, "") || !streq (file_path, "")) {
+                s_osrv_metrics_update (self);
+                self->exporter = zactor_new (outage_metrics_exporter, self->metrics);
+            }
+            if (self->exporter && !streq (socket_path, ""))
+                zstr_sendx (self->exporter, "SOCKET", socket_path, NULL);
+            if (self->exporter && !streq (file_path, ""))
+                zstr_sendx (self->exporter, "FILE", file_path, interval, NULL);
+        }
+        zstr_free(&socket_path);
+        zstr_free(&file_path);
+        zstr_free(&interval);
+    }
+    else
+    if (zframe_streq (command, "HISTORY-TOP"))
+    {
+        char count [32];
+        char by [32] = "count";
+        if (s_frame_copy (zmsg_first (message), count, sizeof (count))) {
+            s_frame_copy (zmsg_next (message), by, sizeof (by));
+            s_osrv_history_send (self, pipe, (size_t) atol (count),
+                streq (by, "downtime") ? OUTAGE_HISTORY_BY_DOWNTIME : OUTAGE_HISTORY_BY_COUNT);
+        }
+        else
+            log_error ("HISTORY-TOP: invalid values");
+    }
+    else
+    if (zframe_streq (command, "STATE-FILE"))
     {
         char *state_file = zmsg_popstr(message);
         if (state_file) {
@@ -345,15 +1296,280 @@ s_osrv_actor_commands (s_osrv_t* self, zmsg_t **message_p)
         }
         zstr_free(&state_file);
     }
+    else
+    if (zframe_streq (command, "SUMMARY"))
+    {
+        char *stream = zmsg_popstr(message);
+        char *interval = zmsg_popstr(message);
+        char *full_every = zmsg_popstr(message);
+        char *site = zmsg_popstr(message);  // optional
+
+        if (stream && interval && full_every) {
+            log_debug ("SUMMARY: %s/%s/%s/%s", stream, interval, full_every, site ? site : "");
+            if (!self->endpoint)
+                log_error ("SUMMARY requires CONNECT first");
+            else {
+                zactor_destroy (&self->summary_publisher);
+                outage_summary_destroy (&self->summary);
+                self->summary_publisher = alert_publisher_new (NULL);
+                char *summary_name = zsys_sprintf ("%s-summary", self->name);
+                zstr_sendx (self->summary_publisher, "CONNECT", self->endpoint, summary_name, NULL);
+                zstr_sendx (self->summary_publisher, "PRODUCER", stream, NULL);
+                zstr_free (&summary_name);
+                self->summary = outage_summary_new ((size_t) atol (full_every));
+                self->summary_interval_ms = (uint64_t) atoll (interval);
+                zstr_free (&self->summary_subject);
+                if (site && !streq (site, ""))
+                    self->summary_subject = zsys_sprintf ("%s@%s", OUTAGE_SUMMARY_SUBJECT, site);
+                else
+                    self->summary_subject = strdup (OUTAGE_SUMMARY_SUBJECT);
+            }
+        }
+        zstr_free(&stream);
+        zstr_free(&interval);
+        zstr_free(&full_every);
+        zstr_free(&site);
+    }
+    else
+    if (zframe_streq (command, "STATS"))
+    {
+        s_osrv_stats_send (self, pipe);
+    }
+    else
+    if (zframe_streq (command, "COMPACT"))
+    {
+        s_osrv_compact (self);
+    }
+    else
+    if (zframe_streq (command, "SKEW"))
+    {
+        s_osrv_skew_send (self, pipe);
+    }
     else {
-        log_error ("Unknown actor command: %s.\n", command);
+        log_error ("Unknown actor command: %.*s.", (int) zframe_size (command), (char *) zframe_data (command));
     }
 
-    zstr_free (&command);
+    zframe_destroy (&command);
     zmsg_destroy (message_p);
     return 0;
 }
 
+// count metric from future by verdict of data_touch_asset
+static void
+s_osrv_count_future (s_osrv_t *self, int verdict)
+{
+    if (verdict == CLOCK_SKEW_TOLERATED)
+        outage_metrics_add (self->metrics, OUTAGE_METRICS_FUTURE_TOLERATED, 1);
+    else
+    if (verdict == CLOCK_SKEW_CLAMPED)
+        outage_metrics_add (self->metrics, OUTAGE_METRICS_FUTURE_CLAMPED, 1);
+}
+
+// process decoded metric or asset received on 'stream', takes ownership of it
+static void
+s_osrv_handle_proto (s_osrv_t *self, const char *stream, const char *subject, fty_proto_t **bmsg_p)
+{
+    assert (self);
+    assert (bmsg_p);
+
+    fty_proto_t *bmsg = *bmsg_p;
+    // resolve sent alert
+    if (fty_proto_id (bmsg) == FTY_PROTO_METRIC || streq (stream, FTY_PROTO_STREAM_METRICS_SENSOR)) {
+        self->stats.metrics_received++;
+        const char *is_computed = fty_proto_aux_string (bmsg, "x-cm-count", NULL);
+        if ( !is_computed ) {
+            uint64_t now_sec = outage_clock_wall_ms (self->clock) / 1000;
+            uint64_t timestamp = fty_proto_time (bmsg);
+            const char* port = fty_proto_aux_string (bmsg, FTY_PROTO_METRICS_SENSOR_AUX_PORT, NULL);
+
+            if (port != NULL ) {
+                // is it from sensor? yes
+                // get sensors attached to the 'asset' on the 'port'! we can have more then 1!
+                const char *source = fty_proto_aux_string (bmsg, FTY_PROTO_METRICS_SENSOR_AUX_SNAME, NULL);
+                if (NULL == source) {
+                    log_error("Sensor message malformed: found %s='%s' but %s is missing", FTY_PROTO_METRICS_SENSOR_AUX_PORT,
+                            port, FTY_PROTO_METRICS_SENSOR_AUX_SNAME);
+                    outage_metrics_add (self->metrics, OUTAGE_METRICS_DECODE_ERRORS, 1);
+                    fty_proto_destroy (bmsg_p);
+                    return;
+                }
+                log_debug ("Sensor '%s' on '%s'/'%s' is still alive", source,  fty_proto_name (bmsg), port);
+                asset_key_t key;
+                asset_key_init (&key, source);
+                s_osrv_resolve_alert (self, &key);
+                // metric from future is taken as seen now, skew is reported by data
+                s_osrv_count_future (self, data_touch_asset (self->assets, &key, timestamp, fty_proto_ttl (bmsg), now_sec));
+            }
+            else {
+                // is it from sensor? no
+                const char *source = fty_proto_name (bmsg);
+                // the only time the name of this message is hashed
+                asset_key_t key;
+                asset_key_init (&key, source);
+                s_osrv_resolve_alert (self, &key);
+                // metric from future is taken as seen now, skew is reported by data
+                int verdict = data_touch_asset (self->assets, &key, timestamp, fty_proto_ttl (bmsg), now_sec);
+                s_osrv_count_future (self, verdict);
+                // next metrics of the subject need not be decoded for a while
+                if (self->elision && verdict == CLOCK_SKEW_NONE && subject)
+                    touch_elision_update (self->elision, subject, &key, (int64_t) fty_proto_ttl (bmsg) * 1000,
+                        outage_clock_wall_ms (self->clock) - (int64_t) timestamp * 1000, outage_clock_mono_ms (self->clock));
+            }
+        }
+        else {
+            // intentionally left empty
+            // so it is metric from agent-cm -> it is not comming from the device itself ->ignore it
+        }
+    }
+    else
+    if (fty_proto_id (bmsg) == FTY_PROTO_ASSET) {
+        self->stats.assets_received++;
+        // asset updated out of the filter is dropped by data as well
+        if (streq (fty_proto_operation (bmsg), FTY_PROTO_ASSET_OP_DELETE)
+             || !streq (fty_proto_aux_string (bmsg, FTY_PROTO_ASSET_STATUS, "active"), "active")
+             || !data_selects (self->assets, bmsg) )
+        {
+            asset_key_t key;
+            asset_key_init (&key, fty_proto_name (bmsg));
+            s_osrv_resolve_alert (self, &key);
+        }
+        data_put (self->assets, bmsg_p);
+    }
+    fty_proto_destroy (bmsg_p);
+}
+
+// process METRICUNAVAILABLE message, topic in form aaaa@bbb where bbb is the
+// asset, frames are read in place
+static void
+s_osrv_handle_unavailable (s_osrv_t *self, zmsg_t *message)
+{
+    assert (self);
+    assert (message);
+
+    if (!zframe_streq (zmsg_first (message), "METRICUNAVAILABLE"))
+        return;
+    zframe_t *topic = zmsg_next (message);
+    const char *at = topic ? (const char *) memchr (zframe_data (topic), '@', zframe_size (topic)) : NULL;
+    if (!at) {
+        log_warning ("METRICUNAVAILABLE: malformed topic, ignored");
+        outage_metrics_add (self->metrics, OUTAGE_METRICS_DECODE_ERRORS, 1);
+        return;
+    }
+    char source [256];
+    size_t length = zframe_size (topic) - (size_t) (at + 1 - (const char *) zframe_data (topic));
+    if (length == 0 || length >= sizeof (source)) {
+        log_warning ("METRICUNAVAILABLE: invalid asset name in topic, ignored");
+        outage_metrics_add (self->metrics, OUTAGE_METRICS_DECODE_ERRORS, 1);
+        return;
+    }
+    memcpy (source, at + 1, length);
+    source [length] = '\0';
+    asset_key_t key;
+    asset_key_init (&key, source);
+    s_osrv_resolve_alert (self, &key);
+    data_delete (self->assets, &key);
+}
+
+// metric of a subject which touched alive asset a moment ago would not move
+// its deadline meaningfully, it is taken as seen now after a look at its
+// subject, without decode, resolve lookup or logging
+// return true if the metric was elided
+static bool
+s_osrv_elide (s_osrv_t *self, mlm_client_t *client)
+{
+    if (!self->elision || !streq (mlm_client_address (client), FTY_PROTO_STREAM_METRICS))
+        return false;
+    const asset_key_t *key = touch_elision_check (self->elision, mlm_client_subject (client), outage_clock_mono_ms (self->clock));
+    if (!key || data_elide_touch (self->assets, key) != 0)
+        return false;
+    self->stats.metrics_received++;
+    self->stats.metrics_elided++;
+    return true;
+}
+
+// receive and process one message from malamute stream consumed by 'client'
+// return -1 if the client was interrupted, 0 otherwise
+static int
+s_osrv_handle_stream (s_osrv_t *self, mlm_client_t *client)
+{
+    assert (self);
+    assert (client);
+
+    zmsg_t *message = mlm_client_recv (client);
+    if (!message)
+        return -1;
+
+    // control mail is served by the mailbox client only
+    if (!streq (mlm_client_command (client), "STREAM DELIVER")) {
+        log_warning ("Mail %s from %s to %s ignored, requests go to %s",
+            mlm_client_subject (client), mlm_client_sender (client),
+            mlm_client_address (client), self->name ? self->name : "the actor name");
+        zmsg_destroy (&message);
+        return 0;
+    }
+
+    outage_metrics_message (self->metrics, outage_metrics_stream (mlm_client_address (client)));
+    if (s_osrv_elide (self, client)) {
+        zmsg_destroy (&message);
+        return 0;
+    }
+    if (!is_fty_proto(message)) {
+        if (streq (mlm_client_address (client), FTY_PROTO_STREAM_METRICS_UNAVAILABLE))
+            s_osrv_handle_unavailable (self, message);
+        zmsg_destroy(&message);
+        return 0;
+    }
+
+    fty_proto_t *bmsg = fty_proto_decode (&message);
+    if (!bmsg) {
+        outage_metrics_add (self->metrics, OUTAGE_METRICS_DECODE_ERRORS, 1);
+        return 0;
+    }
+    s_osrv_handle_proto (self, mlm_client_address (client), mlm_client_subject (client), &bmsg);
+    return 0;
+}
+
+// receive and process one request from the mailbox of the actor
+// return -1 if the client was interrupted, 0 otherwise
+static int
+s_osrv_handle_mailbox (s_osrv_t *self)
+{
+    assert (self);
+
+    mlm_client_t *client = self->mailbox_client;
+    zmsg_t *message = mlm_client_recv (client);
+    if (!message)
+        return -1;
+
+    if (!streq (mlm_client_command (client), "MAILBOX DELIVER"))
+        log_warning ("Unexpected %s on mailbox from %s", mlm_client_command (client), mlm_client_sender (client));
+    else
+    if (streq (mlm_client_subject (client), "MAINTENANCE"))
+        s_osrv_maintenance_mailbox (self, client, message);
+    else
+    if (streq (mlm_client_subject (client), "FILTER"))
+        s_osrv_filter_mailbox (self, client, message);
+    else
+    if (streq (mlm_client_subject (client), "LOCATIONS"))
+        s_osrv_locations_mailbox (self, client, message);
+    else
+        log_warning ("Unknown mailbox subject %s from %s", mlm_client_subject (client), mlm_client_sender (client));
+    zmsg_destroy (&message);
+    return 0;
+}
+
+// poller over actor pipe (if any), mailbox and consumer clients, in order of priority
+static zpoller_t *
+s_osrv_poller_new (s_osrv_t *self, zsock_t *pipe)
+{
+    assert (self);
+    if (pipe)
+        return zpoller_new (pipe, mlm_client_msgpipe (self->mailbox_client),
+            mlm_client_msgpipe (self->priority_client), mlm_client_msgpipe (self->client), NULL);
+    return zpoller_new (mlm_client_msgpipe (self->mailbox_client),
+        mlm_client_msgpipe (self->priority_client), mlm_client_msgpipe (self->client), NULL);
+}
+
 // --------------------------------------------------------------------------
 // Create a new fty_outage_server
 void
@@ -362,19 +1578,27 @@ fty_outage_server (zsock_t *pipe, void *args)
     s_osrv_t *self = s_osrv_new ();
     assert (self);
 
-    zpoller_t *poller = zpoller_new (pipe, mlm_client_msgpipe (self->client), NULL);
+    zpoller_t *poller = s_osrv_poller_new (self, pipe);
     assert (poller);
 
     zsock_signal (pipe, 0);
     log_info ("outage_actor: Started");
     //    poller timeout
-    uint64_t now_ms = zclock_mono ();
+    uint64_t now_ms = outage_clock_mono_ms (self->clock);
     uint64_t last_dead_check_ms = now_ms;
     uint64_t last_save_ms = now_ms;
+    uint64_t last_stats_ms = now_ms;
+    uint64_t last_summary_ms = now_ms;
+    uint64_t last_compact_ms = now_ms;
+    uint64_t last_metrics_ms = now_ms;
 
     while (!zsys_interrupted)
     {
-        void *which = zpoller_wait (poller, self->timeout_ms);
+        // wake up earlier for the first deadline of tiers with finer timer
+        // resolution, the rest is checked each timeout
+        int64_t tiers_wait_ms = data_tiers_wait_ms (self->assets);
+        bool tiers_wake = tiers_wait_ms >= 0 && (uint64_t) tiers_wait_ms < self->timeout_ms;
+        void *which = zpoller_wait (poller, tiers_wake ? (int) tiers_wait_ms : (int) self->timeout_ms);
 
         if (which == NULL) {
             if (zpoller_terminated(poller) || zsys_interrupted) {
@@ -383,110 +1607,91 @@ fty_outage_server (zsock_t *pipe, void *args)
             }
         }
 
-        now_ms = zclock_mono ();
+        now_ms = outage_clock_mono_ms (self->clock);
 
         // save the state
         if ((now_ms - last_save_ms) > SAVE_INTERVAL_MS) {
+            int64_t save_start_usec = zclock_usecs ();
             int r = s_osrv_save (self);
+            outage_metrics_observe (self->metrics, OUTAGE_METRICS_SAVE, zclock_usecs () - save_start_usec);
             if (r != 0)
                 log_error ("failed to save state file %s", self->state_file);
             last_save_ms = now_ms;
         }
 
-        // send alerts
-        if (zpoller_expired (poller) || (now_ms - last_dead_check_ms) > self->timeout_ms) {
+        // send alerts, also once all windows ending now are over, so alerts
+        // suppressed by them are sent in one batch
+        bool idle = zpoller_expired (poller) && !tiers_wake;
+        if (idle || (now_ms - last_dead_check_ms) > self->timeout_ms
+            || (uint64_t) outage_clock_wall_ms (self->clock) / 1000 >= maintenance_next_end (self->maintenance)) {
             s_osrv_check_dead_devices (self);
-            last_dead_check_ms = zclock_mono ();
+            last_dead_check_ms = outage_clock_mono_ms (self->clock);
+        }
+        else
+        if (tiers_wake && data_tiers_wait_ms (self->assets) == 0) {
+            s_osrv_check_tiers (self);
+            self->stats.tier_wakeups++;
+        }
+
+        // refresh active alerts before they expire
+        if (now_ms >= alert_refresh_next_ms (self->refresh))
+            s_osrv_refresh_alerts (self, now_ms);
+
+        // publish summary of dead assets
+        if (self->summary && (now_ms - last_summary_ms) >= self->summary_interval_ms) {
+            s_osrv_publish_summary (self);
+            last_summary_ms = now_ms;
         }
 
+        // nothing came for the whole timeout, good time to give memory back
+        if (idle && (now_ms - last_compact_ms) > COMPACT_INTERVAL_MS) {
+            s_osrv_compact (self);
+            last_compact_ms = now_ms;
+        }
+
+        // report statistics
+        if ((now_ms - last_stats_ms) > STATS_INTERVAL_MS) {
+            s_osrv_stats_update (self, now_ms);
+            log_info ("outage_actor: active alerts=%zu, alerts sent=%" PRIu64 ", refresh sent=%" PRIu64 " (%.3f/s)",
+                zhashx_size (self->active_alerts), self->stats.alerts_sent, self->stats.refresh_sent, self->stats.refresh_per_sec);
+            last_stats_ms = now_ms;
+        }
+
+        // gauges of exported metrics
+        if (self->exporter && (now_ms - last_metrics_ms) > METRICS_INTERVAL_MS) {
+            s_osrv_metrics_update (self);
+            last_metrics_ms = now_ms;
+        }
+
+        int64_t loop_start_usec = zclock_usecs ();
         if (which == pipe) {
             log_trace ("which == pipe");
             zmsg_t *msg = zmsg_recv(pipe);
             if (!msg)
                 break;
 
-            int rv = s_osrv_actor_commands (self, &msg);
+            int rv = s_osrv_actor_commands (self, pipe, &msg);
             if (rv == 1)
                 break;
-            continue;
         }
-        // react on incoming messages
+        // react on incoming messages, requests and asset updates first
+        else
+        if (which == mlm_client_msgpipe (self->mailbox_client)) {
+            if (s_osrv_handle_mailbox (self) == -1)
+                break;
+        }
+        else
+        if (which == mlm_client_msgpipe (self->priority_client)) {
+            if (s_osrv_handle_stream (self, self->priority_client) == -1)
+                break;
+        }
         else
         if (which == mlm_client_msgpipe (self->client)) {
-
-            zmsg_t *message = mlm_client_recv (self->client);
-            if (!message)
+            if (s_osrv_handle_stream (self, self->client) == -1)
                 break;
-
-            if (!is_fty_proto(message)) {
-                if (streq (mlm_client_address (self->client), FTY_PROTO_STREAM_METRICS_UNAVAILABLE)) {
-                    char *foo = zmsg_popstr (message);
-                    if ( foo && streq (foo, "METRICUNAVAILABLE")) {
-                        zstr_free (&foo);
-                        foo = zmsg_popstr (message); // topic in form aaaa@bbb
-                        const char* source = strstr (foo, "@") + 1;
-                        s_osrv_resolve_alert (self, source);
-                        data_delete (self->assets, source);
-                    }
-                    zstr_free (&foo);
-                }
-                zmsg_destroy(&message);
-                continue;
-            }
-
-            fty_proto_t *bmsg = fty_proto_decode (&message);
-            if (!bmsg)
-                continue;
-
-            // resolve sent alert
-            if (fty_proto_id (bmsg) == FTY_PROTO_METRIC || streq (mlm_client_address (self->client), FTY_PROTO_STREAM_METRICS_SENSOR)) {
-                const char *is_computed = fty_proto_aux_string (bmsg, "x-cm-count", NULL);
-                if ( !is_computed ) {
-                    uint64_t now_sec = zclock_time() / 1000;
-                    uint64_t timestamp = fty_proto_time (bmsg);
-                    const char* port = fty_proto_aux_string (bmsg, FTY_PROTO_METRICS_SENSOR_AUX_PORT, NULL);
-
-                    if (port != NULL ) {
-                        // is it from sensor? yes
-                        // get sensors attached to the 'asset' on the 'port'! we can have more then 1!
-                        const char *source = fty_proto_aux_string (bmsg, FTY_PROTO_METRICS_SENSOR_AUX_SNAME, NULL);
-                        if (NULL == source) {
-                            log_error("Sensor message malformed: found %s='%s' but %s is missing", FTY_PROTO_METRICS_SENSOR_AUX_PORT,
-                                    port, FTY_PROTO_METRICS_SENSOR_AUX_SNAME);
-                            continue;
-                        }
-                        log_debug ("Sensor '%s' on '%s'/'%s' is still alive", source,  fty_proto_name (bmsg), port);
-                        s_osrv_resolve_alert (self, source);
-                        int rv = data_touch_asset (self->assets, source, timestamp, fty_proto_ttl (bmsg), now_sec);
-                        if ( rv == -1 )
-                            log_error ("asset: name = %s, topic=%s metric is from future! ignore it", source, mlm_client_subject (self->client));
-                    }
-                    else {
-                        // is it from sensor? no
-                        const char *source = fty_proto_name (bmsg);
-                        s_osrv_resolve_alert (self, source);
-                        int rv = data_touch_asset (self->assets, source, timestamp, fty_proto_ttl (bmsg), now_sec);
-                        if ( rv == -1 )
-                            log_error ("asset: name = %s, topic=%s metric is from future! ignore it", source, mlm_client_subject (self->client));
-                    }
-                }
-                else {
-                    // intentionally left empty
-                    // so it is metric from agent-cm -> it is not comming from the device itself ->ignore it
-                }
-            }
-            else
-            if (fty_proto_id (bmsg) == FTY_PROTO_ASSET) {
-                if (streq (fty_proto_operation (bmsg), FTY_PROTO_ASSET_OP_DELETE)
-                     || !streq (fty_proto_aux_string (bmsg, FTY_PROTO_ASSET_STATUS, "active"), "active") )
-                {
-                    const char* source = fty_proto_name (bmsg);
-                    s_osrv_resolve_alert (self, source);
-                }
-                data_put (self->assets, &bmsg);
-            }
-            fty_proto_destroy (&bmsg);
         }
+        if (which)
+            outage_metrics_observe (self->metrics, OUTAGE_METRICS_LOOP, zclock_usecs () - loop_start_usec);
     }
     zpoller_destroy (&poller);
     int r = s_osrv_save (self);
@@ -543,6 +1748,8 @@ fty_outage_server_test (bool verbose)
     zstr_sendx (self, "PRODUCER", "_ALERTS_SYS", NULL);
     zstr_sendx (self, "TIMEOUT", "1000", NULL);
     zstr_sendx (self, "ASSET-EXPIRY-SEC", "3", NULL);
+    unlink ("src/selftest-rw/outage_history.dat");
+    zstr_sendx (self, "HISTORY", "src/selftest-rw/outage_history.dat", "64", NULL);
 
     //to give a time for all the clients and actors to initialize
     zclock_sleep (1000);
@@ -664,20 +1871,289 @@ fty_outage_server_test (bool verbose)
     assert (streq (fty_proto_state (bmsg), "RESOLVED"));
     fty_proto_destroy (&bmsg);
 
+    // test case 05: statistics are reported on request
+    zstr_sendx (self, "STATS", NULL);
+    msg = zmsg_recv (self);
+    assert (msg);
+    char *stats = zmsg_popstr (msg);
+    assert (stats && streq (stats, "STATS"));
+    zstr_free (&stats);
+    bool has_refresh = false;
+    bool has_queue = false;
+    bool has_memory = false;
+    bool has_skew = false;
+    bool has_elision = false;
+    for (char *name = zmsg_popstr (msg); name; name = zmsg_popstr (msg)) {
+        char *value = zmsg_popstr (msg);
+        assert (value);
+        if (streq (name, "alerts-sent"))
+            assert (atoll (value) >= 4);
+        if (streq (name, "refresh-per-sec"))
+            has_refresh = true;
+        if (streq (name, "publish-queue-depth"))
+            has_queue = true;
+        if (streq (name, "memory-assets")) {
+            assert (atoll (value) > 0);
+            has_memory = true;
+        }
+        if (streq (name, "skew-ahead"))
+            has_skew = true;
+        if (streq (name, "elision-ratio"))
+            has_elision = true;
+        zstr_free (&name);
+        zstr_free (&value);
+    }
+    assert (has_refresh);
+    assert (has_queue);
+    assert (has_memory);
+    assert (has_skew);
+    assert (has_elision);
+    zmsg_destroy (&msg);
+
+    // skew per source, name and "ahead clamped max-sec last-sec" pairs
+    zstr_sendx (self, "SKEW", NULL);
+    msg = zmsg_recv (self);
+    assert (msg);
+    assert (zmsg_size (msg) % 2 == 1);
+    char *skew = zmsg_popstr (msg);
+    assert (skew && streq (skew, "SKEW"));
+    zstr_free (&skew);
+    zmsg_destroy (&msg);
+
+    // exported metrics count the alerts sent so far
+    unlink ("src/selftest-rw/outage_metrics.prom");
+    zstr_sendx (self, "EXPORTER", "", "src/selftest-rw/outage_metrics.prom", "100", NULL);
+    zclock_sleep (500);
+    FILE *metrics_file = fopen ("src/selftest-rw/outage_metrics.prom", "r");
+    assert (metrics_file);
+    char metrics_line [256];
+    bool has_alerts_sent = false;
+    while (fgets (metrics_line, sizeof (metrics_line), metrics_file))
+        if (strncmp (metrics_line, "fty_outage_alerts_sent_total ", 29) == 0) {
+            assert (atoll (metrics_line + 29) >= 4);
+            has_alerts_sent = true;
+        }
+    fclose (metrics_file);
+    assert (has_alerts_sent);
+    zstr_sendx (self, "EXPORTER", "", "", "0", NULL);
+    unlink ("src/selftest-rw/outage_metrics.prom");
+
+    // ended outage of UPS42 is in the history
+    zstr_sendx (self, "HISTORY-TOP", "10", "downtime", NULL);
+    msg = zmsg_recv (self);
+    assert (msg);
+    char *history = zmsg_popstr (msg);
+    assert (history && streq (history, "HISTORY-TOP"));
+    zstr_free (&history);
+    bool has_ups42 = false;
+    for (char *name = zmsg_popstr (msg); name; name = zmsg_popstr (msg)) {
+        char *value = zmsg_popstr (msg);
+        assert (value);
+        if (streq (name, "UPS42")) {
+            assert (atoi (value) == 1);
+            has_ups42 = true;
+        }
+        zstr_free (&name);
+        zstr_free (&value);
+    }
+    assert (has_ups42);
+    zmsg_destroy (&msg);
+
+    // test case 05b: asset of a tier with fine timer resolution is alerted
+    // once it is dead, not at the next periodic check
+    FILE *tiers_file = fopen ("src/selftest-rw/tiers.cfg", "w");
+    assert (tiers_file);
+    fprintf (tiers_file, "tiers\n    critical\n        tick = 100\n        priority = 1\n");
+    fclose (tiers_file);
+    zstr_sendx (self, "TIERS-FILE", "src/selftest-rw/tiers.cfg", NULL);
+    zstr_sendx (self, "TIMEOUT", "30000", NULL);
+    aux = zhash_new ();
+    zhash_insert (aux, FTY_PROTO_ASSET_TYPE, "device");
+    zhash_insert (aux, FTY_PROTO_ASSET_SUBTYPE, "ups");
+    zhash_insert (aux, FTY_PROTO_ASSET_STATUS, "active");
+    zhash_insert (aux, FTY_PROTO_ASSET_PRIORITY, "1");
+    sendmsg = fty_proto_encode_asset (aux, "UPS77", FTY_PROTO_ASSET_OP_CREATE, NULL);
+    zhash_destroy (&aux);
+    rv = mlm_client_send (m_sender, "UPS77",  &sendmsg);
+    assert (rv >= 0);
+    sendmsg = fty_proto_encode_metric (NULL, time (NULL), 1, "dev", "UPS77", "1", "c");
+    rv = mlm_client_send (m_sender, "subject",  &sendmsg);
+    assert (rv >= 0);
+    int64_t tier_start_ms = zclock_mono ();
+
+    msg = mlm_client_recv (consumer);
+    assert (msg);
+    bmsg = fty_proto_decode (&msg);
+    assert (bmsg);
+    assert (streq (fty_proto_name (bmsg), "UPS77"));
+    assert (streq (fty_proto_state (bmsg), "ACTIVE"));
+    assert (zclock_mono () - tier_start_ms < 10000);
+    fty_proto_destroy (&bmsg);
+
+    zstr_sendx (self, "STATS", NULL);
+    msg = zmsg_recv (self);
+    assert (msg);
+    bool has_tier_wakeups = false;
+    stats = zmsg_popstr (msg);
+    assert (stats && streq (stats, "STATS"));
+    zstr_free (&stats);
+    for (char *name = zmsg_popstr (msg); name; name = zmsg_popstr (msg)) {
+        char *value = zmsg_popstr (msg);
+        assert (value);
+        if (streq (name, "tier-wakeups")) {
+            assert (atoll (value) >= 1);
+            has_tier_wakeups = true;
+        }
+        zstr_free (&name);
+        zstr_free (&value);
+    }
+    assert (has_tier_wakeups);
+    zmsg_destroy (&msg);
+
+    sendmsg = fty_proto_encode_asset (NULL, "UPS77", FTY_PROTO_ASSET_OP_DELETE, NULL);
+    rv = mlm_client_send (m_sender, "UPS77",  &sendmsg);
+    assert (rv >= 0);
+    msg = mlm_client_recv (consumer);
+    assert (msg);
+    bmsg = fty_proto_decode (&msg);
+    assert (bmsg);
+    assert (streq (fty_proto_name (bmsg), "UPS77"));
+    assert (streq (fty_proto_state (bmsg), "RESOLVED"));
+    fty_proto_destroy (&bmsg);
+    zstr_sendx (self, "TIMEOUT", "1000", NULL);
+    unlink ("src/selftest-rw/tiers.cfg");
+
+    // test case 06: compact summary stream
+    mlm_client_t *summary_consumer = mlm_client_new ();
+    rv = mlm_client_connect (summary_consumer, endpoint, 5000, "summary-consumer");
+    assert (rv >= 0);
+    rv = mlm_client_set_consumer (summary_consumer, "_OUTAGE_SUMMARY", ".*");
+    assert (rv >= 0);
+    zstr_sendx (self, "SUMMARY", "_OUTAGE_SUMMARY", "100", "2", NULL);
+
+    zhashx_t *summary_dead = zhashx_new ();
+    uint64_t summary_sequence = 0;
+    for (int i = 0; i != 3; i++) {
+        msg = mlm_client_recv (summary_consumer);
+        assert (msg);
+        rv = outage_summary_apply (summary_dead, msg, &summary_sequence);
+        assert (rv == 0);
+        zmsg_destroy (&msg);
+    }
+    assert (summary_sequence == 3);
+    assert (zhashx_size (summary_dead) == 0);
+    zhashx_destroy (&summary_dead);
+    mlm_client_destroy (&summary_consumer);
+
+    // test case 07: maintenance window suppresses the outage till it ends
+    unlink ("src/selftest-rw/outage_events.ring");
+    zstr_sendx (self, "EVENT-LOG", "src/selftest-rw/outage_events.ring", "64", NULL);
+    mlm_client_t *maintainer = mlm_client_new ();
+    rv = mlm_client_connect (maintainer, endpoint, 5000, "maintainer");
+    assert (rv >= 0);
+    uint64_t window_end_sec = (uint64_t) time (NULL) + 8;
+    char *window_start = zsys_sprintf ("%" PRIu64, window_end_sec - 60);
+    char *window_end = zsys_sprintf ("%" PRIu64, window_end_sec);
+    rv = mlm_client_sendtox (maintainer, "outage-actor1", "MAINTENANCE", "ADD", "asset", "UPS43", window_start, window_end, NULL);
+    assert (rv >= 0);
+    zstr_free (&window_start);
+    zstr_free (&window_end);
+    msg = mlm_client_recv (maintainer);
+    assert (msg);
+    char *reply = zmsg_popstr (msg);
+    assert (reply && streq (reply, "OK"));
+    zstr_free (&reply);
+    zmsg_destroy (&msg);
+
+    aux = zhash_new ();
+    zhash_insert (aux, FTY_PROTO_ASSET_TYPE, "device");
+    zhash_insert (aux, FTY_PROTO_ASSET_SUBTYPE, "ups");
+    zhash_insert (aux, FTY_PROTO_ASSET_STATUS, "active");
+    zhash_insert (aux, "parent_name.1", "rack-43");
+    sendmsg = fty_proto_encode_asset (aux, "UPS43", FTY_PROTO_ASSET_OP_CREATE, NULL);
+    rv = mlm_client_send (a_sender, "UPS43",  &sendmsg);
+    assert (rv >= 0);
+
+    msg = mlm_client_recv (consumer);
+    assert (msg);
+    bmsg = fty_proto_decode (&msg);
+    assert (bmsg);
+    assert (streq (fty_proto_name (bmsg), "UPS43"));
+    assert (streq (fty_proto_state (bmsg), "ACTIVE"));
+    assert ((uint64_t) time (NULL) >= window_end_sec);
+    fty_proto_destroy (&bmsg);
+
+    // suppression is recorded once, not by each check of dead assets
+    event_log_t *events = event_log_open ("src/selftest-rw/outage_events.ring");
+    assert (events);
+    size_t suppressed_count = 0;
+    for (size_t i = 0; i < event_log_size (events); i++) {
+        const event_log_record_t *record = event_log_get (events, i);
+        if (record && record->type == EVENT_LOG_SUPPRESSED && streq (record->asset, "UPS43"))
+            suppressed_count++;
+    }
+    assert (suppressed_count <= 1);
+    event_log_destroy (&events);
+    zstr_sendx (self, "EVENT-LOG", "", "0", NULL);
+    unlink ("src/selftest-rw/outage_events.ring");
+
+    // dead UPS43 is counted in its rack, unknown location has no assets
+    rv = mlm_client_sendtox (maintainer, "outage-actor1", "LOCATIONS", "rack-43", "room-none", NULL);
+    assert (rv >= 0);
+    msg = mlm_client_recv (maintainer);
+    assert (msg);
+    assert (zmsg_size (msg) == 7);
+    reply = zmsg_popstr (msg);
+    assert (reply && streq (reply, "OK"));
+    zstr_free (&reply);
+    const char *expected [] = {"rack-43", "1", "1", "room-none", "0", "0"};
+    for (int i = 0; i < 6; i++) {
+        reply = zmsg_popstr (msg);
+        assert (reply && streq (reply, expected [i]));
+        zstr_free (&reply);
+    }
+    zmsg_destroy (&msg);
+
+    // stream clients do not serve requests, only the mailbox of the actor does
+    rv = mlm_client_sendtox (maintainer, "outage-actor1-metrics", "LOCATIONS", "rack-43", NULL);
+    assert (rv >= 0);
+    zpoller_t *mail_poller = zpoller_new (mlm_client_msgpipe (maintainer), NULL);
+    assert (mail_poller);
+    assert (zpoller_wait (mail_poller, 500) == NULL);
+    assert (zpoller_expired (mail_poller));
+    zpoller_destroy (&mail_poller);
+
+    zhash_update (aux, FTY_PROTO_ASSET_STATUS, "retired");
+    sendmsg = fty_proto_encode_asset (aux, "UPS43", FTY_PROTO_ASSET_OP_UPDATE, NULL);
+    zhash_destroy (&aux);
+    rv = mlm_client_send (a_sender, "UPS43",  &sendmsg);
+    assert (rv >= 0);
+    msg = mlm_client_recv (consumer);
+    assert (msg);
+    bmsg = fty_proto_decode (&msg);
+    assert (bmsg);
+    assert (streq (fty_proto_name (bmsg), "UPS43"));
+    assert (streq (fty_proto_state (bmsg), "RESOLVED"));
+    fty_proto_destroy (&bmsg);
+    mlm_client_destroy (&maintainer);
+
     zactor_destroy(&self);
     mlm_client_destroy (&m_sender);
     mlm_client_destroy (&a_sender);
     mlm_client_destroy (&consumer);
     zactor_destroy (&server);
+    unlink ("src/selftest-rw/outage_history.dat");
 
     //  @end
 
     // Those are PRIVATE to actor, so won't be a part of documentation
     s_osrv_t * self2 = s_osrv_new ();
-    zhash_insert (self2->active_alerts, "DEVICE1", TRUE);
-    zhash_insert (self2->active_alerts, "DEVICE2", TRUE);
-    zhash_insert (self2->active_alerts, "DEVICE3", TRUE);
-    zhash_insert (self2->active_alerts, "DEVICE WITH SPACE", TRUE);
+    const char *devices [] = {"DEVICE1", "DEVICE2", "DEVICE3", "DEVICE WITH SPACE", "DEVICE4"};
+    asset_key_t device_keys [5];
+    for (int i = 0; i != 5; i++)
+        asset_key_init (&device_keys [i], devices [i]);
+    for (int i = 0; i != 4; i++)
+        zhashx_insert (self2->active_alerts, &device_keys [i], (void *) "CRITICAL");
     self2->state_file = strdup ("src/state.zpl");
     s_osrv_save (self2);
     s_osrv_destroy (&self2);
@@ -686,15 +2162,175 @@ fty_outage_server_test (bool verbose)
     self2->state_file = strdup ("src/state.zpl");
     s_osrv_load (self2);
 
-    assert (zhash_size (self2->active_alerts) == 4);
-    assert (zhash_lookup (self2->active_alerts, "DEVICE1"));
-    assert (zhash_lookup (self2->active_alerts, "DEVICE2"));
-    assert (zhash_lookup (self2->active_alerts, "DEVICE3"));
-    assert (zhash_lookup (self2->active_alerts, "DEVICE WITH SPACE"));
-    assert (!zhash_lookup (self2->active_alerts, "DEVICE4"));
+    assert (zhashx_size (self2->active_alerts) == 4);
+    for (int i = 0; i != 4; i++)
+        assert (zhashx_lookup (self2->active_alerts, &device_keys [i]));
+    assert (!zhashx_lookup (self2->active_alerts, &device_keys [4]));
 
     s_osrv_destroy (&self2);
 
     unlink ("src/state.zpl");
+
+    // frames are parsed in place, malformed values are rejected
+    uint64_t value = 0;
+    zframe_t *frame = zframe_new ("18446744073709551615", 20);
+    assert (s_frame_uint64 (frame, &value) == 0 && value == UINT64_MAX);
+    zframe_destroy (&frame);
+    frame = zframe_new ("18446744073709551616", 20);
+    assert (s_frame_uint64 (frame, &value) == -1);
+    zframe_destroy (&frame);
+    frame = zframe_new ("30s", 3);
+    assert (s_frame_uint64 (frame, &value) == -1);
+    zframe_destroy (&frame);
+    assert (s_frame_uint64 (NULL, &value) == -1);
+
+    self2 = s_osrv_new ();
+    uint64_t expiry_sec = data_default_expiry (self2->assets);
+    zmsg_t *control = zmsg_new ();
+    zmsg_addstr (control, "ASSET-EXPIRY-SEC");
+    zmsg_addstr (control, "-5");
+    s_osrv_actor_commands (self2, NULL, &control);
+    assert (!control);
+    assert (data_default_expiry (self2->assets) == expiry_sec);
+    control = zmsg_new ();
+    zmsg_addstr (control, "TIMEOUT");
+    zmsg_addstr (control, "2000");
+    s_osrv_actor_commands (self2, NULL, &control);
+    assert (self2->timeout_ms == 2000);
+
+    // refresh stamps the alert with the time it is sent, so it does not
+    // expire downstream while the device stays dead
+    outage_clock_t *fake = outage_clock_new_fake ((int64_t) 1500000000 * 1000, 1000);
+    data_set_clock (self2->assets, fake);
+    outage_clock_destroy (&self2->clock);
+    self2->clock = fake;
+    asset_key_t dead;
+    asset_key_init (&dead, "UPS-DEAD");
+    s_osrv_activate_alert (self2, &dead, "CRITICAL");
+    fty_proto_t *cached = (fty_proto_t *) zhashx_lookup (self2->alert_cache, &dead);
+    assert (cached);
+    uint64_t published_sec = fty_proto_time (cached);
+    outage_clock_advance (fake, (int64_t) s_osrv_refresh_period_ms (self2));
+    // the wheel of the refresh runs on the real monotonic clock
+    s_osrv_refresh_alerts (self2, (uint64_t) zclock_mono () + 2 * s_osrv_refresh_period_ms (self2));
+    assert (self2->stats.refresh_sent >= 1);
+    assert (fty_proto_time (cached) > published_sec);
+    assert (fty_proto_ttl (cached) == s_osrv_alert_ttl (self2));
+    // lowered timeout shortens ttl of alerts refreshed later
+    control = zmsg_new ();
+    zmsg_addstr (control, "TIMEOUT");
+    zmsg_addstr (control, "1000");
+    s_osrv_actor_commands (self2, NULL, &control);
+    assert (fty_proto_ttl (cached) == s_osrv_alert_ttl (self2));
+    assert (fty_proto_ttl (cached) == 3000);
+
+    // maintenance starting while the alert is active resolves it and stops
+    // its refresh, the alert is suppressed from then on
+    size_t refreshed = alert_refresh_size (self2->refresh);
+    uint64_t window_sec = (uint64_t) outage_clock_wall_ms (fake) / 1000;
+    rv = maintenance_add (self2->maintenance, "asset", "UPS-DEAD", window_sec - 60, window_sec + 60);
+    assert (rv == 0);
+    uint64_t alerts_sent = self2->stats.alerts_sent;
+    s_osrv_check_dead_device (self2, &dead, window_sec);
+    assert (!zhashx_lookup (self2->active_alerts, &dead));
+    assert (!zhashx_lookup (self2->alert_cache, &dead));
+    assert (alert_refresh_size (self2->refresh) == refreshed - 1);
+    assert (zhashx_lookup (self2->suppressed, &dead));
+    assert (self2->stats.alerts_sent == alerts_sent + 1);
+    // checks later in the window neither resolve nor activate it again
+    s_osrv_check_dead_device (self2, &dead, window_sec + 30);
+    assert (!zhashx_lookup (self2->active_alerts, &dead));
+    assert (self2->stats.alerts_sent == alerts_sent + 1);
+
+    // topic without '@' used to crash the server
+    aux = zhash_new ();
+    zhash_insert (aux, FTY_PROTO_ASSET_TYPE, "device");
+    zhash_insert (aux, FTY_PROTO_ASSET_SUBTYPE, "ups");
+    zmsg_t *encoded = fty_proto_encode_asset (aux, "UPS-GONE", FTY_PROTO_ASSET_OP_CREATE, NULL);
+    zhash_destroy (&aux);
+    fty_proto_t *asset = fty_proto_decode (&encoded);
+    data_put (self2->assets, &asset);
+    fty_proto_destroy (&asset);
+    control = zmsg_new ();
+    zmsg_addstr (control, "METRICUNAVAILABLE");
+    zmsg_addstr (control, "UPS-GONE");
+    s_osrv_handle_unavailable (self2, control);
+    zmsg_destroy (&control);
+    asset_key_t gone;
+    asset_key_init (&gone, "UPS-GONE");
+    assert (data_get_asset (self2->assets, &gone));
+    control = zmsg_new ();
+    zmsg_addstr (control, "METRICUNAVAILABLE");
+    zmsg_addstr (control, "realpower.default@UPS-GONE");
+    s_osrv_handle_unavailable (self2, control);
+    zmsg_destroy (&control);
+    assert (!data_get_asset (self2->assets, &gone));
+    s_osrv_destroy (&self2);
+
+    // asset updates are processed before a flood of metrics sent earlier
+    static const char *flood_endpoint = "inproc://malamute-test-flood";
+    server = zactor_new (mlm_server, (void*) "Malamute");
+    zstr_sendx (server, "BIND", flood_endpoint, NULL);
+
+    m_sender = mlm_client_new ();
+    rv = mlm_client_connect (m_sender, flood_endpoint, 5000, "m_sender");
+    assert (rv >= 0);
+    rv = mlm_client_set_producer (m_sender, FTY_PROTO_STREAM_METRICS);
+    assert (rv >= 0);
+    a_sender = mlm_client_new ();
+    rv = mlm_client_connect (a_sender, flood_endpoint, 5000, "a_sender");
+    assert (rv >= 0);
+    rv = mlm_client_set_producer (a_sender, FTY_PROTO_STREAM_ASSETS);
+    assert (rv >= 0);
+
+    self2 = s_osrv_new ();
+    zmsg_t *command = zmsg_new ();
+    zmsg_addstr (command, "CONNECT");
+    zmsg_addstr (command, flood_endpoint);
+    zmsg_addstr (command, "outage-flood");
+    s_osrv_actor_commands (self2, NULL, &command);
+    command = zmsg_new ();
+    zmsg_addstr (command, "CONSUMER");
+    zmsg_addstr (command, FTY_PROTO_STREAM_METRICS);
+    zmsg_addstr (command, ".*");
+    s_osrv_actor_commands (self2, NULL, &command);
+    command = zmsg_new ();
+    zmsg_addstr (command, "CONSUMER");
+    zmsg_addstr (command, FTY_PROTO_STREAM_ASSETS);
+    zmsg_addstr (command, ".*");
+    s_osrv_actor_commands (self2, NULL, &command);
+
+    const uint64_t flood = 10000;
+    for (uint64_t i = 0; i != flood; i++) {
+        sendmsg = fty_proto_encode_metric (NULL, time (NULL), 300, "dev", "UPS-FLOOD", "1", "c");
+        mlm_client_send (m_sender, "dev@UPS-FLOOD", &sendmsg);
+    }
+    aux = zhash_new ();
+    zhash_insert (aux, FTY_PROTO_ASSET_TYPE, "device");
+    zhash_insert (aux, FTY_PROTO_ASSET_SUBTYPE, "ups");
+    zhash_insert (aux, FTY_PROTO_ASSET_STATUS, "retired");
+    sendmsg = fty_proto_encode_asset (aux, "UPS-FLOOD", FTY_PROTO_ASSET_OP_UPDATE, NULL);
+    zhash_destroy (&aux);
+    mlm_client_send (a_sender, "UPS-FLOOD", &sendmsg);
+    zclock_sleep (1000);
+
+    zpoller_t *poller = s_osrv_poller_new (self2, NULL);
+    assert (poller);
+    while (self2->stats.assets_received == 0) {
+        void *which = zpoller_wait (poller, 5000);
+        assert (which);
+        mlm_client_t *client = which == mlm_client_msgpipe (self2->priority_client) ? self2->priority_client : self2->client;
+        rv = s_osrv_handle_stream (self2, client);
+        assert (rv == 0);
+    }
+    if (verbose)
+        log_info ("asset update processed after %" PRIu64 " of %" PRIu64 " metrics", self2->stats.metrics_received, flood);
+    assert (self2->stats.metrics_received < flood);
+
+    zpoller_destroy (&poller);
+    s_osrv_destroy (&self2);
+    mlm_client_destroy (&m_sender);
+    mlm_client_destroy (&a_sender);
+    zactor_destroy (&server);
     printf ("OK\n");
 }
@@ -0,0 +1,122 @@
+/*  =========================================================================
+    fty_outage_sim - Replay captured traffic under expiry policies
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    fty_outage_sim - Replay captured traffic under expiry policies
+@discuss
+    Loads capture of metric and asset events (see outage_sim) and replays
+    it on simulated time under each policy, without malamute, printing
+    number of outages and alerts per policy, so policies can be compared
+    before they are deployed.
+@end
+*/
+
+#include "fty_outage_classes.h"
+
+int main (int argc, char *argv [])
+{
+    const char *path = NULL;
+    bool print_intervals = false;
+    size_t policies_size = 0;
+    outage_sim_policy_t *policies = (outage_sim_policy_t *) malloc ((argc + 1) * sizeof (outage_sim_policy_t));
+    assert (policies);
+
+    int argn;
+    for (argn = 1; argn < argc; argn++) {
+        if (streq (argv [argn], "--help")
+        ||  streq (argv [argn], "-h")) {
+            puts ("fty-outage-sim [options] capture");
+            puts ("  --policy / -p spec     replay under the policy, may be repeated, spec is");
+            puts ("                         <name>[:<key>=<value>,...] with keys warning and");
+            puts ("                         critical (ttls of silence), expiry and poll (seconds)");
+            puts ("  --intervals / -i       print intervals of outages:");
+            puts ("                         <policy> <asset> <start> <end or -> <severity>");
+            puts ("  --help / -h            this information");
+            puts ("  capture has one event per line, - reads it from the standard input:");
+            puts ("    <time> metric <asset> <ttl> [<timestamp>]");
+            puts ("    <time> asset <asset> <operation> [<aux-key>=<value> ...]");
+            free (policies);
+            return 0;
+        }
+        else
+        if ((streq (argv [argn], "--policy") || streq (argv [argn], "-p")) && argn + 1 < argc) {
+            if (outage_sim_policy_parse (&policies [policies_size], argv [++argn]) != 0) {
+                fprintf (stderr, "Invalid policy: %s\n", argv [argn]);
+                free (policies);
+                return 1;
+            }
+            policies_size++;
+        }
+        else
+        if (streq (argv [argn], "--intervals") || streq (argv [argn], "-i"))
+            print_intervals = true;
+        else
+        if (argv [argn][0] != '-' || streq (argv [argn], "-"))
+            path = argv [argn];
+        else {
+            fprintf (stderr, "Unknown option: %s\n", argv [argn]);
+            free (policies);
+            return 1;
+        }
+    }
+    if (!path) {
+        fprintf (stderr, "Capture is missing, see --help\n");
+        free (policies);
+        return 1;
+    }
+    // the agent as it is configured by default
+    if (policies_size == 0)
+        outage_sim_policy_parse (&policies [policies_size++], "default");
+
+    outage_sim_t *sim = outage_sim_new ();
+    assert (sim);
+    int malformed = outage_sim_load (sim, path);
+    if (malformed == -1) {
+        fprintf (stderr, "Can't read capture %s\n", path);
+        outage_sim_destroy (&sim);
+        free (policies);
+        return 1;
+    }
+    fprintf (stderr, "capture %s: %zu events, %zu assets, %d malformed lines skipped\n",
+        path, outage_sim_size (sim), outage_sim_assets (sim), malformed);
+
+    int rv = 0;
+    for (size_t i = 0; i < policies_size; i++) {
+        outage_sim_result_t result;
+        if (outage_sim_run (sim, &policies [i], &result, print_intervals ? stdout : NULL) != 0) {
+            fprintf (stderr, "Can't replay capture under policy %s (memory error)\n", policies [i].name);
+            rv = 1;
+            break;
+        }
+        double seconds = result.elapsed_usec > 0 ? result.elapsed_usec / 1e6 : 1e-6;
+        printf ("policy=%s outages=%zu open=%zu warning=%zu critical=%zu resolved=%zu"
+                " alerts=%zu downtime-sec=%" PRIu64 " events-per-sec=%.0f\n",
+            policies [i].name, result.outages, result.open, result.active_warning,
+            result.active_critical, result.resolved,
+            result.active_warning + result.active_critical + result.resolved,
+            result.downtime_sec, outage_sim_size (sim) / seconds);
+    }
+
+    outage_sim_destroy (&sim);
+    free (policies);
+    return rv;
+}
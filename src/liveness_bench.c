@@ -0,0 +1,359 @@
+/*  =========================================================================
+    liveness_bench - Microbenchmark of the liveness library
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+
+/*
+@header
+    liveness_bench - Microbenchmark of the liveness library
+@discuss
+    Drives fty_outage_liveness alone, without asset messages, the way an
+    agent tracking heartbeats would: insert, touch one by one and in
+    batches of 16 to 4096, expire, snapshot, restore and delete. Keys are
+    hashed before the measurement, time is simulated, one touch per ms.
+
+    Reports ns/op, allocations/op and peak RSS of every benchmark, as
+    text or with --json as one JSON object per line.
+
+    Tiers benchmarks simulate ten ttl of records reporting once per ttl,
+    a tenth of them going silent, checked periodically each 30s, each 1s
+    and with --fine percent of records in a tier of 1s tick while the
+    rest is checked each 30s. They report wakeups/s of the checking loop
+    and detection latency of the fine and the other records, the time
+    from the exact deadline till the record is found dead.
+
+    Run with 'make bench-liveness BENCH_ARGS="..."'.
+@end
+*/
+
+#include "fty_outage_classes.h"
+#include "../perf/alloc_count.h"
+
+typedef struct _options_t {
+    size_t records;
+    size_t ops;
+    int64_t ttl_ms;
+    unsigned int seed;
+    double fine;                //  percent of records in the fine tier
+    bool json;
+} options_t;
+
+//  detection latency of a group of records
+typedef struct _latency_t {
+    size_t detected;
+    int64_t sum_ms;
+    int64_t max_ms;
+} latency_t;
+
+//  simulation of the checking loop of tiers benchmarks
+typedef struct _tiers_sim_t {
+    int64_t now_ms;
+    size_t fine_records;        //  records below this index are fine
+    latency_t fine;
+    latency_t other;
+} tiers_sim_t;
+
+static void
+s_bench_stop (bench_t *bench, options_t *options, size_t ops)
+{
+    double ns_per_op, allocs_per_op;
+    s_bench_per_op (bench, ops, &ns_per_op, &allocs_per_op);
+    if (options->json)
+        printf ("{\"bench\":\"%s\",\"records\":%zu,\"ops\":%zu,\"ttl_ms\":%" PRIi64 ","
+                "\"ns_per_op\":%.1f,\"allocs_per_op\":%.3f,\"peak_rss_kb\":%ld}\n",
+            bench->name, options->records, ops, options->ttl_ms,
+            ns_per_op, allocs_per_op, s_peak_rss_kb ());
+    else
+        printf ("%-40s %10zu ops %12.1f ns/op %8.3f allocs/op %10ld kB peak RSS\n",
+            bench->name, ops, ns_per_op, allocs_per_op, s_peak_rss_kb ());
+}
+
+// latency of the record found dead, its item is its index + 1
+static void
+s_tiers_handler (void *arg, int type, const asset_key_t *key, void *item, const fty_outage_liveness_state_t *state)
+{
+    tiers_sim_t *sim = (tiers_sim_t *) arg;
+    if (type != FTY_OUTAGE_LIVENESS_EXPIRED || state->level != FTY_OUTAGE_LIVENESS_CRITICAL)
+        return;
+    size_t index = (size_t) (uintptr_t) item - 1;
+    latency_t *latency = index < sim->fine_records ? &sim->fine : &sim->other;
+    int64_t latency_ms = sim->now_ms - (state->seen_ms + 2 * state->ttl_ms);
+    latency->detected++;
+    latency->sum_ms += latency_ms;
+    if (latency_ms > latency->max_ms)
+        latency->max_ms = latency_ms;
+}
+
+static int64_t *s_phase;
+
+static int
+s_phase_cmp (const void *a, const void *b)
+{
+    int64_t phase_a = s_phase [*(const size_t *) a];
+    int64_t phase_b = s_phase [*(const size_t *) b];
+    return phase_a < phase_b ? -1 : phase_a > phase_b;
+}
+
+// check records each period_ms, or each timeout_ms and once the first
+// deadline of the fine tier of tick_ms is due when tick_ms is not 0
+static void
+s_bench_tiers (options_t *options, const char *name, asset_key_t *keys, int64_t period_ms, int64_t tick_ms)
+{
+    tiers_sim_t sim = {
+        .now_ms = 1000,
+        .fine_records = (size_t) (options->records * options->fine / 100)
+    };
+    int64_t duration_ms = 10 * options->ttl_ms;
+
+    // each record reports at its phase of ttl, each tenth goes silent
+    unsigned int seed = options->seed;
+    int64_t *phase = (int64_t *) malloc (options->records * sizeof (int64_t));
+    int64_t *silent = (int64_t *) malloc (options->records * sizeof (int64_t));
+    size_t *order = (size_t *) malloc (options->records * sizeof (size_t));
+    assert (phase && silent && order);
+    for (size_t i = 0; i < options->records; i++) {
+        phase [i] = rand_r (&seed) % options->ttl_ms;
+        silent [i] = i % 10 == 9
+            ? sim.now_ms + options->ttl_ms + rand_r (&seed) % (duration_ms - 4 * options->ttl_ms)
+            : INT64_MAX;
+        order [i] = i;
+    }
+    s_phase = phase;
+    qsort (order, options->records, sizeof (size_t), s_phase_cmp);
+
+    fty_outage_liveness_t *liveness = fty_outage_liveness_new ();
+    assert (liveness);
+    fty_outage_liveness_set_default_ttl (liveness, options->ttl_ms);
+    fty_outage_liveness_set_handler (liveness, s_tiers_handler, &sim);
+    fty_outage_liveness_set_tick (liveness, 1, tick_ms, sim.now_ms);
+    for (size_t i = 0; i < options->records; i++) {
+        fty_outage_liveness_insert (liveness, &keys [i], (void *) (uintptr_t) (i + 1), sim.now_ms);
+        if (tick_ms && i < sim.fine_records)
+            fty_outage_liveness_set_tier (liveness, &keys [i], 1, sim.now_ms);
+    }
+
+    size_t wakeups = 0;
+    int64_t check_ns = 0;
+    int64_t last_check_ms = sim.now_ms;
+    int64_t end_ms = sim.now_ms + duration_ms;
+    size_t next = 0;            //  the next record to report in order of phases
+    for (; sim.now_ms < end_ms; sim.now_ms++) {
+        int64_t slot = sim.now_ms % options->ttl_ms;
+        if (slot == 0)
+            next = 0;
+        for (; next < options->records && phase [order [next]] == slot; next++)
+            if (sim.now_ms < silent [order [next]])
+                fty_outage_liveness_touch (liveness, &keys [order [next]], sim.now_ms, options->ttl_ms, sim.now_ms);
+        if (sim.now_ms - last_check_ms < period_ms
+        &&  fty_outage_liveness_next_deadline (liveness, 1) > sim.now_ms)
+            continue;
+        int64_t start_ns = s_now_ns ();
+        zlistx_t *dead = fty_outage_liveness_expire (liveness, sim.now_ms);
+        zlistx_destroy (&dead);
+        check_ns += s_now_ns () - start_ns;
+        wakeups++;
+        if (sim.now_ms - last_check_ms >= period_ms)
+            last_check_ms = sim.now_ms;
+    }
+    fty_outage_liveness_destroy (&liveness);
+    free (phase);
+    free (silent);
+    free (order);
+
+    double wakeups_per_sec = (double) wakeups * 1000 / duration_ms;
+    double fine_mean_ms = sim.fine.detected ? (double) sim.fine.sum_ms / sim.fine.detected : 0;
+    double other_mean_ms = sim.other.detected ? (double) sim.other.sum_ms / sim.other.detected : 0;
+    double ns_per_wakeup = wakeups ? (double) check_ns / wakeups : 0;
+    if (options->json)
+        printf ("{\"bench\":\"%s\",\"records\":%zu,\"fine_records\":%zu,\"ttl_ms\":%" PRIi64 ","
+                "\"wakeups_per_sec\":%.3f,\"ns_per_wakeup\":%.1f,"
+                "\"fine_detected\":%zu,\"fine_latency_mean_ms\":%.1f,\"fine_latency_max_ms\":%" PRIi64 ","
+                "\"other_detected\":%zu,\"other_latency_mean_ms\":%.1f,\"other_latency_max_ms\":%" PRIi64 "}\n",
+            name, options->records, sim.fine_records, options->ttl_ms, wakeups_per_sec, ns_per_wakeup,
+            sim.fine.detected, fine_mean_ms, sim.fine.max_ms,
+            sim.other.detected, other_mean_ms, sim.other.max_ms);
+    else
+        printf ("%-40s %8.3f wakeups/s %10.1f ns/wakeup, latency fine %zu %8.1f/%" PRIi64 " ms, other %zu %8.1f/%" PRIi64 " ms (mean/max)\n",
+            name, wakeups_per_sec, ns_per_wakeup,
+            sim.fine.detected, fine_mean_ms, sim.fine.max_ms,
+            sim.other.detected, other_mean_ms, sim.other.max_ms);
+}
+
+int main (int argc, char *argv [])
+{
+    //  benchmarks are single threaded, count everything
+    s_counting = true;
+    options_t options = {
+        .records = 10000,
+        .ops = 1000000,
+        .ttl_ms = 60000,
+        .seed = 1,
+        .fine = 1
+    };
+
+    int argn;
+    for (argn = 1; argn < argc; argn++) {
+        if (streq (argv [argn], "--help")
+        ||  streq (argv [argn], "-h")) {
+            puts ("liveness_bench [options] ...");
+            puts ("  --records / -r count   number of records [10000]");
+            puts ("  --ops / -o count       number of touches [1000000]");
+            puts ("  --ttl / -t ms          ttl of records [60000]");
+            puts ("  --seed / -s number     random seed [1]");
+            puts ("  --fine / -f percent    records in the fine tier [1]");
+            puts ("  --json / -j            JSON line per benchmark");
+            puts ("  --help / -h            this information");
+            return 0;
+        }
+        else
+        if ((streq (argv [argn], "--records") || streq (argv [argn], "-r")) && argn + 1 < argc)
+            options.records = (size_t) atol (argv [++argn]);
+        else
+        if ((streq (argv [argn], "--ops") || streq (argv [argn], "-o")) && argn + 1 < argc)
+            options.ops = (size_t) atol (argv [++argn]);
+        else
+        if ((streq (argv [argn], "--ttl") || streq (argv [argn], "-t")) && argn + 1 < argc)
+            options.ttl_ms = (int64_t) atoll (argv [++argn]);
+        else
+        if ((streq (argv [argn], "--seed") || streq (argv [argn], "-s")) && argn + 1 < argc)
+            options.seed = (unsigned int) atol (argv [++argn]);
+        else
+        if ((streq (argv [argn], "--fine") || streq (argv [argn], "-f")) && argn + 1 < argc)
+            options.fine = atof (argv [++argn]);
+        else
+        if (streq (argv [argn], "--json") || streq (argv [argn], "-j"))
+            options.json = true;
+        else {
+            fprintf (stderr, "Unknown option: %s\n", argv [argn]);
+            return 1;
+        }
+    }
+    if (options.records == 0 || options.ttl_ms <= 0 || options.fine < 0 || options.fine > 100) {
+        fprintf (stderr, "Invalid number of records, ttl or fine percent\n");
+        return 1;
+    }
+#if !defined (__GLIBC__)
+    fprintf (stderr, "allocations are not counted on this platform\n");
+#endif
+    ftylog_setInstance ("liveness_bench", "");
+
+    // inputs prepared outside of measurements
+    char **names = (char **) malloc (options.records * sizeof (char *));
+    asset_key_t *keys = (asset_key_t *) malloc (options.records * sizeof (asset_key_t));
+    size_t *touched = (size_t *) malloc (options.ops * sizeof (size_t));
+    fty_outage_liveness_touch_t *items = (fty_outage_liveness_touch_t *) malloc (4096 * sizeof (fty_outage_liveness_touch_t));
+    fty_outage_liveness_transition_t *transitions = (fty_outage_liveness_transition_t *) malloc (4096 * sizeof (fty_outage_liveness_transition_t));
+    assert (names && keys && touched && items && transitions);
+    for (size_t i = 0; i < options.records; i++) {
+        names [i] = zsys_sprintf ("agent-%zu", i);
+        asset_key_init (&keys [i], names [i]);
+    }
+    for (size_t op = 0; op < options.ops; op++)
+        touched [op] = (size_t) rand_r (&options.seed) % options.records;
+
+    fty_outage_liveness_t *liveness = fty_outage_liveness_new ();
+    assert (liveness);
+    fty_outage_liveness_set_default_ttl (liveness, options.ttl_ms);
+    int64_t now_ms = 1000;
+    bench_t bench;
+
+    s_bench_start (&bench, "fty_outage_liveness_insert");
+    for (size_t i = 0; i < options.records; i++)
+        fty_outage_liveness_insert (liveness, &keys [i], NULL, now_ms);
+    s_bench_stop (&bench, &options, options.records);
+
+    // one touch per ms of simulated time
+    s_bench_start (&bench, "fty_outage_liveness_touch");
+    for (size_t op = 0; op < options.ops; op++) {
+        now_ms++;
+        fty_outage_liveness_touch (liveness, &keys [touched [op]], now_ms, options.ttl_ms, now_ms);
+    }
+    s_bench_stop (&bench, &options, options.ops);
+
+    // same touches in batches, one batch per batch size ms
+    size_t batch_sizes [] = {16, 64, 256, 1024, 4096};
+    for (size_t i = 0; i < sizeof (batch_sizes) / sizeof (batch_sizes [0]); i++) {
+        size_t batch_size = batch_sizes [i];
+        char name [64];
+        snprintf (name, sizeof (name), "fty_outage_liveness_touch_batch/%zu", batch_size);
+        s_bench_start (&bench, name);
+        for (size_t op = 0; op < options.ops; op += batch_size) {
+            size_t count = options.ops - op < batch_size ? options.ops - op : batch_size;
+            now_ms += (int64_t) count;
+            for (size_t item = 0; item < count; item++) {
+                items [item].key = keys [touched [op + item]];
+                items [item].seen_ms = now_ms;
+                items [item].ttl_ms = options.ttl_ms;
+            }
+            fty_outage_liveness_touch_batch (liveness, items, count, now_ms, transitions);
+        }
+        s_bench_stop (&bench, &options, options.ops);
+    }
+
+    // periodic check right after the touches, only cold keys may be dead
+    size_t rounds = 1000;
+    s_bench_start (&bench, "fty_outage_liveness_expire/steady");
+    for (size_t round = 0; round < rounds; round++) {
+        zlistx_t *dead = fty_outage_liveness_expire (liveness, now_ms);
+        zlistx_destroy (&dead);
+    }
+    s_bench_stop (&bench, &options, rounds);
+
+    // all of them expire at once
+    now_ms += 2 * options.ttl_ms + 1;
+    s_bench_start (&bench, "fty_outage_liveness_expire/all");
+    zlistx_t *dead = fty_outage_liveness_expire (liveness, now_ms);
+    zlistx_destroy (&dead);
+    s_bench_stop (&bench, &options, 1);
+
+    s_bench_start (&bench, "fty_outage_liveness_snapshot");
+    zconfig_t *snapshot = fty_outage_liveness_snapshot (liveness, now_ms);
+    s_bench_stop (&bench, &options, options.records);
+
+    fty_outage_liveness_t *restored = fty_outage_liveness_new ();
+    assert (restored);
+    s_bench_start (&bench, "fty_outage_liveness_restore");
+    fty_outage_liveness_restore (restored, snapshot, now_ms);
+    s_bench_stop (&bench, &options, options.records);
+    assert (fty_outage_liveness_size (restored) == options.records);
+    fty_outage_liveness_destroy (&restored);
+    zconfig_destroy (&snapshot);
+
+    s_bench_start (&bench, "fty_outage_liveness_delete");
+    for (size_t i = 0; i < options.records; i++)
+        fty_outage_liveness_delete (liveness, &keys [i]);
+    s_bench_stop (&bench, &options, options.records);
+
+    fty_outage_liveness_destroy (&liveness);
+
+    // the same traffic checked with a single resolution and with tiers
+    s_bench_tiers (&options, "tiers/periodic-30000", keys, 30000, 0);
+    s_bench_tiers (&options, "tiers/periodic-1000", keys, 1000, 0);
+    s_bench_tiers (&options, "tiers/tiered-1000", keys, 30000, 1000);
+
+    for (size_t i = 0; i < options.records; i++)
+        zstr_free (&names [i]);
+    free (names);
+    free (keys);
+    free (touched);
+    free (items);
+    free (transitions);
+    return 0;
+}
@@ -0,0 +1,398 @@
+/*  =========================================================================
+    maintenance - Maintenance windows suppressing outage alerts
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    maintenance - Maintenance windows suppressing outage alerts
+@discuss
+    During planned maintenance devices go silent on purpose. A window
+    suppresses outage alerts of one asset, of all children of a parent or
+    of all assets of a subtype.
+
+    Windows are indexed per scope and name, sorted by start, together with
+    running maximum of their ends. A window containing time t exists iff
+    the running maximum end of the last window starting before t is after
+    t, so a check is a binary search, O(log W) even with thousands of
+    windows.
+@end
+*/
+
+#include "fty_outage_classes.h"
+
+typedef struct _window_t {
+    uint64_t start_sec;         // [s] wall time, inclusive
+    uint64_t end_sec;           // [s] wall time, exclusive
+} window_t;
+
+//  windows of one scope and name
+typedef struct _window_list_t {
+    window_t *windows;          // sorted by start
+    uint64_t *max_end_sec;      // max_end_sec [i] is max end of windows [0..i]
+    size_t size;
+    size_t capacity;
+} window_list_t;
+
+//  Structure of our class
+struct _maintenance_t {
+    zhashx_t *lists;            // "scope:name" => window_list_t
+    size_t size;                // number of windows
+    uint64_t next_end_sec;      // [s] end of the window which ends first
+};
+
+static void
+window_list_destroy (window_list_t **self_p)
+{
+    assert (self_p);
+    if (*self_p) {
+        window_list_t *self = *self_p;
+        free (self->windows);
+        free (self->max_end_sec);
+        free (self);
+        *self_p = NULL;
+    }
+}
+
+static void
+window_list_update_max (window_list_t *self, size_t from)
+{
+    for (size_t i = from; i < self->size; i++) {
+        uint64_t end_sec = self->windows [i].end_sec;
+        if (i > 0 && self->max_end_sec [i - 1] > end_sec)
+            end_sec = self->max_end_sec [i - 1];
+        self->max_end_sec [i] = end_sec;
+    }
+}
+
+static int
+window_list_insert (window_list_t *self, uint64_t start_sec, uint64_t end_sec)
+{
+    if (self->size == self->capacity) {
+        size_t capacity = self->capacity ? self->capacity * 2 : 4;
+        window_t *windows = (window_t *) realloc (self->windows, capacity * sizeof (window_t));
+        if (!windows)
+            return -1;
+        self->windows = windows;
+        uint64_t *max_end_sec = (uint64_t *) realloc (self->max_end_sec, capacity * sizeof (uint64_t));
+        if (!max_end_sec)
+            return -1;
+        self->max_end_sec = max_end_sec;
+        self->capacity = capacity;
+    }
+    size_t index = self->size;
+    while (index > 0 && self->windows [index - 1].start_sec > start_sec) {
+        self->windows [index] = self->windows [index - 1];
+        index--;
+    }
+    self->windows [index].start_sec = start_sec;
+    self->windows [index].end_sec = end_sec;
+    self->size++;
+    window_list_update_max (self, index);
+    return 0;
+}
+
+//  true if some window contains 'now_sec'
+static bool
+window_list_active (window_list_t *self, uint64_t now_sec)
+{
+    // number of windows starting at or before now
+    size_t low = 0;
+    size_t high = self->size;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (self->windows [middle].start_sec <= now_sec)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low > 0 && self->max_end_sec [low - 1] > now_sec;
+}
+
+//  drop windows ended at 'now_sec', return number of dropped windows
+static size_t
+window_list_expire (window_list_t *self, uint64_t now_sec)
+{
+    size_t kept = 0;
+    for (size_t i = 0; i < self->size; i++) {
+        if (self->windows [i].end_sec > now_sec)
+            self->windows [kept++] = self->windows [i];
+    }
+    size_t dropped = self->size - kept;
+    self->size = kept;
+    window_list_update_max (self, 0);
+    return dropped;
+}
+
+//  --------------------------------------------------------------------------
+//  Destroy the maintenance windows
+void
+maintenance_destroy (maintenance_t **self_p)
+{
+    assert (self_p);
+    if (*self_p) {
+        maintenance_t *self = *self_p;
+        zhashx_destroy (&self->lists);
+        free (self);
+        *self_p = NULL;
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Create a new set of maintenance windows
+maintenance_t *
+maintenance_new (void)
+{
+    maintenance_t *self = (maintenance_t *) zmalloc (sizeof (maintenance_t));
+    if (self) {
+        self->lists = zhashx_new ();
+        if (self->lists) {
+            zhashx_set_destructor (self->lists, (zhashx_destructor_fn *) window_list_destroy);
+            self->next_end_sec = UINT64_MAX;
+        }
+        else
+            maintenance_destroy (&self);
+    }
+    return self;
+}
+
+//  --------------------------------------------------------------------------
+//  Add window <start_sec, end_sec) of wall time for 'scope', which is
+//  "asset", "parent" or "subtype", and its 'name'
+//  Return -1 if the window is not valid, 0 otherwise
+int
+maintenance_add (maintenance_t *self, const char *scope, const char *name, uint64_t start_sec, uint64_t end_sec)
+{
+    assert (self);
+    if (!scope || !name || start_sec >= end_sec)
+        return -1;
+    if (!streq (scope, "asset") && !streq (scope, "parent") && !streq (scope, "subtype"))
+        return -1;
+
+    char *key = zsys_sprintf ("%s:%s", scope, name);
+    window_list_t *list = (window_list_t *) zhashx_lookup (self->lists, key);
+    if (!list) {
+        list = (window_list_t *) zmalloc (sizeof (window_list_t));
+        zhashx_insert (self->lists, key, list);
+    }
+    zstr_free (&key);
+    if (window_list_insert (list, start_sec, end_sec) != 0) {
+        log_error ("Can't add maintenance window of %s '%s' (memory error)", scope, name);
+        return -1;
+    }
+    self->size++;
+    if (end_sec < self->next_end_sec)
+        self->next_end_sec = end_sec;
+    return 0;
+}
+
+//  --------------------------------------------------------------------------
+//  Remove all windows
+void
+maintenance_clear (maintenance_t *self)
+{
+    assert (self);
+    zhashx_purge (self->lists);
+    self->size = 0;
+    self->next_end_sec = UINT64_MAX;
+}
+
+//  --------------------------------------------------------------------------
+//  Replace all windows by 'window' children of 'config', each with scope,
+//  name, start and end
+//  Return number of invalid windows, which were skipped
+int
+maintenance_load (maintenance_t *self, zconfig_t *config)
+{
+    assert (self);
+    assert (config);
+
+    maintenance_clear (self);
+    int invalid = 0;
+    for (zconfig_t *child = zconfig_child (config);
+                    child != NULL;
+                    child = zconfig_next (child))
+    {
+        if (!streq (zconfig_name (child), "window"))
+            continue;
+        const char *scope = zconfig_get (child, "scope", "");
+        const char *name = zconfig_get (child, "name", "");
+        uint64_t start_sec = (uint64_t) atoll (zconfig_get (child, "start", "0"));
+        uint64_t end_sec = (uint64_t) atoll (zconfig_get (child, "end", "0"));
+        if (maintenance_add (self, scope, name, start_sec, end_sec) != 0) {
+            log_warning ("Invalid maintenance window %s '%s' <%" PRIu64 ", %" PRIu64 ">, skipped", scope, name, start_sec, end_sec);
+            invalid++;
+        }
+    }
+    return invalid;
+}
+
+static bool
+s_maintenance_active (maintenance_t *self, const char *scope, const char *name, uint64_t now_sec)
+{
+    if (!name || streq (name, ""))
+        return false;
+    char *key = zsys_sprintf ("%s:%s", scope, name);
+    window_list_t *list = (window_list_t *) zhashx_lookup (self->lists, key);
+    zstr_free (&key);
+    return list && window_list_active (list, now_sec);
+}
+
+//  --------------------------------------------------------------------------
+//  Return true if the asset, its parent or its subtype is in maintenance
+//  at 'now_sec', 'parent' and 'subtype' can be NULL
+bool
+maintenance_active (maintenance_t *self, const char *asset, const char *parent, const char *subtype, uint64_t now_sec)
+{
+    assert (self);
+    assert (asset);
+    if (self->size == 0)
+        return false;
+    return s_maintenance_active (self, "asset", asset, now_sec)
+        || s_maintenance_active (self, "parent", parent, now_sec)
+        || s_maintenance_active (self, "subtype", subtype, now_sec);
+}
+
+//  --------------------------------------------------------------------------
+//  Drop windows which ended at 'now_sec', return number of dropped windows
+size_t
+maintenance_expire (maintenance_t *self, uint64_t now_sec)
+{
+    assert (self);
+    if (now_sec < self->next_end_sec)
+        return 0;
+
+    size_t dropped = 0;
+    self->next_end_sec = UINT64_MAX;
+    zlistx_t *empty = zlistx_new ();
+    for (window_list_t *list = (window_list_t *) zhashx_first (self->lists);
+                        list != NULL;
+                        list = (window_list_t *) zhashx_next (self->lists))
+    {
+        dropped += window_list_expire (list, now_sec);
+        if (list->size == 0)
+            zlistx_add_end (empty, (void *) zhashx_cursor (self->lists));
+        for (size_t i = 0; i < list->size; i++) {
+            if (list->windows [i].end_sec < self->next_end_sec)
+                self->next_end_sec = list->windows [i].end_sec;
+        }
+    }
+    for (const char *key = (const char *) zlistx_first (empty);
+                     key != NULL;
+                     key = (const char *) zlistx_next (empty))
+        zhashx_delete (self->lists, key);
+    zlistx_destroy (&empty);
+    self->size -= dropped;
+    return dropped;
+}
+
+//  --------------------------------------------------------------------------
+//  Return the end of the window which ends first, UINT64_MAX if there is none
+uint64_t
+maintenance_next_end (maintenance_t *self)
+{
+    assert (self);
+    return self->next_end_sec;
+}
+
+//  --------------------------------------------------------------------------
+//  Return number of windows
+size_t
+maintenance_size (maintenance_t *self)
+{
+    assert (self);
+    return self->size;
+}
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+void
+maintenance_test (bool verbose)
+{
+    printf (" * maintenance: ");
+
+    //  @selftest
+    maintenance_t *self = maintenance_new ();
+    assert (self);
+    assert (maintenance_next_end (self) == UINT64_MAX);
+    assert (!maintenance_active (self, "ups-1", NULL, NULL, 100));
+
+    // invalid windows
+    assert (maintenance_add (self, "asset", "ups-1", 200, 100) == -1);
+    assert (maintenance_add (self, "rack", "ups-1", 100, 200) == -1);
+    assert (maintenance_size (self) == 0);
+
+    // overlapping windows, the long one hidden behind later starts
+    assert (maintenance_add (self, "asset", "ups-1", 300, 400) == 0);
+    assert (maintenance_add (self, "asset", "ups-1", 100, 1000) == 0);
+    assert (maintenance_add (self, "asset", "ups-1", 500, 600) == 0);
+    assert (maintenance_add (self, "parent", "rack-1", 2000, 3000) == 0);
+    assert (maintenance_add (self, "subtype", "epdu", 50, 60) == 0);
+    assert (maintenance_size (self) == 5);
+    assert (maintenance_next_end (self) == 60);
+
+    assert (!maintenance_active (self, "ups-1", NULL, NULL, 99));
+    assert (maintenance_active (self, "ups-1", NULL, NULL, 100));
+    assert (maintenance_active (self, "ups-1", NULL, NULL, 700));
+    assert (!maintenance_active (self, "ups-1", NULL, NULL, 1000));
+    assert (!maintenance_active (self, "ups-2", NULL, NULL, 700));
+    assert (maintenance_active (self, "ups-2", "rack-1", "ups", 2500));
+    assert (!maintenance_active (self, "ups-2", "rack-1", "ups", 3000));
+    assert (maintenance_active (self, "epdu-1", "rack-2", "epdu", 55));
+
+    // expire
+    assert (maintenance_expire (self, 59) == 0);
+    assert (maintenance_expire (self, 60) == 1);
+    assert (maintenance_next_end (self) == 400);
+    assert (maintenance_expire (self, 650) == 2);
+    assert (maintenance_next_end (self) == 1000);
+    assert (maintenance_active (self, "ups-1", NULL, NULL, 700));
+    assert (maintenance_expire (self, 5000) == 2);
+    assert (maintenance_size (self) == 0);
+    assert (maintenance_next_end (self) == UINT64_MAX);
+
+    // thousands of windows
+    for (uint64_t i = 0; i < 5000; i++)
+        assert (maintenance_add (self, "asset", "ups-1", i * 10, i * 10 + 5) == 0);
+    assert (maintenance_active (self, "ups-1", NULL, NULL, 12344));
+    assert (!maintenance_active (self, "ups-1", NULL, NULL, 12346));
+
+    // load
+    zconfig_t *config = zconfig_new ("maintenance", NULL);
+    zconfig_t *window = zconfig_new ("window", config);
+    zconfig_put (window, "scope", "asset");
+    zconfig_put (window, "name", "ups-3");
+    zconfig_put (window, "start", "10");
+    zconfig_put (window, "end", "20");
+    window = zconfig_new ("window", config);
+    zconfig_put (window, "scope", "room");
+    zconfig_put (window, "name", "room-1");
+    zconfig_put (window, "start", "10");
+    zconfig_put (window, "end", "20");
+    assert (maintenance_load (self, config) == 1);
+    assert (maintenance_size (self) == 1);
+    assert (maintenance_active (self, "ups-3", NULL, NULL, 15));
+    assert (!maintenance_active (self, "ups-1", NULL, NULL, 12344));
+    zconfig_destroy (&config);
+
+    maintenance_destroy (&self);
+    //  @end
+    printf ("OK\n");
+}
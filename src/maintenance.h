@@ -0,0 +1,88 @@
+/*  =========================================================================
+    maintenance - Maintenance windows suppressing outage alerts
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef MAINTENANCE_H_INCLUDED
+#define MAINTENANCE_H_INCLUDED
+
+#include "../include/fty_outage.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef MAINTENANCE_T_DEFINED
+typedef struct _maintenance_t maintenance_t;
+#define MAINTENANCE_T_DEFINED
+#endif
+
+//  @interface
+//  Create a new set of maintenance windows
+FTY_OUTAGE_EXPORT maintenance_t *
+    maintenance_new (void);
+
+//  Destroy the maintenance windows
+FTY_OUTAGE_EXPORT void
+    maintenance_destroy (maintenance_t **self_p);
+
+//  Add window <start_sec, end_sec) of wall time for 'scope', which is
+//  "asset", "parent" or "subtype", and its 'name'
+//  Return -1 if the window is not valid, 0 otherwise
+FTY_OUTAGE_EXPORT int
+    maintenance_add (maintenance_t *self, const char *scope, const char *name, uint64_t start_sec, uint64_t end_sec);
+
+//  Remove all windows
+FTY_OUTAGE_EXPORT void
+    maintenance_clear (maintenance_t *self);
+
+//  Replace all windows by 'window' children of 'config', each with scope,
+//  name, start and end
+//  Return number of invalid windows, which were skipped
+FTY_OUTAGE_EXPORT int
+    maintenance_load (maintenance_t *self, zconfig_t *config);
+
+//  Return true if the asset, its parent or its subtype is in maintenance
+//  at 'now_sec', 'parent' and 'subtype' can be NULL
+FTY_OUTAGE_EXPORT bool
+    maintenance_active (maintenance_t *self, const char *asset, const char *parent, const char *subtype, uint64_t now_sec);
+
+//  Drop windows which ended at 'now_sec', return number of dropped windows
+FTY_OUTAGE_EXPORT size_t
+    maintenance_expire (maintenance_t *self, uint64_t now_sec);
+
+//  Return the end of the window which ends first, UINT64_MAX if there is none
+FTY_OUTAGE_EXPORT uint64_t
+    maintenance_next_end (maintenance_t *self);
+
+//  Return number of windows
+FTY_OUTAGE_EXPORT size_t
+    maintenance_size (maintenance_t *self);
+
+//  Self test of this class
+FTY_OUTAGE_EXPORT void
+    maintenance_test (bool verbose);
+
+//  @end
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,190 @@
+/*  =========================================================================
+    memory_usage - Estimates of heap memory held by structures
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    memory_usage - Estimates of heap memory held by structures
+@discuss
+    The figures are estimates: czmq containers and fty_proto_t are opaque,
+    so their sizes are approximated from their layout in the czmq and
+    fty-proto versions in use, heap blocks are rounded the way glibc
+    malloc does. They are meant to show which structure grows over months
+    of asset churn, not to match RSS exactly.
+@end
+*/
+
+#include "fty_outage_classes.h"
+#if defined (__GLIBC__)
+#include <malloc.h>
+#endif
+
+#define BLOCK_OVERHEAD 8        // malloc chunk header
+#define BLOCK_ALIGN 16
+#define BLOCK_MIN 32
+#define HASH_ITEM_SIZE 48       // zhashx item: value, next, index, key, free_fn
+#define HASH_SIZE 96            // zhashx_t itself
+#define PROTO_SIZE 320          // fty_proto_t, all fields of all message ids
+
+//  --------------------------------------------------------------------------
+//  Return bytes taken by a heap block of given size, allocator overhead included
+
+size_t
+memory_usage_block (size_t size)
+{
+    size_t block = (size + BLOCK_OVERHEAD + BLOCK_ALIGN - 1) & ~((size_t) BLOCK_ALIGN - 1);
+    return block < BLOCK_MIN ? BLOCK_MIN : block;
+}
+
+//  --------------------------------------------------------------------------
+//  Return bytes taken by a heap allocated string, 0 for NULL
+
+size_t
+memory_usage_string (const char *string)
+{
+    return string ? memory_usage_block (strlen (string) + 1) : 0;
+}
+
+//  --------------------------------------------------------------------------
+//  Return bytes taken by hash table of given number of items, keys and
+//  values excluded
+
+size_t
+memory_usage_hash (size_t items)
+{
+    // buckets are kept above the number of items
+    return memory_usage_block (HASH_SIZE)
+        + memory_usage_block ((items + items / 2 + 1) * sizeof (void *))
+        + items * memory_usage_block (HASH_ITEM_SIZE);
+}
+
+static size_t
+s_string_hash (zhash_t *hash)
+{
+    if (!hash)
+        return 0;
+    size_t bytes = memory_usage_hash (zhash_size (hash));
+    for (const char *value = (const char *) zhash_first (hash); value; value = (const char *) zhash_next (hash))
+        bytes += memory_usage_string (zhash_cursor (hash)) + memory_usage_string (value);
+    return bytes;
+}
+
+//  --------------------------------------------------------------------------
+//  Return bytes taken by decoded message, including its name and aux/ext hashes
+
+size_t
+memory_usage_proto (fty_proto_t *proto)
+{
+    if (!proto)
+        return 0;
+    return memory_usage_block (PROTO_SIZE)
+        + memory_usage_string (fty_proto_name (proto))
+        + s_string_hash (fty_proto_aux (proto))
+        + s_string_hash (fty_proto_ext (proto));
+}
+
+//  --------------------------------------------------------------------------
+//  Return resident set size of the process in bytes, 0 if not known
+
+size_t
+memory_usage_rss (void)
+{
+    size_t bytes = 0;
+    FILE *file = fopen ("/proc/self/statm", "r");
+    if (file) {
+        unsigned long size, resident;
+        if (fscanf (file, "%lu %lu", &size, &resident) == 2)
+            bytes = (size_t) resident * (size_t) sysconf (_SC_PAGESIZE);
+        fclose (file);
+    }
+    return bytes;
+}
+
+//  --------------------------------------------------------------------------
+//  Return free heap memory to the operating system where supported
+//  return true if some memory was released
+
+bool
+memory_usage_trim (void)
+{
+#if defined (__GLIBC__)
+    return malloc_trim (0) == 1;
+#else
+    return false;
+#endif
+}
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+void
+memory_usage_test (bool verbose)
+{
+    printf (" * memory_usage: ");
+
+    //  @selftest
+    assert (memory_usage_block (1) == 32);
+    assert (memory_usage_block (24) == 32);
+    assert (memory_usage_block (25) == 48);
+    assert (memory_usage_string (NULL) == 0);
+    assert (memory_usage_string ("ups-1") == 32);
+    assert (memory_usage_hash (1000) > memory_usage_hash (10));
+
+    zhash_t *aux = zhash_new ();
+    zhash_insert (aux, FTY_PROTO_ASSET_TYPE, "device");
+    zhash_insert (aux, FTY_PROTO_ASSET_SUBTYPE, "ups");
+    zmsg_t *msg = fty_proto_encode_asset (aux, "ups-1", FTY_PROTO_ASSET_OP_CREATE, NULL);
+    fty_proto_t *proto = fty_proto_decode (&msg);
+    assert (proto);
+    size_t bytes = memory_usage_proto (proto);
+    assert (bytes > memory_usage_block (PROTO_SIZE) + memory_usage_hash (2));
+    assert (memory_usage_proto (NULL) == 0);
+    fty_proto_destroy (&proto);
+    zhash_destroy (&aux);
+
+    // trimming freed memory never grows RSS, how much it gives back depends
+    // on the allocator
+    size_t rss = memory_usage_rss ();
+    if (verbose)
+        printf ("\nRSS %zu kB\n", rss / 1024);
+#if defined (__linux__)
+    assert (rss > 0);
+    size_t count = 100000;
+    char **blocks = (char **) malloc (count * sizeof (char *));
+    assert (blocks);
+    for (size_t i = 0; i < count; i++) {
+        blocks [i] = (char *) malloc (100);
+        memset (blocks [i], 1, 100);
+    }
+    size_t peak = memory_usage_rss ();
+    for (size_t i = 0; i < count; i++)
+        free (blocks [i]);
+    free (blocks);
+    size_t freed = memory_usage_rss ();
+    memory_usage_trim ();
+    size_t trimmed = memory_usage_rss ();
+    if (verbose)
+        printf ("RSS %zu kB peak, %zu kB freed, %zu kB after trim\n", peak / 1024, freed / 1024, trimmed / 1024);
+    assert (peak > rss);
+    assert (trimmed <= freed);
+#endif
+    //  @end
+    printf ("OK\n");
+}
@@ -0,0 +1,68 @@
+/*  =========================================================================
+    memory_usage - Estimates of heap memory held by structures
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef MEMORY_USAGE_H_INCLUDED
+#define MEMORY_USAGE_H_INCLUDED
+
+#include "../include/fty_outage.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  @interface
+//  Return bytes taken by a heap block of given size, allocator overhead included
+FTY_OUTAGE_EXPORT size_t
+    memory_usage_block (size_t size);
+
+//  Return bytes taken by a heap allocated string, 0 for NULL
+FTY_OUTAGE_EXPORT size_t
+    memory_usage_string (const char *string);
+
+//  Return bytes taken by hash table of given number of items, keys and
+//  values excluded
+FTY_OUTAGE_EXPORT size_t
+    memory_usage_hash (size_t items);
+
+//  Return bytes taken by decoded message, including its name and aux/ext hashes
+FTY_OUTAGE_EXPORT size_t
+    memory_usage_proto (fty_proto_t *proto);
+
+//  Return resident set size of the process in bytes, 0 if not known
+FTY_OUTAGE_EXPORT size_t
+    memory_usage_rss (void);
+
+//  Return free heap memory to the operating system where supported
+//  return true if some memory was released
+FTY_OUTAGE_EXPORT bool
+    memory_usage_trim (void);
+
+//  Self test of this class
+FTY_OUTAGE_EXPORT void
+    memory_usage_test (bool verbose);
+
+//  @end
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
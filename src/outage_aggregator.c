@@ -0,0 +1,581 @@
+/*  =========================================================================
+    outage_aggregator - Central aggregator of outage summaries from edge agents
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    outage_aggregator - Central aggregator of outage summaries from edge agents
+@discuss
+    Edge agents publish compact summaries of their dead assets (see
+    outage_summary) with subject outage-summary@site. The aggregator keeps
+    the set of dead assets per site and a global table counting in how
+    many sites an asset is dead. A site whose delta does not follow the
+    last applied summary keeps its last known set and is reported STALE
+    until the next full snapshot, as is a site silent for longer than
+    STALE-MS. Queries are answered on the actor pipe and on mailbox
+    subject STATUS, so the same binary runs either as an edge agent or as
+    the central aggregator.
+@end
+*/
+
+#include "fty_outage_classes.h"
+
+#define DEFAULT_STALE_MS 180000     // three default summary intervals
+
+typedef struct _aggregator_site_t {
+    zhashx_t *dead;                 // dead asset names, as applied from summaries
+    uint64_t sequence;              // sequence of the last applied summary
+    uint64_t last_ms;               // monotonic time of the last applied summary
+    uint64_t rejected;              // summaries not applied (gap or malformed)
+    bool synced;                    // false after a rejected summary till the next FULL
+} aggregator_site_t;
+
+typedef struct _aggregator_t {
+    mlm_client_t *client;
+    zhashx_t *sites;                // site => aggregator_site_t
+    zhashx_t *global;               // asset name => number of sites it is dead in
+    uint64_t stale_ms;
+} aggregator_t;
+
+static void
+s_site_destroy (aggregator_site_t **self_p)
+{
+    if (*self_p) {
+        aggregator_site_t *self = *self_p;
+        zhashx_destroy (&self->dead);
+        free (self);
+        *self_p = NULL;
+    }
+}
+
+static aggregator_site_t *
+s_site_new (void)
+{
+    aggregator_site_t *self = (aggregator_site_t *) zmalloc (sizeof (aggregator_site_t));
+    if (self) {
+        self->dead = zhashx_new ();
+        if (!self->dead)
+            s_site_destroy (&self);
+    }
+    return self;
+}
+
+static void
+s_aggregator_destroy (aggregator_t **self_p)
+{
+    if (*self_p) {
+        aggregator_t *self = *self_p;
+        mlm_client_destroy (&self->client);
+        zhashx_destroy (&self->sites);
+        zhashx_destroy (&self->global);
+        free (self);
+        *self_p = NULL;
+    }
+}
+
+static aggregator_t *
+s_aggregator_new (void)
+{
+    aggregator_t *self = (aggregator_t *) zmalloc (sizeof (aggregator_t));
+    if (self) {
+        self->sites = zhashx_new ();
+        self->global = zhashx_new ();
+        self->stale_ms = DEFAULT_STALE_MS;
+        if (!self->sites || !self->global)
+            s_aggregator_destroy (&self);
+        else
+            zhashx_set_destructor (self->sites, (zhashx_destructor_fn *) s_site_destroy);
+    }
+    return self;
+}
+
+// add delta to the number of sites asset is dead in
+static void
+s_global_add (aggregator_t *self, const char *asset, int delta)
+{
+    uintptr_t count = (uintptr_t) zhashx_lookup (self->global, asset) + delta;
+    if (count == 0)
+        zhashx_delete (self->global, asset);
+    else
+        zhashx_update (self->global, asset, (void *) count);
+}
+
+// apply summary of a site and update the global table by the difference
+// return -1 if the summary was rejected
+static int
+s_aggregator_merge (aggregator_t *self, const char *site_name, zmsg_t *msg, uint64_t now_ms)
+{
+    aggregator_site_t *site = (aggregator_site_t *) zhashx_lookup (self->sites, site_name);
+    if (!site) {
+        site = s_site_new ();
+        if (!site)
+            return -1;
+        zhashx_insert (self->sites, site_name, site);
+    }
+
+    zhashx_t *before = zhashx_new ();
+    for (void *it = zhashx_first (site->dead); it; it = zhashx_next (site->dead))
+        zhashx_insert (before, zhashx_cursor (site->dead), it);
+
+    if (outage_summary_apply (site->dead, msg, &site->sequence) != 0) {
+        log_warning ("outage_aggregator: summary from %s rejected after sequence %" PRIu64, site_name, site->sequence);
+        site->rejected++;
+        site->synced = false;
+        zhashx_destroy (&before);
+        return -1;
+    }
+    site->synced = true;
+    site->last_ms = now_ms;
+
+    for (void *it = zhashx_first (before); it; it = zhashx_next (before)) {
+        const char *asset = (const char *) zhashx_cursor (before);
+        if (!zhashx_lookup (site->dead, asset))
+            s_global_add (self, asset, -1);
+    }
+    for (void *it = zhashx_first (site->dead); it; it = zhashx_next (site->dead)) {
+        const char *asset = (const char *) zhashx_cursor (site->dead);
+        if (!zhashx_lookup (before, asset))
+            s_global_add (self, asset, +1);
+    }
+    zhashx_destroy (&before);
+    return 0;
+}
+
+static const char *
+s_site_state (aggregator_t *self, aggregator_site_t *site, uint64_t now_ms)
+{
+    return site->synced && now_ms - site->last_ms <= self->stale_ms ? "SYNCED" : "STALE";
+}
+
+// append sorted keys of the hash to the message
+static void
+s_add_sorted_keys (zmsg_t *msg, zhashx_t *hash)
+{
+    zlistx_t *keys = zhashx_keys (hash);
+    zlistx_set_comparator (keys, (zlistx_comparator_fn *) strcmp);
+    zlistx_sort (keys);
+    for (char *key = (char *) zlistx_first (keys); key; key = (char *) zlistx_next (keys))
+        zmsg_addstr (msg, key);
+    zlistx_destroy (&keys);
+}
+
+// answer a query, request starts with the query name
+static zmsg_t *
+s_aggregator_query (aggregator_t *self, zmsg_t *request, uint64_t now_ms)
+{
+    zmsg_t *reply = zmsg_new ();
+    char *query = zmsg_popstr (request);
+    char *arg = zmsg_popstr (request);
+
+    if (query && streq (query, "SITES")) {
+        zmsg_addstr (reply, "OK");
+        zlistx_t *names = zhashx_keys (self->sites);
+        zlistx_set_comparator (names, (zlistx_comparator_fn *) strcmp);
+        zlistx_sort (names);
+        for (char *name = (char *) zlistx_first (names); name; name = (char *) zlistx_next (names)) {
+            aggregator_site_t *site = (aggregator_site_t *) zhashx_lookup (self->sites, name);
+            zmsg_addstr (reply, name);
+            zmsg_addstrf (reply, "%zu", zhashx_size (site->dead));
+            zmsg_addstrf (reply, "%" PRIu64, site->sequence);
+            zmsg_addstr (reply, s_site_state (self, site, now_ms));
+            zmsg_addstrf (reply, "%" PRIu64, site->last_ms ? now_ms - site->last_ms : 0);
+        }
+        zlistx_destroy (&names);
+    }
+    else
+    if (query && streq (query, "SITE") && arg) {
+        aggregator_site_t *site = (aggregator_site_t *) zhashx_lookup (self->sites, arg);
+        if (site) {
+            zmsg_addstr (reply, "OK");
+            zmsg_addstr (reply, s_site_state (self, site, now_ms));
+            s_add_sorted_keys (reply, site->dead);
+        }
+        else {
+            zmsg_addstr (reply, "ERROR");
+            zmsg_addstr (reply, "UNKNOWN-SITE");
+        }
+    }
+    else
+    if (query && streq (query, "ASSET") && arg) {
+        zmsg_addstr (reply, "OK");
+        zmsg_addstr (reply, zhashx_lookup (self->global, arg) ? "DEAD" : "ALIVE");
+        if (zhashx_lookup (self->global, arg)) {
+            zlistx_t *names = zhashx_keys (self->sites);
+            zlistx_set_comparator (names, (zlistx_comparator_fn *) strcmp);
+            zlistx_sort (names);
+            for (char *name = (char *) zlistx_first (names); name; name = (char *) zlistx_next (names)) {
+                aggregator_site_t *site = (aggregator_site_t *) zhashx_lookup (self->sites, name);
+                if (zhashx_lookup (site->dead, arg))
+                    zmsg_addstr (reply, name);
+            }
+            zlistx_destroy (&names);
+        }
+    }
+    else
+    if (query && streq (query, "DEAD")) {
+        zmsg_addstr (reply, "OK");
+        zmsg_addstrf (reply, "%zu", zhashx_size (self->global));
+        s_add_sorted_keys (reply, self->global);
+    }
+    else {
+        zmsg_addstr (reply, "ERROR");
+        zmsg_addstr (reply, "UNKNOWN-QUERY");
+    }
+
+    zstr_free (&query);
+    zstr_free (&arg);
+    return reply;
+}
+
+// handle message from malamute: summaries from the stream, queries from mailbox
+static void
+s_aggregator_handle_client (aggregator_t *self)
+{
+    zmsg_t *msg = mlm_client_recv (self->client);
+    if (!msg)
+        return;
+    const char *subject = mlm_client_subject (self->client);
+    uint64_t now_ms = (uint64_t) zclock_mono ();
+
+    if (streq (mlm_client_command (self->client), "MAILBOX DELIVER")) {
+        if (streq (subject, "STATUS")) {
+            zmsg_t *reply = s_aggregator_query (self, msg, now_ms);
+            if (mlm_client_sendto (self->client, mlm_client_sender (self->client), "STATUS", NULL, 1000, &reply) != 0)
+                log_error ("outage_aggregator: cannot reply to %s", mlm_client_sender (self->client));
+            zmsg_destroy (&reply);
+        }
+        else
+            log_warning ("outage_aggregator: Unknown mailbox subject %s from %s", subject, mlm_client_sender (self->client));
+    }
+    else
+    if (strncmp (subject, OUTAGE_SUMMARY_SUBJECT, strlen (OUTAGE_SUMMARY_SUBJECT)) == 0) {
+        // summaries without site are keyed by the address of the edge agent
+        const char *site = strchr (subject, '@');
+        s_aggregator_merge (self, site ? site + 1 : mlm_client_sender (self->client), msg, now_ms);
+    }
+    zmsg_destroy (&msg);
+}
+
+// process command from the pipe
+// return 1 on $TERM, 0 otherwise
+static int
+s_aggregator_command (aggregator_t *self, zsock_t *pipe, zmsg_t **message_p)
+{
+    zmsg_t *message = *message_p;
+    char *command = zmsg_popstr (message);
+    int ret = 0;
+
+    if (!command)
+        ;
+    else
+    if (streq (command, "$TERM"))
+        ret = 1;
+    else
+    if (streq (command, "CONNECT")) {
+        char *endpoint = zmsg_popstr (message);
+        char *address = zmsg_popstr (message);
+        if (endpoint && address) {
+            mlm_client_destroy (&self->client);
+            self->client = mlm_client_new ();
+            if (mlm_client_connect (self->client, endpoint, 1000, address) == -1)
+                log_error ("outage_aggregator: Can't connect to malamute endpoint %s", endpoint);
+        }
+        zstr_free (&endpoint);
+        zstr_free (&address);
+    }
+    else
+    if (streq (command, "CONSUMER")) {
+        char *stream = zmsg_popstr (message);
+        char *pattern = zmsg_popstr (message);
+        if (!self->client)
+            log_error ("outage_aggregator: CONSUMER requires CONNECT first");
+        else
+        if (stream && pattern && mlm_client_set_consumer (self->client, stream, pattern) == -1)
+            log_error ("outage_aggregator: mlm_set_consumer failed");
+        zstr_free (&stream);
+        zstr_free (&pattern);
+    }
+    else
+    if (streq (command, "STALE-MS")) {
+        char *stale = zmsg_popstr (message);
+        if (stale)
+            self->stale_ms = (uint64_t) atoll (stale);
+        zstr_free (&stale);
+    }
+    else
+    if (streq (command, "QUERY")) {
+        zmsg_t *reply = s_aggregator_query (self, message, (uint64_t) zclock_mono ());
+        zmsg_send (&reply, pipe);
+    }
+    else
+        log_error ("outage_aggregator: Unknown actor command: %s", command);
+
+    zstr_free (&command);
+    zmsg_destroy (message_p);
+    return ret;
+}
+
+// --------------------------------------------------------------------------
+// outage_aggregator actor
+void
+outage_aggregator (zsock_t *pipe, void *args)
+{
+    aggregator_t *self = s_aggregator_new ();
+    assert (self);
+
+    zpoller_t *poller = zpoller_new (pipe, NULL);
+    assert (poller);
+
+    zsock_signal (pipe, 0);
+    log_info ("outage_aggregator: Started");
+
+    while (!zsys_interrupted)
+    {
+        void *which = zpoller_wait (poller, -1);
+        if (which == pipe) {
+            zmsg_t *msg = zmsg_recv (pipe);
+            if (!msg)
+                break;
+            mlm_client_t *client = self->client;
+            if (s_aggregator_command (self, pipe, &msg) == 1)
+                break;
+            // (re)connected, the old client is gone, watch the new one
+            if (self->client != client) {
+                zpoller_destroy (&poller);
+                poller = zpoller_new (pipe, mlm_client_msgpipe (self->client), NULL);
+                assert (poller);
+            }
+        }
+        else
+        if (self->client && which == mlm_client_msgpipe (self->client))
+            s_aggregator_handle_client (self);
+        else
+        if (zpoller_terminated (poller))
+            break;
+    }
+
+    zpoller_destroy (&poller);
+    s_aggregator_destroy (&self);
+    log_info ("outage_aggregator: Ended");
+}
+
+// --------------------------------------------------------------------------
+// Self test of this class
+
+// send query to the actor and return the reply as one space separated string
+static char *
+s_query (zactor_t *self, const char *query, const char *arg)
+{
+    zstr_sendx (self, "QUERY", query, arg, NULL);
+    zmsg_t *reply = zmsg_recv (self);
+    assert (reply);
+    char *ret = zmsg_popstr (reply);
+    for (char *frame = zmsg_popstr (reply); frame; frame = zmsg_popstr (reply)) {
+        char *joined = zsys_sprintf ("%s %s", ret, frame);
+        zstr_free (&ret);
+        zstr_free (&frame);
+        ret = joined;
+    }
+    zmsg_destroy (&reply);
+    return ret;
+}
+
+static void
+s_assert_reply (char *reply, const char *expected)
+{
+    if (!streq (reply, expected))
+        printf ("expected '%s', got '%s'\n", expected, reply);
+    assert (streq (reply, expected));
+    zstr_free (&reply);
+}
+
+// add or remove asset of the test set of dead assets
+static void
+s_dead_set (zhashx_t *dead, const char *name, bool is_dead)
+{
+    asset_key_t key;
+    asset_key_init (&key, name);
+    if (is_dead)
+        zhashx_insert (dead, &key, (void *) "CRITICAL");
+    else
+        zhashx_delete (dead, &key);
+}
+
+void
+outage_aggregator_test (bool verbose)
+{
+    printf (" * outage_aggregator: ");
+
+    //  @selftest
+    // merge: global table counts sites an asset is dead in
+    aggregator_t *aggregator = s_aggregator_new ();
+    assert (aggregator);
+    outage_summary_t *edge_a = outage_summary_new (10);
+    outage_summary_t *edge_b = outage_summary_new (10);
+    zhashx_t *dead_a = asset_key_hash_new (true);
+    zhashx_t *dead_b = asset_key_hash_new (true);
+
+    s_dead_set (dead_a, "ups-1", true);
+    s_dead_set (dead_a, "ups-2", true);
+    s_dead_set (dead_b, "ups-2", true);
+    zmsg_t *msg = outage_summary_encode (edge_a, dead_a);
+    assert (s_aggregator_merge (aggregator, "site-a", msg, 1000) == 0);
+    zmsg_destroy (&msg);
+    msg = outage_summary_encode (edge_b, dead_b);
+    assert (s_aggregator_merge (aggregator, "site-b", msg, 1000) == 0);
+    zmsg_destroy (&msg);
+    assert (zhashx_size (aggregator->sites) == 2);
+    assert ((uintptr_t) zhashx_lookup (aggregator->global, "ups-1") == 1);
+    assert ((uintptr_t) zhashx_lookup (aggregator->global, "ups-2") == 2);
+
+    // delta: ups-2 is back in site-a, still dead in site-b
+    s_dead_set (dead_a, "ups-2", false);
+    msg = outage_summary_encode (edge_a, dead_a);
+    assert (s_aggregator_merge (aggregator, "site-a", msg, 2000) == 0);
+    zmsg_destroy (&msg);
+    assert ((uintptr_t) zhashx_lookup (aggregator->global, "ups-2") == 1);
+
+    zmsg_t *request = zmsg_new ();
+    zmsg_addstr (request, "ASSET");
+    zmsg_addstr (request, "ups-2");
+    zmsg_t *reply = s_aggregator_query (aggregator, request, 2000);
+    assert (zmsg_size (reply) == 3);
+    char *frame = zmsg_popstr (reply);
+    assert (streq (frame, "OK"));
+    zstr_free (&frame);
+    frame = zmsg_popstr (reply);
+    assert (streq (frame, "DEAD"));
+    zstr_free (&frame);
+    frame = zmsg_popstr (reply);
+    assert (streq (frame, "site-b"));
+    zstr_free (&frame);
+    zmsg_destroy (&reply);
+    zmsg_destroy (&request);
+
+    // lost delta: site-b keeps its last set and is STALE till the next FULL
+    s_dead_set (dead_b, "ups-3", true);
+    msg = outage_summary_encode (edge_b, dead_b);
+    zmsg_destroy (&msg);
+    s_dead_set (dead_b, "ups-2", false);
+    msg = outage_summary_encode (edge_b, dead_b);
+    assert (s_aggregator_merge (aggregator, "site-b", msg, 3000) == -1);
+    zmsg_destroy (&msg);
+    aggregator_site_t *site = (aggregator_site_t *) zhashx_lookup (aggregator->sites, "site-b");
+    assert (!site->synced && site->rejected == 1);
+    assert (zhashx_lookup (site->dead, "ups-2"));
+    assert (streq (s_site_state (aggregator, site, 3000), "STALE"));
+
+    // site silent for too long is STALE too
+    site = (aggregator_site_t *) zhashx_lookup (aggregator->sites, "site-a");
+    assert (streq (s_site_state (aggregator, site, 2000 + DEFAULT_STALE_MS), "SYNCED"));
+    assert (streq (s_site_state (aggregator, site, 2001 + DEFAULT_STALE_MS), "STALE"));
+
+    zhashx_destroy (&dead_a);
+    zhashx_destroy (&dead_b);
+    outage_summary_destroy (&edge_a);
+    outage_summary_destroy (&edge_b);
+    s_aggregator_destroy (&aggregator);
+
+    // several edge agents and one aggregator in-process
+    static const char *endpoint = "inproc://outage-aggregator-test";
+    zactor_t *server = zactor_new (mlm_server, (void*) "Malamute");
+    zstr_sendx (server, "BIND", endpoint, NULL);
+
+    zactor_t *self = zactor_new (outage_aggregator, NULL);
+    assert (self);
+    zstr_sendx (self, "CONNECT", endpoint, "outage-aggregator", NULL);
+    zstr_sendx (self, "CONSUMER", "_OUTAGE_SUMMARY", OUTAGE_SUMMARY_SUBJECT ".*", NULL);
+
+    // two edges publish hand made summaries, a third one is a real agent
+    mlm_client_t *edges [2];
+    outage_summary_t *summaries [2];
+    for (int i = 0; i != 2; i++) {
+        char *address = zsys_sprintf ("edge-%d", i);
+        edges [i] = mlm_client_new ();
+        int rv = mlm_client_connect (edges [i], endpoint, 5000, address);
+        assert (rv >= 0);
+        rv = mlm_client_set_producer (edges [i], "_OUTAGE_SUMMARY");
+        assert (rv >= 0);
+        zstr_free (&address);
+        summaries [i] = outage_summary_new (10);
+    }
+    zactor_t *agent = zactor_new (fty_outage_server, NULL);
+    assert (agent);
+    zstr_sendx (agent, "CONNECT", endpoint, "outage-edge", NULL);
+    zstr_sendx (agent, "SUMMARY", "_OUTAGE_SUMMARY", "100", "2", "site-c", NULL);
+
+    zhashx_t *dead = asset_key_hash_new (true);
+    s_dead_set (dead, "epdu-7", true);
+    s_dead_set (dead, "ups-1", true);
+    msg = outage_summary_encode (summaries [0], dead);
+    int rv = mlm_client_send (edges [0], OUTAGE_SUMMARY_SUBJECT "@site-a", &msg);
+    assert (rv >= 0);
+    s_dead_set (dead, "epdu-7", false);
+    msg = outage_summary_encode (summaries [1], dead);
+    rv = mlm_client_send (edges [1], OUTAGE_SUMMARY_SUBJECT "@site-b", &msg);
+    assert (rv >= 0);
+    zhashx_destroy (&dead);
+
+    // wait for all three sites
+    char *reply_str = NULL;
+    for (int i = 0; i != 50; i++) {
+        zstr_free (&reply_str);
+        reply_str = s_query (self, "SITES", NULL);
+        if (strstr (reply_str, "site-a") && strstr (reply_str, "site-b") && strstr (reply_str, "site-c"))
+            break;
+        zclock_sleep (100);
+    }
+    if (verbose)
+        printf ("\n%s\n", reply_str);
+    assert (strstr (reply_str, "site-a 2 1 SYNCED"));
+    assert (strstr (reply_str, "site-b 1 1 SYNCED"));
+    assert (strstr (reply_str, "site-c 0 "));
+    zstr_free (&reply_str);
+
+    s_assert_reply (s_query (self, "ASSET", "ups-1"), "OK DEAD site-a site-b");
+    s_assert_reply (s_query (self, "ASSET", "epdu-7"), "OK DEAD site-a");
+    s_assert_reply (s_query (self, "ASSET", "ups-2"), "OK ALIVE");
+    s_assert_reply (s_query (self, "DEAD", NULL), "OK 2 epdu-7 ups-1");
+    s_assert_reply (s_query (self, "SITE", "site-b"), "OK SYNCED ups-1");
+    s_assert_reply (s_query (self, "SITE", "site-x"), "ERROR UNKNOWN-SITE");
+
+    // the same queries over mailbox
+    mlm_client_t *client = mlm_client_new ();
+    rv = mlm_client_connect (client, endpoint, 5000, "aggregator-client");
+    assert (rv >= 0);
+    rv = mlm_client_sendtox (client, "outage-aggregator", "STATUS", "ASSET", "ups-1", NULL);
+    assert (rv >= 0);
+    msg = mlm_client_recv (client);
+    assert (msg);
+    assert (streq (mlm_client_subject (client), "STATUS"));
+    assert (zmsg_size (msg) == 4);
+    zmsg_destroy (&msg);
+    mlm_client_destroy (&client);
+
+    zactor_destroy (&agent);
+    for (int i = 0; i != 2; i++) {
+        mlm_client_destroy (&edges [i]);
+        outage_summary_destroy (&summaries [i]);
+    }
+    zactor_destroy (&self);
+    zactor_destroy (&server);
+    //  @end
+    printf ("OK\n");
+}
@@ -0,0 +1,59 @@
+/*  =========================================================================
+    outage_aggregator - Central aggregator of outage summaries from edge agents
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef OUTAGE_AGGREGATOR_H_INCLUDED
+#define OUTAGE_AGGREGATOR_H_INCLUDED
+
+#include "../include/fty_outage.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  @interface
+//  outage_aggregator actor, merges outage summaries published by edge agents
+//  (subject outage-summary@site) into a global table of dead assets
+//
+//  Commands:
+//      CONNECT/endpoint/address    - connect to malamute
+//      CONSUMER/stream/pattern     - consume outage summaries
+//      STALE-MS/ms                 - site without summary for ms is reported STALE
+//      QUERY/query/args...         - reply with the result of query, see below
+//
+//  Queries, also answered on mailbox subject STATUS:
+//      SITES           - OK/site/dead count/sequence/SYNCED|STALE/age ms/...
+//      SITE/site       - OK/SYNCED|STALE/dead asset/... or ERROR/UNKNOWN-SITE
+//      ASSET/asset     - OK/DEAD|ALIVE/site where dead/...
+//      DEAD            - OK/count/dead asset/...
+FTY_OUTAGE_EXPORT void
+    outage_aggregator (zsock_t *pipe, void *args);
+
+//  Self test of this class
+FTY_OUTAGE_EXPORT void
+    outage_aggregator_test (bool verbose);
+
+//  @end
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
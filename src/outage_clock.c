@@ -0,0 +1,207 @@
+/*  =========================================================================
+    outage_clock - Injectable wall and monotonic clock
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    outage_clock - Injectable wall and monotonic clock
+@discuss
+    Metrics carry wall clock timestamps, but deadlines must not jump when
+    the wall clock is stepped. The clock keeps the offset between wall and
+    monotonic time seen at the last sync; a change of the offset larger
+    than CLOCK_STEP_THRESHOLD_MS is reported as a step, smaller changes
+    (NTP slewing) just update the mapping.
+
+    A simulated clock is used by tests and simulations, it never reads
+    the system time.
+@end
+*/
+
+#include "fty_outage_classes.h"
+
+#define CLOCK_STEP_THRESHOLD_MS 1000
+
+//  Structure of our class
+struct _outage_clock_t {
+    bool fake;              // simulated clock
+    int64_t fake_wall_ms;   // [ms] simulated wall time
+    int64_t fake_mono_ms;   // [ms] simulated monotonic time
+    int64_t offset_ms;      // [ms] wall - monotonic at the last sync
+};
+
+//  --------------------------------------------------------------------------
+//  Create a new clock reading system wall and monotonic time
+outage_clock_t *
+outage_clock_new (void)
+{
+    outage_clock_t *self = (outage_clock_t *) zmalloc (sizeof (outage_clock_t));
+    if (self) {
+        self->fake = false;
+        self->offset_ms = outage_clock_wall_ms (self) - outage_clock_mono_ms (self);
+    }
+    return self;
+}
+
+//  --------------------------------------------------------------------------
+//  Create a new simulated clock
+outage_clock_t *
+outage_clock_new_fake (int64_t wall_ms, int64_t mono_ms)
+{
+    outage_clock_t *self = (outage_clock_t *) zmalloc (sizeof (outage_clock_t));
+    if (self) {
+        self->fake = true;
+        self->fake_wall_ms = wall_ms;
+        self->fake_mono_ms = mono_ms;
+        self->offset_ms = wall_ms - mono_ms;
+    }
+    return self;
+}
+
+//  --------------------------------------------------------------------------
+//  Destroy the clock
+void
+outage_clock_destroy (outage_clock_t **self_p)
+{
+    assert (self_p);
+    if (*self_p) {
+        free (*self_p);
+        *self_p = NULL;
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Return wall clock time
+int64_t
+outage_clock_wall_ms (outage_clock_t *self)
+{
+    assert (self);
+    return self->fake ? self->fake_wall_ms : zclock_time ();
+}
+
+//  --------------------------------------------------------------------------
+//  Return monotonic time
+int64_t
+outage_clock_mono_ms (outage_clock_t *self)
+{
+    assert (self);
+    return self->fake ? self->fake_mono_ms : zclock_mono ();
+}
+
+//  --------------------------------------------------------------------------
+//  Simulated clock only: move both wall and monotonic time forward
+void
+outage_clock_advance (outage_clock_t *self, int64_t delta_ms)
+{
+    assert (self);
+    assert (self->fake);
+    assert (delta_ms >= 0);
+    self->fake_wall_ms += delta_ms;
+    self->fake_mono_ms += delta_ms;
+}
+
+//  --------------------------------------------------------------------------
+//  Simulated clock only: step wall time
+void
+outage_clock_step (outage_clock_t *self, int64_t delta_ms)
+{
+    assert (self);
+    assert (self->fake);
+    self->fake_wall_ms += delta_ms;
+}
+
+//  --------------------------------------------------------------------------
+//  Compare wall and monotonic time with the last sync and update the mapping
+int64_t
+outage_clock_sync (outage_clock_t *self)
+{
+    assert (self);
+    int64_t offset_ms = outage_clock_wall_ms (self) - outage_clock_mono_ms (self);
+    int64_t step_ms = offset_ms - self->offset_ms;
+    self->offset_ms = offset_ms;
+    if (step_ms > CLOCK_STEP_THRESHOLD_MS || step_ms < -CLOCK_STEP_THRESHOLD_MS)
+        return step_ms;
+    return 0;
+}
+
+//  --------------------------------------------------------------------------
+//  Convert wall time to the monotonic timeline
+int64_t
+outage_clock_wall_to_mono (outage_clock_t *self, int64_t wall_ms)
+{
+    assert (self);
+    return wall_ms - self->offset_ms;
+}
+
+//  --------------------------------------------------------------------------
+//  Convert monotonic time to wall time
+int64_t
+outage_clock_mono_to_wall (outage_clock_t *self, int64_t mono_ms)
+{
+    assert (self);
+    return mono_ms + self->offset_ms;
+}
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+void
+outage_clock_test (bool verbose)
+{
+    printf (" * outage_clock: ");
+
+    //  @selftest
+    outage_clock_t *self = outage_clock_new ();
+    assert (self);
+    int64_t wall_ms = outage_clock_wall_ms (self);
+    assert (wall_ms > 0);
+    assert (llabs (outage_clock_mono_to_wall (self, outage_clock_mono_ms (self)) - wall_ms) < 1000);
+    assert (outage_clock_sync (self) == 0);
+    outage_clock_destroy (&self);
+
+    self = outage_clock_new_fake (1000000, 5000);
+    assert (outage_clock_wall_ms (self) == 1000000);
+    assert (outage_clock_mono_ms (self) == 5000);
+    assert (outage_clock_wall_to_mono (self, 1000000) == 5000);
+
+    outage_clock_advance (self, 500);
+    assert (outage_clock_wall_ms (self) == 1000500);
+    assert (outage_clock_mono_ms (self) == 5500);
+    assert (outage_clock_sync (self) == 0);
+
+    // small correction is not a step
+    outage_clock_step (self, 200);
+    assert (outage_clock_sync (self) == 0);
+    assert (outage_clock_wall_to_mono (self, 1000700) == 5500);
+
+    // step forward and backward
+    outage_clock_step (self, 3600 * 1000);
+    assert (outage_clock_wall_to_mono (self, 1000700) == 5500);
+    assert (outage_clock_sync (self) == 3600 * 1000);
+    assert (outage_clock_sync (self) == 0);
+    assert (outage_clock_wall_to_mono (self, outage_clock_wall_ms (self)) == 5500);
+
+    outage_clock_step (self, -7200 * 1000);
+    assert (outage_clock_sync (self) == -7200 * 1000);
+    assert (outage_clock_mono_to_wall (self, 5500) == 1000700 - 3600 * 1000);
+
+    outage_clock_destroy (&self);
+    //  @end
+    printf ("OK\n");
+}
@@ -0,0 +1,88 @@
+/*  =========================================================================
+    outage_clock - Injectable wall and monotonic clock
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef OUTAGE_CLOCK_H_INCLUDED
+#define OUTAGE_CLOCK_H_INCLUDED
+
+#include "../include/fty_outage.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef OUTAGE_CLOCK_T_DEFINED
+typedef struct _outage_clock_t outage_clock_t;
+#define OUTAGE_CLOCK_T_DEFINED
+#endif
+
+//  @interface
+//  Create a new clock reading system wall and monotonic time
+FTY_OUTAGE_EXPORT outage_clock_t *
+    outage_clock_new (void);
+
+//  Create a new simulated clock, time moves only by advance/step
+FTY_OUTAGE_EXPORT outage_clock_t *
+    outage_clock_new_fake (int64_t wall_ms, int64_t mono_ms);
+
+//  Destroy the clock
+FTY_OUTAGE_EXPORT void
+    outage_clock_destroy (outage_clock_t **self_p);
+
+//  Return wall clock time [ms since epoch]
+FTY_OUTAGE_EXPORT int64_t
+    outage_clock_wall_ms (outage_clock_t *self);
+
+//  Return monotonic time [ms]
+FTY_OUTAGE_EXPORT int64_t
+    outage_clock_mono_ms (outage_clock_t *self);
+
+//  Simulated clock only: move both wall and monotonic time forward
+FTY_OUTAGE_EXPORT void
+    outage_clock_advance (outage_clock_t *self, int64_t delta_ms);
+
+//  Simulated clock only: step wall time (like NTP or an operator would do)
+FTY_OUTAGE_EXPORT void
+    outage_clock_step (outage_clock_t *self, int64_t delta_ms);
+
+//  Compare wall and monotonic time with the last sync and update the mapping
+//  return size of detected wall clock step [ms], 0 if there was none
+FTY_OUTAGE_EXPORT int64_t
+    outage_clock_sync (outage_clock_t *self);
+
+//  Convert wall time to the monotonic timeline using the last sync
+FTY_OUTAGE_EXPORT int64_t
+    outage_clock_wall_to_mono (outage_clock_t *self, int64_t wall_ms);
+
+//  Convert monotonic time to wall time using the last sync
+FTY_OUTAGE_EXPORT int64_t
+    outage_clock_mono_to_wall (outage_clock_t *self, int64_t mono_ms);
+
+//  Self test of this class
+FTY_OUTAGE_EXPORT void
+    outage_clock_test (bool verbose);
+
+//  @end
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,931 @@
+/*  =========================================================================
+    outage_history - Persistent history of outages with MTBF and MTTR per asset
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    outage_history - Persistent history of outages with MTBF and MTTR per asset
+@discuss
+    Outage of an asset starts when its ACTIVE alert is sent and ends when
+    it is RESOLVED. Both are appended to the file as fixed size binary
+    records, so the history survives restarts, an outage ongoing at
+    restart is ended by the next resolve. Running aggregates per asset
+    (number of outages, downtime, start of the ongoing outage) are kept in
+    memory and rebuilt from the file on start, MTBF and MTTR are derived
+    from them on query.
+
+    File starts with 64 bytes header (magic, version, record size and wall
+    time the history started) followed by the records. Once it holds more
+    records than configured, the older half is rolled up into one record
+    per asset, holding the number and downtime of its outages and span of
+    the last one, so the aggregates stay exact and the file bounded.
+    Assets with neither an ongoing outage nor a record in the newer half
+    are dropped then, so assets removed long ago do not stay in memory.
+    The rollup is done in steps of a few hundred records by following
+    appends, so a big file does not block the caller.
+@end
+*/
+
+#include <sys/stat.h>
+#include <fcntl.h>
+#include "fty_outage_classes.h"
+
+#define OUTAGE_HISTORY_MAGIC    "FTYOHST1"
+#define OUTAGE_HISTORY_VERSION  1
+#define READ_CHUNK              64      // records read at once
+#define ROLLUP_STEP             256     // records rolled up at once
+
+//  Phases of the rollup, in order
+#define ROLLUP_ADD              0       // sum up records of the older part
+#define ROLLUP_SCAN             1       // find assets with records in the retained part
+#define ROLLUP_HEADER           2
+#define ROLLUP_WRITE_ROLLUPS    3
+#define ROLLUP_WRITE_OPENS      4
+#define ROLLUP_COPY             5       // copy the retained part and records appended since
+
+static void *SEEN = (void*) "seen";     // value of assets in the retained part
+
+typedef struct _outage_history_header_t {
+    char magic [8];
+    uint32_t version;
+    uint32_t record_size;
+    int64_t since_ms;           // wall time the history started
+    char reserved [40];
+} outage_history_header_t;
+
+//  Running aggregates of an asset, with its name in the same block
+typedef struct _asset_t {
+    asset_key_t key;            // key of the asset in the table
+    uint32_t count;             // ended outages
+    int64_t downtime_ms;        // [ms] downtime of ended outages
+    int64_t last_ms;            // [ms] wall time the last outage started
+    int64_t open_ms;            // [ms] wall time the ongoing outage started, 0 if none
+    char name [OUTAGE_HISTORY_ASSET_SIZE];
+} asset_t;
+
+//  Rollup in progress, done in steps
+typedef struct _rollup_t {
+    int phase;                  // ROLLUP_*
+    size_t index;               // next record of the file to read
+    size_t rolled;              // records of the older part
+    size_t scanned;             // end of the retained part at start
+    size_t records;             // records written into the new file
+    size_t dropped;             // assets without outage in the retained part
+    zhashx_t *rollups;          // asset_key_t => record summing its ended outages
+    zhashx_t *opens;            // asset_key_t => record of its last started outage
+    zhashx_t *seen;             // asset_key_t => SEEN if it has a record in the retained part
+    const outage_history_record_t *cursor;  // next record to write
+    char *path;
+    int fd;                     // the new file
+} rollup_t;
+
+//  Structure of our class
+struct _outage_history_t {
+    char *path;
+    int fd;                     // appended to, -1 if the file can't be written
+    size_t max_records;         // rollup once the file holds more
+    size_t records;             // records in the file
+    int64_t since_ms;           // [ms] wall time the history started
+    zhashx_t *assets;           // asset_key_t => asset_t, keys live in the items
+    rollup_t *rollup;           // rollup in progress, NULL if none
+    outage_clock_t *clock;
+};
+
+static void
+s_free (void **item_p)
+{
+    free (*item_p);
+    *item_p = NULL;
+}
+
+// end the rollup, the file stays as it is unless it was replaced already
+static void
+s_rollup_destroy (outage_history_t *self, bool failed)
+{
+    rollup_t *rollup = self->rollup;
+    if (!rollup)
+        return;
+    if (failed)
+        log_error ("Can't roll outage history %s up: %m", self->path);
+    if (rollup->fd != -1)
+        close (rollup->fd);
+    if (rollup->path)
+        unlink (rollup->path);
+    zstr_free (&rollup->path);
+    zhashx_destroy (&rollup->rollups);
+    zhashx_destroy (&rollup->opens);
+    zhashx_destroy (&rollup->seen);
+    free (rollup);
+    self->rollup = NULL;
+}
+
+//  --------------------------------------------------------------------------
+//  Destroy the history
+void
+outage_history_destroy (outage_history_t **self_p)
+{
+    assert (self_p);
+    if (*self_p) {
+        outage_history_t *self = *self_p;
+        s_rollup_destroy (self, false);
+        if (self->fd != -1)
+            close (self->fd);
+        zhashx_destroy (&self->assets);
+        zstr_free (&self->path);
+        free (self);
+        *self_p = NULL;
+    }
+}
+
+// key of the name as stored in records, truncated one is set up in buffer
+static const asset_key_t *
+s_key (const asset_key_t *key, char *buffer, asset_key_t *truncated)
+{
+    if (key->length < OUTAGE_HISTORY_ASSET_SIZE)
+        return key;
+    memcpy (buffer, key->name, OUTAGE_HISTORY_ASSET_SIZE - 1);
+    buffer [OUTAGE_HISTORY_ASSET_SIZE - 1] = '\0';
+    asset_key_init (truncated, buffer);
+    return truncated;
+}
+
+// return aggregates of the asset, created if needed, NULL on memory error
+static asset_t *
+s_asset (outage_history_t *self, const asset_key_t *key)
+{
+    asset_t *asset = (asset_t *) zhashx_lookup (self->assets, key);
+    if (!asset) {
+        asset = (asset_t *) zmalloc (sizeof (asset_t));
+        if (asset) {
+            memcpy (asset->name, key->name, key->length + 1);
+            asset->key = *key;
+            asset->key.name = asset->name;
+            zhashx_insert (self->assets, &asset->key, asset);
+        }
+    }
+    return asset;
+}
+
+// update aggregates by record read from the file
+static void
+s_apply (outage_history_t *self, const outage_history_record_t *record)
+{
+    char name [OUTAGE_HISTORY_ASSET_SIZE];
+    memcpy (name, record->asset, sizeof (name));
+    name [sizeof (name) - 1] = '\0';
+    asset_key_t key;
+    asset_key_init (&key, name);
+    asset_t *asset = s_asset (self, &key);
+    if (!asset)
+        return;
+    if (record->count == 0)
+        asset->open_ms = record->start_ms;
+    else {
+        asset->count += record->count;
+        asset->downtime_ms += record->downtime_ms;
+        // end of the ongoing outage, or of a later one
+        if (asset->open_ms && asset->open_ms <= record->start_ms)
+            asset->open_ms = 0;
+    }
+    if (record->start_ms > asset->last_ms)
+        asset->last_ms = record->start_ms;
+}
+
+// write all of the buffer, return -1 on error
+static int
+s_write (int fd, const void *buffer, size_t size)
+{
+    const char *data = (const char *) buffer;
+    while (size > 0) {
+        ssize_t written = write (fd, data, size);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            return -1;
+        data += written;
+        size -= (size_t) written;
+    }
+    return 0;
+}
+
+// read index-th to (index + count)-th record, return number of records read
+static size_t
+s_read (int fd, size_t index, size_t count, outage_history_record_t *records)
+{
+    off_t offset = (off_t) (sizeof (outage_history_header_t) + index * sizeof (outage_history_record_t));
+    ssize_t bytes = pread (fd, records, count * sizeof (outage_history_record_t), offset);
+    return bytes > 0 ? (size_t) bytes / sizeof (outage_history_record_t) : 0;
+}
+
+static void
+s_record_init (outage_history_record_t *record, const asset_key_t *key, int64_t start_ms, int64_t end_ms, int64_t downtime_ms, uint32_t count)
+{
+    memset (record, 0, sizeof (outage_history_record_t));
+    record->start_ms = start_ms;
+    record->end_ms = end_ms;
+    record->downtime_ms = downtime_ms;
+    record->count = count;
+    memcpy (record->asset, key->name, key->length < OUTAGE_HISTORY_ASSET_SIZE ? key->length : OUTAGE_HISTORY_ASSET_SIZE - 1);
+}
+
+// name of the record as a key, name is set up in buffer
+static void
+s_record_key (const outage_history_record_t *record, char *buffer, asset_key_t *key)
+{
+    memcpy (buffer, record->asset, OUTAGE_HISTORY_ASSET_SIZE);
+    buffer [OUTAGE_HISTORY_ASSET_SIZE - 1] = '\0';
+    asset_key_init (key, buffer);
+}
+
+// start to roll the older half of the file up, return -1 on error
+static int
+s_rollup_start (outage_history_t *self)
+{
+    rollup_t *rollup = (rollup_t *) zmalloc (sizeof (rollup_t));
+    if (!rollup)
+        return -1;
+    self->rollup = rollup;
+    rollup->fd = -1;
+    rollup->rolled = self->records - self->max_records / 2;
+    rollup->scanned = self->records;
+    rollup->rollups = asset_key_hash_new (true);
+    rollup->opens = asset_key_hash_new (true);
+    rollup->seen = asset_key_hash_new (true);
+    rollup->path = zsys_sprintf ("%s.rollup", self->path);
+    if (rollup->path)
+        rollup->fd = open (rollup->path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0640);
+    if (!rollup->rollups || !rollup->opens || !rollup->seen || rollup->fd == -1) {
+        s_rollup_destroy (self, true);
+        return -1;
+    }
+    zhashx_set_destructor (rollup->rollups, s_free);
+    zhashx_set_destructor (rollup->opens, s_free);
+    return 0;
+}
+
+// add record of the older part to the rollup of its asset, return -1 on error
+static int
+s_rollup_add (rollup_t *rollup, const outage_history_record_t *record)
+{
+    char name [OUTAGE_HISTORY_ASSET_SIZE];
+    asset_key_t key;
+    s_record_key (record, name, &key);
+    if (record->count == 0) {
+        // the last start of an outage, it is kept if the outage still goes on
+        outage_history_record_t *open = (outage_history_record_t *) zhashx_lookup (rollup->opens, &key);
+        if (!open) {
+            open = (outage_history_record_t *) malloc (sizeof (outage_history_record_t));
+            if (!open)
+                return -1;
+            zhashx_insert (rollup->opens, &key, open);
+        }
+        *open = *record;
+        return 0;
+    }
+    outage_history_record_t *sum = (outage_history_record_t *) zhashx_lookup (rollup->rollups, &key);
+    if (!sum) {
+        sum = (outage_history_record_t *) zmalloc (sizeof (outage_history_record_t));
+        if (!sum)
+            return -1;
+        memcpy (sum->asset, record->asset, sizeof (sum->asset));
+        zhashx_insert (rollup->rollups, &key, sum);
+    }
+    sum->count += record->count;
+    sum->downtime_ms += record->downtime_ms;
+    if (record->start_ms >= sum->start_ms) {
+        sum->start_ms = record->start_ms;
+        sum->end_ms = record->end_ms;
+    }
+    return 0;
+}
+
+// asset of the record has a record in the retained part of the file
+static void
+s_rollup_see (rollup_t *rollup, const outage_history_record_t *record)
+{
+    char name [OUTAGE_HISTORY_ASSET_SIZE];
+    asset_key_t key;
+    s_record_key (record, name, &key);
+    zhashx_update (rollup->seen, &key, SEEN);
+}
+
+// write rolled up record of an asset which is still tracked, aggregates of
+// an asset without outage in the retained part are dropped with it
+static int
+s_rollup_write (outage_history_t *self, const outage_history_record_t *record)
+{
+    rollup_t *rollup = self->rollup;
+    char name [OUTAGE_HISTORY_ASSET_SIZE];
+    asset_key_t key;
+    s_record_key (record, name, &key);
+    asset_t *asset = (asset_t *) zhashx_lookup (self->assets, &key);
+    if (record->count == 0) {
+        if (!asset || asset->open_ms != record->start_ms)
+            return 0;
+    }
+    else
+    if (!zhashx_lookup (rollup->seen, &key) && !(asset && asset->open_ms)) {
+        zhashx_delete (self->assets, &key);
+        rollup->dropped++;
+        return 0;
+    }
+    if (s_write (rollup->fd, record, sizeof (outage_history_record_t)) != 0)
+        return -1;
+    rollup->records++;
+    return 0;
+}
+
+// replace the file by the rolled up one, return -1 on error
+static int
+s_rollup_finish (outage_history_t *self)
+{
+    rollup_t *rollup = self->rollup;
+    if (fsync (rollup->fd) != 0 || rename (rollup->path, self->path) != 0)
+        return -1;
+    log_info ("outage history %s: %zu records rolled up into %zu, %zu assets dropped",
+        self->path, rollup->rolled, zhashx_size (rollup->rollups) - rollup->dropped, rollup->dropped);
+    close (self->fd);
+    self->fd = open (self->path, O_RDWR | O_APPEND | O_CLOEXEC);
+    self->records = rollup->records;
+    if (self->fd == -1)
+        log_error ("Can't open outage history %s: %m", self->path);
+    s_rollup_destroy (self, false);
+    return 0;
+}
+
+//  --------------------------------------------------------------------------
+//  roll the older part of the file up into one record per asset, and one
+//  more for its ongoing outage, the rest is copied as it is into new file
+//  replacing the old one. Each call reads or writes about ROLLUP_STEP
+//  records, so a big file does not stall the caller, records appended
+//  meanwhile go to the old file and are copied at the end.
+//  Return -1 on error, the rollup is abandoned then
+static int
+s_rollup_step (outage_history_t *self)
+{
+    rollup_t *rollup = self->rollup;
+    outage_history_record_t chunk [READ_CHUNK];
+    size_t budget = ROLLUP_STEP;
+    while (budget > 0) {
+        if (rollup->phase == ROLLUP_ADD || rollup->phase == ROLLUP_SCAN) {
+            size_t end = rollup->phase == ROLLUP_ADD ? rollup->rolled : rollup->scanned;
+            if (rollup->index == end) {
+                rollup->phase++;
+                continue;
+            }
+            size_t count = s_read (self->fd, rollup->index, end - rollup->index < READ_CHUNK ? end - rollup->index : READ_CHUNK, chunk);
+            if (count == 0)
+                goto error;
+            for (size_t i = 0; i < count; i++) {
+                if (rollup->phase == ROLLUP_SCAN)
+                    s_rollup_see (rollup, &chunk [i]);
+                else
+                if (s_rollup_add (rollup, &chunk [i]) != 0)
+                    goto error;
+            }
+            rollup->index += count;
+            budget -= count < budget ? count : budget;
+        }
+        else
+        if (rollup->phase == ROLLUP_HEADER) {
+            outage_history_header_t header;
+            memset (&header, 0, sizeof (header));
+            memcpy (header.magic, OUTAGE_HISTORY_MAGIC, sizeof (header.magic));
+            header.version = OUTAGE_HISTORY_VERSION;
+            header.record_size = sizeof (outage_history_record_t);
+            header.since_ms = self->since_ms;
+            if (s_write (rollup->fd, &header, sizeof (header)) != 0)
+                goto error;
+            rollup->cursor = (const outage_history_record_t *) zhashx_first (rollup->rollups);
+            rollup->phase++;
+        }
+        else
+        if (rollup->phase == ROLLUP_WRITE_ROLLUPS || rollup->phase == ROLLUP_WRITE_OPENS) {
+            zhashx_t *part = rollup->phase == ROLLUP_WRITE_ROLLUPS ? rollup->rollups : rollup->opens;
+            if (!rollup->cursor) {
+                rollup->phase++;
+                if (rollup->phase == ROLLUP_WRITE_OPENS)
+                    rollup->cursor = (const outage_history_record_t *) zhashx_first (rollup->opens);
+                else
+                    rollup->index = rollup->rolled;
+                continue;
+            }
+            if (s_rollup_write (self, rollup->cursor) != 0)
+                goto error;
+            rollup->cursor = (const outage_history_record_t *) zhashx_next (part);
+            budget--;
+        }
+        else {
+            // copy the retained part, including records appended meanwhile
+            if (rollup->index == self->records) {
+                if (s_rollup_finish (self) != 0)
+                    goto error;
+                return 0;
+            }
+            size_t count = s_read (self->fd, rollup->index, self->records - rollup->index < READ_CHUNK ? self->records - rollup->index : READ_CHUNK, chunk);
+            if (count == 0 || s_write (rollup->fd, chunk, count * sizeof (outage_history_record_t)) != 0)
+                goto error;
+            rollup->index += count;
+            rollup->records += count;
+            budget -= count < budget ? count : budget;
+        }
+    }
+    return 0;
+error:
+    s_rollup_destroy (self, true);
+    return -1;
+}
+
+// append record to the file, roll it up in steps once it grows over the limit
+static void
+s_append (outage_history_t *self, const outage_history_record_t *record)
+{
+    if (self->fd == -1)
+        return;
+    if (s_write (self->fd, record, sizeof (outage_history_record_t)) != 0) {
+        log_error ("Can't write outage history %s: %m", self->path);
+        // a torn record would shift all following ones
+        if (ftruncate (self->fd, (off_t) (sizeof (outage_history_header_t) + self->records * sizeof (outage_history_record_t))) != 0)
+            log_error ("Can't truncate outage history %s: %m", self->path);
+        return;
+    }
+    self->records++;
+    if (self->rollup)
+        s_rollup_see (self->rollup, record);
+    else
+    if (self->records > self->max_records && s_rollup_start (self) != 0)
+        return;
+    if (self->rollup)
+        s_rollup_step (self);
+}
+
+//  --------------------------------------------------------------------------
+//  Create or continue the history in file 'path'
+outage_history_t *
+outage_history_new (const char *path, size_t records, outage_clock_t *clock)
+{
+    assert (path);
+    assert (records > 1);
+    assert (clock);
+
+    outage_history_t *self = (outage_history_t *) zmalloc (sizeof (outage_history_t));
+    if (!self)
+        return NULL;
+    self->clock = clock;
+    self->max_records = records;
+    self->path = strdup (path);
+    self->assets = asset_key_hash_new (false);
+    self->fd = open (path, O_RDWR | O_APPEND | O_CREAT | O_CLOEXEC, 0640);
+    if (!self->path || !self->assets || self->fd == -1) {
+        log_error ("Can't open outage history %s: %m", path);
+        outage_history_destroy (&self);
+        return NULL;
+    }
+    zhashx_set_destructor (self->assets, s_free);
+
+    outage_history_header_t header;
+    struct stat st;
+    bool valid = fstat (self->fd, &st) == 0
+        && (size_t) st.st_size >= sizeof (header)
+        && pread (self->fd, &header, sizeof (header), 0) == (ssize_t) sizeof (header)
+        && memcmp (header.magic, OUTAGE_HISTORY_MAGIC, sizeof (header.magic)) == 0
+        && header.version == OUTAGE_HISTORY_VERSION
+        && header.record_size == sizeof (outage_history_record_t);
+    if (!valid) {
+        memset (&header, 0, sizeof (header));
+        memcpy (header.magic, OUTAGE_HISTORY_MAGIC, sizeof (header.magic));
+        header.version = OUTAGE_HISTORY_VERSION;
+        header.record_size = sizeof (outage_history_record_t);
+        header.since_ms = outage_clock_wall_ms (clock);
+        if (ftruncate (self->fd, 0) != 0 || s_write (self->fd, &header, sizeof (header)) != 0) {
+            log_error ("Can't write outage history %s: %m", path);
+            outage_history_destroy (&self);
+            return NULL;
+        }
+        st.st_size = sizeof (header);
+    }
+    self->since_ms = header.since_ms;
+
+    // a record torn by crash is dropped
+    size_t size = ((size_t) st.st_size - sizeof (header)) / sizeof (outage_history_record_t);
+    if (sizeof (header) + size * sizeof (outage_history_record_t) != (size_t) st.st_size
+    &&  ftruncate (self->fd, (off_t) (sizeof (header) + size * sizeof (outage_history_record_t))) != 0)
+        log_error ("Can't truncate outage history %s: %m", path);
+    outage_history_record_t chunk [READ_CHUNK];
+    while (self->records < size) {
+        size_t count = s_read (self->fd, self->records, size - self->records < READ_CHUNK ? size - self->records : READ_CHUNK, chunk);
+        if (count == 0)
+            break;
+        for (size_t i = 0; i < count; i++)
+            s_apply (self, &chunk [i]);
+        self->records += count;
+    }
+    log_info ("outage history %s: %zu records of %zu assets", path, self->records, zhashx_size (self->assets));
+    if (self->records > self->max_records && s_rollup_start (self) == 0)
+        while (self->rollup)
+            s_rollup_step (self);
+    return self;
+}
+
+//  --------------------------------------------------------------------------
+//  Record start of outage of the asset
+int
+outage_history_start (outage_history_t *self, const asset_key_t *key)
+{
+    assert (self);
+    assert (key);
+
+    char buffer [OUTAGE_HISTORY_ASSET_SIZE];
+    asset_key_t truncated;
+    key = s_key (key, buffer, &truncated);
+    asset_t *asset = s_asset (self, key);
+    if (!asset || asset->open_ms)
+        return -1;
+    asset->open_ms = outage_clock_wall_ms (self->clock);
+    asset->last_ms = asset->open_ms;
+    outage_history_record_t record;
+    s_record_init (&record, key, asset->open_ms, 0, 0, 0);
+    s_append (self, &record);
+    return 0;
+}
+
+//  --------------------------------------------------------------------------
+//  Record end of outage of the asset
+int
+outage_history_end (outage_history_t *self, const asset_key_t *key)
+{
+    assert (self);
+    assert (key);
+
+    char buffer [OUTAGE_HISTORY_ASSET_SIZE];
+    asset_key_t truncated;
+    key = s_key (key, buffer, &truncated);
+    asset_t *asset = (asset_t *) zhashx_lookup (self->assets, key);
+    if (!asset || !asset->open_ms)
+        return -1;
+    int64_t end_ms = outage_clock_wall_ms (self->clock);
+    int64_t downtime_ms = end_ms > asset->open_ms ? end_ms - asset->open_ms : 0;
+    outage_history_record_t record;
+    s_record_init (&record, key, asset->open_ms, end_ms, downtime_ms, 1);
+    asset->count++;
+    asset->downtime_ms += downtime_ms;
+    asset->open_ms = 0;
+    s_append (self, &record);
+    return 0;
+}
+
+// derive statistics from aggregates
+static void
+s_stats (outage_history_t *self, const asset_t *asset, int64_t now_ms, outage_history_stats_t *stats)
+{
+    stats->asset = asset->name;
+    stats->down = asset->open_ms != 0;
+    stats->outages = asset->count + (stats->down ? 1 : 0);
+    stats->downtime_ms = asset->downtime_ms;
+    if (stats->down && now_ms > asset->open_ms)
+        stats->downtime_ms += now_ms - asset->open_ms;
+    stats->mttr_ms = asset->count ? asset->downtime_ms / asset->count : 0;
+    int64_t uptime_ms = now_ms - self->since_ms - stats->downtime_ms;
+    stats->mtbf_ms = stats->outages && uptime_ms > 0 ? uptime_ms / stats->outages : 0;
+    stats->last_ms = asset->last_ms;
+}
+
+//  --------------------------------------------------------------------------
+//  Fill running aggregates of the asset
+int
+outage_history_stats (outage_history_t *self, const asset_key_t *key, outage_history_stats_t *stats)
+{
+    assert (self);
+    assert (key);
+    assert (stats);
+
+    char buffer [OUTAGE_HISTORY_ASSET_SIZE];
+    asset_key_t truncated;
+    key = s_key (key, buffer, &truncated);
+    const asset_t *asset = (const asset_t *) zhashx_lookup (self->assets, key);
+    if (!asset)
+        return -1;
+    s_stats (self, asset, outage_clock_wall_ms (self->clock), stats);
+    return 0;
+}
+
+// true if a is better (less worth of attention) than b
+static bool
+s_better (const outage_history_stats_t *a, const outage_history_stats_t *b, int by)
+{
+    int64_t a1 = by == OUTAGE_HISTORY_BY_DOWNTIME ? a->downtime_ms : a->outages;
+    int64_t b1 = by == OUTAGE_HISTORY_BY_DOWNTIME ? b->downtime_ms : b->outages;
+    if (a1 != b1)
+        return a1 < b1;
+    int64_t a2 = by == OUTAGE_HISTORY_BY_DOWNTIME ? a->outages : a->downtime_ms;
+    int64_t b2 = by == OUTAGE_HISTORY_BY_DOWNTIME ? b->outages : b->downtime_ms;
+    return a2 < b2;
+}
+
+// restore order of heap with the best asset on top, broken at index
+static void
+s_sift_down (outage_history_stats_t *heap, size_t size, size_t index, int by)
+{
+    while (true) {
+        size_t best = index;
+        size_t left = 2 * index + 1;
+        size_t right = left + 1;
+        if (left < size && s_better (&heap [left], &heap [best], by))
+            best = left;
+        if (right < size && s_better (&heap [right], &heap [best], by))
+            best = right;
+        if (best == index)
+            return;
+        outage_history_stats_t swap = heap [index];
+        heap [index] = heap [best];
+        heap [best] = swap;
+        index = best;
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Fill up to 'count' worst assets. Stats serves as a heap with the best
+//  of the worst on top, so one pass over assets is O(assets * log count).
+size_t
+outage_history_top (outage_history_t *self, size_t count, int by, outage_history_stats_t *stats)
+{
+    assert (self);
+    assert (stats || count == 0);
+
+    int64_t now_ms = outage_clock_wall_ms (self->clock);
+    size_t size = 0;
+    for (const asset_t *asset = (const asset_t *) zhashx_first (self->assets);
+                        asset != NULL && count > 0;
+                        asset = (const asset_t *) zhashx_next (self->assets))
+    {
+        outage_history_stats_t candidate;
+        s_stats (self, asset, now_ms, &candidate);
+        if (size < count) {
+            stats [size++] = candidate;
+            if (size == count)
+                for (size_t i = size / 2; i-- > 0; )
+                    s_sift_down (stats, size, i, by);
+        }
+        else
+        if (s_better (&stats [0], &candidate, by)) {
+            stats [0] = candidate;
+            s_sift_down (stats, size, 0, by);
+        }
+    }
+    if (size < count)
+        for (size_t i = size / 2; i-- > 0; )
+            s_sift_down (stats, size, i, by);
+    // heap sort, the best goes to the end, the worst stays first
+    for (size_t end = size; end > 1; end--) {
+        outage_history_stats_t swap = stats [0];
+        stats [0] = stats [end - 1];
+        stats [end - 1] = swap;
+        s_sift_down (stats, end - 1, 0, by);
+    }
+    return size;
+}
+
+//  --------------------------------------------------------------------------
+//  Return number of assets with an outage
+size_t
+outage_history_size (outage_history_t *self)
+{
+    assert (self);
+    return zhashx_size (self->assets);
+}
+
+//  --------------------------------------------------------------------------
+//  Return number of records in the file
+size_t
+outage_history_records (outage_history_t *self)
+{
+    assert (self);
+    return self->records;
+}
+
+//  --------------------------------------------------------------------------
+//  Return bytes of heap memory held by the history
+size_t
+outage_history_memory (outage_history_t *self)
+{
+    assert (self);
+    size_t size = zhashx_size (self->assets);
+    size_t bytes = memory_usage_block (sizeof (outage_history_t))
+        + memory_usage_string (self->path)
+        + memory_usage_hash (size)
+        + size * memory_usage_block (sizeof (asset_t));
+    if (self->rollup) {
+        size_t records = zhashx_size (self->rollup->rollups) + zhashx_size (self->rollup->opens);
+        bytes += memory_usage_block (sizeof (rollup_t))
+            + memory_usage_string (self->rollup->path)
+            + memory_usage_hash (zhashx_size (self->rollup->rollups))
+            + memory_usage_hash (zhashx_size (self->rollup->opens))
+            + memory_usage_hash (zhashx_size (self->rollup->seen))
+            + records * memory_usage_block (sizeof (outage_history_record_t));
+    }
+    return bytes;
+}
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+void
+outage_history_test (bool verbose)
+{
+    printf (" * outage_history: ");
+
+    //  @selftest
+    const char *path = "src/selftest-rw/outage_history.dat";
+    assert (sizeof (outage_history_header_t) == 64);
+    assert (sizeof (outage_history_record_t) == 64);
+    unlink (path);
+
+    int64_t since_ms = (int64_t) 1500000000 * 1000;
+    outage_clock_t *clock = outage_clock_new_fake (since_ms, 1000);
+    outage_history_t *self = outage_history_new (path, 8, clock);
+    assert (self);
+    assert (outage_history_size (self) == 0);
+    assert (outage_history_records (self) == 0);
+
+    asset_key_t ups, epdu, sts;
+    asset_key_init (&ups, "ups-1");
+    asset_key_init (&epdu, "epdu-1");
+    asset_key_init (&sts, "sts-with-very-long-name-which-does-not-fit-into-the-record");
+    outage_history_stats_t stats;
+    assert (outage_history_stats (self, &ups, &stats) == -1);
+    assert (outage_history_end (self, &ups) == -1);
+
+    // one ended outage of a minute
+    outage_clock_advance (clock, 3600 * 1000);
+    assert (outage_history_start (self, &ups) == 0);
+    assert (outage_history_start (self, &ups) == -1);
+    outage_clock_advance (clock, 60 * 1000);
+    assert (outage_history_end (self, &ups) == 0);
+    assert (outage_history_end (self, &ups) == -1);
+    assert (outage_history_records (self) == 2);
+    assert (outage_history_stats (self, &ups, &stats) == 0);
+    assert (streq (stats.asset, "ups-1"));
+    assert (stats.outages == 1 && !stats.down);
+    assert (stats.downtime_ms == 60 * 1000);
+    assert (stats.mttr_ms == 60 * 1000);
+    assert (stats.mtbf_ms == 3600 * 1000);
+
+    // ongoing outage counts till now, but not into mttr
+    assert (outage_history_start (self, &epdu) == 0);
+    outage_clock_advance (clock, 10 * 1000);
+    assert (outage_history_stats (self, &epdu, &stats) == 0);
+    assert (stats.outages == 1 && stats.down);
+    assert (stats.downtime_ms == 10 * 1000 && stats.mttr_ms == 0);
+
+    // two more outages of ups-1, long name is truncated
+    for (int i = 0; i < 2; i++) {
+        assert (outage_history_start (self, &ups) == 0);
+        outage_clock_advance (clock, 30 * 1000);
+        assert (outage_history_end (self, &ups) == 0);
+    }
+    assert (outage_history_start (self, &sts) == 0);
+    outage_clock_advance (clock, 1000);
+    assert (outage_history_end (self, &sts) == 0);
+    assert (outage_history_stats (self, &sts, &stats) == 0);
+    assert (strlen (stats.asset) == OUTAGE_HISTORY_ASSET_SIZE - 1);
+    assert (outage_history_size (self) == 3);
+    // ninth record rolled up the older five: two outages of ups-1 into
+    // one record, start of ongoing outage of epdu-1 is kept
+    assert (outage_history_records (self) == 6);
+
+    outage_history_stats_t top [4];
+    assert (outage_history_top (self, 4, OUTAGE_HISTORY_BY_COUNT, top) == 3);
+    assert (streq (top [0].asset, "ups-1") && top [0].outages == 3);
+    assert (top [0].downtime_ms == 120 * 1000);
+    assert (streq (top [1].asset, "epdu-1"));
+    assert (top [2].outages == 1 && top [2].downtime_ms == 1000);
+    assert (outage_history_top (self, 1, OUTAGE_HISTORY_BY_DOWNTIME, top) == 1);
+    assert (streq (top [0].asset, "ups-1"));
+    // epdu-1 has been down for 71 s since
+    assert (outage_history_top (self, 2, OUTAGE_HISTORY_BY_DOWNTIME, top) == 2);
+    assert (streq (top [1].asset, "epdu-1") && top [1].downtime_ms == 71 * 1000);
+    assert (outage_history_top (self, 0, OUTAGE_HISTORY_BY_COUNT, NULL) == 0);
+    assert (outage_history_memory (self) > 3 * sizeof (outage_history_record_t));
+    outage_history_destroy (&self);
+
+    // aggregates are rebuilt after restart, ongoing outage continues
+    self = outage_history_new (path, 8, clock);
+    assert (self);
+    assert (outage_history_records (self) == 6);
+    assert (outage_history_stats (self, &ups, &stats) == 0);
+    assert (stats.outages == 3 && stats.downtime_ms == 120 * 1000);
+    assert (outage_history_stats (self, &epdu, &stats) == 0);
+    assert (stats.down);
+
+    // older half is rolled up, the aggregates stay exact
+    assert (outage_history_start (self, &sts) == 0);
+    assert (outage_history_records (self) <= 8);
+    for (int i = 0; i < 20; i++) {
+        assert (outage_history_start (self, &ups) == 0);
+        outage_clock_advance (clock, 1000);
+        assert (outage_history_end (self, &ups) == 0);
+        assert (outage_history_records (self) <= 8);
+    }
+    assert (outage_history_stats (self, &ups, &stats) == 0);
+    assert (stats.outages == 23 && stats.downtime_ms == 140 * 1000);
+    assert (outage_history_stats (self, &epdu, &stats) == 0);
+    assert (stats.outages == 1 && stats.down);
+    outage_history_destroy (&self);
+
+    self = outage_history_new (path, 8, clock);
+    assert (outage_history_size (self) == 3);
+    assert (outage_history_stats (self, &ups, &stats) == 0);
+    assert (stats.outages == 23 && stats.downtime_ms == 140 * 1000 && !stats.down);
+    assert (stats.mttr_ms == 140 * 1000 / 23);
+    assert (outage_history_stats (self, &sts, &stats) == 0);
+    assert (stats.outages == 2 && stats.down);
+    assert (outage_history_end (self, &epdu) == 0);
+    assert (outage_history_stats (self, &epdu, &stats) == 0);
+    assert (stats.outages == 1 && !stats.down && stats.mttr_ms == 91 * 1000);
+    outage_history_destroy (&self);
+
+    // torn record is dropped, other file is replaced
+    FILE *file = fopen (path, "a");
+    assert (file);
+    fputs ("torn", file);
+    fclose (file);
+    self = outage_history_new (path, 8, clock);
+    assert (outage_history_size (self) == 3);
+    assert (outage_history_end (self, &sts) == 0);
+
+    // assets without outage in the retained half are dropped by the rollup,
+    // from the aggregates and the file
+    for (int i = 0; i < 10; i++) {
+        assert (outage_history_start (self, &ups) == 0);
+        assert (outage_history_end (self, &ups) == 0);
+    }
+    assert (outage_history_size (self) == 1);
+    assert (outage_history_stats (self, &epdu, &stats) == -1);
+    assert (outage_history_stats (self, &sts, &stats) == -1);
+    assert (outage_history_stats (self, &ups, &stats) == 0);
+    assert (stats.outages == 33);
+    outage_history_destroy (&self);
+    self = outage_history_new (path, 8, clock);
+    assert (outage_history_size (self) == 1);
+    assert (outage_history_stats (self, &ups, &stats) == 0);
+    assert (stats.outages == 33 && stats.downtime_ms == 140 * 1000);
+    outage_history_destroy (&self);
+    file = fopen (path, "w");
+    assert (file);
+    fputs ("this is not an outage history", file);
+    fclose (file);
+    self = outage_history_new (path, 8, clock);
+    assert (self);
+    assert (outage_history_size (self) == 0);
+    outage_history_destroy (&self);
+
+    // big file is rolled up in steps of following appends, which are kept
+    unlink (path);
+    self = outage_history_new (path, 1024, clock);
+    assert (self);
+    for (int i = 0; i < 512; i++) {
+        assert (outage_history_start (self, &ups) == 0);
+        assert (outage_history_end (self, &ups) == 0);
+    }
+    assert (outage_history_start (self, &epdu) == 0);
+    assert (outage_history_records (self) == 1025);
+    size_t appended = 0;
+    while (outage_history_records (self) > 1024) {
+        assert (outage_history_start (self, &ups) == 0);
+        assert (outage_history_end (self, &ups) == 0);
+        appended++;
+    }
+    assert (appended > 1);
+    assert (outage_history_stats (self, &ups, &stats) == 0);
+    assert (stats.outages == 512 + appended);
+    outage_history_destroy (&self);
+    self = outage_history_new (path, 1024, clock);
+    assert (outage_history_size (self) == 2);
+    assert (outage_history_stats (self, &ups, &stats) == 0);
+    assert (stats.outages == 512 + appended);
+    assert (outage_history_stats (self, &epdu, &stats) == 0);
+    assert (stats.down);
+    outage_history_destroy (&self);
+
+    unlink (path);
+    outage_clock_destroy (&clock);
+    //  @end
+    printf ("OK\n");
+}
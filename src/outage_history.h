@@ -0,0 +1,118 @@
+/*  =========================================================================
+    outage_history - Persistent history of outages with MTBF and MTTR per asset
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef OUTAGE_HISTORY_H_INCLUDED
+#define OUTAGE_HISTORY_H_INCLUDED
+
+#include "../include/fty_outage.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef OUTAGE_HISTORY_T_DEFINED
+typedef struct _outage_history_t outage_history_t;
+#define OUTAGE_HISTORY_T_DEFINED
+#endif
+
+#define OUTAGE_HISTORY_ASSET_SIZE   36  //  asset names are truncated to 35 characters
+
+//  Order of outage_history_top
+#define OUTAGE_HISTORY_BY_COUNT     0   //  most outages first
+#define OUTAGE_HISTORY_BY_DOWNTIME  1   //  longest downtime first
+
+//  One record of the file, stored as is. Start of an outage is recorded
+//  with count 0, its end with count 1 repeating the start, old records
+//  are rolled up into one per asset with count of outages they held.
+typedef struct _outage_history_record_t {
+    int64_t start_ms;               //  [ms] wall time the (first) outage started
+    int64_t end_ms;                 //  [ms] wall time the (last) outage ended, 0 while it lasts
+    int64_t downtime_ms;            //  [ms] total downtime of the outages
+    uint32_t count;                 //  number of outages
+    char asset [OUTAGE_HISTORY_ASSET_SIZE];
+} outage_history_record_t;
+
+//  Running aggregates of an asset
+typedef struct _outage_history_stats_t {
+    const char *asset;              //  valid till the history changes
+    uint32_t outages;               //  outages, the ongoing one included
+    int64_t downtime_ms;            //  [ms] total downtime, the ongoing outage till now included
+    int64_t mtbf_ms;                //  [ms] mean time between failures, uptime per outage
+    int64_t mttr_ms;                //  [ms] mean time to repair of ended outages, 0 if none
+    int64_t last_ms;                //  [ms] wall time the last outage started
+    bool down;                      //  outage is ongoing
+} outage_history_stats_t;
+
+//  @interface
+//  Create or continue the history in file 'path', once it holds more
+//  than 'records' records, the older half is rolled up and assets with
+//  no outage in the newer half are dropped. Time is read from 'clock',
+//  which is not owned and must outlive the history.
+FTY_OUTAGE_EXPORT outage_history_t *
+    outage_history_new (const char *path, size_t records, outage_clock_t *clock);
+
+//  Destroy the history
+FTY_OUTAGE_EXPORT void
+    outage_history_destroy (outage_history_t **self_p);
+
+//  Record start of outage of the asset
+//  return -1 if its outage is already ongoing, 0 otherwise
+FTY_OUTAGE_EXPORT int
+    outage_history_start (outage_history_t *self, const asset_key_t *key);
+
+//  Record end of outage of the asset
+//  return -1 if it had no ongoing outage, 0 otherwise
+FTY_OUTAGE_EXPORT int
+    outage_history_end (outage_history_t *self, const asset_key_t *key);
+
+//  Fill running aggregates of the asset
+//  return -1 if it had no outage, 0 otherwise
+FTY_OUTAGE_EXPORT int
+    outage_history_stats (outage_history_t *self, const asset_key_t *key, outage_history_stats_t *stats);
+
+//  Fill up to 'count' worst assets, ordered by OUTAGE_HISTORY_BY_*, and
+//  return how many were filled
+FTY_OUTAGE_EXPORT size_t
+    outage_history_top (outage_history_t *self, size_t count, int by, outage_history_stats_t *stats);
+
+//  Return number of assets with an outage
+FTY_OUTAGE_EXPORT size_t
+    outage_history_size (outage_history_t *self);
+
+//  Return number of records in the file
+FTY_OUTAGE_EXPORT size_t
+    outage_history_records (outage_history_t *self);
+
+//  Return bytes of heap memory held by the history
+FTY_OUTAGE_EXPORT size_t
+    outage_history_memory (outage_history_t *self);
+
+//  Self test of this class
+FTY_OUTAGE_EXPORT void
+    outage_history_test (bool verbose);
+
+//  @end
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
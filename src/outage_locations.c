@@ -0,0 +1,416 @@
+/*  =========================================================================
+    outage_locations - Monitored and dead assets per location
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    outage_locations - Monitored and dead assets per location
+@discuss
+    Each monitored asset is counted in all locations of its chain (parent
+    names from its ASSET message, direct parent first), so a datacenter
+    counts assets of all its rooms and racks. The asset holds pointers to
+    its locations, so a transition of it (dead, alive again) updates the
+    counters in O(depth) without hashing location names. Location exists
+    while it holds a monitored asset.
+@end
+*/
+
+#include "fty_outage_classes.h"
+
+// aux keys of asset locations, from direct parent up
+static const char *PARENT_KEYS [OUTAGE_LOCATIONS_DEPTH] = {
+    "parent_name.1", "parent_name.2", "parent_name.3", "parent_name.4", "parent_name.5",
+    "parent_name.6", "parent_name.7", "parent_name.8", "parent_name.9", "parent_name.10"
+};
+
+//  Counters of a location, with its name in the same block
+typedef struct _location_t {
+    outage_locations_stats_t stats;
+    char name [];
+} location_t;
+
+//  Monitored asset and its location chain, with its name in the same block
+typedef struct _member_t {
+    asset_key_t key;            // key of the asset in the table
+    bool dead;
+    size_t depth;               // locations in the chain
+    location_t *chain [OUTAGE_LOCATIONS_DEPTH];
+    char name [];
+} member_t;
+
+//  Structure of our class
+struct _outage_locations_t {
+    zhashx_t *locations;        // iname => location_t, keys live in the items
+    zhashx_t *members;          // asset_key_t => member_t, keys live in the items
+};
+
+static void
+s_free (void **item_p)
+{
+    free (*item_p);
+    *item_p = NULL;
+}
+
+//  --------------------------------------------------------------------------
+//  Create a new, empty, locations
+outage_locations_t *
+outage_locations_new (void)
+{
+    outage_locations_t *self = (outage_locations_t *) zmalloc (sizeof (outage_locations_t));
+    if (self) {
+        self->locations = zhashx_new ();
+        if (self->locations) {
+            zhashx_set_key_duplicator (self->locations, NULL);
+            zhashx_set_key_destructor (self->locations, NULL);
+            zhashx_set_destructor (self->locations, s_free);
+            self->members = asset_key_hash_new (false);
+        }
+        if (self->members)
+            zhashx_set_destructor (self->members, s_free);
+        else
+            outage_locations_destroy (&self);
+    }
+    return self;
+}
+
+//  --------------------------------------------------------------------------
+//  Destroy the locations
+void
+outage_locations_destroy (outage_locations_t **self_p)
+{
+    assert (self_p);
+    if (*self_p) {
+        outage_locations_t *self = *self_p;
+        zhashx_destroy (&self->members);
+        zhashx_destroy (&self->locations);
+        free (self);
+        *self_p = NULL;
+    }
+}
+
+// stop counting the member in its locations, empty ones are dropped
+static void
+s_leave (outage_locations_t *self, member_t *member)
+{
+    for (size_t i = 0; i < member->depth; i++) {
+        location_t *location = member->chain [i];
+        location->stats.monitored--;
+        if (member->dead)
+            location->stats.dead--;
+        if (location->stats.monitored == 0)
+            zhashx_delete (self->locations, location->name);
+    }
+    member->depth = 0;
+}
+
+// count the member in locations of the names, created if needed
+// return -1 on memory error, the chain is cut there, 0 otherwise
+static int
+s_join (outage_locations_t *self, member_t *member, const char **names, size_t depth)
+{
+    for (size_t i = 0; i < depth; i++) {
+        location_t *location = (location_t *) zhashx_lookup (self->locations, names [i]);
+        if (!location) {
+            size_t length = strlen (names [i]);
+            location = (location_t *) zmalloc (sizeof (location_t) + length + 1);
+            if (!location) {
+                log_error ("Can't count assets of location %s (memory error)", names [i]);
+                return -1;
+            }
+            memcpy (location->name, names [i], length + 1);
+            location->stats.location = location->name;
+            zhashx_insert (self->locations, location->name, location);
+        }
+        location->stats.monitored++;
+        if (member->dead)
+            location->stats.dead++;
+        member->chain [member->depth++] = location;
+    }
+    return 0;
+}
+
+//  --------------------------------------------------------------------------
+//  Count monitored asset in the locations of its ASSET message, asset
+//  counted already is moved if its locations changed
+int
+outage_locations_insert (outage_locations_t *self, const asset_key_t *key, fty_proto_t *asset)
+{
+    assert (self);
+    assert (key);
+    assert (asset);
+
+    const char *names [OUTAGE_LOCATIONS_DEPTH];
+    size_t depth = 0;
+    while (depth < OUTAGE_LOCATIONS_DEPTH) {
+        const char *name = fty_proto_aux_string (asset, PARENT_KEYS [depth], NULL);
+        if (!name || streq (name, ""))
+            break;
+        names [depth++] = name;
+    }
+
+    member_t *member = (member_t *) zhashx_lookup (self->members, key);
+    if (member) {
+        bool moved = member->depth != depth;
+        for (size_t i = 0; !moved && i < depth; i++)
+            moved = !streq (member->chain [i]->name, names [i]);
+        if (!moved)
+            return 0;
+        s_leave (self, member);
+    }
+    else {
+        member = (member_t *) zmalloc (sizeof (member_t) + key->length + 1);
+        if (!member) {
+            log_error ("Can't count asset %s in its locations (memory error)", key->name);
+            return -1;
+        }
+        memcpy (member->name, key->name, key->length + 1);
+        member->key = *key;
+        member->key.name = member->name;
+        zhashx_insert (self->members, &member->key, member);
+    }
+    return s_join (self, member, names, depth);
+}
+
+//  --------------------------------------------------------------------------
+//  Stop counting the asset
+int
+outage_locations_delete (outage_locations_t *self, const asset_key_t *key)
+{
+    assert (self);
+    assert (key);
+    member_t *member = (member_t *) zhashx_lookup (self->members, key);
+    if (!member)
+        return -1;
+    s_leave (self, member);
+    zhashx_delete (self->members, key);
+    return 0;
+}
+
+//  --------------------------------------------------------------------------
+//  Count the asset as dead or alive again in all its locations
+int
+outage_locations_set_dead (outage_locations_t *self, const asset_key_t *key, bool dead)
+{
+    assert (self);
+    assert (key);
+    member_t *member = (member_t *) zhashx_lookup (self->members, key);
+    if (!member)
+        return -1;
+    if (member->dead == dead)
+        return 0;
+    member->dead = dead;
+    for (size_t i = 0; i < member->depth; i++) {
+        if (dead)
+            member->chain [i]->stats.dead++;
+        else
+            member->chain [i]->stats.dead--;
+    }
+    return 0;
+}
+
+//  --------------------------------------------------------------------------
+//  Return counters of the location, NULL if it holds no monitored asset
+const outage_locations_stats_t *
+outage_locations_lookup (outage_locations_t *self, const char *location)
+{
+    assert (self);
+    assert (location);
+    location_t *item = (location_t *) zhashx_lookup (self->locations, location);
+    return item ? &item->stats : NULL;
+}
+
+//  --------------------------------------------------------------------------
+//  Return counters of the first location, NULL if there are none
+const outage_locations_stats_t *
+outage_locations_first (outage_locations_t *self)
+{
+    assert (self);
+    location_t *item = (location_t *) zhashx_first (self->locations);
+    return item ? &item->stats : NULL;
+}
+
+//  --------------------------------------------------------------------------
+//  Return counters of the next location, NULL after the last one
+const outage_locations_stats_t *
+outage_locations_next (outage_locations_t *self)
+{
+    assert (self);
+    location_t *item = (location_t *) zhashx_next (self->locations);
+    return item ? &item->stats : NULL;
+}
+
+//  --------------------------------------------------------------------------
+//  Return number of locations holding a monitored asset
+size_t
+outage_locations_size (outage_locations_t *self)
+{
+    assert (self);
+    return zhashx_size (self->locations);
+}
+
+//  --------------------------------------------------------------------------
+//  Return bytes of heap memory held by the locations
+size_t
+outage_locations_memory (outage_locations_t *self)
+{
+    assert (self);
+    size_t bytes = memory_usage_block (sizeof (outage_locations_t))
+        + memory_usage_hash (zhashx_size (self->locations))
+        + memory_usage_hash (zhashx_size (self->members));
+    for (location_t *location = (location_t *) zhashx_first (self->locations);
+                     location != NULL;
+                     location = (location_t *) zhashx_next (self->locations))
+        bytes += memory_usage_block (sizeof (location_t) + strlen (location->name) + 1);
+    for (member_t *member = (member_t *) zhashx_first (self->members);
+                   member != NULL;
+                   member = (member_t *) zhashx_next (self->members))
+        bytes += memory_usage_block (sizeof (member_t) + member->key.length + 1);
+    return bytes;
+}
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+static fty_proto_t *
+s_test_asset (const char *name, const char *parent1, const char *parent2, const char *parent3)
+{
+    zhash_t *aux = zhash_new ();
+    zhash_insert (aux, "type", "device");
+    zhash_insert (aux, "subtype", "ups");
+    if (parent1)
+        zhash_insert (aux, "parent_name.1", (void *) parent1);
+    if (parent2)
+        zhash_insert (aux, "parent_name.2", (void *) parent2);
+    if (parent3)
+        zhash_insert (aux, "parent_name.3", (void *) parent3);
+    zmsg_t *msg = fty_proto_encode_asset (aux, name, FTY_PROTO_ASSET_OP_CREATE, NULL);
+    zhash_destroy (&aux);
+    fty_proto_t *asset = fty_proto_decode (&msg);
+    assert (asset);
+    return asset;
+}
+
+// key of the name for tests, valid till the next call
+static const asset_key_t *
+s_key (const char *name)
+{
+    static asset_key_t key;
+    asset_key_init (&key, name);
+    return &key;
+}
+
+// true if the location has the counters, unknown location has none
+static bool
+s_counts (outage_locations_t *self, const char *location, size_t monitored, size_t dead)
+{
+    const outage_locations_stats_t *stats = outage_locations_lookup (self, location);
+    if (!stats)
+        return monitored == 0 && dead == 0;
+    return streq (stats->location, location) && stats->monitored == monitored && stats->dead == dead;
+}
+
+void
+outage_locations_test (bool verbose)
+{
+    printf (" * outage_locations: ");
+
+    //  @selftest
+    outage_locations_t *self = outage_locations_new ();
+    assert (self);
+
+    fty_proto_t *asset = s_test_asset ("ups-1", "rack-1", "room-1", "datacenter-1");
+    assert (outage_locations_insert (self, s_key ("ups-1"), asset) == 0);
+    fty_proto_destroy (&asset);
+    asset = s_test_asset ("ups-2", "rack-2", "room-1", "datacenter-1");
+    assert (outage_locations_insert (self, s_key ("ups-2"), asset) == 0);
+    fty_proto_destroy (&asset);
+    asset = s_test_asset ("epdu-1", "rack-1", "room-1", "datacenter-1");
+    assert (outage_locations_insert (self, s_key ("epdu-1"), asset) == 0);
+    fty_proto_destroy (&asset);
+    // asset without location is not counted anywhere
+    asset = s_test_asset ("sts-1", NULL, NULL, NULL);
+    assert (outage_locations_insert (self, s_key ("sts-1"), asset) == 0);
+    fty_proto_destroy (&asset);
+    assert (outage_locations_size (self) == 4);
+    assert (s_counts (self, "datacenter-1", 3, 0));
+    assert (s_counts (self, "room-1", 3, 0));
+    assert (s_counts (self, "rack-1", 2, 0));
+    assert (s_counts (self, "rack-2", 1, 0));
+
+    // transitions go up the whole chain, repeated ones are counted once
+    assert (outage_locations_set_dead (self, s_key ("ups-1"), true) == 0);
+    assert (outage_locations_set_dead (self, s_key ("ups-1"), true) == 0);
+    assert (outage_locations_set_dead (self, s_key ("ups-2"), true) == 0);
+    assert (outage_locations_set_dead (self, s_key ("sts-1"), true) == 0);
+    assert (outage_locations_set_dead (self, s_key ("unknown"), true) == -1);
+    assert (s_counts (self, "datacenter-1", 3, 2));
+    assert (s_counts (self, "rack-1", 2, 1));
+    assert (s_counts (self, "rack-2", 1, 1));
+    assert (outage_locations_set_dead (self, s_key ("ups-2"), false) == 0);
+    assert (s_counts (self, "room-1", 3, 1));
+    assert (s_counts (self, "rack-2", 1, 0));
+
+    // dead asset moves with its state, empty location is dropped
+    asset = s_test_asset ("ups-1", "rack-3", "room-2", "datacenter-1");
+    assert (outage_locations_insert (self, s_key ("ups-1"), asset) == 0);
+    fty_proto_destroy (&asset);
+    assert (s_counts (self, "datacenter-1", 3, 1));
+    assert (s_counts (self, "room-1", 2, 0));
+    assert (s_counts (self, "room-2", 1, 1));
+    assert (s_counts (self, "rack-1", 1, 0));
+    assert (s_counts (self, "rack-3", 1, 1));
+    // the same locations again change nothing
+    asset = s_test_asset ("ups-1", "rack-3", "room-2", "datacenter-1");
+    assert (outage_locations_insert (self, s_key ("ups-1"), asset) == 0);
+    fty_proto_destroy (&asset);
+    assert (s_counts (self, "datacenter-1", 3, 1));
+
+    size_t iterated = 0;
+    size_t monitored = 0;
+    for (const outage_locations_stats_t *stats = outage_locations_first (self);
+                                         stats != NULL;
+                                         stats = outage_locations_next (self)) {
+        if (verbose)
+            zsys_debug ("%s: %zu monitored, %zu dead", stats->location, stats->monitored, stats->dead);
+        monitored += stats->monitored;
+        iterated++;
+    }
+    assert (iterated == outage_locations_size (self));
+    assert (iterated == 6);
+    assert (monitored == 3 + 2 + 1 + 1 + 1 + 1);
+    assert (outage_locations_memory (self) > 6 * sizeof (location_t));
+
+    assert (outage_locations_delete (self, s_key ("ups-1")) == 0);
+    assert (outage_locations_delete (self, s_key ("ups-1")) == -1);
+    assert (s_counts (self, "datacenter-1", 2, 0));
+    assert (s_counts (self, "room-2", 0, 0));
+    assert (s_counts (self, "rack-3", 0, 0));
+    assert (outage_locations_size (self) == 4);
+    assert (outage_locations_delete (self, s_key ("ups-2")) == 0);
+    assert (outage_locations_delete (self, s_key ("epdu-1")) == 0);
+    assert (outage_locations_delete (self, s_key ("sts-1")) == 0);
+    assert (outage_locations_size (self) == 0);
+    assert (outage_locations_first (self) == NULL);
+
+    outage_locations_destroy (&self);
+    assert (self == NULL);
+    //  @end
+    printf ("OK\n");
+}
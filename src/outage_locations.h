@@ -0,0 +1,102 @@
+/*  =========================================================================
+    outage_locations - Monitored and dead assets per location
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef OUTAGE_LOCATIONS_H_INCLUDED
+#define OUTAGE_LOCATIONS_H_INCLUDED
+
+#include "../include/fty_outage.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef OUTAGE_LOCATIONS_T_DEFINED
+typedef struct _outage_locations_t outage_locations_t;
+#define OUTAGE_LOCATIONS_T_DEFINED
+#endif
+
+#define OUTAGE_LOCATIONS_DEPTH  10  //  parent_name.1 .. parent_name.10 of ASSET aux
+
+//  Counters of a location
+typedef struct _outage_locations_stats_t {
+    const char *location;           //  iname, valid till the location has no asset
+    size_t monitored;               //  monitored assets in the location, at any depth
+    size_t dead;                    //  of them silent for any escalation level
+} outage_locations_stats_t;
+
+//  @interface
+//  Create a new, empty, locations
+FTY_OUTAGE_EXPORT outage_locations_t *
+    outage_locations_new (void);
+
+//  Destroy the locations
+FTY_OUTAGE_EXPORT void
+    outage_locations_destroy (outage_locations_t **self_p);
+
+//  Count monitored asset in the locations of its ASSET message (parent
+//  names, from direct parent up). Asset counted already is moved if its
+//  locations changed, it stays dead or alive.
+//  return -1 on memory error, 0 otherwise
+FTY_OUTAGE_EXPORT int
+    outage_locations_insert (outage_locations_t *self, const asset_key_t *key, fty_proto_t *asset);
+
+//  Stop counting the asset
+//  return -1 if it is not counted, 0 otherwise
+FTY_OUTAGE_EXPORT int
+    outage_locations_delete (outage_locations_t *self, const asset_key_t *key);
+
+//  Count the asset as dead or alive again in all its locations
+//  return -1 if it is not counted, 0 otherwise
+FTY_OUTAGE_EXPORT int
+    outage_locations_set_dead (outage_locations_t *self, const asset_key_t *key, bool dead);
+
+//  Return counters of the location, NULL if it holds no monitored asset
+FTY_OUTAGE_EXPORT const outage_locations_stats_t *
+    outage_locations_lookup (outage_locations_t *self, const char *location);
+
+//  Return counters of the first location, NULL if there are none
+FTY_OUTAGE_EXPORT const outage_locations_stats_t *
+    outage_locations_first (outage_locations_t *self);
+
+//  Return counters of the next location, NULL after the last one. Assets
+//  must not be inserted, deleted or moved while iterating.
+FTY_OUTAGE_EXPORT const outage_locations_stats_t *
+    outage_locations_next (outage_locations_t *self);
+
+//  Return number of locations holding a monitored asset
+FTY_OUTAGE_EXPORT size_t
+    outage_locations_size (outage_locations_t *self);
+
+//  Return bytes of heap memory held by the locations
+FTY_OUTAGE_EXPORT size_t
+    outage_locations_memory (outage_locations_t *self);
+
+//  Self test of this class
+FTY_OUTAGE_EXPORT void
+    outage_locations_test (bool verbose);
+
+//  @end
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
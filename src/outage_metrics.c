@@ -0,0 +1,578 @@
+/*  =========================================================================
+    outage_metrics - Lock-free counters of the agent and their OpenMetrics exporter
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    outage_metrics - Lock-free counters of the agent and their OpenMetrics exporter
+@discuss
+    The server thread updates plain 64 bit counters, gauges and histogram
+    buckets with relaxed atomic operations, there are no locks and no
+    allocations. The exporter actor reads them from its own thread and
+    serves them in OpenMetrics text format, over HTTP on a unix domain
+    socket and/or by rewriting a file periodically (for textfile
+    collectors), so a scrape never waits for the server thread nor delays
+    it. Values read by one scrape are not one snapshot, each of them is
+    consistent on its own; histogram count is the sum of buckets read.
+
+    Rates (messages per second) are left to the scraper, the exporter
+    serves monotonic counters.
+@end
+*/
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "fty_outage_classes.h"
+
+#define HISTOGRAM_BUCKETS 7
+#define REQUEST_TIMEOUT_MS 1000     // client gets this long to send request and read response
+
+//  Upper bounds of histogram buckets [us], and as printed [s]
+static const int64_t BUCKET_USEC [HISTOGRAM_BUCKETS] = {
+    10, 100, 1000, 10000, 100000, 1000000, 10000000
+};
+static const char *BUCKET_LE [HISTOGRAM_BUCKETS] = {
+    "0.00001", "0.0001", "0.001", "0.01", "0.1", "1.0", "10.0"
+};
+
+static const char *STREAM_NAMES [OUTAGE_METRICS_STREAMS] = {
+    FTY_PROTO_STREAM_METRICS,
+    FTY_PROTO_STREAM_METRICS_SENSOR,
+    FTY_PROTO_STREAM_METRICS_UNAVAILABLE,
+    FTY_PROTO_STREAM_ASSETS,
+    "other"
+};
+
+static const char *SUBTYPE_NAMES [OUTAGE_METRICS_SUBTYPES] = {
+    "ups", "epdu", "sensor", "sensorgpio", "sts", "other"
+};
+
+typedef struct _histogram_t {
+    uint64_t buckets [HISTOGRAM_BUCKETS + 1];   // the last one is +Inf
+    uint64_t sum_usec;
+} histogram_t;
+
+//  Structure of our class
+struct _outage_metrics_t {
+    uint64_t counters [OUTAGE_METRICS_COUNTERS];
+    int64_t gauges [OUTAGE_METRICS_GAUGES];
+    uint64_t messages [OUTAGE_METRICS_STREAMS];
+    int64_t assets [OUTAGE_METRICS_SUBTYPES];
+    histogram_t histograms [OUTAGE_METRICS_HISTOGRAMS];
+};
+
+//  --------------------------------------------------------------------------
+//  Create a new metrics, all zero
+outage_metrics_t *
+outage_metrics_new (void)
+{
+    return (outage_metrics_t *) zmalloc (sizeof (outage_metrics_t));
+}
+
+//  --------------------------------------------------------------------------
+//  Destroy the metrics
+void
+outage_metrics_destroy (outage_metrics_t **self_p)
+{
+    assert (self_p);
+    if (*self_p) {
+        free (*self_p);
+        *self_p = NULL;
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Add to counter
+void
+outage_metrics_add (outage_metrics_t *self, int counter, uint64_t value)
+{
+    assert (self);
+    assert (counter >= 0 && counter < OUTAGE_METRICS_COUNTERS);
+    __atomic_fetch_add (&self->counters [counter], value, __ATOMIC_RELAXED);
+}
+
+//  --------------------------------------------------------------------------
+//  Set gauge
+void
+outage_metrics_set (outage_metrics_t *self, int gauge, int64_t value)
+{
+    assert (self);
+    assert (gauge >= 0 && gauge < OUTAGE_METRICS_GAUGES);
+    __atomic_store_n (&self->gauges [gauge], value, __ATOMIC_RELAXED);
+}
+
+//  --------------------------------------------------------------------------
+//  Add observation to histogram
+void
+outage_metrics_observe (outage_metrics_t *self, int histogram, int64_t usec)
+{
+    assert (self);
+    assert (histogram >= 0 && histogram < OUTAGE_METRICS_HISTOGRAMS);
+    if (usec < 0)
+        usec = 0;
+    size_t bucket = 0;
+    while (bucket < HISTOGRAM_BUCKETS && usec > BUCKET_USEC [bucket])
+        bucket++;
+    histogram_t *h = &self->histograms [histogram];
+    __atomic_fetch_add (&h->buckets [bucket], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add (&h->sum_usec, (uint64_t) usec, __ATOMIC_RELAXED);
+}
+
+//  --------------------------------------------------------------------------
+//  Return index of the stream
+size_t
+outage_metrics_stream (const char *stream)
+{
+    assert (stream);
+    size_t index = 0;
+    while (index < OUTAGE_METRICS_STREAMS - 1 && !streq (stream, STREAM_NAMES [index]))
+        index++;
+    return index;
+}
+
+//  --------------------------------------------------------------------------
+//  Count message received on stream of the index
+void
+outage_metrics_message (outage_metrics_t *self, size_t stream)
+{
+    assert (self);
+    assert (stream < OUTAGE_METRICS_STREAMS);
+    __atomic_fetch_add (&self->messages [stream], 1, __ATOMIC_RELAXED);
+}
+
+//  --------------------------------------------------------------------------
+//  Return index of the asset subtype
+size_t
+outage_metrics_subtype (const char *subtype)
+{
+    assert (subtype);
+    size_t index = 0;
+    while (index < OUTAGE_METRICS_SUBTYPES - 1 && !streq (subtype, SUBTYPE_NAMES [index]))
+        index++;
+    return index;
+}
+
+//  --------------------------------------------------------------------------
+//  Set number of monitored assets of each subtype
+void
+outage_metrics_set_assets (outage_metrics_t *self, const size_t *counts)
+{
+    assert (self);
+    assert (counts);
+    for (size_t i = 0; i < OUTAGE_METRICS_SUBTYPES; i++)
+        __atomic_store_n (&self->assets [i], (int64_t) counts [i], __ATOMIC_RELAXED);
+}
+
+//  --------------------------------------------------------------------------
+//  Return value of counter
+uint64_t
+outage_metrics_counter (outage_metrics_t *self, int counter)
+{
+    assert (self);
+    assert (counter >= 0 && counter < OUTAGE_METRICS_COUNTERS);
+    return __atomic_load_n (&self->counters [counter], __ATOMIC_RELAXED);
+}
+
+static void
+s_print_counter (FILE *file, const char *name, const char *help, uint64_t value)
+{
+    fprintf (file, "# TYPE %s counter\n# HELP %s %s\n%s_total %" PRIu64 "\n", name, name, help, name, value);
+}
+
+static void
+s_print_histogram (FILE *file, const char *name, const char *help, histogram_t *h)
+{
+    fprintf (file, "# TYPE %s histogram\n# HELP %s %s\n", name, name, help);
+    uint64_t count = 0;
+    for (size_t i = 0; i <= HISTOGRAM_BUCKETS; i++) {
+        count += __atomic_load_n (&h->buckets [i], __ATOMIC_RELAXED);
+        fprintf (file, "%s_bucket{le=\"%s\"} %" PRIu64 "\n", name, i < HISTOGRAM_BUCKETS ? BUCKET_LE [i] : "+Inf", count);
+    }
+    uint64_t sum_usec = __atomic_load_n (&h->sum_usec, __ATOMIC_RELAXED);
+    fprintf (file, "%s_sum %" PRIu64 ".%06" PRIu64 "\n%s_count %" PRIu64 "\n",
+        name, sum_usec / 1000000, sum_usec % 1000000, name, count);
+}
+
+//  --------------------------------------------------------------------------
+//  Print the metrics in OpenMetrics text format
+void
+outage_metrics_print (outage_metrics_t *self, FILE *file)
+{
+    assert (self);
+    assert (file);
+
+    fprintf (file, "# TYPE fty_outage_assets gauge\n# HELP fty_outage_assets Monitored assets.\n");
+    for (size_t i = 0; i < OUTAGE_METRICS_SUBTYPES; i++)
+        fprintf (file, "fty_outage_assets{subtype=\"%s\"} %" PRIi64 "\n",
+            SUBTYPE_NAMES [i], __atomic_load_n (&self->assets [i], __ATOMIC_RELAXED));
+    fprintf (file, "# TYPE fty_outage_active_outages gauge\n# HELP fty_outage_active_outages Assets with ACTIVE outage alert.\n");
+    fprintf (file, "fty_outage_active_outages %" PRIi64 "\n",
+        __atomic_load_n (&self->gauges [OUTAGE_METRICS_ACTIVE_OUTAGES], __ATOMIC_RELAXED));
+    fprintf (file, "# TYPE fty_outage_messages counter\n# HELP fty_outage_messages Messages received.\n");
+    for (size_t i = 0; i < OUTAGE_METRICS_STREAMS; i++)
+        fprintf (file, "fty_outage_messages_total{stream=\"%s\"} %" PRIu64 "\n",
+            STREAM_NAMES [i], __atomic_load_n (&self->messages [i], __ATOMIC_RELAXED));
+    s_print_counter (file, "fty_outage_decode_errors", "Messages which could not be decoded.",
+        outage_metrics_counter (self, OUTAGE_METRICS_DECODE_ERRORS));
+    fprintf (file, "# TYPE fty_outage_future_metrics counter\n# HELP fty_outage_future_metrics Metrics stamped ahead of local clock, taken as seen now.\n");
+    fprintf (file, "fty_outage_future_metrics_total{skew=\"tolerated\"} %" PRIu64 "\n",
+        outage_metrics_counter (self, OUTAGE_METRICS_FUTURE_TOLERATED));
+    fprintf (file, "fty_outage_future_metrics_total{skew=\"clamped\"} %" PRIu64 "\n",
+        outage_metrics_counter (self, OUTAGE_METRICS_FUTURE_CLAMPED));
+    s_print_counter (file, "fty_outage_alerts_sent", "ACTIVE and RESOLVED alerts sent.",
+        outage_metrics_counter (self, OUTAGE_METRICS_ALERTS_SENT));
+    s_print_histogram (file, "fty_outage_loop_seconds", "Handling of one message or command.",
+        &self->histograms [OUTAGE_METRICS_LOOP]);
+    s_print_histogram (file, "fty_outage_save_seconds", "Saving of the state file.",
+        &self->histograms [OUTAGE_METRICS_SAVE]);
+    fprintf (file, "# EOF\n");
+}
+
+//  --------------------------------------------------------------------------
+//  Replace file at path with the metrics, atomically
+int
+outage_metrics_save (outage_metrics_t *self, const char *path)
+{
+    assert (self);
+    assert (path);
+
+    char *temp = zsys_sprintf ("%s.tmp", path);
+    if (!temp)
+        return -1;
+    FILE *file = fopen (temp, "w");
+    int rv = -1;
+    if (file) {
+        outage_metrics_print (self, file);
+        if (fclose (file) == 0 && rename (temp, path) == 0)
+            rv = 0;
+    }
+    if (rv != 0) {
+        log_error ("Can't write metrics to %s: %m", path);
+        unlink (temp);
+    }
+    zstr_free (&temp);
+    return rv;
+}
+
+//  --------------------------------------------------------------------------
+//  Exporter actor
+
+typedef struct _exporter_t {
+    outage_metrics_t *metrics;      // not owned
+    int listener;                   // unix socket, -1 if not serving
+    char *socket_path;
+    char *file_path;                // NULL if not rewriting a file
+    int64_t file_interval_ms;
+    int64_t file_next_ms;           // [ms] monotonic, next rewrite
+} exporter_t;
+
+static void
+s_exporter_close (exporter_t *self)
+{
+    if (self->listener != -1) {
+        close (self->listener);
+        unlink (self->socket_path);
+        self->listener = -1;
+    }
+    zstr_free (&self->socket_path);
+}
+
+// listen on unix socket at path, stale socket is replaced
+// return -1 on error
+static int
+s_exporter_listen (exporter_t *self, const char *path)
+{
+    s_exporter_close (self);
+    struct sockaddr_un address;
+    memset (&address, 0, sizeof (address));
+    address.sun_family = AF_UNIX;
+    if (strlen (path) >= sizeof (address.sun_path)) {
+        log_error ("metrics socket path %s is too long", path);
+        return -1;
+    }
+    strcpy (address.sun_path, path);
+    int fd = socket (AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1)
+        return -1;
+    unlink (path);
+    if (bind (fd, (struct sockaddr *) &address, sizeof (address)) != 0
+    ||  listen (fd, 8) != 0) {
+        log_error ("Can't listen on metrics socket %s: %m", path);
+        close (fd);
+        return -1;
+    }
+    self->listener = fd;
+    self->socket_path = strdup (path);
+    log_info ("outage_metrics_exporter: serving %s", path);
+    return 0;
+}
+
+// serve the metrics to one client, request is read but not parsed, any
+// request gets the metrics, HTTP/1.0 response ends by closing connection
+static void
+s_exporter_serve (exporter_t *self)
+{
+    int fd = accept (self->listener, NULL, NULL);
+    if (fd == -1)
+        return;
+    struct timeval timeout = { REQUEST_TIMEOUT_MS / 1000, (REQUEST_TIMEOUT_MS % 1000) * 1000 };
+    setsockopt (fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof (timeout));
+    setsockopt (fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof (timeout));
+    char request [1024];
+    ssize_t size = recv (fd, request, sizeof (request), 0);
+
+    char *body = NULL;
+    size_t body_size = 0;
+    FILE *file = size > 0 ? open_memstream (&body, &body_size) : NULL;
+    if (file) {
+        fprintf (file, "HTTP/1.0 200 OK\r\n"
+            "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+            "Connection: close\r\n\r\n");
+        outage_metrics_print (self->metrics, file);
+        fclose (file);
+        const char *data = body;
+        while (body_size > 0) {
+            ssize_t sent = send (fd, data, body_size, MSG_NOSIGNAL);
+            if (sent <= 0)
+                break;
+            data += sent;
+            body_size -= (size_t) sent;
+        }
+        free (body);
+    }
+    close (fd);
+}
+
+// return 1 on $TERM, 0 otherwise
+static int
+s_exporter_command (exporter_t *self, zmsg_t **msg_p)
+{
+    zmsg_t *msg = *msg_p;
+    char *command = zmsg_popstr (msg);
+    int rv = 0;
+    if (!command)
+        ;
+    else
+    if (streq (command, "$TERM"))
+        rv = 1;
+    else
+    if (streq (command, "SOCKET")) {
+        char *path = zmsg_popstr (msg);
+        if (path && !streq (path, ""))
+            s_exporter_listen (self, path);
+        else
+            s_exporter_close (self);
+        zstr_free (&path);
+    }
+    else
+    if (streq (command, "FILE")) {
+        char *path = zmsg_popstr (msg);
+        char *interval = zmsg_popstr (msg);
+        zstr_free (&self->file_path);
+        if (path && !streq (path, "") && interval && atol (interval) > 0) {
+            self->file_path = strdup (path);
+            self->file_interval_ms = atol (interval);
+            self->file_next_ms = zclock_mono ();
+        }
+        zstr_free (&path);
+        zstr_free (&interval);
+    }
+    else
+        log_error ("outage_metrics_exporter: unknown command %s", command);
+    zstr_free (&command);
+    zmsg_destroy (msg_p);
+    return rv;
+}
+
+//  --------------------------------------------------------------------------
+//  Exporter actor serving the metrics passed as args
+void
+outage_metrics_exporter (zsock_t *pipe, void *args)
+{
+    assert (args);
+    exporter_t self;
+    memset (&self, 0, sizeof (self));
+    self.metrics = (outage_metrics_t *) args;
+    self.listener = -1;
+
+    zsock_signal (pipe, 0);
+    log_info ("outage_metrics_exporter: Started");
+
+    zmq_pollitem_t items [2] = {
+        { zsock_resolve (pipe), 0, ZMQ_POLLIN, 0 },
+        { NULL, -1, ZMQ_POLLIN, 0 }
+    };
+    while (!zsys_interrupted) {
+        long timeout = -1;
+        if (self.file_path) {
+            int64_t now_ms = zclock_mono ();
+            timeout = now_ms < self.file_next_ms ? (long) (self.file_next_ms - now_ms) : 0;
+        }
+        items [1].fd = self.listener;
+        if (zmq_poll (items, self.listener != -1 ? 2 : 1, timeout) == -1)
+            break;
+
+        if (items [0].revents & ZMQ_POLLIN) {
+            zmsg_t *msg = zmsg_recv (pipe);
+            if (!msg || s_exporter_command (&self, &msg) == 1)
+                break;
+            continue;
+        }
+        if (self.listener != -1 && (items [1].revents & ZMQ_POLLIN))
+            s_exporter_serve (&self);
+        if (self.file_path && zclock_mono () >= self.file_next_ms) {
+            outage_metrics_save (self.metrics, self.file_path);
+            self.file_next_ms = zclock_mono () + self.file_interval_ms;
+        }
+    }
+
+    s_exporter_close (&self);
+    zstr_free (&self.file_path);
+    log_info ("outage_metrics_exporter: Ended");
+}
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+// connect to unix socket at path, send request and return response
+static char *
+s_test_scrape (const char *path, exporter_t *exporter)
+{
+    struct sockaddr_un address;
+    memset (&address, 0, sizeof (address));
+    address.sun_family = AF_UNIX;
+    strcpy (address.sun_path, path);
+    int fd = socket (AF_UNIX, SOCK_STREAM, 0);
+    assert (fd != -1);
+    int rv = connect (fd, (struct sockaddr *) &address, sizeof (address));
+    assert (rv == 0);
+    const char *request = "GET /metrics HTTP/1.0\r\n\r\n";
+    assert (send (fd, request, strlen (request), 0) == (ssize_t) strlen (request));
+    // served in this thread, the backlog holds the connection meanwhile
+    if (exporter)
+        s_exporter_serve (exporter);
+    char *response = (char *) zmalloc (16384);
+    size_t size = 0;
+    ssize_t bytes;
+    while ((bytes = recv (fd, response + size, 16383 - size, 0)) > 0)
+        size += (size_t) bytes;
+    close (fd);
+    return response;
+}
+
+void
+outage_metrics_test (bool verbose)
+{
+    printf (" * outage_metrics: ");
+
+    //  @selftest
+    outage_metrics_t *self = outage_metrics_new ();
+    assert (self);
+    outage_metrics_add (self, OUTAGE_METRICS_DECODE_ERRORS, 2);
+    outage_metrics_add (self, OUTAGE_METRICS_FUTURE_CLAMPED, 1);
+    assert (outage_metrics_counter (self, OUTAGE_METRICS_DECODE_ERRORS) == 2);
+    outage_metrics_set (self, OUTAGE_METRICS_ACTIVE_OUTAGES, 3);
+    assert (outage_metrics_stream (FTY_PROTO_STREAM_ASSETS) == 3);
+    assert (outage_metrics_stream ("_ALERTS_SYS") == OUTAGE_METRICS_STREAMS - 1);
+    outage_metrics_message (self, outage_metrics_stream (FTY_PROTO_STREAM_METRICS));
+    outage_metrics_message (self, outage_metrics_stream (FTY_PROTO_STREAM_METRICS));
+    assert (outage_metrics_subtype ("epdu") == 1);
+    assert (outage_metrics_subtype ("rack") == OUTAGE_METRICS_SUBTYPES - 1);
+    size_t assets [OUTAGE_METRICS_SUBTYPES] = { 10, 5, 0, 0, 1, 2 };
+    outage_metrics_set_assets (self, assets);
+    outage_metrics_observe (self, OUTAGE_METRICS_LOOP, 5);
+    outage_metrics_observe (self, OUTAGE_METRICS_LOOP, 150);
+    outage_metrics_observe (self, OUTAGE_METRICS_LOOP, 60 * 1000000);
+    outage_metrics_observe (self, OUTAGE_METRICS_SAVE, 250000);
+
+    char *text = NULL;
+    size_t text_size = 0;
+    FILE *file = open_memstream (&text, &text_size);
+    assert (file);
+    outage_metrics_print (self, file);
+    fclose (file);
+    if (verbose)
+        printf ("\n%s", text);
+    assert (strstr (text, "fty_outage_assets{subtype=\"ups\"} 10\n"));
+    assert (strstr (text, "fty_outage_assets{subtype=\"other\"} 2\n"));
+    assert (strstr (text, "fty_outage_active_outages 3\n"));
+    assert (strstr (text, "fty_outage_messages_total{stream=\"METRICS\"} 2\n"));
+    assert (strstr (text, "fty_outage_decode_errors_total 2\n"));
+    assert (strstr (text, "fty_outage_future_metrics_total{skew=\"clamped\"} 1\n"));
+    assert (strstr (text, "fty_outage_loop_seconds_bucket{le=\"0.00001\"} 1\n"));
+    assert (strstr (text, "fty_outage_loop_seconds_bucket{le=\"0.001\"} 2\n"));
+    assert (strstr (text, "fty_outage_loop_seconds_bucket{le=\"10.0\"} 2\n"));
+    assert (strstr (text, "fty_outage_loop_seconds_bucket{le=\"+Inf\"} 3\n"));
+    assert (strstr (text, "fty_outage_loop_seconds_sum 60.000155\n"));
+    assert (strstr (text, "fty_outage_loop_seconds_count 3\n"));
+    assert (strstr (text, "fty_outage_save_seconds_sum 0.250000\n"));
+    assert (text_size > 6 && streq (text + text_size - 6, "# EOF\n"));
+
+    // file is replaced as a whole
+    const char *path = "src/selftest-rw/metrics.prom";
+    assert (outage_metrics_save (self, path) == 0);
+    file = fopen (path, "r");
+    assert (file);
+    char *saved = (char *) zmalloc (text_size + 1);
+    assert (fread (saved, 1, text_size + 1, file) == text_size);
+    fclose (file);
+    assert (streq (saved, text));
+    free (saved);
+    free (text);
+    assert (outage_metrics_save (self, "src/selftest-rw/no-such-dir/metrics.prom") == -1);
+
+    // scrape over unix socket
+    const char *socket_path = "src/selftest-rw/metrics.sock";
+    exporter_t exporter;
+    memset (&exporter, 0, sizeof (exporter));
+    exporter.metrics = self;
+    exporter.listener = -1;
+    assert (s_exporter_listen (&exporter, socket_path) == 0);
+    char *response = s_test_scrape (socket_path, &exporter);
+    assert (strncmp (response, "HTTP/1.0 200 OK\r\n", 17) == 0);
+    assert (strstr (response, "application/openmetrics-text"));
+    assert (strstr (response, "\r\n\r\n# TYPE fty_outage_assets gauge\n"));
+    assert (strstr (response, "fty_outage_active_outages 3\n"));
+    free (response);
+    s_exporter_close (&exporter);
+    assert (access (socket_path, F_OK) != 0);
+
+    // the actor serves both while metrics change
+    zactor_t *actor = zactor_new (outage_metrics_exporter, self);
+    assert (actor);
+    zstr_sendx (actor, "SOCKET", socket_path, NULL);
+    zstr_sendx (actor, "FILE", path, "50", NULL);
+    outage_metrics_set (self, OUTAGE_METRICS_ACTIVE_OUTAGES, 4);
+    zclock_sleep (200);
+    response = s_test_scrape (socket_path, NULL);
+    assert (strstr (response, "fty_outage_active_outages 4\n"));
+    free (response);
+    file = fopen (path, "r");
+    assert (file);
+    fclose (file);
+    zactor_destroy (&actor);
+    assert (access (socket_path, F_OK) != 0);
+
+    unlink (path);
+    outage_metrics_destroy (&self);
+    assert (self == NULL);
+    //  @end
+    printf ("OK\n");
+}
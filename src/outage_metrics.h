@@ -0,0 +1,128 @@
+/*  =========================================================================
+    outage_metrics - Lock-free counters of the agent and their OpenMetrics exporter
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef OUTAGE_METRICS_H_INCLUDED
+#define OUTAGE_METRICS_H_INCLUDED
+
+#include "../include/fty_outage.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef OUTAGE_METRICS_T_DEFINED
+typedef struct _outage_metrics_t outage_metrics_t;
+#define OUTAGE_METRICS_T_DEFINED
+#endif
+
+//  Counters
+#define OUTAGE_METRICS_DECODE_ERRORS    0   //  messages which could not be decoded
+#define OUTAGE_METRICS_FUTURE_TOLERATED 1   //  metrics from future within skew tolerance
+#define OUTAGE_METRICS_FUTURE_CLAMPED   2   //  metrics from future beyond it
+#define OUTAGE_METRICS_ALERTS_SENT      3   //  ACTIVE and RESOLVED alerts sent
+#define OUTAGE_METRICS_COUNTERS         4
+
+//  Gauges
+#define OUTAGE_METRICS_ACTIVE_OUTAGES   0   //  assets with ACTIVE alert
+#define OUTAGE_METRICS_GAUGES           1
+
+//  Histograms
+#define OUTAGE_METRICS_LOOP             0   //  handling of one message or command
+#define OUTAGE_METRICS_SAVE             1   //  saving of the state file
+#define OUTAGE_METRICS_HISTOGRAMS       2
+
+//  Streams messages are counted by, index of a stream not listed is
+//  OUTAGE_METRICS_STREAMS - 1
+#define OUTAGE_METRICS_STREAMS          5
+
+//  Subtypes monitored assets are counted by, index of a subtype not
+//  listed is OUTAGE_METRICS_SUBTYPES - 1
+#define OUTAGE_METRICS_SUBTYPES         6
+
+//  @interface
+//  Create a new metrics, all zero
+FTY_OUTAGE_EXPORT outage_metrics_t *
+    outage_metrics_new (void);
+
+//  Destroy the metrics, the exporter reading them must be destroyed first
+FTY_OUTAGE_EXPORT void
+    outage_metrics_destroy (outage_metrics_t **self_p);
+
+//  Add to counter OUTAGE_METRICS_*
+FTY_OUTAGE_EXPORT void
+    outage_metrics_add (outage_metrics_t *self, int counter, uint64_t value);
+
+//  Set gauge OUTAGE_METRICS_*
+FTY_OUTAGE_EXPORT void
+    outage_metrics_set (outage_metrics_t *self, int gauge, int64_t value);
+
+//  Add observation [us] to histogram OUTAGE_METRICS_*
+FTY_OUTAGE_EXPORT void
+    outage_metrics_observe (outage_metrics_t *self, int histogram, int64_t usec);
+
+//  Return index of the stream
+FTY_OUTAGE_EXPORT size_t
+    outage_metrics_stream (const char *stream);
+
+//  Count message received on stream of the index
+FTY_OUTAGE_EXPORT void
+    outage_metrics_message (outage_metrics_t *self, size_t stream);
+
+//  Return index of the asset subtype
+FTY_OUTAGE_EXPORT size_t
+    outage_metrics_subtype (const char *subtype);
+
+//  Set number of monitored assets of each subtype, counts are indexed by
+//  outage_metrics_subtype
+FTY_OUTAGE_EXPORT void
+    outage_metrics_set_assets (outage_metrics_t *self, const size_t *counts);
+
+//  Return value of counter OUTAGE_METRICS_*
+FTY_OUTAGE_EXPORT uint64_t
+    outage_metrics_counter (outage_metrics_t *self, int counter);
+
+//  Print the metrics in OpenMetrics text format, '# EOF' included
+FTY_OUTAGE_EXPORT void
+    outage_metrics_print (outage_metrics_t *self, FILE *file);
+
+//  Replace file at path with the metrics, atomically
+//  return -1 on error, 0 otherwise
+FTY_OUTAGE_EXPORT int
+    outage_metrics_save (outage_metrics_t *self, const char *path);
+
+//  Exporter actor serving the metrics passed as args from its own thread,
+//  it never touches the thread updating them. Commands:
+//      SOCKET <path>               serve over HTTP on unix socket
+//      FILE <path> <interval-ms>   rewrite the file periodically
+FTY_OUTAGE_EXPORT void
+    outage_metrics_exporter (zsock_t *pipe, void *args);
+
+//  Self test of this class
+FTY_OUTAGE_EXPORT void
+    outage_metrics_test (bool verbose);
+
+//  @end
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,767 @@
+/*  =========================================================================
+    outage_sim - Offline replay of captured traffic under expiry policies
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    outage_sim - Offline replay of captured traffic under expiry policies
+@discuss
+    Capture of metric and asset events is held in columns (arrival time,
+    kind, asset index, ttl or asset event, metric age), 17 bytes an event,
+    asset names are interned and hashed once, when loaded. The replay
+    drives data on a simulated clock as the server does: metrics arriving
+    in the same second are touched as one batch, metric of asset with
+    active alert resolves it, and dead assets are checked each poll
+    interval, raising or escalating alerts. Only the expiry logic runs,
+    nothing is published and maintenance windows are not applied.
+@end
+*/
+
+#include "fty_outage_classes.h"
+
+// defaults of the agent, see data and fty_outage_server
+#define SIM_WARNING_FACTOR  0.0
+#define SIM_CRITICAL_FACTOR 2.0
+#define SIM_EXPIRY_SEC      (15*60/2)
+#define SIM_POLL_SEC        30
+
+#define SIM_METRIC  0
+#define SIM_ASSET   1
+
+//  Asset event of the capture, rare compared to metrics
+typedef struct _sim_asset_event_t {
+    char *operation;
+    zhash_t *aux;
+} sim_asset_event_t;
+
+//  Structure of our class
+struct _outage_sim_t {
+    // columns of events, in order of arrival
+    uint32_t *time;             // [s] arrival since base_sec
+    uint8_t *kind;              // SIM_METRIC or SIM_ASSET
+    uint32_t *asset;            // index of the asset
+    uint32_t *arg;              // ttl [s] of metric, index of asset event
+    int32_t *age;               // [s] arrival - timestamp of metric, negative if from future
+    size_t size;
+    size_t capacity;
+    uint64_t base_sec;          // arrival of the first event
+
+    sim_asset_event_t *asset_events;
+    size_t asset_events_size;
+    size_t asset_events_capacity;
+
+    asset_key_t **keys;         // asset index => key owning the name
+    size_t keys_size;
+    size_t keys_capacity;
+    zhashx_t *index;            // asset_key_t => asset index + 1, keys live in keys
+};
+
+//  State of one replay
+typedef struct _sim_run_t {
+    outage_sim_t *sim;
+    const outage_sim_policy_t *policy;
+    outage_sim_result_t *result;
+    FILE *intervals;
+    outage_clock_t *clock;
+    data_t *data;
+    uint8_t *level;             // asset index => severity of active alert, DATA_LEVEL_NONE if none
+    uint8_t *peak;              // asset index => the highest severity of the interval
+    uint64_t *since;            // asset index => [s] start of the interval
+} sim_run_t;
+
+//  --------------------------------------------------------------------------
+//  Create a new, empty, capture
+outage_sim_t *
+outage_sim_new (void)
+{
+    outage_sim_t *self = (outage_sim_t *) zmalloc (sizeof (outage_sim_t));
+    if (self) {
+        self->index = asset_key_hash_new (false);
+        if (!self->index)
+            outage_sim_destroy (&self);
+    }
+    return self;
+}
+
+//  --------------------------------------------------------------------------
+//  Destroy the capture
+void
+outage_sim_destroy (outage_sim_t **self_p)
+{
+    assert (self_p);
+    if (*self_p) {
+        outage_sim_t *self = *self_p;
+        free (self->time);
+        free (self->kind);
+        free (self->asset);
+        free (self->arg);
+        free (self->age);
+        for (size_t i = 0; i < self->asset_events_size; i++) {
+            zstr_free (&self->asset_events [i].operation);
+            zhash_destroy (&self->asset_events [i].aux);
+        }
+        free (self->asset_events);
+        zhashx_destroy (&self->index);
+        for (size_t i = 0; i < self->keys_size; i++)
+            asset_key_destroy (&self->keys [i]);
+        free (self->keys);
+        free (self);
+        *self_p = NULL;
+    }
+}
+
+// grow array of 'size' bytes items to 'capacity' of them
+// return -1 on memory error, 0 otherwise
+static int
+s_grow (void **array_p, size_t size, size_t capacity)
+{
+    void *array = realloc (*array_p, size * capacity);
+    if (!array)
+        return -1;
+    *array_p = array;
+    return 0;
+}
+
+// room for one more event in all columns
+static int
+s_sim_reserve (outage_sim_t *self)
+{
+    if (self->size < self->capacity)
+        return 0;
+    size_t capacity = self->capacity ? self->capacity * 2 : 4096;
+    if (s_grow ((void **) &self->time, sizeof (uint32_t), capacity)
+    ||  s_grow ((void **) &self->kind, sizeof (uint8_t), capacity)
+    ||  s_grow ((void **) &self->asset, sizeof (uint32_t), capacity)
+    ||  s_grow ((void **) &self->arg, sizeof (uint32_t), capacity)
+    ||  s_grow ((void **) &self->age, sizeof (int32_t), capacity))
+        return -1;
+    self->capacity = capacity;
+    return 0;
+}
+
+// index of the asset, interned on the first sight
+// return -1 on memory error
+static int64_t
+s_sim_intern (outage_sim_t *self, const char *name)
+{
+    asset_key_t key;
+    asset_key_init (&key, name);
+    void *item = zhashx_lookup (self->index, &key);
+    if (item)
+        return (int64_t) ((uintptr_t) item - 1);
+
+    if (self->keys_size == UINT32_MAX)
+        return -1;
+    if (self->keys_size == self->keys_capacity) {
+        size_t capacity = self->keys_capacity ? self->keys_capacity * 2 : 256;
+        if (s_grow ((void **) &self->keys, sizeof (asset_key_t *), capacity))
+            return -1;
+        self->keys_capacity = capacity;
+    }
+    asset_key_t *owned = asset_key_new (name);
+    if (!owned)
+        return -1;
+    if (zhashx_insert (self->index, owned, (void *) (uintptr_t) (self->keys_size + 1)) != 0) {
+        asset_key_destroy (&owned);
+        return -1;
+    }
+    self->keys [self->keys_size] = owned;
+    return (int64_t) self->keys_size++;
+}
+
+// parse unsigned decimal number, the whole token
+static int
+s_parse_uint64 (const char *token, uint64_t *value_p)
+{
+    if (!token || !isdigit ((unsigned char) *token))
+        return -1;
+    char *end;
+    errno = 0;
+    unsigned long long value = strtoull (token, &end, 10);
+    if (errno || *end)
+        return -1;
+    *value_p = (uint64_t) value;
+    return 0;
+}
+
+// parse asset event from the tokens following the operation
+static int
+s_sim_parse_asset_event (outage_sim_t *self, const char *operation, char **saveptr)
+{
+    if (self->asset_events_size == UINT32_MAX)
+        return -1;
+    if (self->asset_events_size == self->asset_events_capacity) {
+        size_t capacity = self->asset_events_capacity ? self->asset_events_capacity * 2 : 256;
+        if (s_grow ((void **) &self->asset_events, sizeof (sim_asset_event_t), capacity))
+            return -1;
+        self->asset_events_capacity = capacity;
+    }
+    zhash_t *aux = zhash_new ();
+    if (!aux)
+        return -1;
+    zhash_autofree (aux);
+    for (char *pair = strtok_r (NULL, " \t\r\n", saveptr); pair; pair = strtok_r (NULL, " \t\r\n", saveptr)) {
+        char *value = strchr (pair, '=');
+        if (!value || value == pair) {
+            zhash_destroy (&aux);
+            return -1;
+        }
+        *value++ = 0;
+        zhash_update (aux, pair, value);
+    }
+    char *copy = strdup (operation);
+    if (!copy) {
+        zhash_destroy (&aux);
+        return -1;
+    }
+    self->asset_events [self->asset_events_size].operation = copy;
+    self->asset_events [self->asset_events_size].aux = aux;
+    self->asset_events_size++;
+    return 0;
+}
+
+// parse tokens of a line and append its event
+static int
+s_sim_append (outage_sim_t *self, char *line)
+{
+    char *saveptr = NULL;
+    const char *time = strtok_r (line, " \t\r\n", &saveptr);
+    const char *kind = strtok_r (NULL, " \t\r\n", &saveptr);
+    const char *name = strtok_r (NULL, " \t\r\n", &saveptr);
+    const char *value = strtok_r (NULL, " \t\r\n", &saveptr);
+
+    uint64_t time_sec;
+    if (s_parse_uint64 (time, &time_sec) || !kind || !name || !value)
+        return -1;
+    // capture is in order of arrival, earlier time is taken as the previous one
+    uint64_t base_sec = self->size ? self->base_sec : time_sec;
+    uint64_t previous_sec = self->size ? base_sec + self->time [self->size - 1] : base_sec;
+    if (time_sec < previous_sec)
+        time_sec = previous_sec;
+    if (time_sec - base_sec > UINT32_MAX)
+        return -1;
+
+    uint8_t event_kind;
+    uint32_t arg;
+    int32_t age = 0;
+    if (streq (kind, "metric")) {
+        uint64_t ttl, timestamp = time_sec;
+        const char *stamp = strtok_r (NULL, " \t\r\n", &saveptr);
+        if (s_parse_uint64 (value, &ttl) || ttl > UINT32_MAX
+        ||  (stamp && s_parse_uint64 (stamp, &timestamp))
+        ||  strtok_r (NULL, " \t\r\n", &saveptr))
+            return -1;
+        int64_t metric_age = (int64_t) time_sec - (int64_t) timestamp;
+        age = (int32_t) (metric_age > INT32_MAX ? INT32_MAX : metric_age < INT32_MIN ? INT32_MIN : metric_age);
+        event_kind = SIM_METRIC;
+        arg = (uint32_t) ttl;
+    }
+    else
+    if (streq (kind, "asset")) {
+        if (s_sim_parse_asset_event (self, value, &saveptr))
+            return -1;
+        event_kind = SIM_ASSET;
+        arg = (uint32_t) (self->asset_events_size - 1);
+    }
+    else
+        return -1;
+
+    int64_t asset = s_sim_intern (self, name);
+    if (asset == -1 || s_sim_reserve (self)) {
+        if (event_kind == SIM_ASSET) {
+            sim_asset_event_t *event = &self->asset_events [--self->asset_events_size];
+            zstr_free (&event->operation);
+            zhash_destroy (&event->aux);
+        }
+        return -1;
+    }
+    self->base_sec = base_sec;
+    self->time [self->size] = (uint32_t) (time_sec - base_sec);
+    self->kind [self->size] = event_kind;
+    self->asset [self->size] = (uint32_t) asset;
+    self->arg [self->size] = arg;
+    self->age [self->size] = age;
+    self->size++;
+    return 0;
+}
+
+//  --------------------------------------------------------------------------
+//  Append event of one line of capture
+//  return -1 if the line is malformed, 0 otherwise
+int
+outage_sim_append (outage_sim_t *self, const char *line)
+{
+    assert (self);
+    assert (line);
+
+    while (isspace ((unsigned char) *line))
+        line++;
+    if (*line == 0 || *line == '#')
+        return 0;
+
+    char *copy = strdup (line);
+    if (!copy)
+        return -1;
+    int rv = s_sim_append (self, copy);
+    free (copy);
+    return rv;
+}
+
+//  --------------------------------------------------------------------------
+//  Append all lines of capture file, "-" reads the standard input
+//  return number of malformed lines skipped, -1 if the file can't be read
+int
+outage_sim_load (outage_sim_t *self, const char *path)
+{
+    assert (self);
+    assert (path);
+
+    FILE *file = streq (path, "-") ? stdin : fopen (path, "r");
+    if (!file)
+        return -1;
+    int malformed = 0;
+    char *line = NULL;
+    size_t line_size = 0;
+    while (getline (&line, &line_size, file) != -1) {
+        if (outage_sim_append (self, line) != 0)
+            malformed++;
+    }
+    free (line);
+    if (file != stdin)
+        fclose (file);
+    return malformed;
+}
+
+//  --------------------------------------------------------------------------
+//  Return number of events of the capture
+size_t
+outage_sim_size (outage_sim_t *self)
+{
+    assert (self);
+    return self->size;
+}
+
+//  --------------------------------------------------------------------------
+//  Return number of distinct assets of the capture
+size_t
+outage_sim_assets (outage_sim_t *self)
+{
+    assert (self);
+    return self->keys_size;
+}
+
+//  --------------------------------------------------------------------------
+//  Set up policy with the defaults of the agent, then apply its spec
+//  return -1 if the spec is malformed, 0 otherwise
+int
+outage_sim_policy_parse (outage_sim_policy_t *policy, const char *spec)
+{
+    assert (policy);
+    assert (spec);
+
+    memset (policy, 0, sizeof (outage_sim_policy_t));
+    policy->warning_factor = SIM_WARNING_FACTOR;
+    policy->critical_factor = SIM_CRITICAL_FACTOR;
+    policy->expiry_sec = SIM_EXPIRY_SEC;
+    policy->poll_sec = SIM_POLL_SEC;
+
+    const char *options = strchr (spec, ':');
+    size_t name_length = options ? (size_t) (options - spec) : strlen (spec);
+    if (name_length == 0)
+        return -1;
+    if (name_length >= OUTAGE_SIM_NAME_SIZE)
+        name_length = OUTAGE_SIM_NAME_SIZE - 1;
+    memcpy (policy->name, spec, name_length);
+    if (!options)
+        return 0;
+
+    char *copy = strdup (options + 1);
+    if (!copy)
+        return -1;
+    int rv = 0;
+    char *saveptr = NULL;
+    for (char *option = strtok_r (copy, ",", &saveptr); option && rv == 0; option = strtok_r (NULL, ",", &saveptr)) {
+        char *value = strchr (option, '=');
+        if (!value) {
+            rv = -1;
+            break;
+        }
+        *value++ = 0;
+        char *end;
+        if (streq (option, "warning") || streq (option, "critical")) {
+            double factor = strtod (value, &end);
+            if (end == value || *end || factor < 0)
+                rv = -1;
+            else
+            if (streq (option, "warning"))
+                policy->warning_factor = factor;
+            else
+                policy->critical_factor = factor;
+        }
+        else
+        if (streq (option, "expiry"))
+            rv = s_parse_uint64 (value, &policy->expiry_sec);
+        else
+        if (streq (option, "poll"))
+            rv = s_parse_uint64 (value, &policy->poll_sec);
+        else
+            rv = -1;
+    }
+    free (copy);
+    // WARNING must come before CRITICAL
+    if (policy->critical_factor <= 0 || policy->warning_factor >= policy->critical_factor
+    ||  policy->expiry_sec == 0 || policy->poll_sec == 0)
+        rv = -1;
+    return rv;
+}
+
+// print and count the interval of asset, if it has active alert
+static void
+s_sim_resolve (sim_run_t *run, uint32_t asset, uint64_t now_sec)
+{
+    if (run->level [asset] == DATA_LEVEL_NONE)
+        return;
+    if (run->intervals)
+        fprintf (run->intervals, "%s %s %" PRIu64 " %" PRIu64 " %s\n", run->policy->name,
+            run->sim->keys [asset]->name, run->since [asset], now_sec,
+            run->peak [asset] == DATA_LEVEL_WARNING ? "WARNING" : "CRITICAL");
+    run->result->outages++;
+    run->result->resolved++;
+    run->result->downtime_sec += now_sec - run->since [asset];
+    run->level [asset] = DATA_LEVEL_NONE;
+}
+
+// raise or escalate alerts of dead assets, as the server does on timeout
+static int
+s_sim_poll (sim_run_t *run, uint64_t now_sec)
+{
+    zlistx_t *dead = data_get_dead (run->data);
+    if (!dead)
+        return -1;
+    for (const asset_key_t *key = (const asset_key_t *) zlistx_first (dead);
+                            key != NULL;
+                            key = (const asset_key_t *) zlistx_next (dead))
+    {
+        // each monitored asset came from the capture
+        uint32_t asset = (uint32_t) ((uintptr_t) zhashx_lookup (run->sim->index, key) - 1);
+        int level = data_asset_level (run->data, key);
+        if (level == run->level [asset])
+            continue;
+        if (run->level [asset] == DATA_LEVEL_NONE) {
+            run->since [asset] = now_sec;
+            run->peak [asset] = DATA_LEVEL_NONE;
+        }
+        if (level == DATA_LEVEL_WARNING)
+            run->result->active_warning++;
+        else
+            run->result->active_critical++;
+        run->level [asset] = (uint8_t) level;
+        if (level > run->peak [asset])
+            run->peak [asset] = (uint8_t) level;
+    }
+    zlistx_destroy (&dead);
+    return 0;
+}
+
+// move the simulated clock forward to the time
+static void
+s_sim_advance (sim_run_t *run, uint64_t time_sec)
+{
+    int64_t delta_ms = (int64_t) time_sec * 1000 - outage_clock_wall_ms (run->clock);
+    if (delta_ms > 0)
+        outage_clock_advance (run->clock, delta_ms);
+}
+
+// put asset event to data, deleted or not active asset resolves its alert
+static void
+s_sim_put_asset (sim_run_t *run, size_t event, uint64_t now_sec)
+{
+    outage_sim_t *sim = run->sim;
+    uint32_t asset = sim->asset [event];
+    sim_asset_event_t *asset_event = &sim->asset_events [sim->arg [event]];
+    const char *status = (const char *) zhash_lookup (asset_event->aux, FTY_PROTO_ASSET_STATUS);
+    if (streq (asset_event->operation, FTY_PROTO_ASSET_OP_DELETE)
+    ||  (status && !streq (status, "active")))
+        s_sim_resolve (run, asset, now_sec);
+
+    zmsg_t *msg = fty_proto_encode_asset (asset_event->aux, sim->keys [asset]->name, asset_event->operation, NULL);
+    fty_proto_t *proto = fty_proto_decode (&msg);
+    data_put (run->data, &proto);
+}
+
+//  --------------------------------------------------------------------------
+//  Replay the capture under the policy on simulated clock
+//  return -1 on memory error, 0 otherwise
+int
+outage_sim_run (outage_sim_t *self, const outage_sim_policy_t *policy, outage_sim_result_t *result, FILE *intervals)
+{
+    assert (self);
+    assert (policy);
+    assert (result);
+
+    memset (result, 0, sizeof (outage_sim_result_t));
+    int64_t start_usec = zclock_usecs ();
+    sim_run_t run = { self, policy, result, intervals, NULL, NULL, NULL, NULL, NULL };
+    run.clock = outage_clock_new_fake ((int64_t) self->base_sec * 1000, (int64_t) self->base_sec * 1000);
+    run.data = data_new ();
+    run.level = (uint8_t *) calloc (self->keys_size + 1, sizeof (uint8_t));
+    run.peak = (uint8_t *) calloc (self->keys_size + 1, sizeof (uint8_t));
+    run.since = (uint64_t *) calloc (self->keys_size + 1, sizeof (uint64_t));
+    data_touch_t *items = NULL;
+    size_t items_capacity = 0;
+    int rv = (run.clock && run.data && run.level && run.peak && run.since) ? 0 : -1;
+    if (rv == 0) {
+        data_set_clock (run.data, run.clock);
+        data_set_default_expiry (run.data, policy->expiry_sec);
+        data_set_escalation (run.data, policy->warning_factor, policy->critical_factor);
+    }
+
+    uint64_t next_poll_sec = self->base_sec + policy->poll_sec;
+    size_t event = 0;
+    while (rv == 0 && event < self->size) {
+        uint32_t time = self->time [event];
+        uint64_t now_sec = self->base_sec + time;
+        for (; rv == 0 && next_poll_sec <= now_sec; next_poll_sec += policy->poll_sec) {
+            s_sim_advance (&run, next_poll_sec);
+            rv = s_sim_poll (&run, next_poll_sec);
+        }
+        s_sim_advance (&run, now_sec);
+        if (self->kind [event] == SIM_ASSET) {
+            s_sim_put_asset (&run, event, now_sec);
+            event++;
+            continue;
+        }
+        // metrics which arrived in the same second are touched as a batch
+        size_t count = 0;
+        for (size_t last = event; last < self->size && self->time [last] == time && self->kind [last] == SIM_METRIC; last++)
+            count++;
+        if (count > items_capacity) {
+            if (s_grow ((void **) &items, sizeof (data_touch_t), count)) {
+                rv = -1;
+                break;
+            }
+            items_capacity = count;
+        }
+        for (size_t i = 0; i < count; i++, event++) {
+            uint32_t asset = self->asset [event];
+            s_sim_resolve (&run, asset, now_sec);
+            items [i].key = *self->keys [asset];
+            items [i].timestamp = (uint64_t) ((int64_t) now_sec - self->age [event]);
+            items [i].ttl = self->arg [event];
+        }
+        data_touch_batch (run.data, items, count, now_sec, NULL);
+    }
+
+    // intervals still open at the end of capture
+    uint64_t end_sec = self->size ? self->base_sec + self->time [self->size - 1] : self->base_sec;
+    for (uint32_t asset = 0; rv == 0 && asset < self->keys_size; asset++) {
+        if (run.level [asset] == DATA_LEVEL_NONE)
+            continue;
+        if (intervals)
+            fprintf (intervals, "%s %s %" PRIu64 " - %s\n", policy->name, self->keys [asset]->name,
+                run.since [asset], run.peak [asset] == DATA_LEVEL_WARNING ? "WARNING" : "CRITICAL");
+        result->outages++;
+        result->open++;
+        result->downtime_sec += end_sec - run.since [asset];
+    }
+
+    free (items);
+    free (run.since);
+    free (run.peak);
+    free (run.level);
+    data_destroy (&run.data);
+    outage_clock_destroy (&run.clock);
+    result->elapsed_usec = zclock_usecs () - start_usec;
+    return rv;
+}
+
+// append the line to the capture and to the file
+static void
+s_test_line (outage_sim_t *self, FILE *file, const char *format, ...)
+{
+    va_list args;
+    va_start (args, format);
+    char *line = zsys_vprintf (format, args);
+    va_end (args);
+    assert (line);
+    int rv = outage_sim_append (self, line);
+    assert (rv == 0);
+    fprintf (file, "%s\n", line);
+    zstr_free (&line);
+}
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+void
+outage_sim_test (bool verbose)
+{
+    printf (" * outage_sim: ");
+
+    //  @selftest
+    // policies
+    outage_sim_policy_t policy;
+    assert (outage_sim_policy_parse (&policy, "default") == 0);
+    assert (streq (policy.name, "default"));
+    assert (policy.warning_factor == 0);
+    assert (policy.critical_factor == 2);
+    assert (policy.expiry_sec == 450);
+    assert (policy.poll_sec == 30);
+    assert (outage_sim_policy_parse (&policy, "fast:warning=1,critical=1.5,expiry=60,poll=10") == 0);
+    assert (streq (policy.name, "fast"));
+    assert (policy.warning_factor == 1);
+    assert (policy.critical_factor == 1.5);
+    assert (policy.expiry_sec == 60);
+    assert (policy.poll_sec == 10);
+    assert (outage_sim_policy_parse (&policy, ":critical=3") == -1);
+    assert (outage_sim_policy_parse (&policy, "x:critical") == -1);
+    assert (outage_sim_policy_parse (&policy, "x:critical=0") == -1);
+    assert (outage_sim_policy_parse (&policy, "x:warning=3,critical=2") == -1);
+    assert (outage_sim_policy_parse (&policy, "x:poll=0") == -1);
+    assert (outage_sim_policy_parse (&policy, "x:expiry=-1") == -1);
+    assert (outage_sim_policy_parse (&policy, "x:ttl=60") == -1);
+
+    // malformed lines are not appended, comments are skipped
+    outage_sim_t *self = outage_sim_new ();
+    assert (self);
+    assert (outage_sim_append (self, "") == 0);
+    assert (outage_sim_append (self, "  # capture of test") == 0);
+    assert (outage_sim_append (self, "now metric ups-1 60") == -1);
+    assert (outage_sim_append (self, "100 metric ups-1") == -1);
+    assert (outage_sim_append (self, "100 metric ups-1 sixty") == -1);
+    assert (outage_sim_append (self, "100 metric ups-1 60 99 extra") == -1);
+    assert (outage_sim_append (self, "100 alert ups-1 ACTIVE") == -1);
+    assert (outage_sim_append (self, "100 asset ups-1 create status") == -1);
+    assert (outage_sim_size (self) == 0);
+    assert (outage_sim_assets (self) == 0);
+    outage_sim_destroy (&self);
+
+    // ups-1 is silent from 600 to 2040, ups-4 since 60 till the end, ups-5
+    // never reports and is deleted at 1000, server is not monitored
+    const char *path = "src/selftest-rw/outage_sim.capture";
+    const char *intervals_path = "src/selftest-rw/outage_sim.intervals";
+    const uint64_t t0 = 1500000000;
+    self = outage_sim_new ();
+    assert (self);
+    FILE *file = fopen (path, "w");
+    assert (file);
+    fprintf (file, "# capture of test\n");
+    s_test_line (self, file, "%" PRIu64 " asset ups-1 create type=device subtype=ups", t0);
+    s_test_line (self, file, "%" PRIu64 " asset ups-2 create type=device subtype=ups", t0);
+    s_test_line (self, file, "%" PRIu64 " asset srv-3 create type=device subtype=server", t0);
+    s_test_line (self, file, "%" PRIu64 " asset ups-4 create type=device subtype=ups", t0);
+    s_test_line (self, file, "%" PRIu64 " asset ups-5 create type=device subtype=ups", t0);
+    for (uint64_t time = 60; time <= 3000; time += 60) {
+        if (time <= 600 || time >= 2000)
+            s_test_line (self, file, "%" PRIu64 " metric ups-1 60 %" PRIu64, t0 + time, t0 + time - 1);
+        s_test_line (self, file, "%" PRIu64 " metric ups-2 60", t0 + time);
+        if (time == 60)
+            s_test_line (self, file, "%" PRIu64 " metric ups-4 60", t0 + time);
+        if (time == 960)
+            s_test_line (self, file, "%" PRIu64 " asset ups-5 delete", t0 + 1000);
+    }
+    fprintf (file, "%" PRIu64 " metric ups-2 sixty\n", t0 + 3000);
+    fclose (file);
+    assert (outage_sim_assets (self) == 5);
+    size_t size = outage_sim_size (self);
+
+    // the same capture loaded from the file
+    outage_sim_t *loaded = outage_sim_new ();
+    assert (loaded);
+    assert (outage_sim_load (loaded, path) == 1);
+    assert (outage_sim_size (loaded) == size);
+    assert (outage_sim_load (loaded, "src/selftest-rw/no-such-file") == -1);
+
+    // default policy: CRITICAL after 2 * ttl of silence, checked each 30s
+    outage_sim_result_t result;
+    assert (outage_sim_policy_parse (&policy, "default") == 0);
+    FILE *intervals = fopen (intervals_path, "w");
+    assert (intervals);
+    int rv = outage_sim_run (self, &policy, &result, intervals);
+    assert (rv == 0);
+    fclose (intervals);
+    if (verbose)
+        zsys_debug ("outages=%zu open=%zu warning=%zu critical=%zu resolved=%zu downtime=%" PRIu64,
+            result.outages, result.open, result.active_warning, result.active_critical,
+            result.resolved, result.downtime_sec);
+    assert (result.outages == 3);
+    assert (result.open == 1);
+    assert (result.active_warning == 0);
+    assert (result.active_critical == 3);
+    assert (result.resolved == 2);
+    // ups-1 from 720 to 2040, ups-4 from 180 to 3000, ups-5 from 900 to 1000
+    assert (result.downtime_sec == 1320 + 2820 + 100);
+
+    intervals = fopen (intervals_path, "r");
+    assert (intervals);
+    char line [256];
+    size_t lines = 0;
+    bool has_open = false;
+    while (fgets (line, sizeof (line), intervals)) {
+        lines++;
+        if (streq (line, "default ups-4 1500000180 - CRITICAL\n"))
+            has_open = true;
+        else
+            assert (streq (line, "default ups-1 1500000720 1500002040 CRITICAL\n")
+                 || streq (line, "default ups-5 1500000900 1500001000 CRITICAL\n"));
+    }
+    fclose (intervals);
+    assert (lines == 3);
+    assert (has_open);
+    unlink (intervals_path);
+
+    // the same outcome from the loaded capture
+    outage_sim_result_t result_loaded;
+    rv = outage_sim_run (loaded, &policy, &result_loaded, NULL);
+    assert (rv == 0);
+    assert (result_loaded.outages == result.outages);
+    assert (result_loaded.downtime_sec == result.downtime_sec);
+    outage_sim_destroy (&loaded);
+    unlink (path);
+
+    // WARNING after 1.5 ttl, escalated to CRITICAL at 2 ttl
+    assert (outage_sim_policy_parse (&policy, "warn:warning=1.5") == 0);
+    rv = outage_sim_run (self, &policy, &result, NULL);
+    assert (rv == 0);
+    assert (result.outages == 3);
+    assert (result.active_warning == 3);
+    assert (result.active_critical == 3);
+    assert (result.downtime_sec == 1350 + 2850 + 310);
+
+    // WARNING after exactly a ttl is raised by each poll coming before
+    // a metric reported each ttl, ups-2 alone flaps all the time
+    assert (outage_sim_policy_parse (&policy, "noisy:warning=1") == 0);
+    rv = outage_sim_run (self, &policy, &result, NULL);
+    assert (rv == 0);
+    assert (result.outages > 40);
+
+    // lenient policy tolerates silence of ups-1 and ups-5 is deleted before
+    assert (outage_sim_policy_parse (&policy, "lenient:critical=30") == 0);
+    rv = outage_sim_run (self, &policy, &result, NULL);
+    assert (rv == 0);
+    assert (result.outages == 1);
+    assert (result.open == 1);
+    assert (result.resolved == 0);
+    assert (result.downtime_sec == 3000 - 1860);
+
+    outage_sim_destroy (&self);
+    //  @end
+    printf ("OK\n");
+}
@@ -0,0 +1,116 @@
+/*  =========================================================================
+    outage_sim - Offline replay of captured traffic under expiry policies
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef OUTAGE_SIM_H_INCLUDED
+#define OUTAGE_SIM_H_INCLUDED
+
+#include "../include/fty_outage.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef OUTAGE_SIM_T_DEFINED
+typedef struct _outage_sim_t outage_sim_t;
+#define OUTAGE_SIM_T_DEFINED
+#endif
+
+#define OUTAGE_SIM_NAME_SIZE    64  //  policy names are truncated to 63 characters
+
+//  Expiry policy, settings of data and the server being compared
+typedef struct _outage_sim_policy_t {
+    char name [OUTAGE_SIM_NAME_SIZE];
+    double warning_factor;          //  ttls of silence to WARNING, 0 disables it
+    double critical_factor;         //  ttls of silence to CRITICAL
+    uint64_t expiry_sec;            //  ttl of asset before its first metric
+    uint64_t poll_sec;              //  how often dead assets are checked
+} outage_sim_policy_t;
+
+//  Outcome of a replay under a policy
+typedef struct _outage_sim_result_t {
+    size_t outages;                 //  intervals with active alert
+    size_t open;                    //  of them still active at the end of capture
+    size_t active_warning;          //  ACTIVE alerts of WARNING severity sent
+    size_t active_critical;         //  ACTIVE alerts of CRITICAL severity sent, escalations included
+    size_t resolved;                //  RESOLVED alerts sent
+    uint64_t downtime_sec;          //  total length of intervals, open ones up to the end of capture
+    int64_t elapsed_usec;           //  how long the replay took
+} outage_sim_result_t;
+
+//  @interface
+//  Create a new, empty, capture
+FTY_OUTAGE_EXPORT outage_sim_t *
+    outage_sim_new (void);
+
+//  Destroy the capture
+FTY_OUTAGE_EXPORT void
+    outage_sim_destroy (outage_sim_t **self_p);
+
+//  Append event of one line of capture:
+//      <time> metric <asset> <ttl> [<timestamp>]
+//      <time> asset <asset> <operation> [<aux-key>=<value> ...]
+//  times are [s] since epoch the message arrived, timestamp of the metric
+//  defaults to its arrival. Empty lines and lines starting with # are
+//  skipped.
+//  return -1 if the line is malformed, 0 otherwise
+FTY_OUTAGE_EXPORT int
+    outage_sim_append (outage_sim_t *self, const char *line);
+
+//  Append all lines of capture file, "-" reads the standard input
+//  return number of malformed lines skipped, -1 if the file can't be read
+FTY_OUTAGE_EXPORT int
+    outage_sim_load (outage_sim_t *self, const char *path);
+
+//  Return number of events of the capture
+FTY_OUTAGE_EXPORT size_t
+    outage_sim_size (outage_sim_t *self);
+
+//  Return number of distinct assets of the capture
+FTY_OUTAGE_EXPORT size_t
+    outage_sim_assets (outage_sim_t *self);
+
+//  Set up policy with the defaults of the agent, then apply its spec
+//      <name>[:<key>=<value>[,<key>=<value> ...]]
+//  with keys warning, critical (factors), expiry and poll [s]
+//  return -1 if the spec is malformed, 0 otherwise
+FTY_OUTAGE_EXPORT int
+    outage_sim_policy_parse (outage_sim_policy_t *policy, const char *spec);
+
+//  Replay the capture under the policy on simulated clock, as the server
+//  would process it, and fill the result. Intervals of outages are
+//  printed to the file, if not NULL, one per line:
+//      <policy> <asset> <start> <end> <severity>
+//  end is - for intervals still open at the end of capture.
+//  return -1 on memory error, 0 otherwise
+FTY_OUTAGE_EXPORT int
+    outage_sim_run (outage_sim_t *self, const outage_sim_policy_t *policy, outage_sim_result_t *result, FILE *intervals);
+
+//  Self test of this class
+FTY_OUTAGE_EXPORT void
+    outage_sim_test (bool verbose);
+
+//  @end
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
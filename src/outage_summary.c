@@ -0,0 +1,416 @@
+/*  =========================================================================
+    outage_summary - Compact summary of dead assets
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    outage_summary - Compact summary of dead assets
+@discuss
+    Consumers interested only in the set of dead devices do not need to
+    parse every outage alert. The summary carries the number of dead assets
+    and the assets which died or came back since the previous summary.
+    Every full_every-th summary is a full snapshot, so a consumer which
+    missed a message (or just started) resynchronizes on it.
+
+    Asset lists are sorted and front coded: each name is stored as the
+    length of the prefix shared with the previous name and the remaining
+    suffix, both lengths as varints. Asset names share long prefixes
+    (ups-1, ups-2, ...), so a list is much smaller than the names.
+@end
+*/
+
+#include "fty_outage_classes.h"
+
+static void *DEAD = (void*) "dead";   // value of the assets in applied summary
+
+//  Structure of our class
+struct _outage_summary_t {
+    zhashx_t *published;        // assets dead in the last summary
+    uint64_t sequence;          // sequence of the last summary
+    size_t full_every;          // each n-th summary is full snapshot
+};
+
+//  --------------------------------------------------------------------------
+//  Destroy the summary encoder
+void
+outage_summary_destroy (outage_summary_t **self_p)
+{
+    assert (self_p);
+    if (*self_p) {
+        outage_summary_t *self = *self_p;
+        zhashx_destroy (&self->published);
+        free (self);
+        *self_p = NULL;
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Create a new summary encoder
+outage_summary_t *
+outage_summary_new (size_t full_every)
+{
+    outage_summary_t *self = (outage_summary_t *) zmalloc (sizeof (outage_summary_t));
+    if (self) {
+        self->published = zhashx_new ();
+        if (self->published) {
+            self->full_every = full_every > 0 ? full_every : 1;
+            self->sequence = 0;
+        }
+        else
+            outage_summary_destroy (&self);
+    }
+    return self;
+}
+
+static int
+s_strcmp (const void *a, const void *b)
+{
+    return strcmp (*(const char **) a, *(const char **) b);
+}
+
+static size_t
+s_varint_put (byte *buffer, uint64_t value)
+{
+    size_t size = 0;
+    do {
+        byte b = value & 0x7f;
+        value >>= 7;
+        buffer [size++] = value ? b | 0x80 : b;
+    } while (value);
+    return size;
+}
+
+// return number of bytes consumed, 0 if data are malformed
+static size_t
+s_varint_get (const byte *data, size_t size, uint64_t *value_p)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i != size && i < 10; i++) {
+        value |= (uint64_t) (data [i] & 0x7f) << (7 * i);
+        if (!(data [i] & 0x80)) {
+            *value_p = value;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+// front code sorted names into a frame
+static zframe_t *
+s_names_encode (const char **names, size_t count)
+{
+    size_t capacity = 0;
+    for (size_t i = 0; i != count; i++)
+        capacity += strlen (names [i]) + 20;
+    byte *buffer = (byte *) malloc (capacity > 0 ? capacity : 1);
+    assert (buffer);
+
+    size_t size = 0;
+    const char *previous = "";
+    for (size_t i = 0; i != count; i++) {
+        size_t shared = 0;
+        while (previous [shared] && previous [shared] == names [i][shared])
+            shared++;
+        size_t suffix = strlen (names [i] + shared);
+        size += s_varint_put (buffer + size, shared);
+        size += s_varint_put (buffer + size, suffix);
+        memcpy (buffer + size, names [i] + shared, suffix);
+        size += suffix;
+        previous = names [i];
+    }
+    zframe_t *frame = zframe_new (buffer, size);
+    free (buffer);
+    return frame;
+}
+
+// decode front coded names from a frame into list of strings
+// return -1 if frame is malformed
+static int
+s_names_decode (zframe_t *frame, zlistx_t *names)
+{
+    const byte *data = zframe_data (frame);
+    size_t size = zframe_size (frame);
+    char *name = NULL;
+    size_t name_size = 0;
+
+    for (size_t pos = 0; pos < size; ) {
+        uint64_t shared, suffix;
+        size_t n = s_varint_get (data + pos, size - pos, &shared);
+        if (n == 0 || shared > name_size)
+            break;
+        pos += n;
+        n = s_varint_get (data + pos, size - pos, &suffix);
+        if (n == 0 || suffix > size - pos - n)
+            break;
+        pos += n;
+        char *next = (char *) malloc (shared + suffix + 1);
+        assert (next);
+        if (shared)
+            memcpy (next, name, shared);
+        memcpy (next + shared, data + pos, suffix);
+        next [shared + suffix] = 0;
+        pos += suffix;
+        free (name);
+        name = next;
+        name_size = shared + suffix;
+        zlistx_add_end (names, strdup (name));
+        if (pos == size) {
+            free (name);
+            return 0;
+        }
+    }
+    free (name);
+    return size == 0 ? 0 : -1;
+}
+
+//  --------------------------------------------------------------------------
+//  Encode summary of dead assets against the last encoded one
+zmsg_t *
+outage_summary_encode (outage_summary_t *self, zhashx_t *dead)
+{
+    assert (self);
+    assert (dead);
+
+    self->sequence++;
+    bool full = (self->sequence - 1) % self->full_every == 0;
+
+    size_t count = zhashx_size (dead);
+    const char **died = (const char **) zmalloc ((count + 1) * sizeof (char *));
+    const char **alive = (const char **) zmalloc ((zhashx_size (self->published) + 1) * sizeof (char *));
+    assert (died && alive);
+    size_t died_count = 0;
+    size_t alive_count = 0;
+
+    for (void *it = zhashx_first (dead); it != NULL; it = zhashx_next (dead)) {
+        const char *name = ((const asset_key_t *) zhashx_cursor (dead))->name;
+        if (full || !zhashx_lookup (self->published, name))
+            died [died_count++] = name;
+    }
+    for (void *it = zhashx_first (self->published); it != NULL; it = zhashx_next (self->published)) {
+        asset_key_t key;
+        asset_key_init (&key, (const char *) zhashx_cursor (self->published));
+        if (!zhashx_lookup (dead, &key))
+            alive [alive_count++] = key.name;
+    }
+    qsort (died, died_count, sizeof (char *), s_strcmp);
+    qsort (alive, alive_count, sizeof (char *), s_strcmp);
+
+    zmsg_t *msg = zmsg_new ();
+    zmsg_addstr (msg, "OUTAGE-SUMMARY");
+    zmsg_addstr (msg, OUTAGE_SUMMARY_VERSION);
+    zmsg_addstrf (msg, "%" PRIu64, self->sequence);
+    zmsg_addstr (msg, full ? "FULL" : "DELTA");
+    zmsg_addstrf (msg, "%zu", count);
+    zframe_t *frame = s_names_encode (died, died_count);
+    zmsg_append (msg, &frame);
+    frame = s_names_encode (full ? NULL : alive, full ? 0 : alive_count);
+    zmsg_append (msg, &frame);
+
+    // remember what consumers know now, names in 'alive' point to our keys
+    for (size_t i = 0; i != died_count; i++)
+        zhashx_update (self->published, died [i], DEAD);
+    for (size_t i = 0; i != alive_count; i++)
+        zhashx_delete (self->published, alive [i]);
+
+    free (died);
+    free (alive);
+    return msg;
+}
+
+//  --------------------------------------------------------------------------
+//  Return sequence number of the last encoded summary
+uint64_t
+outage_summary_sequence (outage_summary_t *self)
+{
+    assert (self);
+    return self->sequence;
+}
+
+//  --------------------------------------------------------------------------
+//  Apply received summary to the set of dead assets
+int
+outage_summary_apply (zhashx_t *dead, zmsg_t *msg, uint64_t *sequence_p)
+{
+    assert (dead);
+    assert (msg);
+    assert (sequence_p);
+
+    if (zmsg_size (msg) != 7)
+        return -1;
+    zframe_t *frame = zmsg_first (msg);
+    if (!zframe_streq (frame, "OUTAGE-SUMMARY"))
+        return -1;
+    frame = zmsg_next (msg);
+    if (!zframe_streq (frame, OUTAGE_SUMMARY_VERSION))
+        return -1;
+
+    char *value = zframe_strdup (zmsg_next (msg));
+    uint64_t sequence = strtoull (value, NULL, 10);
+    zstr_free (&value);
+    bool full = zframe_streq (zmsg_next (msg), "FULL");
+    value = zframe_strdup (zmsg_next (msg));
+    size_t count = (size_t) strtoull (value, NULL, 10);
+    zstr_free (&value);
+
+    if (!full && (*sequence_p == 0 || sequence != *sequence_p + 1))
+        return -1;
+
+    zlistx_t *died = zlistx_new ();
+    zlistx_t *alive = zlistx_new ();
+    zlistx_set_destructor (died, (zlistx_destructor_fn *) zstr_free);
+    zlistx_set_destructor (alive, (zlistx_destructor_fn *) zstr_free);
+    int rv = s_names_decode (zmsg_next (msg), died);
+    if (rv == 0)
+        rv = s_names_decode (zmsg_next (msg), alive);
+
+    // verify the result before touching the set
+    if (rv == 0 && !full) {
+        size_t expected = zhashx_size (dead);
+        for (char *name = (char *) zlistx_first (died); name; name = (char *) zlistx_next (died))
+            expected += zhashx_lookup (dead, name) ? 0 : 1;
+        for (char *name = (char *) zlistx_first (alive); name; name = (char *) zlistx_next (alive))
+            expected -= zhashx_lookup (dead, name) ? 1 : 0;
+        if (expected != count)
+            rv = -1;
+    }
+    if (rv == 0 && full && zlistx_size (died) != count)
+        rv = -1;
+
+    if (rv == 0) {
+        if (full)
+            zhashx_purge (dead);
+        for (char *name = (char *) zlistx_first (died); name; name = (char *) zlistx_next (died))
+            zhashx_update (dead, name, DEAD);
+        for (char *name = (char *) zlistx_first (alive); name; name = (char *) zlistx_next (alive))
+            zhashx_delete (dead, name);
+        *sequence_p = sequence;
+    }
+    zlistx_destroy (&died);
+    zlistx_destroy (&alive);
+    return rv;
+}
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+// add or remove asset of the test set
+static void
+s_dead_set (zhashx_t *dead, const char *name, bool is_dead)
+{
+    asset_key_t key;
+    asset_key_init (&key, name);
+    if (is_dead)
+        zhashx_insert (dead, &key, DEAD);
+    else
+        zhashx_delete (dead, &key);
+}
+
+void
+outage_summary_test (bool verbose)
+{
+    printf (" * outage_summary: ");
+
+    //  @selftest
+    outage_summary_t *self = outage_summary_new (3);
+    assert (self);
+
+    zhashx_t *dead = asset_key_hash_new (true);
+    zhashx_t *received = zhashx_new ();
+    uint64_t sequence = 0;
+
+    // first summary is a full snapshot
+    char name [32];
+    for (int i = 0; i != 100; i++) {
+        snprintf (name, sizeof (name), "ups-%d", i);
+        s_dead_set (dead, name, true);
+    }
+    zmsg_t *msg = outage_summary_encode (self, dead);
+    assert (outage_summary_sequence (self) == 1);
+    assert (zframe_streq (zmsg_first (msg), "OUTAGE-SUMMARY"));
+    zmsg_next (msg);
+    zmsg_next (msg);
+    assert (zframe_streq (zmsg_next (msg), "FULL"));
+    // front coding pays off on similar names
+    assert (zmsg_content_size (msg) < 100 * strlen ("ups-00"));
+    assert (outage_summary_apply (received, msg, &sequence) == 0);
+    assert (sequence == 1);
+    assert (zhashx_size (received) == 100);
+    assert (zhashx_lookup (received, "ups-42"));
+    zmsg_destroy (&msg);
+
+    // delta carries only changes
+    s_dead_set (dead, "ups-42", false);
+    s_dead_set (dead, "ups-7", false);
+    s_dead_set (dead, "epdu-1", true);
+    msg = outage_summary_encode (self, dead);
+    zmsg_first (msg);
+    zmsg_next (msg);
+    zmsg_next (msg);
+    assert (zframe_streq (zmsg_next (msg), "DELTA"));
+    assert (outage_summary_apply (received, msg, &sequence) == 0);
+    assert (sequence == 2);
+    assert (zhashx_size (received) == 99);
+    assert (!zhashx_lookup (received, "ups-42"));
+    assert (!zhashx_lookup (received, "ups-7"));
+    assert (zhashx_lookup (received, "epdu-1"));
+
+    // applying the same delta twice is refused
+    assert (outage_summary_apply (received, msg, &sequence) == -1);
+    assert (zhashx_size (received) == 99);
+    zmsg_destroy (&msg);
+
+    // lost delta is detected, consumer waits for the next full snapshot
+    s_dead_set (dead, "ups-42", true);
+    msg = outage_summary_encode (self, dead);
+    zmsg_destroy (&msg);
+    s_dead_set (dead, "epdu-1", false);
+    msg = outage_summary_encode (self, dead);
+    assert (outage_summary_sequence (self) == 4);
+    zmsg_first (msg);
+    zmsg_next (msg);
+    zmsg_next (msg);
+    assert (zframe_streq (zmsg_next (msg), "FULL"));
+    assert (outage_summary_apply (received, msg, &sequence) == 0);
+    assert (sequence == 4);
+    assert (zhashx_size (received) == 99);
+    assert (zhashx_lookup (received, "ups-42"));
+    assert (!zhashx_lookup (received, "epdu-1"));
+    zmsg_destroy (&msg);
+
+    // empty set
+    zhashx_destroy (&dead);
+    dead = asset_key_hash_new (true);
+    msg = outage_summary_encode (self, dead);
+    assert (outage_summary_apply (received, msg, &sequence) == 0);
+    assert (zhashx_size (received) == 0);
+    zmsg_destroy (&msg);
+
+    // malformed message
+    msg = zmsg_new ();
+    zmsg_addstr (msg, "OUTAGE-SUMMARY");
+    assert (outage_summary_apply (received, msg, &sequence) == -1);
+    zmsg_destroy (&msg);
+
+    zhashx_destroy (&received);
+    zhashx_destroy (&dead);
+    outage_summary_destroy (&self);
+    //  @end
+    printf ("OK\n");
+}
@@ -0,0 +1,77 @@
+/*  =========================================================================
+    outage_summary - Compact summary of dead assets
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef OUTAGE_SUMMARY_H_INCLUDED
+#define OUTAGE_SUMMARY_H_INCLUDED
+
+#include "../include/fty_outage.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef OUTAGE_SUMMARY_T_DEFINED
+typedef struct _outage_summary_t outage_summary_t;
+#define OUTAGE_SUMMARY_T_DEFINED
+#endif
+
+#define OUTAGE_SUMMARY_VERSION "1"
+#define OUTAGE_SUMMARY_SUBJECT "outage-summary"     // optionally followed by @site
+
+//  @interface
+//  Create a new summary encoder, every full_every-th summary is a full snapshot
+FTY_OUTAGE_EXPORT outage_summary_t *
+    outage_summary_new (size_t full_every);
+
+//  Destroy the summary encoder
+FTY_OUTAGE_EXPORT void
+    outage_summary_destroy (outage_summary_t **self_p);
+
+//  Encode summary of dead assets (asset_key_t keys of 'dead', a table made by
+//  asset_key_hash_new) against the last encoded one
+//  OUTAGE-SUMMARY/version/sequence/FULL|DELTA/count/newly dead/newly alive
+//  asset lists are sorted and front coded (varint shared prefix, varint suffix length, suffix)
+FTY_OUTAGE_EXPORT zmsg_t *
+    outage_summary_encode (outage_summary_t *self, zhashx_t *dead);
+
+//  Return sequence number of the last encoded summary
+FTY_OUTAGE_EXPORT uint64_t
+    outage_summary_sequence (outage_summary_t *self);
+
+//  Apply received summary to the set of dead assets (asset name => any value)
+//  *sequence_p holds the sequence of the last applied summary, it is updated
+//  return -1 if message is malformed, of unknown version or a delta does not
+//  follow the last applied summary (consumer has to wait for the next FULL)
+//  return 0 otherwise, 'dead' is unchanged on error
+FTY_OUTAGE_EXPORT int
+    outage_summary_apply (zhashx_t *dead, zmsg_t *msg, uint64_t *sequence_p);
+
+//  Self test of this class
+FTY_OUTAGE_EXPORT void
+    outage_summary_test (bool verbose);
+
+//  @end
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
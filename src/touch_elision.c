@@ -0,0 +1,268 @@
+/*  =========================================================================
+    touch_elision - Hints to skip metrics which would not move deadlines
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    touch_elision - Hints to skip metrics which would not move deadlines
+@discuss
+    A device sends dozens of metrics per poll, but only a metric which moves
+    its deadline meaningfully is worth decoding. Hint of a subject says
+    which asset its messages touch and until when the next one can be
+    skipped without decode, resolve lookup or logging; it is taken as seen
+    on arrival by a deferred touch, which moves the deadline exactly as a
+    plain touch would, once it is due.
+
+    Hints are kept per subject, not per asset: only subject <quantity>@<asset>
+    whose decoded message touched that very asset gets one, so computed
+    metrics (never touching) and sensors (touching an asset other than the
+    one in the subject) are always decoded.
+@end
+*/
+
+#include "fty_outage_classes.h"
+
+// stale hints are swept at most this often when the table is full
+#define SWEEP_INTERVAL_MS 1000
+
+//  Hint of a subject, with the subject and asset name in the same block
+typedef struct _hint_t {
+    int64_t until_ms;           // [ms] messages arriving before are elided
+    asset_key_t key;            // asset touched by messages of the subject
+    char *subject;              // key in the table, follows the asset name
+    char name [];
+} hint_t;
+
+//  Structure of our class
+struct _touch_elision_t {
+    zhashx_t *hints;            // subject => hint_t, keys live in the items
+    unsigned divisor;
+    size_t max_subjects;
+    int64_t next_sweep_ms;      // [ms] full table is not swept before
+};
+
+static void
+s_free (void **item_p)
+{
+    free (*item_p);
+    *item_p = NULL;
+}
+
+//  --------------------------------------------------------------------------
+//  Create a new elision
+touch_elision_t *
+touch_elision_new (unsigned divisor, size_t subjects)
+{
+    assert (divisor > 0);
+    touch_elision_t *self = (touch_elision_t *) zmalloc (sizeof (touch_elision_t));
+    if (self) {
+        self->divisor = divisor;
+        self->max_subjects = subjects;
+        self->hints = zhashx_new ();
+        if (self->hints) {
+            zhashx_set_key_duplicator (self->hints, NULL);
+            zhashx_set_key_destructor (self->hints, NULL);
+            zhashx_set_destructor (self->hints, s_free);
+        }
+        else
+            touch_elision_destroy (&self);
+    }
+    return self;
+}
+
+//  --------------------------------------------------------------------------
+//  Destroy the elision
+void
+touch_elision_destroy (touch_elision_t **self_p)
+{
+    assert (self_p);
+    if (*self_p) {
+        touch_elision_t *self = *self_p;
+        zhashx_destroy (&self->hints);
+        free (self);
+        *self_p = NULL;
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Return the divisor of ttl
+unsigned
+touch_elision_divisor (touch_elision_t *self)
+{
+    assert (self);
+    return self->divisor;
+}
+
+//  --------------------------------------------------------------------------
+//  Return key of asset touched by messages of the subject, if its message
+//  arriving at now_ms can be elided
+const asset_key_t *
+touch_elision_check (touch_elision_t *self, const char *subject, int64_t now_ms)
+{
+    assert (self);
+    assert (subject);
+    hint_t *hint = (hint_t *) zhashx_lookup (self->hints, subject);
+    if (!hint || now_ms >= hint->until_ms)
+        return NULL;
+    return &hint->key;
+}
+
+// drop hints which are over, a full table is swept at most once per interval
+static void
+s_sweep (touch_elision_t *self, int64_t now_ms)
+{
+    if (now_ms < self->next_sweep_ms)
+        return;
+    self->next_sweep_ms = now_ms + SWEEP_INTERVAL_MS;
+    zlistx_t *stale = zlistx_new ();
+    if (!stale)
+        return;
+    for (hint_t *hint = (hint_t *) zhashx_first (self->hints);
+                 hint != NULL;
+                 hint = (hint_t *) zhashx_next (self->hints))
+        if (now_ms >= hint->until_ms)
+            zlistx_add_end (stale, hint->subject);
+    for (char *subject = (char *) zlistx_first (stale);
+               subject != NULL;
+               subject = (char *) zlistx_next (stale))
+        zhashx_delete (self->hints, subject);
+    zlistx_destroy (&stale);
+}
+
+//  --------------------------------------------------------------------------
+//  Decoded message of the subject touched the asset with ttl_ms at now_ms
+void
+touch_elision_update (touch_elision_t *self, const char *subject, const asset_key_t *key, int64_t ttl_ms, int64_t age_ms, int64_t now_ms)
+{
+    assert (self);
+    assert (subject);
+    assert (key);
+
+    int64_t window_ms = ttl_ms / self->divisor;
+    const char *at = strrchr (subject, '@');
+    if (window_ms <= 0 || age_ms > window_ms || !at || !streq (at + 1, key->name))
+        return;
+
+    hint_t *hint = (hint_t *) zhashx_lookup (self->hints, subject);
+    if (!hint) {
+        if (zhashx_size (self->hints) >= self->max_subjects) {
+            s_sweep (self, now_ms);
+            if (zhashx_size (self->hints) >= self->max_subjects)
+                return;
+        }
+        size_t subject_size = strlen (subject) + 1;
+        hint = (hint_t *) malloc (sizeof (hint_t) + key->length + 1 + subject_size);
+        if (!hint)
+            return;
+        memcpy (hint->name, key->name, key->length + 1);
+        hint->key = *key;
+        hint->key.name = hint->name;
+        hint->subject = hint->name + key->length + 1;
+        memcpy (hint->subject, subject, subject_size);
+        zhashx_insert (self->hints, hint->subject, hint);
+    }
+    hint->until_ms = now_ms + window_ms;
+}
+
+//  --------------------------------------------------------------------------
+//  Return number of subjects with a hint
+size_t
+touch_elision_size (touch_elision_t *self)
+{
+    assert (self);
+    return zhashx_size (self->hints);
+}
+
+//  --------------------------------------------------------------------------
+//  Return bytes of heap memory held by the elision
+size_t
+touch_elision_memory (touch_elision_t *self)
+{
+    assert (self);
+    size_t bytes = memory_usage_block (sizeof (touch_elision_t))
+        + memory_usage_hash (zhashx_size (self->hints));
+    for (hint_t *hint = (hint_t *) zhashx_first (self->hints);
+                 hint != NULL;
+                 hint = (hint_t *) zhashx_next (self->hints))
+        bytes += memory_usage_block (sizeof (hint_t) + hint->key.length + 1 + strlen (hint->subject) + 1);
+    return bytes;
+}
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+// key of the name for tests, valid till the next call
+static const asset_key_t *
+s_key (const char *name)
+{
+    static asset_key_t key;
+    asset_key_init (&key, name);
+    return &key;
+}
+
+void
+touch_elision_test (bool verbose)
+{
+    printf (" * touch_elision: ");
+
+    //  @selftest
+    touch_elision_t *self = touch_elision_new (4, 2);
+    assert (self);
+    assert (touch_elision_divisor (self) == 4);
+    assert (!touch_elision_check (self, "realpower.default@ups-1", 0));
+
+    // hint lasts ttl/4 after the decoded message
+    touch_elision_update (self, "realpower.default@ups-1", s_key ("ups-1"), 8000, 0, 1000);
+    const asset_key_t *key = touch_elision_check (self, "realpower.default@ups-1", 2999);
+    assert (key && streq (key->name, "ups-1"));
+    assert (key->hash == s_key ("ups-1")->hash);
+    assert (!touch_elision_check (self, "realpower.default@ups-1", 3000));
+    assert (!touch_elision_check (self, "voltage.input.L1@ups-1", 1000));
+    touch_elision_update (self, "realpower.default@ups-1", s_key ("ups-1"), 8000, 500, 3000);
+    assert (touch_elision_check (self, "realpower.default@ups-1", 4999));
+    assert (touch_elision_size (self) == 1);
+
+    // message of another asset than in subject (sensor), of other subject
+    // convention, too old or with too short ttl gets no hint
+    touch_elision_update (self, "temperature.0@epdu-1", s_key ("sensor-1"), 8000, 0, 1000);
+    touch_elision_update (self, "subject", s_key ("ups-2"), 8000, 0, 1000);
+    touch_elision_update (self, "load@ups-2", s_key ("ups-2"), 8000, 2001, 1000);
+    touch_elision_update (self, "load@ups-2", s_key ("ups-2"), 3, 0, 1000);
+    assert (touch_elision_size (self) == 1);
+    assert (!touch_elision_check (self, "temperature.0@epdu-1", 1000));
+
+    // full table takes new subject once stale hints are swept
+    touch_elision_update (self, "load@ups-2", s_key ("ups-2"), 8000, 0, 4000);
+    touch_elision_update (self, "load@ups-3", s_key ("ups-3"), 8000, 0, 4000);
+    assert (touch_elision_size (self) == 2);
+    assert (!touch_elision_check (self, "load@ups-3", 4000));
+    touch_elision_update (self, "load@ups-3", s_key ("ups-3"), 8000, 0, 5000);
+    assert (touch_elision_size (self) == 2);
+    assert (touch_elision_check (self, "load@ups-3", 5000));
+    assert (!touch_elision_check (self, "realpower.default@ups-1", 5000));
+    assert (touch_elision_memory (self) > 2 * sizeof (hint_t));
+    if (verbose)
+        zsys_debug ("touch_elision: %zu hints, %zu bytes", touch_elision_size (self), touch_elision_memory (self));
+
+    touch_elision_destroy (&self);
+    assert (self == NULL);
+    //  @end
+    printf ("OK\n");
+}
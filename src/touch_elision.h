@@ -0,0 +1,81 @@
+/*  =========================================================================
+    touch_elision - Hints to skip metrics which would not move deadlines
+
+    Copyright (C) 2014 - 2017 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef TOUCH_ELISION_H_INCLUDED
+#define TOUCH_ELISION_H_INCLUDED
+
+#include "../include/fty_outage.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef TOUCH_ELISION_T_DEFINED
+typedef struct _touch_elision_t touch_elision_t;
+#define TOUCH_ELISION_T_DEFINED
+#endif
+
+//  @interface
+//  Create a new elision, message of a subject which touched its asset
+//  within the last ttl/divisor is elided, hints of at most 'subjects'
+//  subjects are kept
+FTY_OUTAGE_EXPORT touch_elision_t *
+    touch_elision_new (unsigned divisor, size_t subjects);
+
+//  Destroy the elision
+FTY_OUTAGE_EXPORT void
+    touch_elision_destroy (touch_elision_t **self_p);
+
+//  Return the divisor of ttl
+FTY_OUTAGE_EXPORT unsigned
+    touch_elision_divisor (touch_elision_t *self);
+
+//  Return key of asset touched by messages of the subject, if its message
+//  arriving at now_ms can be elided, NULL otherwise
+FTY_OUTAGE_EXPORT const asset_key_t *
+    touch_elision_check (touch_elision_t *self, const char *subject, int64_t now_ms);
+
+//  Decoded message of the subject touched the asset with ttl_ms at now_ms,
+//  it was age_ms old. Hint is kept only if the subject is <quantity>@<asset>
+//  and the message was fresh, so elided message taken as seen on arrival
+//  is not fresher than its decoded one would be.
+FTY_OUTAGE_EXPORT void
+    touch_elision_update (touch_elision_t *self, const char *subject, const asset_key_t *key, int64_t ttl_ms, int64_t age_ms, int64_t now_ms);
+
+//  Return number of subjects with a hint
+FTY_OUTAGE_EXPORT size_t
+    touch_elision_size (touch_elision_t *self);
+
+//  Return bytes of heap memory held by the elision
+FTY_OUTAGE_EXPORT size_t
+    touch_elision_memory (touch_elision_t *self);
+
+//  Self test of this class
+FTY_OUTAGE_EXPORT void
+    touch_elision_test (bool verbose);
+
+//  @end
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif